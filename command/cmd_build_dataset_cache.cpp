@@ -0,0 +1,94 @@
+
+#include <tclap/CmdLine.h>
+#include <SlamCore/config_utils.h>
+#include <SlamCore/utils.h>
+#include <SlamCore/timer.h>
+#include <ct_icp/config.h>
+#include <ct_icp/dataset_cache.h>
+
+
+struct Arguments {
+    std::string config_path;
+    std::string output_dir;
+    ct_icp::DatasetCacheWriter::Options options;
+};
+
+// ------ Read Arguments
+Arguments ReadArguments(int argc, char **argv) {
+    try {
+        TCLAP::CmdLine cmd("Builds a dataset cache file for each sequence of the dataset (to speed up the reading of frames)",
+                           ' ', "0.9");
+        TCLAP::ValueArg<std::string> config_arg("c", "config",
+                                                "Path to the yaml configuration file on disk (with a node `dataset_options`)",
+                                                true, "", "string");
+        TCLAP::ValueArg<std::string> output_arg("o", "output_dir",
+                                                "The output directory (defaults to the `cache_directory` of the dataset options)",
+                                                false, "", "string");
+        TCLAP::ValueArg<double> xyz_resolution_arg("r", "xyz_resolution",
+                                                   "The quantization step of the coordinates (in meters)",
+                                                   false, 1.e-3, "double");
+        TCLAP::ValueArg<double> time_resolution_arg("t", "timestamp_resolution",
+                                                    "The quantization step of the timestamps (in seconds)",
+                                                    false, 1.e-7, "double");
+
+        cmd.add(config_arg);
+        cmd.add(output_arg);
+        cmd.add(xyz_resolution_arg);
+        cmd.add(time_resolution_arg);
+
+        // Parse the arguments of the command line
+        cmd.parse(argc, argv);
+
+        Arguments arguments;
+        arguments.config_path = config_arg.getValue();
+        arguments.output_dir = output_arg.getValue();
+        arguments.options.xyz_resolution = xyz_resolution_arg.getValue();
+        arguments.options.timestamp_resolution = time_resolution_arg.getValue();
+        CHECK(!arguments.config_path.empty()) << "The path to the config is required and cannot be empty";
+        return arguments;
+    } catch (TCLAP::ArgException &e) {
+        std::cerr << "Error: " << e.error() << " for arg " << e.argId() << std::endl;
+        exit(1);
+    }
+}
+
+// ------ Main Function
+int main(int argc, char **argv) {
+    slam::setup_signal_handler(argc, argv);
+    auto arguments = ReadArguments(argc, argv);
+    YAML::Node config = YAML::LoadFile(arguments.config_path);
+    SLAM_CHECK_STREAM(config["dataset_options"], "The config does not contain a node `dataset_options`");
+    YAML::Node dataset_node = config["dataset_options"];
+
+    std::vector<ct_icp::DatasetOptions> all_options;
+    if (dataset_node.IsSequence())
+        all_options = ct_icp::yaml_to_dataset_options_vector(dataset_node);
+    else
+        all_options.push_back(ct_icp::yaml_to_dataset_options(dataset_node));
+
+    for (auto &dataset_options: all_options) {
+        std::string output_dir = arguments.output_dir.empty() ? dataset_options.cache_directory : arguments.output_dir;
+        SLAM_CHECK_STREAM(!output_dir.empty(), "No output directory defined for the dataset "
+                << ct_icp::DATASETEnumToString(dataset_options.dataset));
+        if (!fs::exists(output_dir))
+            fs::create_directories(output_dir);
+
+        // Read the frames from the original files
+        dataset_options.cache_directory.clear();
+        auto dataset = ct_icp::Dataset::LoadDataset(dataset_options);
+        for (auto &sequence: dataset.AllSequences()) {
+            auto cache_path = ct_icp::dataset_cache::CacheFilePath(output_dir, sequence->GetSequenceInfo());
+            LOG(INFO) << "Writing the cache of sequence " << sequence->GetSequenceInfo().sequence_name
+                      << " to " << cache_path << std::endl;
+            slam::Timer timer;
+            {
+                slam::Timer::Ticker ticker(timer, "write");
+                ct_icp::WriteDatasetCache(*sequence, cache_path, arguments.options);
+            }
+            LOG(INFO) << "Wrote " << sequence->NumFrames() << " frames in "
+                      << timer.AverageDuration("write", slam::Timer::SECONDS) << "(s)" << std::endl;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -163,15 +163,28 @@ namespace ct_icp {
 #endif // CT_ICP_WITH_VIZ
 
             double sum_frame_time = 0.;
+#if CT_ICP_WITH_VIZ == 1
+            // The map is streamed to the window by chunks, only the chunks modified since the last frame are sent
+            uint64_t map_version = 0;
+            std::map<slam::Voxel, int> map_chunk_ids;
+#endif // CT_ICP_WITH_VIZ
             while (next_sequence->HasNext()) {
 
 #if CT_ICP_WITH_VIZ == 1
                 if (options.with_viz3d) {
 
                     if (window_ptr->GetWindow().ShowMap()) {
-                        auto pc = odometry.GetMapPointer()->MapAsPointCloud();
-                        auto polydata = slam::polydata_from_pointcloud(*pc);
-                        window_ptr->AddPolyData("Map", 0, polydata);
+                        auto map = odometry.GetMapPointer();
+                        auto version = map->Version();
+                        for (auto &chunk: map->ExtractChunks(ct_icp::MapRegion(), map_version)) {
+                            auto [it, _] = map_chunk_ids.emplace(chunk.coordinates, int(map_chunk_ids.size()));
+                            if (chunk.points->size() == 0)
+                                window_ptr->RemovePolyData("Map", it->second);
+                            else
+                                window_ptr->AddPolyData("Map", it->second,
+                                                        slam::polydata_from_pointcloud(*chunk.points));
+                        }
+                        map_version = version;
                     }
                     window_ptr->GetWindow().WaitIfPaused();
                     if (window_ptr->GetWindow().stop) {
@@ -0,0 +1,187 @@
+#ifndef SlamCore_BINARY_TRAJECTORY_H
+#define SlamCore_BINARY_TRAJECTORY_H
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+
+#include "SlamCore/types.h"
+#include "SlamCore/memory_mapped_file.h"
+
+namespace slam {
+
+    /*!
+     * @brief   A binary container of poses, designed for large trajectories
+     *
+     * Layout of the file:
+     *
+     *  [Header (32 bytes)] [Record 0] ... [Record N-1] [Index Entries] [Footer (40 bytes)]
+     *
+     *  - Records are fixed-size (80 bytes) and contain all the information of a slam::Pose
+     *  - The Index keeps the timestamp of every `index_stride` record (for a fast search by timestamp)
+     *  - The Footer locates the index, and is rewritten after each batch of appended records
+     *
+     * Appending records to an existing file first truncates its index and footer (the records are never rewritten),
+     * so that a crash before the next flush leaves no stale footer or index bytes after the records. A file without
+     * a valid footer is recovered up to its first invalid record.
+     * All values are stored in the native (little endian) byte order.
+     */
+    namespace binary_trajectory {
+
+        constexpr char kHeaderMagic[8] = {'S', 'L', 'A', 'M', 'T', 'R', 'A', 'J'};
+        constexpr char kFooterMagic[8] = {'S', 'L', 'A', 'M', 'T', 'E', 'N', 'D'};
+        constexpr std::uint32_t kVersion = 1;
+        constexpr std::uint32_t kDefaultIndexStride = 256;
+
+        enum FLAGS : std::uint32_t {
+            SORTED_BY_TIMESTAMP = 1 << 0 //< Whether the records are sorted by increasing `dest_timestamp`
+        };
+
+        struct Header {
+            char magic[8];
+            std::uint32_t version = kVersion;
+            std::uint32_t record_size = 0;
+            std::uint64_t reserved[2] = {0, 0};
+        };
+
+        // A fixed-size record of a pose
+        struct PoseRecord {
+            double dest_timestamp;
+            double ref_timestamp;
+            std::uint32_t dest_frame_id;
+            std::uint32_t ref_frame_id;
+            double quat[4]; //< Coefficients [qx, qy, qz, qw]
+            double tr[3];
+
+            static PoseRecord FromPose(const slam::Pose &pose);
+
+            slam::Pose ToPose() const;
+        };
+
+        struct IndexEntry {
+            double timestamp; //< The timestamp of the record at `record_idx`
+            std::uint64_t record_idx;
+        };
+
+        struct Footer {
+            std::uint64_t num_records = 0;
+            std::uint64_t index_offset = 0;
+            std::uint64_t num_index_entries = 0;
+            std::uint32_t index_stride = kDefaultIndexStride;
+            std::uint32_t flags = SORTED_BY_TIMESTAMP;
+            char magic[8];
+        };
+
+        static_assert(sizeof(Header) == 32);
+        static_assert(sizeof(PoseRecord) == 80);
+        static_assert(sizeof(IndexEntry) == 16);
+        static_assert(sizeof(Footer) == 40);
+
+    } // namespace binary_trajectory
+
+    /*!
+     * @brief   Writes poses into a binary trajectory file, supporting appends without rewriting the records
+     */
+    class BinaryTrajectoryWriter {
+    public:
+
+        /*!
+         * @param append If the file exists and `append` is true, new poses are appended to the existing records
+         *               Otherwise the file is (re)created
+         */
+        explicit BinaryTrajectoryWriter(const std::string &file_path, bool append = true,
+                                        std::uint32_t index_stride = binary_trajectory::kDefaultIndexStride);
+
+        // Closes the file, the errors are logged (and not thrown): call `Close` to handle them
+        ~BinaryTrajectoryWriter();
+
+        // Appends a pose to the file
+        void Append(const slam::Pose &pose);
+
+        // Appends a set of poses to the file
+        void Append(const std::vector<slam::Pose> &poses);
+
+        // Writes the index and footer, after this call the file is valid and can be read
+        // Throws a std::runtime_error if the file could not be written
+        void Flush();
+
+        // Flushes and closes the file (see `Flush`)
+        void Close();
+
+        inline size_t NumRecords() const { return footer_.num_records; }
+
+    private:
+        // Recovers the state of an existing file (rebuilding the index if the footer is missing)
+        void ReadExistingFile();
+
+        // Truncates the file after the last record (removing the index and footer before new records are appended)
+        void TruncateAfterRecords();
+
+        std::string file_path_;
+        std::fstream file_;
+        binary_trajectory::Footer footer_;
+        std::vector<binary_trajectory::IndexEntry> index_;
+        double last_timestamp_ = std::numeric_limits<double>::lowest();
+        bool is_dirty_ = false;
+        bool has_trailer_ = false; //< Whether data (index, footer or a partial record) follows the records
+    };
+
+    /*!
+     * @brief   Reads a binary trajectory file with random access (the file is mapped in memory)
+     */
+    class BinaryTrajectoryReader {
+    public:
+        explicit BinaryTrajectoryReader(const std::string &file_path);
+
+        inline size_t NumPoses() const { return footer_.num_records; }
+
+        inline bool IsSortedByTimestamp() const {
+            return footer_.flags & binary_trajectory::SORTED_BY_TIMESTAMP;
+        }
+
+        // Returns a reference to the record at `index` (pointing to the mapped memory)
+        const binary_trajectory::PoseRecord &RecordAt(size_t index) const;
+
+        // Returns the pose at `index`
+        inline slam::Pose PoseAt(size_t index) const { return RecordAt(index).ToPose(); }
+
+        /*!
+         * @returns The index of the first pose with a timestamp greater or equal to `timestamp`
+         *          Or an empty optional if no such pose exists
+         *
+         * @note    Requires the records to be sorted by timestamp
+         */
+        std::optional<size_t> LowerBoundTimestamp(double timestamp) const;
+
+        // Returns the poses of indices in [begin, end)
+        std::vector<slam::Pose> ReadPoses(size_t begin = 0,
+                                          size_t end = std::numeric_limits<size_t>::max()) const;
+
+    private:
+        std::unique_ptr<MemoryMappedFile> file_;
+        binary_trajectory::Footer footer_;
+        const binary_trajectory::PoseRecord *records_ = nullptr;
+        const binary_trajectory::IndexEntry *index_ = nullptr;
+    };
+
+    // Saves poses to a binary trajectory file (overwrites the file if it exists)
+    void SavePosesBinary(const std::string &file_path, const std::vector<slam::Pose> &poses);
+
+    // Appends poses to a binary trajectory file (creates the file if it does not exist)
+    void AppendPosesBinary(const std::string &file_path, const std::vector<slam::Pose> &poses);
+
+    // Reads all poses from a binary trajectory file
+    std::vector<slam::Pose> ReadPosesBinary(const std::string &file_path);
+
+    /*!
+     * @brief   Converts a trajectory file between the binary, PLY and KITTI formats
+     *
+     * The formats are deduced from the extensions of the files (`.bin`, `.ply` or `.txt` for KITTI).
+     * The conversions between the binary and PLY formats are lossless. The KITTI format only stores the pose
+     * matrices: its timestamps and frame ids are regenerated when it is read (see `LoadPosesKITTIFormat`).
+     */
+    void ConvertTrajectoryFile(const std::string &input_file_path, const std::string &output_file_path);
+
+} // namespace slam
+
+#endif //SlamCore_BINARY_TRAJECTORY_H
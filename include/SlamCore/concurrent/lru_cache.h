@@ -0,0 +1,155 @@
+#ifndef SLAMCORE_LRU_CACHE_H
+#define SLAMCORE_LRU_CACHE_H
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "SlamCore/types.h"
+
+
+namespace slam {
+
+    /*!
+     * @brief   A Thread-Safe Least Recently Used cache
+     *
+     * When the cache exceeds its capacity, the least recently accessed items are evicted
+     *
+     * @tparam KeyT     The type of the keys (must be hashable)
+     * @tparam ValueT   The type of the values stored (copied when accessed)
+     */
+    template<typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>>
+    class lru_cache {
+    public:
+
+        explicit lru_cache(size_t max_capacity = 100) : max_capacity_(max_capacity) {}
+
+        // Returns a copy of the value associated to `key` (and marks it as the most recently used), or {}
+        std::optional<ValueT> get(const KeyT &key);
+
+        // Inserts or replaces the value associated to `key`
+        void put(const KeyT &key, const ValueT &value);
+
+        // Whether the cache contains `key` (does not modify the order of the items)
+        bool contains(const KeyT &key) const;
+
+        // Removes the value associated to `key`
+        void erase(const KeyT &key);
+
+        // Removes all elements from the cache
+        void clear();
+
+        // Returns the number of items in the cache
+        size_t size() const;
+
+        size_t capacity() const { return max_capacity_; }
+
+        // Sets the max capacity of the cache (evicting the least recently used items if necessary)
+        void set_max_capacity(size_t capacity);
+
+        // Returns the number of successful / failed calls to `get`
+        size_t num_hits() const { return num_hits_; }
+
+        size_t num_misses() const { return num_misses_; }
+
+    private:
+        // Removes the least recently used items until the size is below the capacity
+        void evict();
+
+        typedef std::pair<KeyT, ValueT> item_t;
+        std::list<item_t> items_; //< Items ordered from the most to the least recently used
+        std::unordered_map<KeyT, typename std::list<item_t>::iterator, HashT> map_;
+        size_t max_capacity_;
+        std::atomic<size_t> num_hits_ = 0, num_misses_ = 0;
+        mutable std::mutex mutex_;
+    };
+
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// IMPLEMENTATIONS                                                                                              ///
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    std::optional<ValueT> lru_cache<KeyT, ValueT, HashT>::get(const KeyT &key) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            num_misses_++;
+            return {};
+        }
+        num_hits_++;
+        items_.splice(items_.begin(), items_, it->second);
+        return it->second->second;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    void lru_cache<KeyT, ValueT, HashT>::put(const KeyT &key, const ValueT &value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            it->second->second = value;
+            items_.splice(items_.begin(), items_, it->second);
+            return;
+        }
+        items_.emplace_front(key, value);
+        map_[key] = items_.begin();
+        evict();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    bool lru_cache<KeyT, ValueT, HashT>::contains(const KeyT &key) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return map_.find(key) != map_.end();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    void lru_cache<KeyT, ValueT, HashT>::erase(const KeyT &key) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end())
+            return;
+        items_.erase(it->second);
+        map_.erase(it);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    void lru_cache<KeyT, ValueT, HashT>::clear() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        items_.clear();
+        map_.clear();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    size_t lru_cache<KeyT, ValueT, HashT>::size() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    void lru_cache<KeyT, ValueT, HashT>::set_max_capacity(size_t capacity) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        max_capacity_ = capacity;
+        evict();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    template<typename KeyT, typename ValueT, typename HashT>
+    void lru_cache<KeyT, ValueT, HashT>::evict() {
+        while (items_.size() > max_capacity_) {
+            map_.erase(items_.back().first);
+            items_.pop_back();
+        }
+    }
+
+}
+
+#endif //SLAMCORE_LRU_CACHE_H
@@ -10,6 +10,7 @@
 
 #include "SlamCore/utils.h"
 #include "SlamCore/data/schema.h"
+#include "SlamCore/data/buffer_pool.h"
 
 namespace slam {
 
@@ -28,6 +29,9 @@ namespace slam {
         // Whether the Items Buffer is resizable
         virtual bool IsResizable() const { return false; }
 
+        // Whether the Items Buffer owns its data (or keeps it alive), ie whether it remains valid without its source
+        virtual bool OwnsData() const { return false; }
+
         // Removes an Item from the schema
         // Note, this does not actually change the layout of the data
         void RemoveElementFromSchema(const std::string &element_name);
@@ -65,6 +69,9 @@ namespace slam {
     /*!
      * @brief   A ResizableBuffer provides an interface for resizable buffer managing their own memory.
      *          It provides a vector like interface for managing the memory of its items.
+     *
+     * As for a std::vector, the capacity of the buffer (the number of items it can hold without reallocating)
+     * grows geometrically when items are inserted, and can be set explicitly with `Reserve`.
      */
     struct ResizableBuffer : ItemBuffer {
 
@@ -85,6 +92,9 @@ namespace slam {
         // Reserves an additional `num_items` into the buffer
         virtual void ReserveAdditional(size_t num_items) = 0;
 
+        // Returns the number of items the buffer can hold without reallocating its memory
+        virtual size_t Capacity() const = 0;
+
         // Inserts num_items into the buffer
         virtual void InsertItems(size_t num_items, const char *items_data = nullptr) = 0;
 
@@ -103,21 +113,37 @@ namespace slam {
         inline size_t Size() const { return NumItems(); }
 
         bool IsResizable() const final { return true; }
+
+        bool OwnsData() const final { return true; }
     };
 
 
     /*!
      * @brief   A VectorBuffer if a Resizable buffer which stores its data on a heap allocated vector of bytes
+     *
+     * A VectorBuffer can be attached to a BufferPool: its first allocation is then taken from the pool,
+     * and its memory is returned to the pool when the buffer is destroyed.
      */
     class VectorBuffer : public ResizableBuffer {
     private:
         std::vector<char> data;
+        std::shared_ptr<BufferPool> pool_ = nullptr;
+
+        // Grows the capacity of the byte array to at least `num_bytes`
+        void Grow(size_t num_bytes, bool geometric_growth);
+
+        // Updates the view pointer after a (possible) reallocation
+        void UpdateDataPtr();
+
     public:
         ~VectorBuffer() override;
 
         explicit VectorBuffer(ItemSchema &&schema, int item_size)
                 : ResizableBuffer(std::move(schema), item_size) {}
 
+        explicit VectorBuffer(ItemSchema &&schema, int item_size, std::shared_ptr<BufferPool> pool)
+                : ResizableBuffer(std::move(schema), item_size), pool_(std::move(pool)) {}
+
         template<typename T, typename Alloc_ = std::allocator<T>>
         static VectorBuffer Copy(std::vector<T, Alloc_> &items,
                                  ItemSchema &&info);
@@ -135,11 +161,20 @@ namespace slam {
         // Reserves an additional `num_items` into the buffer
         void ReserveAdditional(size_t num_items) override;
 
+        size_t Capacity() const override;
+
+        // Releases the unused capacity of the buffer
+        void ShrinkToFit();
+
+        // Returns the pool of the buffer (nullptr if the buffer is allocated on the heap)
+        inline const std::shared_ptr<BufferPool> &Pool() const { return pool_; }
+
         // Returns a Deep Copy of a given ItemBuffer
         VectorBuffer static DeepCopy(const ItemBuffer &other);
 
-        // Returns a Deep Copy of a given ItemBuffer
-        std::unique_ptr<VectorBuffer> static DeepCopyPtr(const ItemBuffer &other);
+        // Returns a Deep Copy of a given ItemBuffer (allocated from `pool` if it is defined)
+        std::unique_ptr<VectorBuffer> static DeepCopyPtr(const ItemBuffer &other,
+                                                         std::shared_ptr<BufferPool> pool = nullptr);
 
     };
 
@@ -180,6 +215,8 @@ namespace slam {
         // Reserves an additional `num_items` into the buffer
         void ReserveAdditional(size_t num_items) override;;
 
+        size_t Capacity() const override { return capacity_; }
+
     };
 
 
@@ -235,6 +272,8 @@ namespace slam {
 
         bool IsResizable() const override { return false; }
 
+        bool OwnsData() const override { return smart_data_ptr_ != nullptr; }
+
         size_t NumItems() const override { return num_items_; }
     };
 
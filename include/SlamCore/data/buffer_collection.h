@@ -12,6 +12,10 @@ namespace slam {
      * @brief A BufferCollection wraps a vector of ItemBuffer pointers,
      *
      * It provides helping functions for their manipulation, without modifying the data's topology
+     *
+     * The item buffers can be shared between collections (see `ShallowCopy`), with copy-on-write semantics:
+     * A shared buffer is detached (ie deep copied) by every non-const method giving access to its data or schema.
+     * Views obtained before a shallow copy still point to the shared buffers.
      */
     class BufferCollection {
     public:
@@ -19,6 +23,15 @@ namespace slam {
 
         explicit BufferCollection(ItemBufferPtr &&buffer_ptr);
 
+        BufferCollection(BufferCollection &&) = default;
+
+        BufferCollection &operator=(BufferCollection &&) = default;
+
+        // Copies are explicit (see `ShallowCopy` and `DeepCopy`)
+        BufferCollection(const BufferCollection &) = delete;
+
+        BufferCollection &operator=(const BufferCollection &) = delete;
+
         // A static Factory to build a collection from an arbitrary number of item buffers rvalue references
         template<typename BufferT, typename ...Args>
         static BufferCollection Factory(std::unique_ptr<BufferT> &&ptr,
@@ -92,6 +105,9 @@ namespace slam {
         // Returns element
         const ElementInfo &GetElement(const std::string &element) const;
 
+        // Whether the item buffer at index `item_index` is shared with another collection
+        bool IsShared(size_t item_index) const;
+
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         /// Buffer Management
         ///
@@ -120,6 +136,9 @@ namespace slam {
         // Reserves the size for all buffers
         void Reserve(size_t new_size);
 
+        // Returns the number of items which can be held by all buffers without reallocating
+        size_t Capacity() const;
+
         // Inserts `num_items` with default data (zeros characters)
         void InsertItems(size_t num_items);
 
@@ -147,8 +166,44 @@ namespace slam {
          */
         BufferCollection SelectItems(const std::vector<size_t> &indices) const;
 
+        /**
+         * @returns A buffer collection containing copies of the selected point indices,
+         *          Restricted to the elements in `element_names` (laid out contiguously in new VectorBuffers)
+         */
+        BufferCollection SelectItems(const std::vector<size_t> &indices,
+                                     const std::vector<std::string> &element_names) const;
+
+        /**
+         * @returns A shallow copy of the collection, sharing its item buffers (which are copied on write)
+         *
+         * @note    The buffers which do not own their data (e.g. wrapping a vector) are deep copied,
+         *          so that the copy remains valid after the wrapped data is freed
+         */
+        BufferCollection ShallowCopy() const;
+
+        /**
+         * @returns A projection of the collection on the elements in `element_names`
+         *
+         * Item buffers with all their elements selected are shared with the returned collection (copied on write),
+         * The elements selected from other item buffers are copied in new VectorBuffers
+         */
+        BufferCollection SelectElements(const std::vector<std::string> &element_names) const;
+
     private:
-        std::vector<ItemBufferPtr> item_buffers;
+        typedef std::shared_ptr<ItemBuffer> SharedItemBufferPtr;
+        std::vector<SharedItemBufferPtr> item_buffers;
+
+        explicit BufferCollection(std::vector<SharedItemBufferPtr> &&buffer_ptr);
+
+        // Deep copies the item buffer at `item_index` if it is shared with another collection
+        void Detach(size_t item_index);
+
+        // Detaches all item buffers
+        void DetachAll();
+
+        // Returns the schema of the selected elements of an item buffer, laid out contiguously
+        static std::optional<ItemSchema> ProjectSchema(const ItemSchema &schema,
+                                                       const std::vector<std::string> &element_names);
 
         // Returns whether the sizes are consistent
         static bool AreSizesConsistent(const std::vector<ItemBufferPtr> &buffer);
@@ -195,6 +250,7 @@ namespace slam {
 
     template<typename T>
     View<T> BufferCollection::element(const std::string &element_name) {
+        Detach(GetItemIndex(element_name));
         BUFFER_COLLECTION_ELEMENT_FUNCTION
     }
 
@@ -217,6 +273,7 @@ namespace slam {
 
     template<typename T>
     View<T> BufferCollection::property(const std::string &element_name, const std::string &property_name) {
+        Detach(GetItemIndex(element_name));
         BUFFER_COLLECTION_PROPERTY_METHOD
     }
 
@@ -236,6 +293,7 @@ namespace slam {
 
     template<typename T>
     View<T> BufferCollection::item(size_t index) {
+        Detach(index);
         BUFFER_COLLECTION_ITEM_METHOD
     }
 
@@ -257,6 +315,7 @@ namespace slam {
 
     template<typename T>
     ProxyView<T> BufferCollection::element_proxy(const std::string &element_name) {
+        Detach(GetItemIndex(element_name));
         BUFFER_COLLECTION_ELEMENT_PROXY_METHOD
     }
 
@@ -281,6 +340,7 @@ namespace slam {
     ProxyView<T> BufferCollection::property_proxy(const std::string &element_name,
                                                   const std::string &property_name,
                                                   int property_dim) {
+        Detach(GetItemIndex(element_name));
         BUFFER_COLLECTION_PROPERTY_PROXY_METHOD
     }
 
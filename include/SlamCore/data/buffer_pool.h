@@ -0,0 +1,70 @@
+#ifndef SlamCore_BUFFER_POOL_H
+#define SlamCore_BUFFER_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace slam {
+
+    /*!
+     * @brief   A BufferPool recycles the byte arrays of released buffers.
+     *
+     * Point clouds of consecutive frames have similar sizes: a VectorBuffer attached to a pool returns its memory
+     * to the pool when it is destroyed, and acquires the memory of its first allocation from the pool.
+     * This avoids the allocations (and page faults) of a new frame buffer for every frame in the loaders.
+     *
+     * @note    This class is thread-safe
+     */
+    class BufferPool {
+    public:
+
+        struct Options {
+            size_t max_num_buffers = 16; //< The maximum number of byte arrays kept in the pool
+
+            size_t max_total_bytes = size_t(512) << 20; //< The maximum memory (in bytes) kept in the pool
+        };
+
+        explicit BufferPool(const Options &options) : options_(options) {}
+
+        BufferPool() : BufferPool(Options()) {}
+
+        // Returns the process-wide pool, used by the dataset loaders
+        static std::shared_ptr<BufferPool> DefaultPool();
+
+        // Returns an empty byte array with a capacity of at least `num_bytes`
+        // (the smallest pooled array large enough, or a newly allocated one)
+        std::vector<char> Acquire(size_t num_bytes);
+
+        // Returns a byte array to the pool (dropped if the pool is full)
+        void Release(std::vector<char> &&data);
+
+        // Frees all the byte arrays in the pool
+        void Clear();
+
+        // Returns the number of byte arrays in the pool
+        size_t NumPooledBuffers() const;
+
+        // Returns the memory held by the pool (in bytes)
+        size_t PooledBytes() const;
+
+        // Returns the number of calls to `Acquire` satisfied by a pooled byte array
+        inline size_t NumRecycled() const { return num_recycled_; }
+
+        // Returns the number of calls to `Acquire` which required a new allocation
+        inline size_t NumAllocated() const { return num_allocated_; }
+
+        inline const Options &GetOptions() const { return options_; }
+
+    private:
+        Options options_;
+        std::vector<std::vector<char>> buffers_;
+        size_t pooled_bytes_ = 0;
+        std::atomic<size_t> num_recycled_ = 0, num_allocated_ = 0;
+        mutable std::mutex mutex_;
+    };
+
+} // namespace slam
+
+#endif //SlamCore_BUFFER_POOL_H
@@ -0,0 +1,92 @@
+#ifndef SlamCore_SCHEMA_CONVERTER_H
+#define SlamCore_SCHEMA_CONVERTER_H
+
+#include <memory>
+#include <vector>
+
+#include "SlamCore/data/schema.h"
+
+namespace slam {
+
+    /*!
+     * @brief   A function copying `num_items` scalars from a strided source to a strided destination,
+     *          converting each scalar from the source type to the destination type
+     */
+    typedef void (*StridedScalarCopyFunction)(const char *source, size_t source_stride,
+                                              char *dest, size_t dest_stride, size_t num_items);
+
+    // Returns the strided copy function between two property types (selected once, without a per-scalar switch)
+    StridedScalarCopyFunction GetStridedScalarCopyFunction(PROPERTY_TYPE source_type, PROPERTY_TYPE dest_type);
+
+    // Returns a string uniquely identifying the memory layout of a schema
+    std::string SchemaSignature(const ItemSchema &schema);
+
+    // Whether two schemas have the same memory layout (same item size, and same property types at the same offsets),
+    // whatever the names of their elements and properties
+    bool HaveSameLayout(const ItemSchema &lhs, const ItemSchema &rhs);
+
+    /*!
+     * @brief   A SchemaConverter is a compiled copy plan between the layouts of two ItemSchema
+     *
+     * The properties of the destination schema are matched by (element name, property name) in the source schema.
+     * The plan consists in a list of operations, computed once for each pair of schemas:
+     *  - MEMCPY operations copy contiguous runs of bytes, when the types and layout of the properties match
+     *    (consecutive properties with the same relative layout are merged in a single run)
+     *  - CONVERT operations cast consecutive scalars from one type to another (e.g. float to double)
+     *
+     * Operations are applied column by column on all items, so that each loop has a fixed type and stride.
+     */
+    class SchemaConverter {
+    public:
+
+        struct Operation {
+            enum TYPE {
+                MEMCPY,
+                CONVERT
+            } type = MEMCPY;
+
+            int source_offset = 0; //< Offset of the first byte in the source item
+            int dest_offset = 0; //< Offset of the first byte in the destination item
+            int num_bytes = 0; //< The number of bytes written in the destination item
+            int dimension = 1; //< The number of scalars converted (CONVERT operations only)
+            PROPERTY_TYPE source_type = FLOAT32, dest_type = FLOAT32;
+            StridedScalarCopyFunction function = nullptr; //< The function converting a scalar column
+        };
+
+        // Builds the copy plan between the two schemas
+        SchemaConverter(const ItemSchema &source, const ItemSchema &dest);
+
+        /*!
+         * @brief   Returns a converter from a process-wide cache of converters, indexed by pair of schemas
+         *
+         * @note    This method is thread-safe
+         */
+        static std::shared_ptr<const SchemaConverter> Get(const ItemSchema &source, const ItemSchema &dest);
+
+        // Copies `num_items` items from the source buffer to the destination buffer
+        void Convert(const char *source, char *dest, size_t num_items) const;
+
+        // Copies the items at `indices` in the source buffer to consecutive items in the destination buffer
+        void ConvertSelection(const char *source, const std::vector<size_t> &indices, char *dest) const;
+
+        // Whether every property of the destination schema is written by the plan
+        inline bool IsComplete() const { return is_complete_; }
+
+        // Whether the plan is a single copy of the whole items (in which case buffers are copied with one memcpy)
+        inline bool IsIdentity() const { return is_identity_; }
+
+        inline const std::vector<Operation> &Operations() const { return operations_; }
+
+        inline int SourceItemSize() const { return source_item_size_; }
+
+        inline int DestItemSize() const { return dest_item_size_; }
+
+    private:
+        std::vector<Operation> operations_;
+        int source_item_size_ = 0, dest_item_size_ = 0;
+        bool is_complete_ = true, is_identity_ = false;
+    };
+
+} // namespace slam
+
+#endif //SlamCore_SCHEMA_CONVERTER_H
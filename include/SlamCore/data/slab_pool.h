@@ -0,0 +1,126 @@
+#ifndef SlamCore_SLAB_POOL_H
+#define SlamCore_SLAB_POOL_H
+
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+namespace slam {
+
+    /*!
+     * @brief   A SlabPool serves small memory blocks carved from large slabs, with one free list per size class.
+     *
+     * The size classes grow by steps of 1.5x / 2x (64, 96, 128, 192, 256, ...) up to a quarter of a slab, larger
+     * requests are forwarded to `operator new`. A released block is pushed to the free list of its size class and
+     * recycled by the next allocation of the same class (the slabs are only freed with the pool).
+     *
+     * This replaces the many small heap allocations of containers which grow by small steps (e.g. the points
+     * of the voxels of a map), with less fragmentation and without the allocator overhead per block.
+     *
+     * @note    This class is not thread-safe
+     */
+    class SlabPool {
+    public:
+
+        struct Options {
+            size_t slab_size = size_t(64) << 10; //< The size (in bytes) of the slabs allocated by the pool
+        };
+
+        struct Stats {
+            size_t num_slabs = 0; //< The number of slabs allocated
+            size_t reserved_bytes = 0; //< The memory reserved by the pool (slabs and large blocks)
+            size_t allocated_bytes = 0; //< The memory of the blocks in use (rounded up to their size class)
+            size_t requested_bytes = 0; //< The memory requested for the blocks in use
+            size_t num_blocks = 0; //< The number of blocks in use
+            size_t num_recycled = 0; //< The number of allocations served from a free list
+            size_t num_allocations = 0; //< The total number of allocations
+
+            // The fraction of the reserved memory which is not used by the requested blocks
+            inline double Fragmentation() const {
+                return reserved_bytes == 0 ? 0. : 1. - double(requested_bytes) / double(reserved_bytes);
+            }
+        };
+
+        explicit SlabPool(const Options &options);
+
+        SlabPool() : SlabPool(Options()) {}
+
+        ~SlabPool();
+
+        SlabPool(const SlabPool &) = delete;
+
+        SlabPool &operator=(const SlabPool &) = delete;
+
+        // Returns a block of at least `num_bytes` (aligned for any fundamental type)
+        void *Allocate(size_t num_bytes);
+
+        // Returns a block to the pool (`num_bytes` must be the size passed to `Allocate`)
+        void Deallocate(void *ptr, size_t num_bytes);
+
+        // Returns the size of the blocks served for a request of `num_bytes`
+        size_t BlockSize(size_t num_bytes) const;
+
+        inline const Stats &GetStats() const { return stats_; }
+
+        inline const Options &GetOptions() const { return options_; }
+
+    private:
+        // Returns the index of the smallest size class of at least `num_bytes`
+        size_t SizeClass(size_t num_bytes) const;
+
+        // Pushes the remaining memory of the current slab to the free lists of the smaller size classes
+        void RecycleSlabRemainder();
+
+        Options options_;
+        Stats stats_;
+        std::vector<size_t> class_sizes_;
+        std::vector<void *> free_lists_; //< The heads of the intrusive free lists of each size class
+        std::vector<std::unique_ptr<char[]>> slabs_;
+        char *slab_cursor_ = nullptr, *slab_end_ = nullptr;
+    };
+
+    /*!
+     * @brief   A standard allocator serving the memory of a container from a SlabPool
+     *
+     * A default-constructed allocator (without pool) falls back to `operator new`.
+     * The allocator propagates with the container, so that a block always returns to the pool which allocated it.
+     */
+    template<typename T>
+    struct SlabAllocator {
+        typedef T value_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        SlabAllocator() = default;
+
+        explicit SlabAllocator(SlabPool *pool) : pool(pool) {}
+
+        template<typename U>
+        SlabAllocator(const SlabAllocator<U> &other) : pool(other.pool) {}
+
+        T *allocate(size_t n) {
+            if (pool)
+                return static_cast<T *>(pool->Allocate(n * sizeof(T)));
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T *ptr, size_t n) {
+            if (pool)
+                pool->Deallocate(ptr, n * sizeof(T));
+            else
+                ::operator delete(ptr);
+        }
+
+        template<typename U>
+        bool operator==(const SlabAllocator<U> &other) const { return pool == other.pool; }
+
+        template<typename U>
+        bool operator!=(const SlabAllocator<U> &other) const { return pool != other.pool; }
+
+        SlabPool *pool = nullptr;
+    };
+
+} // namespace slam
+
+#endif //SlamCore_SLAB_POOL_H
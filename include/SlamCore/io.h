@@ -106,7 +106,9 @@ namespace slam {
         };
 
         // Creates a buffer collection for the items corresponding to the ItemSchema of this Schema Mapper
-        slam::BufferCollection AllocateBufferCollection(size_t num_items = 0) const;
+        // The memory of the buffers is taken from (and returned to) the `pool` if it is not null
+        slam::BufferCollection AllocateBufferCollection(size_t num_items = 0,
+                                                        std::shared_ptr<BufferPool> pool = nullptr) const;
 
         // Returns the slam::ItemSchema's associated with the mapper
         const std::vector<slam::ItemSchema> &GetItemSchemas() const;
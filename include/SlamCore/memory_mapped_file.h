@@ -0,0 +1,59 @@
+#ifndef SlamCore_MEMORY_MAPPED_FILE_H
+#define SlamCore_MEMORY_MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "SlamCore/utils.h"
+
+namespace slam {
+
+    /*!
+     * @brief   A MemoryMappedFile gives a read-only access to the bytes of a file on disk
+     *
+     * On POSIX platforms, the file is mapped in memory (and the pages are loaded lazily by the OS),
+     * On other platforms, the file is read entirely into a heap allocated buffer.
+     *
+     * @note    The mapping is only valid as long as the file is not truncated by another process
+     */
+    class MemoryMappedFile {
+    public:
+        explicit MemoryMappedFile(const std::string &file_path);
+
+        ~MemoryMappedFile();
+
+        MemoryMappedFile(const MemoryMappedFile &) = delete;
+
+        MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+        // Returns a pointer to the first byte of the file
+        inline const char *Data() const { return data_; }
+
+        // Returns the size in bytes of the file
+        inline size_t Size() const { return size_; }
+
+        // Returns a pointer to the byte at `offset` in the file
+        inline const char *At(size_t offset) const {
+            SLAM_CHECK_STREAM(offset <= size_, "Offset " << offset << " out of the file of size " << size_);
+            return data_ + offset;
+        }
+
+        // Whether the file is effectively mapped in memory (or was read into a buffer)
+        inline bool IsMapped() const { return is_mapped_; }
+
+        const std::string &FilePath() const { return file_path_; }
+
+    private:
+        std::string file_path_;
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        bool is_mapped_ = false;
+        std::vector<char> buffer_; //< Fallback buffer on platforms without mmap support
+    };
+
+    typedef std::shared_ptr<MemoryMappedFile> MemoryMappedFilePtr;
+
+} // namespace slam
+
+#endif //SlamCore_MEMORY_MAPPED_FILE_H
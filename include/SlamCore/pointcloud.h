@@ -100,7 +100,8 @@ namespace slam {
         template<typename PointT, typename ScalarT = float>
         std::enable_if_t<std::is_same_v<decltype(PointT::xyz), Eigen::Matrix<ScalarT, 3, 1>>,
                 slam::PointCloudPtr> static MakeEmptyPointCloud(std::optional<slam::ItemSchema> schema = {},
-                                                                const std::string &xyz_element = "vertex");
+                                                                const std::string &xyz_element = "vertex",
+                                                                std::shared_ptr<BufferPool> pool = nullptr);
 
         /**
          * @returns Register default fields from the schema
@@ -342,13 +343,29 @@ namespace slam {
          */
         slam::PointCloudPtr SelectPoints(const std::vector<size_t> &indices) const;
 
-        // TODO: Make a filter API to avoid copying the selected point cloud
+        /**
+         * @returns A PointCloud managing its own memory, copying only the elements in `element_names`
+         *          (and the XYZ element) for the corresponding indices
+         *
+         * @note    Fields which are not defined by the selected elements are not registered in the result
+         */
+        slam::PointCloudPtr SelectPoints(const std::vector<size_t> &indices,
+                                         const std::vector<std::string> &element_names) const;
+
+        /**
+         * @returns A PointCloud restricted to the elements in `element_names` (and the XYZ element)
+         *
+         * The item buffers with all their elements selected are shared (copied on write),
+         * The selected elements of other buffers are copied.
+         */
+        slam::PointCloudPtr SelectElements(const std::vector<std::string> &element_names) const;
 
         bool HaveSameSchema(const slam::PointCloud &other) const;
 
         /**
          * @brief Appends the point cloud to the current point cloud.
-         * @note  Requires that the two point clouds have the same underlying schema
+         * @note  Requires that the items of the two point clouds have compatible schemas:
+         *        properties are matched by name (and converted if their types differ)
          */
         void AppendPointCloud(const slam::PointCloud &cloud);
 
@@ -365,6 +382,9 @@ namespace slam {
 
         void reserve(size_t new_size);
 
+        // Returns the number of points the point cloud can hold without reallocating its buffers
+        size_t capacity() const;
+
         template<typename T>
         void PushBackElement(const std::string &element_name, const T &element);;
 
@@ -383,6 +403,15 @@ namespace slam {
         // Makes a Deep Copy of the PointCloud (all buffers will be copied)
         PointCloudPtr DeepCopyPtr() const;
 
+        /**
+         * @returns A Shallow Copy of the PointCloud, sharing the buffers of the point cloud
+         *
+         * @note    The buffers are copied on write: the first non-const access to a shared buffer (by any of the
+         *          point clouds sharing it) makes a deep copy of the buffer. Const accesses never copy the data.
+         *          The buffers which do not own their data (see `WrapVector`) are deep copied immediately.
+         */
+        PointCloudPtr ShallowCopyPtr() const;
+
         /**
          * @returns A Resizable PointCloud with the same schema than the current point cloud
          */
@@ -421,6 +450,9 @@ namespace slam {
     private:
         BufferCollection collection_;
 
+        // Copies the fields of `cloud` which are defined in the collection of the point cloud
+        void CopyFieldsFrom(const PointCloud &cloud);
+
         // Fields (optional and required)
         Field xyz_; //< Required field
         std::map<std::string, Field> registered_fields_;
@@ -701,7 +733,8 @@ namespace slam {
     template<typename PointT, typename ScalarT>
     std::enable_if_t<std::is_same_v<decltype(PointT::xyz), Eigen::Matrix<ScalarT, 3, 1>>,
             slam::PointCloudPtr> PointCloud::MakeEmptyPointCloud(std::optional<slam::ItemSchema> schema,
-                                                                 const std::string &xyz_element) {
+                                                                 const std::string &xyz_element,
+                                                                 std::shared_ptr<BufferPool> pool) {
         slam::ItemSchema::Builder builder(sizeof(PointT));
         bool add_xyz_element = true;
         if (schema && schema->HasElement(xyz_element)) {
@@ -719,7 +752,7 @@ namespace slam {
                                 offset_of_x + 2 * sizeof(ScalarT),
                                 1);
         }
-        auto item_buffer = std::make_unique<slam::VectorBuffer>(builder.Build(), sizeof(PointT));
+        auto item_buffer = std::make_unique<slam::VectorBuffer>(builder.Build(), sizeof(PointT), std::move(pool));
         auto buffer_collection = slam::BufferCollection(std::move(item_buffer));
         return std::make_shared<slam::PointCloud>(std::move(buffer_collection), std::string(xyz_element));
     }
@@ -81,10 +81,44 @@ namespace slam {
             return x < other.x || (x == other.x && (y < other.y || (y == other.y && z < other.z)));
         }
 
+        // Returns the coordinates of the voxel containing `point` (voxels are the cells [k, k+1) * voxel_size)
         static Voxel Coordinates(const Eigen::Vector3d &point, double voxel_size);
 
+        static constexpr int kNumBitsPerAxis = 21;
+        static constexpr int kMinCoordinate = -(1 << (kNumBitsPerAxis - 1));
+        static constexpr int kMaxCoordinate = (1 << (kNumBitsPerAxis - 1)) - 1;
+
+        // Returns the packed 64-bit key of the voxel (21 bits per axis, offset to be positive)
+        // The coordinates must lie in [kMinCoordinate, kMaxCoordinate]
+        inline uint64_t Key() const {
+            constexpr uint64_t kMask = (uint64_t(1) << kNumBitsPerAxis) - 1;
+            return (uint64_t(uint32_t(x - kMinCoordinate)) & kMask) |
+                   ((uint64_t(uint32_t(y - kMinCoordinate)) & kMask) << kNumBitsPerAxis) |
+                   ((uint64_t(uint32_t(z - kMinCoordinate)) & kMask) << (2 * kNumBitsPerAxis));
+        }
+
+        // Returns the voxel from its packed key (see `Key`)
+        static inline Voxel FromKey(uint64_t key) {
+            constexpr uint64_t kMask = (uint64_t(1) << kNumBitsPerAxis) - 1;
+            return Voxel(int(key & kMask) + kMinCoordinate,
+                         int((key >> kNumBitsPerAxis) & kMask) + kMinCoordinate,
+                         int((key >> (2 * kNumBitsPerAxis)) & kMask) + kMinCoordinate);
+        }
+
     };
 
+    // @brief   Mixes the bits of a 64-bit key (the splitmix64 finalizer)
+    //          Every bit of the key affects every bit of the hash, so that the neighboring voxels of a map
+    //          are spread over the buckets of a hash table, even for tables indexed by the lower bits of the hash
+    inline uint64_t MixKey(uint64_t key) {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ull;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebull;
+        key ^= key >> 31;
+        return key;
+    }
+
     template<typename T> using Quat = Eigen::Quaternion<T>;
     template<typename T> using Tr = Eigen::Matrix<T, 3, 1>;
     template<typename T> using Vec3 = Eigen::Matrix<T, 3, 1>;
@@ -611,13 +645,7 @@ namespace std {
     template<>
     struct hash<slam::Voxel> {
         std::size_t operator()(const slam::Voxel &vox) const {
-            // const std::hash<int32_t> hasher;
-            const size_t kP1 = 73856093;
-            const size_t kP2 = 19349669;
-            const size_t kP3 = 83492791;
-
-            // return ((hasher(vox.x) ^ (hasher(vox.y) << 1)) >> 1) ^ (hasher(vox.z) << 1) >> 1;
-            return vox.x * kP1 + vox.y * kP2 + vox.z * kP3;
+            return std::size_t(slam::MixKey(vox.Key()));
         }
     };
 }
@@ -1,6 +1,9 @@
 #ifndef CT_ICP_COST_FUNCTIONS_H
 #define CT_ICP_COST_FUNCTIONS_H
 
+#include <memory>
+
+#include <ceres/cost_function.h>
 #include <ceres/loss_function.h>
 #include <Eigen/Dense>
 
@@ -23,9 +26,44 @@ namespace ct_icp {
         POINT_TO_PLANE,
         POINT_TO_POINT,
         POINT_TO_LINE,
-        POINT_TO_DISTRIBUTION
+        POINT_TO_DISTRIBUTION,
+        DISTRIBUTION_TO_DISTRIBUTION //< Generalized-ICP, using the distributions cached by the map when available
     };
 
+    /*!
+     * @brief Regularizes a covariance in the GICP fashion
+     *
+     * The eigenvalues are normalized by the largest one and clamped to `epsilon`, then rescaled so that the smallest
+     * is 1: residuals whitened by the regularized covariance are distances along the normal of planar distributions.
+     *
+     * @param information_sqrt Optionally returns S such that S^T S is the inverse of the regularized covariance
+     */
+    inline Eigen::Matrix3d RegularizeCovariance(const Eigen::Matrix3d &covariance, double epsilon,
+                                                Eigen::Matrix3d *information_sqrt = nullptr) {
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+        Eigen::Vector3d values = solver.eigenvalues(); // Sorted in increasing order
+        const double max_value = values[2];
+        if (solver.info() != Eigen::Success || max_value <= 0.) {
+            if (information_sqrt)
+                *information_sqrt = Eigen::Matrix3d::Identity();
+            return Eigen::Matrix3d::Identity();
+        }
+        values = (values / max_value).cwiseMax(epsilon);
+        values /= values[0];
+        const auto &vectors = solver.eigenvectors();
+        if (information_sqrt)
+            *information_sqrt = values.cwiseSqrt().cwiseInverse().asDiagonal() * vectors.transpose();
+        return vectors * values.asDiagonal() * vectors.transpose();
+    }
+
+    /*!
+     * @brief Returns S such that S^T S is the inverse of a (symmetric definite positive) covariance
+     */
+    inline Eigen::Matrix3d InformationSqrt(const Eigen::Matrix3d &covariance) {
+        Eigen::LLT<Eigen::Matrix3d> llt(covariance);
+        return llt.matrixL().solve(Eigen::Matrix3d::Identity());
+    }
+
     /**
      * @brief A Point to plane functor
      */
@@ -150,11 +188,6 @@ namespace ct_icp {
                                    double weight = 1.0) : world_reference_(reference),
                                                           raw_point_(target),
                                                           weight_(weight) {
-            Eigen::JacobiSVD<Eigen::Matrix3d> svd(neighborhood.covariance);
-//             Rescale the neighborhood covariance by the largest singular value
-//            neighborhood_information_ = (neighborhood.covariance / std::abs(svd.singularValues()[0]) +
-//                                         Eigen::Matrix3d::Identity() * epsilon).inverse();
-
             neighborhood_information_ = (neighborhood.covariance +
                                          Eigen::Matrix3d::Identity() * epsilon).inverse();
         }
@@ -183,6 +216,63 @@ namespace ct_icp {
     };
 
 
+    /*!
+     * @brief A Distribution to distribution (Generalized-ICP) functor
+     *
+     * The residual is the difference between the transformed point and the mean of the target distribution,
+     * whitened by the sum of the target covariance and of the covariance of the source point (expressed in the world
+     * frame with the current estimate of the pose, which is kept constant during the optimization).
+     */
+    struct FunctorDistributionToDistribution {
+
+        static constexpr int NumResiduals() { return 3; }
+
+        typedef ceres::AutoDiffCostFunction<FunctorDistributionToDistribution, 3, 4, 3> cost_function_t;
+
+        // Builds the target distribution from the covariance of the neighborhood (without source covariance)
+        FunctorDistributionToDistribution(const Eigen::Vector3d &reference,
+                                          const Eigen::Vector3d &raw_point,
+                                          const slam::NeighborhoodDescription<double> &neighborhood,
+                                          double weight = 1.0) : mean_(neighborhood.barycenter),
+                                                                 raw_point_(raw_point),
+                                                                 weight_(weight) {
+            RegularizeCovariance(neighborhood.covariance, kDefaultEpsilon, &information_sqrt_);
+        }
+
+        // Uses the whitening matrix precomputed by the caller (see `RegularizeCovariance` and `InformationSqrt`)
+        FunctorDistributionToDistribution(const Eigen::Vector3d &raw_point,
+                                          const Eigen::Vector3d &mean,
+                                          const Eigen::Matrix3d &information_sqrt,
+                                          double weight = 1.0) : mean_(mean),
+                                                                 raw_point_(raw_point),
+                                                                 information_sqrt_(information_sqrt),
+                                                                 weight_(weight) {}
+
+        template<typename T>
+        bool operator()(const T *const rot_params, const T *const trans_params, T *residual) const {
+            Eigen::Map<Eigen::Quaternion<T>> quat(const_cast<T *>(rot_params));
+            Eigen::Matrix<T, 3, 1> transformed = quat.normalized() * raw_point_.template cast<T>();
+            transformed(0, 0) += trans_params[0];
+            transformed(1, 0) += trans_params[1];
+            transformed(2, 0) += trans_params[2];
+
+            Eigen::Map<Eigen::Matrix<T, 3, 1>> _residual(residual);
+            _residual = T(weight_) * (information_sqrt_.template cast<T>() *
+                                      (transformed - mean_.template cast<T>()));
+            return true;
+        }
+
+        static constexpr double kDefaultEpsilon = 1.e-3;
+
+        Eigen::Vector3d mean_;
+        Eigen::Vector3d raw_point_;
+        Eigen::Matrix3d information_sqrt_;
+        double weight_ = 1.0;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+
     template<typename FunctorT>
     struct CTFunctor {
 
@@ -190,12 +280,10 @@ namespace ct_icp {
 
         typedef ceres::AutoDiffCostFunction<CTFunctor<FunctorT>, FunctorT::NumResiduals(), 4, 3, 4, 3> cost_function_t;
 
-        CTFunctor(double timestamp,
-                  const Eigen::Vector3d &reference,
-                  const Eigen::Vector3d &raw_point,
-                  const slam::NeighborhoodDescription<double> &desc,
-                  double weight = 1.0)
-                : functor(reference, raw_point, desc, weight), alpha_timestamp_(timestamp) {}
+        // The arguments following the timestamp are forwarded to the constructor of the functor
+        template<typename... Args>
+        explicit CTFunctor(double timestamp, Args &&... args)
+                : functor(std::forward<Args>(args)...), alpha_timestamp_(timestamp) {}
 
         template<typename T>
         inline bool operator()(const T *const begin_rot_params, const T *begin_trans_params,
@@ -222,6 +310,49 @@ namespace ct_icp {
     };
 
 
+    /*!
+     * @brief The point-to-plane residuals of a frame packed in a single residual block
+     *
+     * The residuals are stored as a structure of arrays and evaluated, with analytic jacobians, in parallel chunks.
+     * The rotation of a point is the normalized linear interpolation of the begin and end quaternions, which matches
+     * the slerp of `CTFunctor` for the small rotations within a frame.
+     * The robust loss is applied to each residual internally: the residual r is replaced by sign(r) * sqrt(rho(r^2)),
+     * so that the cost seen by the solver is the robust cost (the block must be added without loss function).
+     *
+     * The parameter blocks are (begin_quat, begin_tr, end_quat, end_tr) for the CONTINUOUS_TIME parametrization,
+     * and (end_quat, end_tr) for the SIMPLE parametrization.
+     */
+    class PointToPlaneBundle : public ceres::CostFunction {
+    public:
+        explicit PointToPlaneBundle(POSE_PARAMETRIZATION parametrization,
+                                    std::unique_ptr<ceres::LossFunction> loss_function = nullptr,
+                                    int num_threads = 1);
+
+        void Reserve(size_t num_points);
+
+        // Adds the residual of a point (`alpha_timestamp` is ignored by the SIMPLE parametrization)
+        void AddResidual(const Eigen::Vector3d &reference,
+                         const Eigen::Vector3d &raw_point,
+                         const Eigen::Vector3d &normal,
+                         double weight = 1.0,
+                         double alpha_timestamp = 1.0);
+
+        size_t NumPoints() const { return weights_.size(); }
+
+        bool Evaluate(double const *const *parameters, double *residuals, double **jacobians) const override;
+
+    private:
+        POSE_PARAMETRIZATION parametrization_;
+        std::unique_ptr<ceres::LossFunction> loss_function_;
+        int num_threads_ = 1;
+
+        std::vector<double> raw_x_, raw_y_, raw_z_;
+        std::vector<double> normal_x_, normal_y_, normal_z_;
+        std::vector<double> offsets_; //< The dot product of the reference point and the normal
+        std::vector<double> weights_;
+        std::vector<double> alphas_;
+    };
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /// REGULARISATION COST FUNCTORS
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,7 @@
 #ifndef CT_ICP_CT_ICP_H
 #define CT_ICP_CT_ICP_H
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -32,6 +33,18 @@ namespace ct_icp {
     void grid_sampling(const std::vector<slam::WPoint3D> &frame, std::vector<slam::WPoint3D> &keypoints,
                        double size_voxel_subsampling);
 
+    typedef std::vector<Eigen::Matrix<double, 6, 1>,
+            Eigen::aligned_allocator<Eigen::Matrix<double, 6, 1>>> jacobian_rows_t;
+
+    // Selects a subset of the keypoints which preserves the information of the registration in every direction
+    // (see `CTICPOptions::observability_selection`). Returns a flag for each keypoint
+    //
+    // Each row is the (weighted) jacobian of the point-to-plane residual of a keypoint w.r.t. a rotation and
+    // a translation (around the sensor location)
+    std::vector<char> select_observable_keypoints(const jacobian_rows_t &rows,
+                                                  double information_ratio,
+                                                  int min_num_keypoints);
+
     enum CT_ICP_SOLVER {
         GN,
         CERES,
@@ -59,6 +72,18 @@ namespace ct_icp {
         /* Main Params                                                                                                */
         int num_iters_icp = 5; // The Maximum number of ICP iterations performed
 
+        struct CoarseToFineLevel {
+            int num_iters = 2; // The maximum number of ICP iterations performed at this level
+            double keypoints_ratio = 0.25; // The fraction of the keypoints registered at this level
+            double search_radius = 1.5; // The radius of the neighborhood search (selects the resolution of the map)
+        };
+
+        // The levels registered (in order, typically from the coarsest to the finest) before the fine iterations,
+        // which use all the keypoints and the neighborhood strategy of the caller
+        // The iterations of the levels are deducted from the `num_iters_icp` budget (keeping at least one fine iteration)
+        // An empty schedule disables the coarse-to-fine registration
+        std::vector<CoarseToFineLevel> coarse_to_fine_levels;
+
         POSE_PARAMETRIZATION parametrization = CONTINUOUS_TIME;
 
         ICP_DISTANCE distance = POINT_TO_PLANE;
@@ -77,6 +102,16 @@ namespace ct_icp {
 
         double weight_neighborhood = 0.1;
 
+        // Whether to select (after the first association) the subset of the keypoints preserving the information of
+        // the registration in every direction. The following iterations only use the selected keypoints
+        // Only applies to the CERES solver with the POINT_TO_PLANE distance
+        bool observability_selection = false;
+
+        // The fraction of the information preserved in each eigen direction of the hessian of the registration
+        double observability_information_ratio = 0.5;
+
+        int observability_min_num_keypoints = 200; // The minimum number of keypoints selected
+
         /* ---------------------------------------------------------------------------------------------------------- */
         /* Neighborhood Params                                                                                        */
 
@@ -121,6 +156,10 @@ namespace ct_icp {
 
         int ls_num_threads = 16;
 
+        // Whether to pack the point-to-plane residuals in a single residual block with analytic jacobians
+        // (see `PointToPlaneBundle`), which avoids the per-block overhead of ceres for large numbers of keypoints
+        bool bundle_residuals = false;
+
         double ls_sigma = 0.1; // The robust parameter (for Cauchy, Huber or truncated least square)
 
         double ls_tolerant_min_threshold = 0.05; // The Tolerant
@@ -130,12 +169,21 @@ namespace ct_icp {
 
         double max_dist_to_plane_ct_icp = 0.3; // The maximum distance point-to-plane (OLD Version of ICP)
 
+        /* ---------------------------------------------------------------------------------------------------------- */
+        /* Generalized-ICP params (DISTRIBUTION_TO_DISTRIBUTION)                                                      */
+
+        // The radius of the neighborhood (in the keypoints) defining the covariance of a keypoint
+        // The keypoints without covariance (or all if the radius is not positive) only use the covariance of the map
+        double gicp_source_radius = 2.0;
+
+        double gicp_epsilon = 1.e-3; // The regularization of the covariances of the keypoints
+
         /* ---------------------------------------------------------------------------------------------------------- */
         /* ROBUST Solver params                                                                                           */
         double threshold_linearity = 0.8; //< Threshold on linearity to for the classification of the neighborhood
         double threshold_planarity = 0.8; //< Threshold on planarity for the classification of the neighborhood
         double weight_point_to_point = 0.1; //< Weighting scheme for point-to-point residuals
-        double outlier_distance = 1.0; //< Maximum distance to consider adding the residual
+        double outlier_distance = 1.0; //< Maximum distance to consider adding the residual (also for the GICP residuals of CERES)
         bool use_barycenter = false; //< Whether to use the barycenter or the nearest neighbor for the association
         bool use_lines = true;
         bool use_distribution = true;
@@ -157,7 +205,9 @@ namespace ct_icp {
         bool success = false; // Whether the registration succeeded
 
         int num_residuals_used = 0;
-        int num_iters = 0;
+        int num_distribution_residuals = 0; // The number of Generalized-ICP residuals using the distributions of the map
+        int num_iters = 0; // The number of ICP iterations performed
+        int num_coarse_iters = 0; // The number of iterations performed by the coarse-to-fine levels
 
         std::string error_log;
 
@@ -177,6 +227,9 @@ namespace ct_icp {
 
         const CTICPOptions &Options() const { return options_; }
 
+        // Sets a flag checked at each ICP iteration: the registration stops (and fails) once the flag is raised
+        void SetCancellationFlag(const std::atomic<bool> *cancel_flag) { cancel_flag_ = cancel_flag; }
+
         ICPSummary Register(const ct_icp::ISlamMap &voxel_map,
                             std::vector<slam::WPoint3D> &keypoints,
                             TrajectoryFrame &trajectory_frame,
@@ -214,12 +267,38 @@ namespace ct_icp {
                                     const AMotionModel *motion_model = nullptr,
                                     ANeighborhoodStrategy * = nullptr);
 
+        // Registers the keypoints with the solver of the options, after the coarse-to-fine levels (if any)
+        ICPSummary RegisterWithSolver(const ct_icp::ISlamMap &voxel_map,
+                                      slam::ProxyView<Eigen::Vector3d> &raw_kpts,
+                                      slam::ProxyView<Eigen::Vector3d> &world_kpts,
+                                      slam::ProxyView<double> &timestamps,
+                                      TrajectoryFrame &trajectory_frame,
+                                      const AMotionModel *motion_model,
+                                      ANeighborhoodStrategy *strategy);
+
+        // Registers subsets of the keypoints following the coarse-to-fine schedule of the options
+        // Returns the total number of iterations performed
+        int RegisterCoarseToFine(const ct_icp::ISlamMap &voxel_map,
+                                 slam::ProxyView<Eigen::Vector3d> &raw_kpts,
+                                 slam::ProxyView<Eigen::Vector3d> &world_kpts,
+                                 slam::ProxyView<double> &timestamps,
+                                 TrajectoryFrame &trajectory_frame,
+                                 const AMotionModel *motion_model = nullptr);
+
         void TransformKeyPoints(TrajectoryFrame &frame,
                                 slam::ProxyView<Eigen::Vector3d> &raw_kpts,
                                 slam::ProxyView<Eigen::Vector3d> &world_kpts,
                                 slam::ProxyView<double> &timestamps) const;
 
+        // Whether the registration was cancelled by the owner of the cancellation flag
+        bool IsCancelled() const {
+            return cancel_flag_ != nullptr && cancel_flag_->load(std::memory_order_relaxed);
+        }
+
+        ICPSummary CancelledSummary() const;
+
         CTICPOptions options_;
+        const std::atomic<bool> *cancel_flag_ = nullptr;
     };
 
 } // namespace Elastic_ICP
@@ -2,6 +2,7 @@
 #define CT_ICP_DATASET_HPP
 
 #include <memory>
+#include <thread>
 
 #include "types.h"
 #include "ct_icp/utils.h"
@@ -10,6 +11,7 @@
 #include <SlamCore/trajectory.h>
 #include <SlamCore/experimental/synthetic.h>
 #include <SlamCore/pointcloud.h>
+#include <SlamCore/concurrent/lru_cache.h>
 
 namespace ct_icp {
 
@@ -74,12 +76,23 @@ namespace ct_icp {
         // Applies the eventual filter defined on the frame
         virtual Frame GetFrame(size_t index) const;
 
+        // Returns the frames of indices in [begin, end) in order (requires Random Access)
+        // Applies the eventual filter defined on the frames
+        virtual std::vector<Frame> GetFrames(size_t begin, size_t end) const;
+
+        // Returns (at most) the `num_frames` next frames of the sequence
+        // Reads the frames with `GetFrames` if the dataset supports random access
+        std::vector<Frame> NextFrames(size_t num_frames);
+
         // Sets a filter on the frame
         void SetFilter(std::function<void(slam::PointCloud &)> &&filter);
 
         // Remove the filter on the frame
         void ClearFilter();
 
+        // Returns the filter defined on the frame (if any)
+        const std::optional<std::function<void(slam::PointCloud &)>> &GetFilter() const { return filter_; }
+
         virtual void SetInitFrame(int frame_index) = 0;
 
         void SetMaxNumFrames(int max_num_frames) { max_num_frames_ = max_num_frames; };
@@ -177,6 +190,9 @@ namespace ct_icp {
         typedef std::function<std::string(size_t)> FilePatternFunctionType;
         typedef std::function<bool(const std::string &, const std::string &)> SortingFunctionType;
 
+        // A cache of decoded (unfiltered) frames, indexed by the path of their file
+        typedef slam::lru_cache<std::string, Frame> FrameCache;
+
         /*! @brief Reads a Frame from the disk */
         virtual Frame ReadFrame(const std::string &filename) const = 0;
 
@@ -200,6 +216,9 @@ namespace ct_icp {
         // Returns a frame at `index`. Throws an exception if the dataset does not support Random Access
         [[nodiscard]] Frame GetUnfilteredFrame(size_t index) const override;
 
+        // Reads and decodes the files of the frames in [begin, end) concurrently
+        [[nodiscard]] std::vector<Frame> GetFrames(size_t begin, size_t end) const override;
+
         // Whether the dataset support random access
         [[nodiscard]] bool WithRandomAccess() const override { return true; };
 
@@ -208,6 +227,18 @@ namespace ct_icp {
 
         void SetInitFrame(int frame_index) override;
 
+        // Returns the path of the file of the frame at `index`
+        [[nodiscard]] std::string FilePath(size_t index) const;
+
+        // Sets the number of threads used to read files in `GetFrames`
+        void SetNumReadThreads(int num_threads) { num_read_threads_ = std::max(num_threads, 1); }
+
+        // Sets the cache of decoded frames (the cache can be shared between sequences)
+        void SetFrameCache(std::shared_ptr<FrameCache> cache) { frame_cache_ = std::move(cache); }
+
+        // Returns a process-wide cache of decoded frames, which can be shared by all file sequences
+        static std::shared_ptr<FrameCache> SharedFrameCache();
+
 
     protected:
 
@@ -215,9 +246,9 @@ namespace ct_icp {
                                const std::vector<std::string> &filenames_) : ADatasetSequence(std::move(seq_info)),
                                                                              root_dir_path_(std::move(dir_path)) {
             SLAM_CHECK_STREAM(fs::exists(root_dir_path_), "The Directory " << root_dir_path_ << " does not exist");
-            file_names_.emplace(std::vector<std::string>{});
-            file_names_->reserve(filenames_.size());
+            file_names_.emplace(filenames_);
             full_sequence_size_ = file_names_->size();
+            seq_info_.sequence_size = int(full_sequence_size_);
             std::sort(file_names_->begin(), file_names_->end(), sorting_function);
         }
 
@@ -239,6 +270,8 @@ namespace ct_icp {
         std::optional<slam::LinearContinuousTrajectory> ground_truth_{};
         std::optional<FilePatternFunctionType> file_pattern_;
         size_t full_sequence_size_ = -1;
+        int num_read_threads_ = int(std::max(std::thread::hardware_concurrency(), 1u));
+        std::shared_ptr<FrameCache> frame_cache_ = nullptr;
     };
 
     /**
@@ -267,6 +300,63 @@ namespace ct_icp {
         std::optional<slam::PLYSchemaMapper> mapper_ = {}; //< The default Schema Mapper.
     };
 
+    inline std::string KITTIBinFilePattern(size_t index_file, int zero_padding = 6) {
+        std::stringstream ss;
+        ss << std::setw(zero_padding) << std::setfill('0') << index_file << ".bin";
+        return ss.str();
+    }
+
+    /**
+     * @brief The conversion parameters of the velodyne files of KITTI / KITTI-360
+     */
+    struct KITTIVelodyneOptions {
+        double frame_duration = 0.1; //< The duration of a sweep (the frame `i` spans [i, i + 1] * frame_duration)
+        double vertical_angle_offset = 0.205; //< The correction of the vertical angle (in degrees)
+        double min_z = -5.0; //< The points below are bad returns under the ground (moved to the sensor's origin)
+        bool clockwise = true; //< Whether the sensor spins clockwise (seen from above), starting from the rear
+    };
+
+    /**
+     * @brief A Sequence of the original KITTI / KITTI-360 velodyne `.bin` files (float32 x, y, z, reflectance)
+     *
+     * The files are memory-mapped and converted in a single pass, which computes the timestamp of each point
+     * from its azimuth and applies the vertical angle correction of the KITTI HDL-64 (no conversion to PLY files).
+     * The index of a frame is read from its file name (e.g. `000042.bin`).
+     */
+    class KITTIBinDirectory : public AFileSequence {
+    public:
+
+        typedef KITTIVelodyneOptions Options;
+
+        explicit KITTIBinDirectory(std::string &&root_path, SequenceInfo &&seq_info,
+                                   size_t expected_size, int zero_padding, const Options &options = Options());
+
+        explicit KITTIBinDirectory(std::string &&root_path, SequenceInfo &&seq_info,
+                                   std::vector<std::string> &&file_names, const Options &options = Options());
+
+        // Returns a sequence of all the `.bin` files of a directory
+        static std::shared_ptr<KITTIBinDirectory> PtrFromDirectoryPath(const std::string &dir_path,
+                                                                       std::optional<SequenceInfo> seq_info = {},
+                                                                       const Options &options = Options());
+
+        // Reads a velodyne `.bin` frame from disk
+        Frame ReadFrame(const std::string &filename) const override;
+
+        /*!
+         * @brief Converts the points of a velodyne file, in a single vectorized pass
+         *
+         * @param data The `num_points` points of the file, each defined by 4 float32 (x, y, z, reflectance)
+         * @param frame_index The index of the frame, which defines the interval of the timestamps
+         */
+        static slam::PointCloudPtr ConvertPoints(const float *data, size_t num_points,
+                                                 size_t frame_index, const Options &options);
+
+        REF_GETTER(GetOptions, options_)
+
+    private:
+        Options options_;
+    };
+
     struct SequenceOptions {
         std::string sequence_name; // The name of the sequence
         int start_frame_id = 0; // The first frame of the sequence
@@ -289,6 +379,8 @@ namespace ct_icp {
 
         bool use_all_datasets = true; // Whether to use all sequences, or only the ones specified in param `sequence_options`
 
+        std::string cache_directory; // Directory of the dataset cache files (see `build_dataset_cache`), used if they exist
+
         std::vector<SequenceOptions> sequence_options;
     };
 
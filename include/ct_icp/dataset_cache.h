@@ -0,0 +1,166 @@
+#ifndef CT_ICP_DATASET_CACHE_H
+#define CT_ICP_DATASET_CACHE_H
+
+#include <cstdint>
+#include <fstream>
+
+#include <SlamCore/memory_mapped_file.h>
+#include <SlamCore/binary_trajectory.h>
+
+#include "ct_icp/dataset.h"
+
+namespace ct_icp {
+
+    /*!
+     * @brief   A single file cache of the frames of a sequence, to avoid parsing a PLY file for each frame
+     *
+     * Layout of the file:
+     *
+     *  [Header (16 bytes)] [Frame 0] ... [Frame N-1] [Ground Truth Poses] [Frame Offsets] [Footer (40 bytes)]
+     *
+     *  - Each frame is a chunk: a FrameHeader followed by the columns x, y, z and the timestamps
+     *  - Coordinates are quantized at a fixed resolution relative to a per-frame origin,
+     *    each column is stored as int16 if its range allows it, int32 otherwise
+     *  - Timestamps are quantized and delta-encoded in int32 (or stored raw if the deltas overflow)
+     *  - The ground truth poses are stored as `slam::binary_trajectory::PoseRecord`
+     *  - The table of frame offsets allows random access to the frames
+     *
+     * Only the coordinates and the timestamps of the points are cached: the other fields (e.g. the intensity of the
+     * KITTI frames) are lost, so a sequence read from the cache must not depend on them.
+     * Every column starts at a multiple of 8 bytes from the beginning of the file.
+     */
+    namespace dataset_cache {
+
+        constexpr char kHeaderMagic[8] = {'C', 'T', 'P', 'C', 'A', 'C', 'H', 'E'};
+        constexpr char kFooterMagic[8] = {'C', 'T', 'P', 'C', 'C', 'E', 'N', 'D'};
+        constexpr std::uint32_t kVersion = 1;
+        constexpr const char *kFileExtension = ".ctcache";
+
+        enum TIMESTAMP_ENCODING : std::uint8_t {
+            NO_TIMESTAMPS = 0,
+            DELTA_INT32 = 1, //< Consecutive differences of the quantized timestamps
+            RAW_FLOAT64 = 2
+        };
+
+        struct Header {
+            char magic[8];
+            std::uint32_t version = kVersion;
+            std::uint32_t reserved = 0;
+        };
+
+        struct FrameHeader {
+            std::uint64_t num_points = 0;
+            double timestamp_min = -1., timestamp_max = -1.;
+            double timestamp_origin = 0.;
+            double timestamp_resolution = 1.;
+            double xyz_origin[3] = {0., 0., 0.};
+            double xyz_resolution = 1.;
+            std::uint8_t xyz_width[3] = {4, 4, 4}; //< The number of bytes of the quantized values of each column
+            std::uint8_t timestamp_encoding = NO_TIMESTAMPS;
+            std::uint8_t reserved[4] = {0, 0, 0, 0};
+        };
+
+        struct Footer {
+            std::uint64_t num_frames = 0;
+            std::uint64_t offsets_offset = 0;
+            std::uint64_t num_poses = 0;
+            std::uint64_t poses_offset = 0;
+            char magic[8];
+        };
+
+        static_assert(sizeof(Header) == 16);
+        static_assert(sizeof(FrameHeader) == 80);
+        static_assert(sizeof(Footer) == 40);
+
+        // Returns the path of the cache file of a sequence in the directory `cache_dir`
+        std::string CacheFilePath(const std::string &cache_dir, const SequenceInfo &seq_info);
+
+    } // namespace dataset_cache
+
+    /*!
+     * @brief   Writes the frames of a sequence into a dataset cache file
+     */
+    class DatasetCacheWriter {
+    public:
+        struct Options {
+            double xyz_resolution = 1.e-3; //< The quantization step of the coordinates (in meters)
+
+            double timestamp_resolution = 1.e-7; //< The quantization step of the timestamps (in seconds)
+        };
+
+        explicit DatasetCacheWriter(const std::string &file_path, const Options &options);
+
+        explicit DatasetCacheWriter(const std::string &file_path) : DatasetCacheWriter(file_path, Options()) {}
+
+        ~DatasetCacheWriter();
+
+        // Appends a frame to the cache (only the XYZ and timestamps fields are saved)
+        void AddFrame(const slam::PointCloud &pointcloud);
+
+        // Sets the ground truth poses of the sequence (written when the file is closed)
+        void SetGroundTruth(const std::vector<slam::Pose> &poses);
+
+        // Writes the ground truth, the table of frame offsets and the footer, and closes the file
+        void Close();
+
+        inline size_t NumFrames() const { return frame_offsets_.size(); }
+
+    private:
+        std::string file_path_;
+        Options options_;
+        std::ofstream file_;
+        std::vector<std::uint64_t> frame_offsets_;
+        std::vector<slam::Pose> ground_truth_;
+        std::vector<char> chunk_; //< Buffer reused for the encoding of frames
+    };
+
+    /*!
+     * @brief   Writes all frames of `sequence` (and its ground truth) into a dataset cache file
+     *
+     * @note    The frames are saved before the filter of the sequence is applied,
+     *          The filter must therefore be set again on the cached sequence
+     */
+    void WriteDatasetCache(ADatasetSequence &sequence, const std::string &file_path,
+                           const DatasetCacheWriter::Options &options = DatasetCacheWriter::Options());
+
+    /*!
+     * @brief   A Sequence reading its frames from a dataset cache file
+     *
+     * The file is mapped in memory, and each frame is decoded on demand (allowing random access)
+     */
+    class CachedSequence : public ADatasetSequence {
+    public:
+
+        explicit CachedSequence(const std::string &file_path, SequenceInfo &&seq_info);
+
+        static std::shared_ptr<CachedSequence> PtrFromFile(const std::string &file_path,
+                                                           std::optional<SequenceInfo> seq_info = {});
+
+        [[nodiscard]] bool HasNext() const override;
+
+        Frame NextUnfilteredFrame() override;
+
+        // Returns the number of frames (-1 if the total number of frames is unknown)
+        [[nodiscard]] size_t NumFrames() const override;
+
+        // Decodes the frame at `index` from the cache
+        [[nodiscard]] Frame GetUnfilteredFrame(size_t index) const override;
+
+        // Whether the dataset support random access
+        [[nodiscard]] bool WithRandomAccess() const override { return true; };
+
+        // Returns the ground truth if the dataset has a ground truth
+        std::optional<std::vector<slam::Pose>> GroundTruth() override;
+
+        void SetInitFrame(int frame_index) override;
+
+    private:
+        slam::MemoryMappedFilePtr file_;
+        dataset_cache::Footer footer_;
+        const std::uint64_t *frame_offsets_ = nullptr;
+        std::optional<slam::LinearContinuousTrajectory> ground_truth_{};
+    };
+
+} // namespace ct_icp
+
+#endif //CT_ICP_DATASET_CACHE_H
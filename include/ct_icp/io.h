@@ -10,6 +10,19 @@ namespace ct_icp {
 
     std::vector<TrajectoryFrame> LoadTrajectory(const std::string &file_path);
 
+    // Saves Trajectory Frames in a binary trajectory file (see SlamCore/binary_trajectory.h)
+    // Each frame is stored as two consecutive pose records (begin and end pose)
+    void SaveTrajectoryFrameBinary(const std::string &file_path, const std::vector<TrajectoryFrame> &);
+
+    // Appends Trajectory Frames to a binary trajectory file, without rewriting the existing frames
+    void AppendTrajectoryFrameBinary(const std::string &file_path, const std::vector<TrajectoryFrame> &);
+
+    // Loads Trajectory Frames from a binary trajectory file
+    std::vector<TrajectoryFrame> LoadTrajectoryBinary(const std::string &file_path);
+
+    // Loads the Trajectory Frame at index `frame_index` from a binary trajectory file (without reading the whole file)
+    TrajectoryFrame LoadTrajectoryFrameBinary(const std::string &file_path, size_t frame_index);
+
 } // namespace ct_icp
 
 #endif //CT_ICP_IO_H
@@ -1,14 +1,114 @@
 #ifndef CT_ICP_MAP_H
 #define CT_ICP_MAP_H
 
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
 #include <SlamCore/conversion.h>
 #include <SlamCore/experimental/map.h>
 #include <SlamCore/trajectory.h>
 #include <SlamCore/types.h>
 #include <SlamCore/config_utils.h>
+#include <SlamCore/memory_mapped_file.h>
+#include <SlamCore/data/slab_pool.h>
+#include <SlamCore/concurrent/lru_cache.h>
+#include <SlamCore/concurrent/blocking_queue.h>
 
 namespace ct_icp {
 
+    /*!
+     * @brief A region of space used to extract a subset of the map
+     *
+     * The region is the intersection of the optional box, ball and frustum defined.
+     * If the sensor location is defined, only the points with an oriented normal facing the sensor are kept.
+     */
+    struct MapRegion {
+
+        struct Frustum {
+            slam::SE3 sensor_pose; //< The pose of the sensor in the world frame (the sensor looks along its x axis)
+            double horizontal_fov = 2 * M_PI; //< The horizontal field of view (in radians)
+            double vertical_fov = M_PI; //< The vertical field of view (in radians)
+            double max_distance = 100.; //< The maximum distance to the sensor
+        };
+
+        std::optional<Eigen::AlignedBox3d> box; //< An axis-aligned box
+        std::optional<Eigen::Vector3d> center; //< The center of the ball of radius `radius`
+        double radius = std::numeric_limits<double>::max();
+        std::optional<Frustum> frustum;
+        std::optional<Eigen::Vector3d> sensor_location; //< The location used to cull points with normals facing away
+
+        // Returns the region of the points in an axis-aligned box
+        static MapRegion Box(const Eigen::Vector3d &min_corner, const Eigen::Vector3d &max_corner);
+
+        // Returns the region of the points at a distance less than `radius` from `center`
+        static MapRegion Ball(const Eigen::Vector3d &center, double radius);
+
+        // Returns the region of the points in the field of view of a sensor (with normal culling)
+        static MapRegion FromFrustum(const Frustum &frustum, bool cull_normals = true);
+
+        // Returns the region of the points with a normal facing the sensor location
+        static MapRegion VisibleFrom(const Eigen::Vector3d &sensor_location);
+
+        // Whether a point lies in the region (ignoring the normal culling)
+        bool Contains(const Eigen::Vector3d &point) const;
+
+        // Whether a point with an (optionally oriented) normal lies in the region and is visible from the sensor
+        inline bool Contains(const Eigen::Vector3d &point, const Eigen::Vector3d &normal, bool is_normal_oriented) const {
+            if (sensor_location && (!is_normal_oriented || normal.dot(point - *sensor_location) >= 0.))
+                return false;
+            return Contains(point);
+        }
+
+        // Whether the region intersects an axis-aligned box (conservative: may return true for disjoint boxes)
+        bool Intersects(const Eigen::AlignedBox3d &box) const;
+
+        // Returns an axis-aligned box containing the region, or {} if the region is unbounded
+        std::optional<Eigen::AlignedBox3d> BoundingBox() const;
+    };
+
+    /*!
+     * @brief A spatial chunk of the map, with the version of its last modification
+     */
+    struct MapChunk {
+        slam::Voxel coordinates; //< The coordinates of the chunk in the grid of chunks of the map
+        uint64_t version = 0; //< The version of the map at the last modification of the chunk
+        slam::PointCloudPtr points = nullptr; //< The points of the chunk in the region (empty if the chunk was removed)
+    };
+
+    /*!
+     * @brief A point inserted in or removed from the map
+     */
+    struct MapPointChange {
+        Eigen::Vector3d xyz;
+        double timestamp = std::numeric_limits<double>::min();
+        size_t frame_id = -1; //< The index of the frame of the point in the map
+        size_t point_id = -1; //< The index of the point in its frame
+        uint64_t version = 0; //< The version of the map after the change
+        bool is_insertion = true;
+    };
+
+    /*!
+     * @brief The changes of the map after a version
+     */
+    struct MapChangeSet {
+        uint64_t since_version = 0; //< The version of the map known by the consumer
+        uint64_t version = 0; //< The current version of the map
+        bool is_complete = true; //< Whether the journal still holds all the changes after `since_version`
+        std::vector<MapPointChange> changes; //< The changes in chronological order
+    };
+
+    /*!
+     * @brief The regularized (GICP-style) distribution of the points of a voxel, cached by a map
+     */
+    struct VoxelDistribution {
+        Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d covariance = Eigen::Matrix3d::Identity(); //< The regularized covariance
+        Eigen::Matrix3d information_sqrt = Eigen::Matrix3d::Identity(); //< S such that S^T S is the inverse of `covariance`
+        int num_points = 0;
+    };
+
     /*! @brief Abstract map interface
      */
     class ISlamMap : public slam::IMap {
@@ -42,6 +142,26 @@ namespace ct_icp {
          */
         virtual slam::PointCloudPtr MapAsPointCloud() const = 0;
 
+        /*!
+         * @brief Returns the version of the map, incremented by each modification of the map
+         */
+        virtual uint64_t Version() const { return 0; }
+
+        /*!
+         * @brief Extracts the points of the map in a region
+         *
+         * The default implementation filters the point cloud returned by `MapAsPointCloud`
+         */
+        virtual slam::PointCloudPtr ExtractPoints(const MapRegion &region) const;
+
+        /*!
+         * @brief Extracts the points of the chunks of the map modified after `since_version`, in a region
+         *
+         * Consumers stream the deltas of the map by keeping the `Version()` read before each extraction,
+         * and replacing the points of each chunk returned (the default implementation returns a single chunk).
+         */
+        virtual std::vector<MapChunk> ExtractChunks(const MapRegion &region, uint64_t since_version = 0) const;
+
         /////////////////////////////////////////
         /// Update trajectory
         /////////////////////////////////////////
@@ -80,6 +200,15 @@ namespace ct_icp {
                                                                      int max_num_neighbors,
                                                                      bool nearest_neighbors,
                                                                      Eigen::Vector3d *sensor_location) const = 0;
+
+        /*!
+         * @brief Finds the cached distribution closest to a query
+         *
+         * @returns false if the map does not cache distributions, or if no distribution is close to the query
+         */
+        virtual bool FindDistribution(const Eigen::Vector3d &query, VoxelDistribution &distribution) const {
+            return false;
+        }
     };
 
     struct IMapOptions {
@@ -123,6 +252,19 @@ namespace ct_icp {
             bool select_valid_normals_direction = true; //< Use the normals direction to filter inconsistent points (behind the normal plane)
             size_t max_frames_to_keep = 100; //< The number of frames to keep in the map
             double default_radius = 0.8; //< The default radius for search with uniform radius
+            int chunk_size = 16; //< The size (in number of voxels) of the spatial chunks used to export the map
+            int num_threads_export = 4; //< The number of threads used to export the map
+            size_t max_journal_size = 0; //< The maximum number of changes kept in the journal of each voxel map (0 disables the journal, e.g. 200000 to synchronize a consumer of the map)
+            bool cache_distributions = false; //< Cache the regularized distributions in the voxels (see `FindDistribution`), used by the DISTRIBUTION_TO_DISTRIBUTION distance (enabled by the Odometry)
+            double distribution_epsilon = 1.e-3; //< The regularization of the distributions cached in the voxels (see `RegularizeCovariance`)
+            bool hierarchical_insertion = false; //< Insert the points in the finest resolution only, and aggregate them in the coarser voxels (see `AggregatePointInVoxelMap`). The resolutions must be integer multiples of the finest one, which the default resolutions are not (e.g. use 0.25, 0.5, 1.5)
+
+            // Compaction parameters (see `Compact`)
+            double compaction_time_budget_ms = 0.; //< The time budget of the compaction after the insertion of each frame (0 disables the compaction)
+            double compaction_merge_ratio = 1.5; //< The points closer than `ratio * min_distance_between_points` are merged
+            double compaction_planarity_threshold = 0.5; //< The voxels of greater planarity (see `NeighborhoodDescription`) are downsampled
+            int compaction_num_planar_points = 10; //< The number of representative points kept in the downsampled planar voxels
+            int compaction_max_unobserved_frames = 0; //< The points never observed again after this number of frames are dropped (0 keeps them)
 
             static std::string Type() { return "MULTI_RESOLUTION_VOXEL_HASHMAP"; }
 
@@ -135,6 +277,7 @@ namespace ct_icp {
 
 
         explicit MultipleResolutionVoxelMap(const Options &options) : options_(options) {
+            CheckOptions(options);
             voxel_maps_.resize(options.resolutions.size());
         }
 
@@ -155,7 +298,8 @@ namespace ct_icp {
                               std::vector<size_t> &out_indices) override {
             SLAM_CHECK_STREAM(!frame_poses.empty(), "the poses are empty");
             auto fidx = frame_id_count_++;
-            frame_id_to_frame[fidx] = {pointcloud.DeepCopyPtr(),
+            // The frame shares the owned buffers of the input point cloud (wrapped buffers are copied)
+            frame_id_to_frame[fidx] = {pointcloud.ShallowCopyPtr(),
                                        slam::LinearContinuousTrajectory::Create(std::vector<slam::Pose>(frame_poses))};
             auto &frame = frame_id_to_frame[fidx];
             auto &pc = frame.pointcloud;
@@ -168,9 +312,6 @@ namespace ct_icp {
                 pc->AddDefaultWorldPointsField();
 
                 // Transform the raw points using the poses
-                auto raw_points = pc->RawPointsProxy<Eigen::Vector3d>();
-                auto world_points = pc->WorldPointsProxy<Eigen::Vector3d>();
-
                 if (pc->HasTimestamps() && trajectory.Poses().size() >= 2)
                     pc->RawPointsToWorldPoints(trajectory);
                 else
@@ -189,13 +330,27 @@ namespace ct_icp {
             // Insert Points into the point cloud
             std::map<size_t, std::set<slam::Voxel>> voxels_to_update; //< Keep track of the voxels modified
             std::set<size_t> selected_indices; //< Keep track of the points inserted
-            auto xyz = pc->WorldPointsProxy<Eigen::Vector3d>();
-            auto timestamps = pc->TimestampsProxy<double>();
+            const slam::PointCloud &const_pc = *pc;
+            auto xyz = const_pc.WorldPointsProxy<Eigen::Vector3d>();
+            auto timestamps = const_pc.TimestampsProxy<double>();
 
 
             for (auto pidx(0); pidx < xyz.size(); pidx++) {
                 Eigen::Vector3d wpoint = xyz[pidx];
                 double t = timestamps[pidx];
+                if (options_.hierarchical_insertion) {
+                    // The finest resolution decides the insertion, the coarser voxels aggregate its points
+                    bool is_new_voxel = false;
+                    auto voxel = InsertPointInVoxelMap(wpoint, 0, fidx, pidx, t, &is_new_voxel);
+                    if (!voxel)
+                        continue;
+                    voxels_to_update[0].insert(*voxel);
+                    selected_indices.insert(pidx);
+                    for (auto map_idx(1); map_idx < options_.resolutions.size(); map_idx++)
+                        voxels_to_update[map_idx].insert(
+                                AggregatePointInVoxelMap(wpoint, *voxel, map_idx, fidx, pidx, t, is_new_voxel));
+                    continue;
+                }
                 for (auto map_idx(0); map_idx < options_.resolutions.size(); map_idx++) {
                     auto voxel = InsertPointInVoxelMap(wpoint, map_idx, fidx, pidx, t);
                     if (voxel) {
@@ -213,23 +368,26 @@ namespace ct_icp {
                 for (auto &voxel: voxels) {
                     auto &voxel_block = map[voxel];
 
-                    if (voxel_block.points.size() >= 5) {
+                    if (voxel_block.num_aggregated >= 5) {
+                        // The description of an aggregated voxel is computed from the moments of all its points
+                        MarkChunkModified(map_id, voxel);
+                        const double num_points = double(voxel_block.num_aggregated);
+                        const Eigen::Vector3d barycenter = voxel_block.sum / num_points;
+                        const Eigen::Matrix3d covariance = voxel_block.sum_outer / num_points -
+                                                           barycenter * barycenter.transpose();
+                        voxel_block.description = slam::ComputeNeighborhoodInfo(barycenter, covariance,
+                                                                                slam::ALL_BUT_KDTREE);
+                        voxel_block.computed_values = slam::ALL_BUT_KDTREE;
+                        voxel_block.is_valid = true;
+                        if (options_.cache_distributions)
+                            UpdateDistribution(voxel_block);
+                        OrientNormals(voxel_block);
+                    } else if (voxel_block.num_aggregated == 0 && voxel_block.points.size() >= 5) {
+                        MarkChunkModified(map_id, voxel);
                         voxel_block.ComputeNeighborhood(slam::ALL_BUT_KDTREE);
-
-                        for (auto &point: voxel_block.points) {
-                            point.normal = voxel_block.description.normal;
-                            point.is_normal_computed = true;
-                            if (frame_id_to_frame.find(point.frame_id) != frame_id_to_frame.end()) {
-                                // Orient the normal using the pose of the source frame
-                                auto &src_frame = frame_id_to_frame[point.frame_id];
-                                auto &begin = src_frame.poses.Poses().front();
-                                if ((point.xyz - begin.TrRef()).dot(point.normal) > 0.) {
-                                    point.normal = -point.normal;
-                                }
-                                point.is_normal_oriented = true;
-                            } else
-                                point.is_normal_oriented = false;
-                        }
+                        if (options_.cache_distributions)
+                            UpdateDistribution(voxel_block);
+                        OrientNormals(voxel_block);
                     }
                 }
             }
@@ -237,13 +395,15 @@ namespace ct_icp {
 
             frame.pointcloud = pc;
             if (frame.pointcloud->HasTimestamps()) {
-                auto _timestamps = frame.pointcloud->TimestampsProxy<double>();
+                auto _timestamps = const_pc.TimestampsProxy<double>();
                 auto [min_it, max_it] = std::minmax_element(_timestamps.begin(), _timestamps.end());
                 frame.min_t = *min_it;
                 frame.max_t = *max_it;
             }
 
             frame_indices_.push_back(frame_id_count_ - 1);
+            if (options_.compaction_time_budget_ms > 0.)
+                Compact(options_.compaction_time_budget_ms);
             // Remove old point clouds in memory
             while (frame_indices_.size() > options_.max_frames_to_keep) {
                 auto oldest_idx = frame_indices_.front();
@@ -257,41 +417,120 @@ namespace ct_icp {
         //  -- Remove Points
         //  -- Fast and Strong Queries
 
-        // Returns the voxel where the point was inserted
+        // Returns the voxel where the point was inserted (`is_new_voxel` is set if the voxel was created by the point)
         std::optional<slam::Voxel> InsertPointInVoxelMap(const Eigen::Vector3d &point, size_t map_index,
                                                          size_t frame_idx, size_t pidx,
-                                                         double timestamp = std::numeric_limits<double>::min()) {
+                                                         double timestamp = std::numeric_limits<double>::min(),
+                                                         bool *is_new_voxel = nullptr) {
             const auto &[resolution, min_dist, max_num_points] = options_.resolutions[map_index];
             auto &hash_map_ = voxel_maps_[map_index];
             slam::Voxel voxel = slam::Voxel::Coordinates(point, resolution);
+            if (is_new_voxel)
+                *is_new_voxel = false;
 
             if (hash_map_.map.find(voxel) == hash_map_.map.end()) {
-                hash_map_.map[voxel].points.reserve(max_num_points);
-                hash_map_.map[voxel].points.push_back(
-                        PointType{point, Eigen::Vector3d::Zero(), timestamp, frame_idx, pidx});
+                if (is_new_voxel)
+                    *is_new_voxel = true;
+                auto &voxel_block = hash_map_.map[voxel];
+                // The points of the voxels are allocated from the pool of the voxel map
+                voxel_block.points = _Neighborhood::vector_points_t(
+                        slam::SlabAllocator<PointType>(hash_map_.pool.get()));
+                AppendPoint(voxel_block, {point, Eigen::Vector3d::Zero(), timestamp, frame_idx, pidx},
+                            max_num_points);
                 hash_map_.num_points++;
+                AddVoxelToChunk(map_index, voxel, voxel_block);
+                EnqueueForCompaction(map_index, voxel, voxel_block);
+                RecordChange(map_index, voxel_block.points.back(), true);
                 return voxel;
             }
             auto &voxel_block = hash_map_.map[voxel];
-            if (voxel_block.points.size() < max_num_points) {
-                double sq_dist_min_to_points = std::numeric_limits<double>::max();
-                // Insert a point only if it is greader than the min distance between points
-                for (int i(0); i < voxel_block.points.size(); ++i) {
-                    auto &_point = voxel_block.points[i];
-                    double sq_dist = (_point.xyz.cast<double>() - point).squaredNorm();
-                    if (sq_dist < sq_dist_min_to_points) {
-                        sq_dist_min_to_points = sq_dist;
-                    }
+            const bool is_full = voxel_block.points.size() >= max_num_points;
+            // The points of full voxels are only scanned to track their observations (for the compaction)
+            if (is_full && options_.compaction_max_unobserved_frames == 0)
+                return {};
+            double sq_dist_min_to_points = std::numeric_limits<double>::max();
+            int closest_idx = -1;
+            // Insert a point only if it is greader than the min distance between points
+            for (int i(0); i < voxel_block.points.size(); ++i) {
+                auto &_point = voxel_block.points[i];
+                double sq_dist = (_point.xyz.cast<double>() - point).squaredNorm();
+                if (sq_dist < sq_dist_min_to_points) {
+                    sq_dist_min_to_points = sq_dist;
+                    closest_idx = i;
                 }
-                if (sq_dist_min_to_points > (min_dist * min_dist)) {
-                    voxel_block.points.push_back({point, Eigen::Vector3d::Zero(), timestamp, frame_idx, pidx});
-                    hash_map_.num_points++;
+            }
+            if (sq_dist_min_to_points > (min_dist * min_dist)) {
+                if (is_full)
+                    return {};
+                if (voxel_block.num_aggregated > 0) {
+                    // The voxel was downsampled by the compaction: its representative points are kept, and the new
+                    // points only update its description (otherwise the voxel would refill between compactions)
+                    AccumulateMoments(voxel_block, point);
                     return voxel;
                 }
+                AppendPoint(voxel_block, {point, Eigen::Vector3d::Zero(), timestamp, frame_idx, pidx},
+                            max_num_points);
+                hash_map_.num_points++;
+                MarkChunkModified(map_index, voxel);
+                RecordChange(map_index, voxel_block.points.back(), true);
+                return voxel;
             }
+            // The closest point of the map is observed again (by a later frame)
+            if (closest_idx >= 0 && voxel_block.points[closest_idx].frame_id != frame_idx)
+                voxel_block.points[closest_idx].num_observations++;
             return {};
         }
 
+        /*!
+         * @brief Aggregates a point inserted in the finest resolution in the coarser voxel map `map_index`
+         *
+         * The moments of the coarse voxel are updated in constant time (without distance scan), and the point is kept
+         * as a representative point of the coarse voxel if it is the first point of its finest voxel
+         * (up to `max_num_points` points per voxel).
+         * The coarse voxel is derived from the finest voxel `fine_voxel` of the point, so that it contains it entirely.
+         *
+         * @returns The coarse voxel of the point
+         */
+        slam::Voxel AggregatePointInVoxelMap(const Eigen::Vector3d &point, const slam::Voxel &fine_voxel,
+                                             size_t map_index, size_t frame_idx, size_t pidx, double timestamp,
+                                             bool is_representative) {
+            const auto max_num_points = options_.resolutions[map_index].max_num_points;
+            auto &hash_map_ = voxel_maps_[map_index];
+            slam::Voxel voxel = CoarseVoxel(fine_voxel, map_index);
+            auto [it, is_new_voxel] = hash_map_.map.try_emplace(voxel);
+            auto &voxel_block = it.value();
+            if (is_new_voxel) {
+                voxel_block.points = _Neighborhood::vector_points_t(
+                        slam::SlabAllocator<PointType>(hash_map_.pool.get()));
+                AddVoxelToChunk(map_index, voxel, voxel_block);
+                EnqueueForCompaction(map_index, voxel, voxel_block);
+            }
+            AccumulateMoments(voxel_block, point);
+            if (is_representative && voxel_block.points.size() < max_num_points) {
+                AppendPoint(voxel_block, {point, Eigen::Vector3d::Zero(), timestamp, frame_idx, pidx},
+                            max_num_points);
+                hash_map_.num_points++;
+                MarkChunkModified(map_index, voxel);
+                RecordChange(map_index, voxel_block.points.back(), true);
+            }
+            return voxel;
+        }
+
+        /*!
+         * @brief Compacts the voxels of the map until the time budget is exhausted
+         *
+         * The voxels of all resolutions are visited in a round robin, resumed at the next call (each call visits a voxel
+         * at most once). In each voxel:
+         *  - The near-duplicate points are merged (see `compaction_merge_ratio`),
+         *  - The points never observed again are dropped (see `compaction_max_unobserved_frames`),
+         *  - The planar voxels are downsampled to a few representative points, their description is then
+         *    maintained from the moments of all the points inserted in the voxel (the points inserted later
+         *    are only accumulated in the moments, so that the voxel does not refill between compactions).
+         *
+         * @returns The number of points removed from the map
+         */
+        size_t Compact(double time_budget_ms);
+
         // @brief   Clears the map
         void ClearMap() override { Reset(options_, false); };
 
@@ -306,25 +545,46 @@ namespace ct_icp {
             // Iterate over all voxels and suppress the voxels to remove
             for (auto map_idx = 0; map_idx < voxel_maps_.size(); map_idx++) {
                 std::set<slam::Voxel> voxels_to_remove;
-                auto &map = voxel_maps_[map_idx].map;
                 for (auto &[voxel, neighborhood]: voxel_maps_[map_idx].map) {
-                    if (neighborhood.points.empty())
+                    if (IsEmpty(neighborhood)) {
                         voxels_to_remove.insert(voxel);
-                    if ((neighborhood.points.front().xyz - location).norm() > distance)
+                        continue;
+                    }
+                    // The voxels without points are located by the barycenter of their aggregated points
+                    const Eigen::Vector3d reference = neighborhood.points.empty() ?
+                                                      Eigen::Vector3d(neighborhood.sum / double(neighborhood.num_aggregated)) :
+                                                      Eigen::Vector3d(neighborhood.points.front().xyz);
+                    if ((reference - location).norm() > distance)
                         voxels_to_remove.insert(voxel);
                 }
 
-                for (auto &voxel: voxels_to_remove) {
-                    voxel_maps_[map_idx].num_points -= map[voxel].points.size();
-                    map.erase(voxel);
-                }
+                for (auto &voxel: voxels_to_remove)
+                    RemoveVoxel(map_idx, voxel);
             }
+            PurgeCompactionQueue();
         };
 
         void Reset(const Options &options, bool keep_frames = false) {
+            CheckOptions(options);
+            // Keep all the chunks as empty chunks to signal the removal to the consumers of the deltas
+            std::vector<tsl::robin_map<slam::Voxel, ChunkInfo>> chunks(options.resolutions.size());
+            for (auto map_idx = 0; map_idx < std::min(chunks.size(), voxel_maps_.size()); map_idx++) {
+                chunks[map_idx] = std::move(voxel_maps_[map_idx].chunks);
+                for (auto it = chunks[map_idx].begin(); it != chunks[map_idx].end(); ++it) {
+                    auto &chunk = it.value();
+                    chunk.voxels.clear();
+                    chunk.version = ++version_;
+                }
+            }
             options_ = options;
+            compaction_queue_.clear();
             voxel_maps_.resize(0);
             voxel_maps_.resize(options.resolutions.size());
+            for (auto map_idx = 0; map_idx < voxel_maps_.size(); map_idx++) {
+                voxel_maps_[map_idx].chunks = std::move(chunks[map_idx]);
+                // The removal of the points is not journaled: consumers must re-synchronize
+                voxel_maps_[map_idx].journal_min_version = version_;
+            }
 
             if (keep_frames) {
                 throw std::runtime_error("Not implemented");
@@ -344,6 +604,27 @@ namespace ct_icp {
          */
         size_t NumPoints() const override { return voxel_maps_.front().num_points; }
 
+        // Memory statistics of a voxel map (of one resolution)
+        struct MemoryStats {
+            double resolution = 0.;
+            size_t num_voxels = 0;
+            size_t num_points = 0;
+            slam::SlabPool::Stats pool; //< The statistics of the pool of the points of the voxels
+
+            // The memory reserved for the points of the voxels (in bytes per point)
+            inline double BytesPerPoint() const {
+                return num_points == 0 ? 0. : double(pool.reserved_bytes) / double(num_points);
+            }
+
+            inline double Fragmentation() const { return pool.Fragmentation(); }
+        };
+
+        // Returns the memory statistics of each voxel map (in the order of the resolutions)
+        std::vector<MemoryStats> GetMemoryStats() const;
+
+        // Returns the number of entries of the round robin of the compaction (see `Compact`)
+        size_t CompactionQueueSize() const { return compaction_queue_.size(); }
+
         /*!
          * @brief Returns the point cloud of the voxel map of least resolution
          */
@@ -351,61 +632,63 @@ namespace ct_icp {
 
         int NumVoxelMaps() const { return options_.resolutions.size(); }
 
-        slam::PointCloudPtr GetMapPoints(size_t map_idx) const {
-            auto &map = voxel_maps_[map_idx];
+        /*!
+         * @brief Returns the point cloud of an inserted frame, or nullptr if the frame is no longer kept in memory
+         *
+         * @param frame_idx The index of the frame, in the order of insertion
+         */
+        slam::PointCloudPtr GetFramePointCloud(size_t frame_idx) const {
+            auto it = frame_id_to_frame.find(frame_idx);
+            return it == frame_id_to_frame.end() ? nullptr : it->second.pointcloud;
+        }
 
-            auto pc = slam::PointCloud::DefaultXYZPtr<double>();
-            pc->resize(map.num_points);
-            pc->AddDefaultNormalsField();
-            pc->AddDefaultTimestampsField();
-            pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
-            auto xyz = pc->XYZ<double>();
-            auto normals = pc->NormalsProxy<Eigen::Vector3d>();
-            size_t idx = 0;
-            for (auto &[_, block]: map.map) {
-                for (auto &point: block.points) {
-                    CHECK(idx < map.num_points);
-                    xyz[idx] = point.xyz;
-                    normals[idx] = point.normal;
-
-                    idx++;
-                }
-            }
+        /*!
+         * @brief Returns the version of the map, incremented by each modification of the map
+         */
+        uint64_t Version() const override { return version_; }
 
-            return pc;
+        /*!
+         * @brief Returns the points of the voxel map of least resolution in a region
+         */
+        slam::PointCloudPtr ExtractPoints(const MapRegion &region) const override { return GetMapPoints(0, region); }
+
+        /*!
+         * @brief Returns the chunks of the voxel map of least resolution modified after `since_version`
+         */
+        std::vector<MapChunk> ExtractChunks(const MapRegion &region, uint64_t since_version = 0) const override {
+            return GetMapChunks(0, region, since_version);
         }
 
+        /*!
+         * @brief Returns the points inserted in and removed from a voxel map after `since_version`
+         *
+         * If the journal was compacted after `since_version` (or the map was reset), the change set is incomplete,
+         * and the consumer must re-synchronize with a full export of the map.
+         */
+        MapChangeSet GetChangesSince(uint64_t since_version, size_t map_idx = 0) const;
+
+        /* @brief Returns all points of a voxel map */
+        slam::PointCloudPtr GetMapPoints(size_t map_idx) const { return GetMapPoints(map_idx, MapRegion()); }
+
         /* @brief Returns all points visible from a sensor location */
-        slam::PointCloudPtr GetVisibleMapPoints(size_t map_idx,
-                                                const Eigen::Vector3d &view_point) const {
-            auto &map = voxel_maps_[map_idx];
-            auto pc = slam::PointCloud::DefaultXYZPtr<double>();
-            pc->reserve(map.num_points);
-            pc->AddDefaultNormalsField();
-            pc->AddDefaultTimestampsField();
-            pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
-            auto xyz = pc->XYZ<double>();
-            auto normals = pc->NormalsProxy<Eigen::Vector3d>();
-            size_t idx = 0;
-            for (auto &[_, block]: map.map) {
-                for (auto &point: block.points) {
-                    CHECK(idx < map.num_points);
-
-                    bool add_point = true;
-                    if (point.is_normal_oriented && point.is_normal_oriented) {
-                        double scalar = point.normal.dot(point.xyz - view_point);
-                        if (scalar < 0.) {
-                            pc->resize(idx + 1);
-                            xyz[idx] = point.xyz;
-                            normals[idx] = point.normal;
-                            idx++;
-                        }
-                    }
-                }
-            }
-            return pc;
+        slam::PointCloudPtr GetVisibleMapPoints(size_t map_idx, const Eigen::Vector3d &view_point) const {
+            return GetMapPoints(map_idx, MapRegion::VisibleFrom(view_point));
         }
 
+        /*!
+         * @brief Returns the points of a voxel map in a region
+         *
+         * Chunks and voxels outside of the region are culled as a whole, the points are counted and copied in parallel
+         * in a point cloud allocated once.
+         */
+        slam::PointCloudPtr GetMapPoints(size_t map_idx, const MapRegion &region) const;
+
+        /*!
+         * @brief Returns the points in a region of each chunk of a voxel map modified after `since_version`
+         */
+        std::vector<MapChunk> GetMapChunks(size_t map_idx, const MapRegion &region,
+                                           uint64_t since_version = 0) const;
+
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
         /// QUERY API
         ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -467,9 +750,9 @@ namespace ct_icp {
             PointType neighbor;
             priority_queue_t priority_queue;
             size_t num_points_skipped = 0;
-            for (short kxx = kx - nb_voxels_visited; kxx < kx + nb_voxels_visited + 1; ++kxx) {
-                for (short kyy = ky - nb_voxels_visited; kyy < ky + nb_voxels_visited + 1; ++kyy) {
-                    for (short kzz = kz - nb_voxels_visited; kzz < kz + nb_voxels_visited + 1; ++kzz) {
+            for (int kxx = kx - nb_voxels_visited; kxx < kx + nb_voxels_visited + 1; ++kxx) {
+                for (int kyy = ky - nb_voxels_visited; kyy < ky + nb_voxels_visited + 1; ++kyy) {
+                    for (int kzz = kz - nb_voxels_visited; kzz < kz + nb_voxels_visited + 1; ++kzz) {
                         voxel.x = kxx;
                         voxel.y = kyy;
                         voxel.z = kzz;
@@ -540,6 +823,13 @@ namespace ct_icp {
             return neighborhoods;
         };
 
+        /*!
+         * @brief Finds the distribution of the voxel closest to the query, at the resolution of the default radius
+         *
+         * @returns false if the distributions are not cached (see `Options::cache_distributions`)
+         */
+        bool FindDistribution(const Eigen::Vector3d &query, VoxelDistribution &distribution) const override;
+
     private:
         size_t frame_id_count_ = 0;
         struct PointType {
@@ -551,6 +841,7 @@ namespace ct_icp {
 
             bool is_normal_computed = false;
             bool is_normal_oriented = false;
+            uint32_t num_observations = 0; //< The number of points of later frames rejected by the min distance to this point
         };
 
         struct _PointConversion {
@@ -574,7 +865,7 @@ namespace ct_icp {
             }
         } conversion_;
 
-        typedef slam::TNeighborhood<PointType, _PointConversion> _Neighborhood;
+        typedef slam::TNeighborhood<PointType, _PointConversion, slam::SlabAllocator<PointType>> _Neighborhood;
 
         struct Frame {
             slam::PointCloudPtr pointcloud = nullptr;
@@ -584,12 +875,184 @@ namespace ct_icp {
 
         Options options_;
 
-        typedef _Neighborhood VoxelBlock;
+        struct VoxelBlock : _Neighborhood {
+            // Cached for the registration (only with `cache_distributions`), updated with the normals of the voxel
+            std::unique_ptr<VoxelDistribution> distribution = nullptr;
+
+            // The moments of the points aggregated in a coarse voxel (only with `hierarchical_insertion`)
+            size_t num_aggregated = 0;
+            Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+            Eigen::Matrix3d sum_outer = Eigen::Matrix3d::Zero();
+
+            uint64_t compaction_id = 0; //< Identifies the voxel in the compaction queue (a voxel recreated gets a new id)
+            size_t chunk_idx = 0; //< The index of the voxel in the voxels of its chunk (see `ChunkInfo`)
+        };
+
+        struct CompactionEntry {
+            size_t map_idx;
+            slam::Voxel voxel;
+            uint64_t compaction_id;
+        };
+
+        // Appends a new voxel at the end of the round robin of the compaction (see `Compact`)
+        void EnqueueForCompaction(size_t map_idx, const slam::Voxel &voxel, VoxelBlock &block) {
+            block.compaction_id = ++compaction_id_count_;
+            compaction_queue_.push_back({map_idx, voxel, block.compaction_id});
+        }
+
+        /*!
+         * @brief Drops the entries of the removed voxels from the compaction queue
+         *
+         * The entries of the removed voxels are otherwise only dropped when `Compact` visits them, and the queue would
+         * grow with every voxel ever created when the compaction is not called. The queue is purged when it holds more
+         * removed voxels than live voxels, for an amortized constant cost per removal.
+         */
+        void PurgeCompactionQueue();
+
+        // Whether a voxel block holds neither points nor aggregated moments (the moments outlive the compacted points)
+        static bool IsEmpty(const VoxelBlock &block) {
+            return block.points.empty() && block.num_aggregated == 0;
+        }
+
+        // Returns the voxel of the map `map_index` containing the finest voxel `fine_voxel` (see `CheckOptions`)
+        slam::Voxel CoarseVoxel(const slam::Voxel &fine_voxel, size_t map_index) const {
+            const int ratio = int(std::lround(options_.resolutions[map_index].resolution /
+                                              options_.resolutions[0].resolution));
+            auto floor_div = [ratio](int coordinate) {
+                return coordinate >= 0 ? coordinate / ratio : -((-coordinate + ratio - 1) / ratio);
+            };
+            return slam::Voxel(floor_div(fine_voxel.x), floor_div(fine_voxel.y), floor_div(fine_voxel.z));
+        }
+
+        // Adds a point to the moments of the points aggregated in a voxel block
+        static void AccumulateMoments(VoxelBlock &block, const Eigen::Vector3d &point) {
+            block.num_aggregated++;
+            block.sum += point;
+            block.sum_outer += point * point.transpose();
+        }
+
+        // Appends a new voxel to the voxels of its chunk
+        void AddVoxelToChunk(size_t map_idx, const slam::Voxel &voxel, VoxelBlock &block) {
+            auto &chunk_voxels = MarkChunkModified(map_idx, voxel).voxels;
+            block.chunk_idx = chunk_voxels.size();
+            chunk_voxels.push_back(voxel);
+        }
+
+        // Removes a voxel and its points from a voxel map
+        void RemoveVoxel(size_t map_idx, const slam::Voxel &voxel) {
+            auto &map = voxel_maps_[map_idx].map;
+            auto it = map.find(voxel);
+            if (it == map.end())
+                return;
+            auto &block = it.value();
+
+            // The chunk is kept (even if empty) to signal the removal to the consumers of the deltas
+            // The last voxel of the chunk takes the place of the removed voxel (in constant time)
+            auto &chunk_voxels = MarkChunkModified(map_idx, voxel).voxels;
+            if (block.chunk_idx < chunk_voxels.size() && chunk_voxels[block.chunk_idx] == voxel) {
+                const slam::Voxel last_voxel = chunk_voxels.back();
+                map.find(last_voxel).value().chunk_idx = block.chunk_idx;
+                chunk_voxels[block.chunk_idx] = last_voxel;
+                chunk_voxels.pop_back();
+            }
+
+            for (auto &point: block.points)
+                RecordChange(map_idx, point, false);
+            voxel_maps_[map_idx].num_points -= block.points.size();
+            map.erase(it);
+        }
+
+        // Compacts a voxel of the map (see `Compact`), and returns the number of points removed
+        size_t CompactVoxel(size_t map_idx, const slam::Voxel &voxel, VoxelBlock &block);
+
+        // Checks the consistency of the options of the map
+        static void CheckOptions(const Options &options);
+
+        // Updates the regularized distribution of a voxel block from its description
+        void UpdateDistribution(VoxelBlock &block) const;
+
+        // Sets the normal of the voxel block to its points, oriented towards the sensor of their frame
+        void OrientNormals(VoxelBlock &block);
+
+        struct ChunkInfo {
+            uint64_t version = 0; //< The version of the map at the last modification of the chunk
+            std::vector<slam::Voxel> voxels; //< The voxels of the chunk
+        };
+
+        // Appends a point to a voxel block, growing its capacity geometrically up to `max_num_points`
+        static void AppendPoint(VoxelBlock &block, const PointType &point, int max_num_points) {
+            auto &points = block.points;
+            if (points.size() == points.capacity())
+                points.reserve(std::max(std::min(2 * points.capacity(), size_t(max_num_points)),
+                                        points.size() + 1));
+            points.push_back(point);
+        }
+
         struct VoxelHashMap {
             size_t num_points = 0;
+            // The pool of the points of the voxels (declared first to outlive the voxels)
+            std::shared_ptr<slam::SlabPool> pool = std::make_shared<slam::SlabPool>();
             tsl::robin_map<slam::Voxel, VoxelBlock> map;
+            tsl::robin_map<slam::Voxel, ChunkInfo> chunks; //< The chunks of voxels (including the emptied chunks)
+            std::deque<MapPointChange> journal; //< The changes of the voxel map, sorted by version
+            uint64_t journal_min_version = 0; //< The journal holds all the changes after this version
         };
 
+        // Records the insertion or the removal of a point in the journal of a voxel map (at the current version)
+        void RecordChange(size_t map_idx, const PointType &point, bool is_insertion) {
+            if (options_.max_journal_size == 0)
+                return;
+            auto &map = voxel_maps_[map_idx];
+            map.journal.push_back({point.xyz, point.timestamp, point.frame_id, point.point_id,
+                                   version_, is_insertion});
+            if (map.journal.size() > options_.max_journal_size) {
+                // Compact the journal by dropping its oldest half (amortized constant cost per change)
+                auto num_dropped = map.journal.size() - options_.max_journal_size / 2;
+                map.journal_min_version = map.journal[num_dropped - 1].version;
+                map.journal.erase(map.journal.begin(), map.journal.begin() + num_dropped);
+            }
+        }
+
+        // Returns the coordinates of the chunk containing a voxel
+        slam::Voxel ChunkCoordinates(const slam::Voxel &voxel) const {
+            const int k = options_.chunk_size;
+            auto floor_div = [k](int x) { return x >= 0 ? x / k : -((-x - 1) / k) - 1; };
+            return {floor_div(voxel.x), floor_div(voxel.y), floor_div(voxel.z)};
+        }
+
+        // Increments the version of the map, and sets it as the version of the chunk containing the voxel
+        ChunkInfo &MarkChunkModified(size_t map_idx, const slam::Voxel &voxel) {
+            auto &chunk = voxel_maps_[map_idx].chunks[ChunkCoordinates(voxel)];
+            chunk.version = ++version_;
+            return chunk;
+        }
+
+        // Returns the bounding box of a chunk (or of a voxel for a chunk size of 1)
+        Eigen::AlignedBox3d ChunkBox(const slam::Voxel &chunk, double resolution, int chunk_size) const;
+
+        // Returns the chunks of a voxel map modified after `since_version` which intersect the region
+        std::vector<std::pair<slam::Voxel, const ChunkInfo *>> SelectChunks(size_t map_idx, const MapRegion &region,
+                                                                           uint64_t since_version) const;
+
+        // Applies `fn` to all points of the chunk in the region, culling the voxels outside of the region
+        template<typename FnT>
+        void ForEachPointInRegion(size_t map_idx, const ChunkInfo &chunk, const MapRegion &region, FnT &&fn) const {
+            const auto &map = voxel_maps_[map_idx].map;
+            const double resolution = options_.resolutions[map_idx].resolution;
+            for (auto &voxel: chunk.voxels) {
+                auto it = map.find(voxel);
+                if (it == map.end() || !region.Intersects(ChunkBox(voxel, resolution, 1)))
+                    continue;
+                for (auto &point: it->second.points) {
+                    if (region.Contains(point.xyz, point.normal, point.is_normal_oriented))
+                        fn(point);
+                }
+            }
+        }
+
+        // Allocates a point cloud with the fields of the exported map
+        static slam::PointCloudPtr AllocateMapPointCloud(size_t num_points);
+
         using pair_distance_t = std::tuple<double, Eigen::Vector3d, slam::Voxel>;
 
         struct __Comparator {
@@ -603,9 +1066,355 @@ namespace ct_icp {
         std::list<size_t> frame_indices_;
         std::map<size_t, Frame> frame_id_to_frame;
         std::vector<VoxelHashMap> voxel_maps_;
+        uint64_t version_ = 0;
+        std::deque<CompactionEntry> compaction_queue_; //< The round robin of the voxels of the map for the compaction
+        uint64_t compaction_id_count_ = 0;
     };
 
 
+    /*!
+     * @brief A read-only voxel map, to localize against a prebuilt map
+     *
+     * The map is loaded from a file written by `FrozenVoxelMap::Write`, which is memory-mapped: the points of each
+     * voxel are contiguous in the file, and the voxels are found with an open-addressing hash table stored in the file.
+     * The map never changes once loaded, so its queries are lock-free, and the maps loaded from the same file
+     * are shared by the odometry instances of a process (the memory of the map is paid once).
+     *
+     * @note The normals are not stored, the `sensor_location` of the queries is ignored
+     */
+    class FrozenVoxelMap : public ISlamMap {
+    public:
+
+        struct Options : public IMapOptions {
+            std::string map_path; //< The path to the file of the map
+            bool share_instances = true; //< Whether the maps loaded from the same file are shared in the process
+
+            static std::string Type() { return "FROZEN_VOXEL_MAP"; }
+
+            std::string GetType() const override { return Type(); }
+
+            std::shared_ptr<ISlamMap> MakeMapFromOptions() const final;
+        };
+
+        /*!
+         * @brief Loads the map of a file
+         *
+         * @param share_instance Whether to return the instance already loaded from this file in the process (if any)
+         */
+        static std::shared_ptr<FrozenVoxelMap> Load(const std::string &file_path, bool share_instance = true);
+
+        /*!
+         * @brief Writes the points of a point cloud in a file which can be loaded as a FrozenVoxelMap
+         *
+         * @param voxel_size The size of the voxels of the hash table (a radius search visits the voxels
+         *                   at a distance of at most `ceil(radius / voxel_size)` voxels)
+         */
+        static void Write(const slam::PointCloud &pointcloud, const std::string &file_path, double voxel_size);
+
+        // Writes the points of a map in a file which can be loaded as a FrozenVoxelMap
+        static void Write(const ISlamMap &map, const std::string &file_path, double voxel_size) {
+            Write(*map.MapAsPointCloud(), file_path, voxel_size);
+        }
+
+        explicit FrozenVoxelMap(const std::string &file_path);
+
+        const std::string &FilePath() const { return file_->FilePath(); }
+
+        double VoxelSize() const { return header_->voxel_size; }
+
+        size_t NumVoxels() const { return header_->num_voxels; }
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        /// UPDATE API (the map is read-only, all modifications throw an exception)
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        void ClearMap() override;
+
+        void InsertPointCloud(const slam::PointCloud &pointcloud,
+                              const std::vector<slam::Pose> &frame_poses,
+                              std::vector<size_t> &out_indices) override;
+
+        void InsertPointCloud(const slam::PointCloud &cloud, std::vector<size_t> &out_selected_points) override {
+            InsertPointCloud(cloud, {slam::Pose()}, out_selected_points);
+        }
+
+        void RemoveElementsFarFromLocation(const Eigen::Vector3d &location, double distance) override;
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        /// QUERY API
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        size_t NumPoints() const override { return header_->num_points; }
+
+        slam::PointCloudPtr MapAsPointCloud() const override;
+
+        /*!
+         * @brief Returns the points of the map in a region, visiting only the voxels intersecting the region
+         *
+         * @note The normals are not stored: the regions culling the normals (see `MapRegion::sensor_location`)
+         *       do not contain any point
+         */
+        slam::PointCloudPtr ExtractPoints(const MapRegion &region) const override;
+
+        /*!
+         * @brief Searches the (at most `max_num_neighbors`) closest points in the radius of the query
+         *
+         * @note As for the MultipleResolutionVoxelMap, the closest neighbors are always selected (`nearest_neighbors`
+         *       is ignored). The normals are not stored: `sensor_location` is ignored, and no point is filtered out
+         */
+        void RadiusSearchInPlace(const Eigen::Vector3d &query, slam::Neighborhood &neighborhood,
+                                 double radius, int max_num_neighbors = -1,
+                                 bool nearest_neighbors = true,
+                                 Eigen::Vector3d *sensor_location = nullptr) const override;
+
+        slam::Neighborhood RadiusSearch(const Eigen::Vector3d &query, double radius,
+                                        int max_num_neighbors = -1, bool nearest_neighbors = true,
+                                        Eigen::Vector3d *sensor_location = nullptr) const override {
+            slam::Neighborhood neighborhood;
+            RadiusSearchInPlace(query, neighborhood, radius, max_num_neighbors, nearest_neighbors, sensor_location);
+            return neighborhood;
+        }
+
+        std::vector<slam::Neighborhood> ComputeNeighborhoods(const std::vector<Eigen::Vector3d> &queries,
+                                                             const std::vector<double> radiuses,
+                                                             int max_num_neighbors,
+                                                             bool nearest_neighbors,
+                                                             Eigen::Vector3d *sensor_location) const override;
+
+        // Searches the neighborhood of a query in a radius of the size of a voxel
+        void ComputeNeighborhoodInPlace(const Eigen::Vector3d &query, int max_num_neighbors,
+                                        slam::Neighborhood &neighborhood) const override {
+            RadiusSearchInPlace(query, neighborhood, VoxelSize(), max_num_neighbors);
+        }
+
+        std::vector<slam::Neighborhood> ComputeNeighborhoods(const std::vector<Eigen::Vector3d> &queries,
+                                                             int max_num_neighbors) const override {
+            return ComputeNeighborhoods(queries, std::vector<double>(queries.size(), VoxelSize()),
+                                        max_num_neighbors, true, nullptr);
+        }
+
+    private:
+        struct FileHeader {
+            char magic[8]; //< "CTICPMAP"
+            uint32_t format_version = 2;
+            uint32_t padding = 0;
+            double voxel_size = 1.;
+            uint64_t num_points = 0;
+            uint64_t num_voxels = 0;
+            uint64_t table_capacity = 0; //< The number of slots of the hash table (a power of two)
+        };
+
+        // A slot of the hash table, followed in the file by the table and the points (three doubles per point)
+        struct VoxelEntry {
+            int32_t x = 0, y = 0, z = 0;
+            uint32_t num_points = 0; //< Zero for the empty slots
+            uint64_t first_point = 0; //< The index of the first point of the voxel
+        };
+
+        // The hash of the voxel coordinates (independent of the platform, as it is persisted in the file)
+        static inline uint64_t HashVoxel(int32_t x, int32_t y, int32_t z) {
+            return slam::MixKey(slam::Voxel(x, y, z).Key());
+        }
+
+        // Returns the entry of a voxel, or nullptr if the voxel is not in the map
+        const VoxelEntry *FindVoxel(int32_t x, int32_t y, int32_t z) const;
+
+        inline Eigen::Map<const Eigen::Vector3d> Point(uint64_t idx) const {
+            return Eigen::Map<const Eigen::Vector3d>(points_ + 3 * idx);
+        }
+
+        slam::MemoryMappedFilePtr file_ = nullptr;
+        const FileHeader *header_ = nullptr;
+        const VoxelEntry *table_ = nullptr;
+        const double *points_ = nullptr;
+    };
+
+    /*!
+     * @brief A read-only map split in fixed-size tiles stored on disk, for maps larger than the memory
+     *
+     * The world is split in square tiles in the (x, y) plane, each stored as a file of a `FrozenVoxelMap`
+     * in a directory written by `TiledVoxelMap::Write`. The tiles are loaded on demand in a LRU cache,
+     * and the tiles ahead of the vehicle (following its velocity from `UpdateTrajectory`) are prefetched
+     * in a background thread. The queries overlapping several tiles merge the neighbors of each tile.
+     *
+     * `UpdateTrajectory` also pins the tiles around the vehicle in an immutable snapshot, read by the queries
+     * without locking the cache. Only the queries outside of the pinned tiles go through the cache (and the disk).
+     */
+    class TiledVoxelMap : public ISlamMap {
+    public:
+
+        struct Options : public IMapOptions {
+            std::string tiles_directory; //< The directory of the tiles written by `TiledVoxelMap::Write`
+            size_t max_tiles_in_memory = 64; //< The capacity of the LRU cache of tiles
+            double prefetch_horizon = 3.0; //< The duration (in seconds) of the motion ahead of the vehicle prefetched
+            int prefetch_radius = 1; //< The number of tiles around the predicted locations prefetched
+            int pinned_radius = 1; //< The number of tiles around the last location pinned for the queries
+            bool asynchronous_prefetch = true; //< Whether to load the prefetched tiles in a background thread
+
+            static std::string Type() { return "TILED_VOXEL_MAP"; }
+
+            std::string GetType() const override { return Type(); }
+
+            inline std::shared_ptr<ISlamMap> MakeMapFromOptions() const final {
+                return std::make_shared<TiledVoxelMap>(*this);
+            };
+        };
+
+        /*!
+         * @brief Writes the points of a point cloud in a directory of tiles
+         *
+         * @param tile_size The size of the side of the tiles (in the (x, y) plane)
+         * @param voxel_size The size of the voxels of the hash table of each tile (see `FrozenVoxelMap::Write`)
+         */
+        static void Write(const slam::PointCloud &pointcloud, const std::string &tiles_directory,
+                          double tile_size, double voxel_size);
+
+        explicit TiledVoxelMap(const Options &options);
+
+        ~TiledVoxelMap();
+
+        double TileSize() const { return tile_size_; }
+
+        size_t NumTiles() const { return tiles_.size(); }
+
+        size_t NumTilesInMemory() const { return cache_.size(); }
+
+        // Whether a tile is in the cache (the tile's coordinates are in the grid of tiles, with z = 0)
+        bool IsTileInMemory(const slam::Voxel &tile) const { return cache_.contains(tile); }
+
+        // The number of tiles pinned for the queries (see `PinTiles`)
+        size_t NumPinnedTiles() const;
+
+        // Returns the coordinates of the tile containing a point
+        slam::Voxel TileCoordinates(const Eigen::Vector3d &point) const {
+            return TileCoordinates(point, tile_size_);
+        }
+
+        // Requests the loading of the tiles at a distance of at most `prefetch_radius` tiles from a location
+        void Prefetch(const Eigen::Vector3d &location);
+
+        /*!
+         * @brief Pins the tiles at a distance of at most `pinned_radius` tiles from a location
+         *
+         * The tiles are loaded (synchronously) and replace the snapshot of pinned tiles read by the queries.
+         * The pinned tiles stay valid for the queries even when they are evicted from the cache.
+         */
+        void PinTiles(const Eigen::Vector3d &location);
+
+        /*!
+         * @brief Pins the tiles around the last pose, and prefetches the tiles along the predicted motion of the vehicle
+         *
+         * The velocity is estimated from the first and last poses (with valid timestamps) and extrapolated
+         * from the last pose for `prefetch_horizon` seconds.
+         */
+        void UpdateTrajectory(const std::vector<slam::Pose> &poses) override;
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        /// UPDATE API (the map is read-only, the insertions throw an exception)
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        void ClearMap() override;
+
+        void InsertPointCloud(const slam::PointCloud &pointcloud,
+                              const std::vector<slam::Pose> &frame_poses,
+                              std::vector<size_t> &out_indices) override;
+
+        void InsertPointCloud(const slam::PointCloud &cloud, std::vector<size_t> &out_selected_points) override {
+            InsertPointCloud(cloud, {slam::Pose()}, out_selected_points);
+        }
+
+        // Evicts the tiles far from the location from the cache (the tiles remain on disk)
+        void RemoveElementsFarFromLocation(const Eigen::Vector3d &location, double distance) override;
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        /// QUERY API
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        size_t NumPoints() const override { return num_points_; }
+
+        // Loads all the tiles sequentially to aggregate the whole map
+        slam::PointCloudPtr MapAsPointCloud() const override;
+
+        /*!
+         * @brief Returns the points of the map in a bounded region, from the tiles intersecting the region only
+         *
+         * The pinned tiles are read from the snapshot, the others are loaded through the cache (as for the queries).
+         * The unbounded regions load all the tiles (see `MapAsPointCloud`).
+         */
+        slam::PointCloudPtr ExtractPoints(const MapRegion &region) const override;
+
+        void RadiusSearchInPlace(const Eigen::Vector3d &query, slam::Neighborhood &neighborhood,
+                                 double radius, int max_num_neighbors = -1,
+                                 bool nearest_neighbors = true,
+                                 Eigen::Vector3d *sensor_location = nullptr) const override;
+
+        slam::Neighborhood RadiusSearch(const Eigen::Vector3d &query, double radius,
+                                        int max_num_neighbors = -1, bool nearest_neighbors = true,
+                                        Eigen::Vector3d *sensor_location = nullptr) const override {
+            slam::Neighborhood neighborhood;
+            RadiusSearchInPlace(query, neighborhood, radius, max_num_neighbors, nearest_neighbors, sensor_location);
+            return neighborhood;
+        }
+
+        std::vector<slam::Neighborhood> ComputeNeighborhoods(const std::vector<Eigen::Vector3d> &queries,
+                                                             const std::vector<double> radiuses,
+                                                             int max_num_neighbors,
+                                                             bool nearest_neighbors,
+                                                             Eigen::Vector3d *sensor_location) const override;
+
+        // Searches the neighborhood of a query in a radius of the size of a voxel
+        void ComputeNeighborhoodInPlace(const Eigen::Vector3d &query, int max_num_neighbors,
+                                        slam::Neighborhood &neighborhood) const override {
+            RadiusSearchInPlace(query, neighborhood, voxel_size_, max_num_neighbors);
+        }
+
+        std::vector<slam::Neighborhood> ComputeNeighborhoods(const std::vector<Eigen::Vector3d> &queries,
+                                                             int max_num_neighbors) const override {
+            return ComputeNeighborhoods(queries, std::vector<double>(queries.size(), voxel_size_),
+                                        max_num_neighbors, true, nullptr);
+        }
+
+    private:
+        // Returns the coordinates of a tile (the tiles are 2D, their z coordinate is always 0)
+        static slam::Voxel TileCoordinates(const Eigen::Vector3d &point, double tile_size) {
+            slam::Voxel tile = slam::Voxel::Coordinates(point, tile_size);
+            tile.z = 0;
+            return tile;
+        }
+
+        // Returns the path of the file of a tile
+        static std::string TilePath(const std::string &tiles_directory, const slam::Voxel &tile);
+
+        typedef tsl::robin_map<slam::Voxel, std::shared_ptr<FrozenVoxelMap>> TilesSnapshot;
+
+        // Returns the tile from the cache, loading it from disk on a cache miss (nullptr if the tile does not exist)
+        std::shared_ptr<FrozenVoxelMap> GetTile(const slam::Voxel &tile) const;
+
+        // Returns the tile from the snapshot of pinned tiles, or from the cache if the tile is not pinned
+        std::shared_ptr<FrozenVoxelMap> GetTile(const TilesSnapshot *pinned_tiles, const slam::Voxel &tile) const;
+
+        // Searches the neighbors of a query in the tiles overlapping its ball
+        void RadiusSearchInTiles(const TilesSnapshot *pinned_tiles,
+                                 const Eigen::Vector3d &query, slam::Neighborhood &neighborhood,
+                                 double radius, int max_num_neighbors, bool nearest_neighbors,
+                                 Eigen::Vector3d *sensor_location) const;
+
+        // Loads the tiles requested by `Prefetch` until the map is destroyed
+        void PrefetchLoop();
+
+        Options options_;
+        double tile_size_ = 1., voxel_size_ = 1.;
+        size_t num_points_ = 0;
+        tsl::robin_map<slam::Voxel, size_t> tiles_; //< The number of points of each tile stored on disk
+
+        mutable slam::lru_cache<slam::Voxel, std::shared_ptr<FrozenVoxelMap>> cache_;
+        mutable std::mutex load_mutex_; //< Serializes the loading of the tiles (a tile missed concurrently is loaded once)
+        std::shared_ptr<const TilesSnapshot> pinned_tiles_; //< Read and replaced with `std::atomic_load/store`
+        slam::blocking_queue<slam::Voxel> prefetch_queue_;
+        std::atomic<bool> stop_prefetch_ = false;
+        std::thread prefetch_thread_;
+    };
+
     /*!
      * @brief Reads a Map Options from a YAML::Node
      */
@@ -32,6 +32,13 @@ namespace ct_icp {
                 return {std::move(neighborhood)};
             return {};
         };
+
+        /*!
+         * @brief Updates the strategy before the registration of a new frame against the map
+         *
+         * @param sensor_pose The predicted pose of the sensor (in the middle of the frame)
+         */
+        virtual void UpdateMapView(const ISlamMap &map, const slam::SE3 &sensor_pose) {};
     };
 
     struct INeighborStrategyOptions {
@@ -145,6 +152,147 @@ namespace ct_icp {
 
     };
 
+    /*!
+     * @brief A Neighborhood strategy which searches neighbors in a ball of fixed radius
+     *
+     * @note The radius also selects the resolution of the map searched (for multi-resolution maps)
+     */
+    class FixedRadiusStrategy : public ANeighborhoodStrategy {
+    public:
+
+        struct Options : public INeighborStrategyOptions {
+
+            static std::string Type() { return "FIXED_RADIUS_STRATEGY"; }
+
+            std::string GetType() const override { return FixedRadiusStrategy::Options::Type(); }
+
+            std::shared_ptr<ct_icp::ANeighborhoodStrategy> MakeStrategyFromOptions() const override {
+                return std::make_shared<FixedRadiusStrategy>(*this);
+            }
+
+            void FromYAML(const YAML::Node &node) override {
+                INeighborStrategyOptions::FromYAML(node);
+                FIND_OPTION(node, (*this), radius, double);
+            }
+
+            double radius = 1.0; //< (m) The radius of the neighborhood search
+
+        } options;
+
+        explicit FixedRadiusStrategy(const Options &options_) : options(options_) {}
+
+        bool ComputeNeighborhoodInPlace(const ISlamMap &map,
+                                        const slam::WPoint3D &query,
+                                        slam::Neighborhood &neighborhood,
+                                        Eigen::Vector3d *sensor_location) const override {
+            map.RadiusSearchInPlace(query.world_point, neighborhood, options.radius,
+                                    options.max_num_neighbors, true, sensor_location);
+            return neighborhood.points.size() >= options.min_num_neighbors;
+        }
+
+    };
+
+    /*!
+     * @brief A Neighborhood strategy which associates the queries projectively in a range image of the map
+     *
+     * Before each frame, the points of the map close to the predicted sensor pose are projected in a spherical range
+     * image (which keeps the closest point of each pixel). The neighbors of a query are the points of the pixels
+     * in a small window around its projection, which is much cheaper than a radius search for spinning LiDARs.
+     * When the window does not contain enough neighbors, the strategy falls back to a radius search in the map.
+     *
+     * @note The points of versioned maps are cached by chunk, and only the chunks modified since the previous frame
+     *       are extracted (see `ISlamMap::ExtractChunks`). The chunks farther than `max_range` from the sensor are
+     *       culled by their bounding box. The points of the other maps in a ball of radius `max_range` are extracted
+     *       at each frame (see `ISlamMap::ExtractPoints`).
+     *       Only the extraction is incremental: the range image is rendered again at each frame from all the points
+     *       in range, as the projection of every point changes with the pose of the sensor.
+     */
+    class RangeImageStrategy : public ANeighborhoodStrategy {
+    public:
+
+        struct Options : public INeighborStrategyOptions {
+
+            static std::string Type() { return "RANGE_IMAGE_STRATEGY"; }
+
+            std::string GetType() const override { return RangeImageStrategy::Options::Type(); }
+
+            std::shared_ptr<ct_icp::ANeighborhoodStrategy> MakeStrategyFromOptions() const override {
+                return std::make_shared<RangeImageStrategy>(*this);
+            }
+
+            void FromYAML(const YAML::Node &node) override {
+                INeighborStrategyOptions::FromYAML(node);
+                FIND_OPTION(node, (*this), num_azimuth_bins, int);
+                FIND_OPTION(node, (*this), num_elevation_bins, int);
+                FIND_OPTION(node, (*this), min_elevation, double);
+                FIND_OPTION(node, (*this), max_elevation, double);
+                FIND_OPTION(node, (*this), max_range, double);
+                FIND_OPTION(node, (*this), window_half_width, int);
+                FIND_OPTION(node, (*this), window_half_height, int);
+                FIND_OPTION(node, (*this), max_distance, double);
+                FIND_OPTION(node, (*this), fallback_radius, double);
+            }
+
+            int num_azimuth_bins = 1024; //< The width of the range image (the number of azimuth bins over 360 degrees)
+
+            int num_elevation_bins = 64; //< The height of the range image (e.g. the number of rings of the sensor)
+
+            double min_elevation = -25.; //< (deg) The elevation of the bottom of the range image
+
+            double max_elevation = 15.; //< (deg) The elevation of the top of the range image
+
+            double max_range = 100.; //< (m) The map points farther from the sensor are not projected
+
+            // The window must hold more than `min_num_neighbors` pixels, as the pixels without a point of the map
+            // (or too far from the query) are not candidates: a window of 9x5 pixels selects the neighbors without
+            // falling back for most queries of a dense scan
+            int window_half_width = 4; //< The half width (in pixels) of the search window
+
+            int window_half_height = 2; //< The half height (in pixels) of the search window
+
+            double max_distance = 1.0; //< (m) The maximum distance between a query and its neighbors in the window
+
+            double fallback_radius = 1.0; //< (m) The radius of the search in the map when the window is not sufficient
+
+        } options;
+
+        explicit RangeImageStrategy(const Options &options_);
+
+        // Projects the points of the map in the range image, from the predicted pose of the sensor
+        void UpdateMapView(const ISlamMap &map, const slam::SE3 &sensor_pose) override;
+
+        bool ComputeNeighborhoodInPlace(const ISlamMap &map,
+                                        const slam::WPoint3D &query,
+                                        slam::Neighborhood &neighborhood,
+                                        Eigen::Vector3d *sensor_location) const override;
+
+        // Returns the pixel (row, col) of a point in the frame of the sensor, or false if it is out of the image
+        bool Project(const Eigen::Vector3d &sensor_point, int &row, int &col) const;
+
+        // Returns the number of non empty pixels of the range image
+        size_t NumFilledPixels() const;
+
+        // Returns the number of queries which fell back to a radius search since the last update of the view
+        inline size_t NumFallbacks() const { return num_fallbacks_; }
+
+    private:
+        slam::SE3 sensor_pose_;
+        bool has_view_ = false;
+        std::vector<Eigen::Vector3d> pixel_points_; //< The world point projected in each pixel (row-major)
+        std::vector<float> pixel_ranges_; //< The range of the point of each pixel (infinity for empty pixels)
+
+        struct CachedChunk {
+            slam::PointCloudPtr points = nullptr;
+            Eigen::AlignedBox3d box; //< The bounding box of the points (to cull the chunks out of range)
+        };
+
+        const ISlamMap *cached_map_ = nullptr;
+        uint64_t cached_version_ = 0;
+        std::map<slam::Voxel, CachedChunk> cached_chunks_; //< The points of each chunk of a versioned map
+
+        mutable std::atomic<size_t> num_fallbacks_ = 0;
+    };
+
     // TODO: Graduated Distance: Max radius which diminishes with iterations / motion
 
 } // namespace ct_icp
@@ -47,6 +47,17 @@ namespace ct_icp {
         double init_sample_voxel_size = 1.0;
         int init_num_frames = 20; // The number of frames defining the initialization of the map
 
+        /* ---------------------------------------------------------------------------------------------------------- */
+        // Motion Hypotheses
+        // Scores several initial motions (current initialization, constant velocity, zero velocity, prediction of the
+        // motion model) with the residuals of a sub-sampled frame, and registers the frame from the best hypothesis
+
+        bool init_with_motion_hypotheses = false;
+        double hypotheses_sample_voxel_size = 1.5; // The voxel size of the sub-sampling of the frame used for the scoring
+        int hypotheses_max_num_points = 300; // The maximum number of points used to score each hypothesis
+        double hypotheses_search_radius = 1.0; // The radius of the neighborhood search in the map
+        double hypotheses_max_residual = 0.5; // The truncation of the point-to-plane residuals (in m)
+
         /* ---------------------------------------------------------------------------------------------------------- */
         // SAMPLING Options
         double sample_voxel_size = 1.5;
@@ -102,6 +113,9 @@ namespace ct_icp {
         double robust_relative_trans_threshold = 1.0;
         bool robust_fail_early = false; // Stop iterations if the final assessment of the registration is unsucessful
         int robust_num_attempts = 6;
+        // The number of robustness levels registered concurrently (speculatively) by the robust registration
+        // The lowest level passing the assessment is selected, and higher levels are cancelled (1 means serial attempts)
+        int robust_num_parallel_attempts = 1;
         int robust_num_attempts_when_rotation = 2;
         short robust_max_voxel_neighborhood = 3;
         double robust_threshold_ego_orientation = 3; // Angle in degrees
@@ -117,6 +131,7 @@ namespace ct_icp {
 
         bool always_insert = false; // Always insert into the map by the Odometry Node (overseeds do_not_insert)
         bool do_no_insert = false; // No insertion in the map by the Odometry Node
+        bool localization_mode = false; // Localizes against a frozen prebuilt map (no insertion nor pruning of the map)
 
         // Debug Parameters
         bool debug_print = true; // Whether to print debug information into the console
@@ -225,6 +240,10 @@ namespace ct_icp {
 
         explicit Odometry(const OdometryOptions &options);
 
+        // Constructs an odometry registering the frames against an existing map (e.g. a `FrozenVoxelMap`
+        // shared by several odometry instances in localization mode)
+        Odometry(const OdometryOptions &options, std::shared_ptr<ct_icp::ISlamMap> map);
+
         explicit Odometry(const OdometryOptions *options) : Odometry(*options) {}
 
         // Registers a new Frame to the Map (with custom motion model)
@@ -250,6 +269,9 @@ namespace ct_icp {
         // Returns the currently registered trajectory
         [[nodiscard]] std::vector<TrajectoryFrame> Trajectory() const;
 
+        // Returns the number of frames registered (without copying the trajectory)
+        [[nodiscard]] size_t NumRegisteredFrames() const { return trajectory_.size(); }
+
         // Returns the Aggregated PointCloud of the Local Map
         [[nodiscard]] slam::PointCloudPtr GetMapPointCloud() const;
 
@@ -316,6 +338,14 @@ namespace ct_icp {
             RegistrationSummary summary;
         };
 
+        // The mutable state of a registration attempt, allowing attempts to run concurrently on the shared map
+        struct RegistrationContext {
+            std::mt19937_64 rng; //< The random generator used for the sampling of keypoints
+            const std::atomic<bool> *cancel_flag = nullptr; //< The flag signaling the cancellation of the attempt
+            bool with_callbacks = true; //< Whether to iterate over the callbacks during the attempt
+            std::vector<slam::WPoint3D> initial_keypoints; //< The keypoints before registration (to replay the callbacks)
+        };
+
         struct FrameInsertionTracker {
             size_t last_inserted_frame_idx = 0;
             double cum_distance_since_insertion = 0.;
@@ -354,6 +384,27 @@ namespace ct_icp {
                                 RegistrationSummary &registration_summary,
                                 AMotionModel *motion_model = nullptr);
 
+        // Launches batches of `robust_num_parallel_attempts` robustness levels concurrently,
+        // And selects the lowest level passing the assessment
+        // The threads of the least-square solver are split between the attempts of a batch,
+        // And the callbacks are replayed for the selected attempt once the batch completed
+        void SpeculativeRobustRegistration(std::vector<slam::WPoint3D> &frame,
+                                           FrameInfo frame_info,
+                                           RegistrationSummary &registration_summary,
+                                           AMotionModel *motion_model = nullptr);
+
+        // Returns whether the robust registration stops after its attempt n°`num_attempts`
+        // (the attempt is good enough, or it is the last attempt allowed)
+        bool IsFinalRobustAttempt(bool is_good_enough, int num_attempts) const;
+
+        // Sets the summary of the robust registration from its final attempt (shared by the serial and speculative modes)
+        void SelectRobustAttempt(const RobustRegistrationAttempt &attempt, int num_attempts,
+                                 RegistrationSummary &registration_summary);
+
+        // Computes the metrics of the summary of an attempt, and returns whether the registration is good enough
+        bool AssessAttempt(const std::vector<slam::WPoint3D> &frame, RobustRegistrationAttempt &attempt,
+                           std::ostream *log_stream = nullptr) const;
+
         void LogInitialization(std::vector<slam::WPoint3D> &sampled_frame,
                                FrameInfo &frame_info, std::ostream *out) const;
 
@@ -383,11 +434,29 @@ namespace ct_icp {
                          CTICPOptions &options,
                          RegistrationSummary &registration_summary,
                          double sample_voxel_size,
-                         AMotionModel *motion_model = nullptr);
+                         AMotionModel *motion_model = nullptr,
+                         RegistrationContext *context = nullptr);
+
+        // Samples the keypoints of a frame (before their random selection, see `max_num_keypoints`)
+        std::vector<slam::WPoint3D> SampleKeypoints(const std::vector<slam::WPoint3D> &frame,
+                                                    double sample_voxel_size) const;
+
+        // Advances `rng` as the random selection of the keypoints of an attempt with `sample_voxel_size`
+        // (used to reproduce the random state of the serial attempts for the speculative attempts)
+        void AdvanceKeypointsSelection(const std::vector<slam::WPoint3D> &frame, FrameInfo frame_info,
+                                       double sample_voxel_size, std::mt19937_64 &rng) const;
 
         // Insert a New Trajectory Frame, and initializes the motion for this new frame
         void InitializeMotion(FrameInfo frame_info, const TrajectoryFrame *initial_estimate = nullptr);
 
+        // Returns the initial motion of a new frame from the previous frames in the trajectory
+        TrajectoryFrame InitialMotionEstimate(FrameInfo frame_info, INITIALIZATION initialization) const;
+
+        // Scores the motion hypotheses of a new frame in parallel, and replaces its initial motion by the best one
+        // Returns the index of the selected hypothesis
+        int SelectMotionHypothesis(const slam::PointCloud &frame, FrameInfo frame_info,
+                                   AMotionModel *motion_model = nullptr);
+
         // Try to insert Points to the map
         // Returns false if it fails
         bool AssessRegistration(const std::vector<slam::WPoint3D> &points, RegistrationSummary &summary,
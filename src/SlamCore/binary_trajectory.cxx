@@ -0,0 +1,361 @@
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "SlamCore/binary_trajectory.h"
+#include "SlamCore/io.h"
+
+namespace slam {
+
+    using namespace binary_trajectory;
+
+    namespace {
+
+        constexpr size_t kRecordsOffset = sizeof(Header);
+
+        /* ---------------------------------------------------------------------------------------------------------- */
+        Header MakeHeader() {
+            Header header;
+            std::memcpy(header.magic, kHeaderMagic, sizeof(kHeaderMagic));
+            header.record_size = sizeof(PoseRecord);
+            return header;
+        }
+
+        /* ---------------------------------------------------------------------------------------------------------- */
+        void CheckHeader(const Header &header, const std::string &file_path) {
+            SLAM_CHECK_STREAM(std::memcmp(header.magic, kHeaderMagic, sizeof(kHeaderMagic)) == 0,
+                              "The file " << file_path << " is not a binary trajectory file");
+            SLAM_CHECK_STREAM(header.version == kVersion,
+                              "Unsupported binary trajectory version " << header.version);
+            SLAM_CHECK_STREAM(header.record_size == sizeof(PoseRecord),
+                              "Unexpected record size " << header.record_size << " in the file " << file_path);
+        }
+
+        /* ---------------------------------------------------------------------------------------------------------- */
+        inline bool IsValidFooter(const Footer &footer, size_t file_size) {
+            return std::memcmp(footer.magic, kFooterMagic, sizeof(kFooterMagic)) == 0 &&
+                   footer.index_offset == kRecordsOffset + footer.num_records * sizeof(PoseRecord) &&
+                   footer.index_offset + footer.num_index_entries * sizeof(IndexEntry) + sizeof(Footer) <= file_size;
+        }
+
+        /* ---------------------------------------------------------------------------------------------------------- */
+        // Returns whether the bytes read are plausibly a record (finite values and a unit quaternion)
+        inline bool IsValidRecord(const PoseRecord &record) {
+            const Eigen::Map<const Eigen::Vector4d> quat(record.quat);
+            const Eigen::Map<const Eigen::Vector3d> tr(record.tr);
+            return std::isfinite(record.dest_timestamp) && std::isfinite(record.ref_timestamp) &&
+                   quat.allFinite() && tr.allFinite() && std::abs(quat.norm() - 1.) < 1.e-6;
+        }
+
+        /* ---------------------------------------------------------------------------------------------------------- */
+        enum TRAJECTORY_FORMAT {
+            BINARY, PLY, KITTI
+        };
+
+        /* ---------------------------------------------------------------------------------------------------------- */
+        TRAJECTORY_FORMAT FormatFromExtension(const std::string &file_path) {
+            const auto extension = fs::path(file_path).extension().string();
+            if (extension == ".bin")
+                return BINARY;
+            if (extension == ".ply")
+                return PLY;
+            SLAM_CHECK_STREAM(extension == ".txt", "Unrecognised trajectory format for the file "
+                    << file_path << " (expected .bin, .ply or .txt)");
+            return KITTI;
+        }
+
+    } // namespace
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    PoseRecord PoseRecord::FromPose(const Pose &pose) {
+        PoseRecord record{};
+        record.dest_timestamp = pose.dest_timestamp;
+        record.ref_timestamp = pose.ref_timestamp;
+        record.dest_frame_id = pose.dest_frame_id;
+        record.ref_frame_id = pose.ref_frame_id;
+        std::copy(pose.pose.quat.coeffs().data(), pose.pose.quat.coeffs().data() + 4, record.quat);
+        std::copy(pose.pose.tr.data(), pose.pose.tr.data() + 3, record.tr);
+        return record;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    Pose PoseRecord::ToPose() const {
+        Pose pose;
+        pose.dest_timestamp = dest_timestamp;
+        pose.ref_timestamp = ref_timestamp;
+        pose.dest_frame_id = dest_frame_id;
+        pose.ref_frame_id = ref_frame_id;
+        // Do not normalize the quaternion, to keep the conversion lossless
+        std::copy(quat, quat + 4, pose.pose.quat.coeffs().data());
+        std::copy(tr, tr + 3, pose.pose.tr.data());
+        return pose;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    BinaryTrajectoryWriter::BinaryTrajectoryWriter(const std::string &file_path, bool append,
+                                                   std::uint32_t index_stride) : file_path_(file_path) {
+        SLAM_CHECK_STREAM(index_stride > 0, "The index stride must be strictly positive");
+        std::memcpy(footer_.magic, kFooterMagic, sizeof(kFooterMagic));
+        footer_.index_stride = index_stride;
+
+        if (append && fs::exists(file_path)) {
+            ReadExistingFile();
+            return;
+        }
+
+        auto parent_path = fs::path(file_path).parent_path();
+        if (!parent_path.empty() && !fs::exists(parent_path))
+            fs::create_directories(parent_path);
+        {
+            std::ofstream create_file(file_path, std::ios::binary | std::ios::trunc);
+            SLAM_CHECK_STREAM(create_file.is_open(), "Could not create the file " << file_path);
+            auto header = MakeHeader();
+            create_file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        }
+        file_.open(file_path, std::ios::binary | std::ios::in | std::ios::out);
+        SLAM_CHECK_STREAM(file_.is_open(), "Could not open the file " << file_path);
+        is_dirty_ = true;
+        Flush();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BinaryTrajectoryWriter::ReadExistingFile() {
+        file_.open(file_path_, std::ios::binary | std::ios::in | std::ios::out);
+        SLAM_CHECK_STREAM(file_.is_open(), "Could not open the file " << file_path_);
+        file_.seekg(0, std::ios::end);
+        const auto kFileSize = size_t(file_.tellg());
+        SLAM_CHECK_STREAM(kFileSize >= sizeof(Header), "The file " << file_path_ << " is not a binary trajectory");
+
+        Header header;
+        file_.seekg(0);
+        file_.read(reinterpret_cast<char *>(&header), sizeof(Header));
+        CheckHeader(header, file_path_);
+
+        Footer footer;
+        bool valid_footer = false;
+        if (kFileSize >= sizeof(Header) + sizeof(Footer)) {
+            file_.seekg(std::streamoff(kFileSize - sizeof(Footer)));
+            file_.read(reinterpret_cast<char *>(&footer), sizeof(Footer));
+            valid_footer = IsValidFooter(footer, kFileSize);
+        }
+
+        if (valid_footer) {
+            // Appends keep the index stride of the existing file
+            footer_ = footer;
+            index_.resize(footer_.num_index_entries);
+            file_.seekg(std::streamoff(footer_.index_offset));
+            file_.read(reinterpret_cast<char *>(index_.data()), std::streamsize(index_.size() * sizeof(IndexEntry)));
+            if (footer_.num_records > 0) {
+                PoseRecord last_record;
+                file_.seekg(std::streamoff(footer_.index_offset - sizeof(PoseRecord)));
+                file_.read(reinterpret_cast<char *>(&last_record), sizeof(PoseRecord));
+                last_timestamp_ = last_record.dest_timestamp;
+            }
+        } else {
+            // The file was not closed properly: recover the records up to the first invalid one, and rebuild the index
+            SLAM_LOG(WARNING) << "The file " << file_path_ << " has no valid footer, rebuilding its index" << std::endl;
+            const auto kMaxNumRecords = (kFileSize - sizeof(Header)) / sizeof(PoseRecord);
+            footer_.num_records = 0;
+            footer_.flags = SORTED_BY_TIMESTAMP;
+            index_.clear();
+            PoseRecord record;
+            file_.seekg(std::streamoff(kRecordsOffset));
+            for (std::uint64_t idx(0); idx < kMaxNumRecords; ++idx) {
+                file_.read(reinterpret_cast<char *>(&record), sizeof(PoseRecord));
+                if (!file_ || !IsValidRecord(record)) {
+                    SLAM_LOG(WARNING) << "Discarding the data of the file " << file_path_ << " after the record "
+                                      << idx << std::endl;
+                    break;
+                }
+                if (idx % footer_.index_stride == 0)
+                    index_.push_back({record.dest_timestamp, idx});
+                if (record.dest_timestamp < last_timestamp_)
+                    footer_.flags &= ~SORTED_BY_TIMESTAMP;
+                last_timestamp_ = record.dest_timestamp;
+                footer_.num_records++;
+            }
+            is_dirty_ = true;
+        }
+        file_.clear();
+        has_trailer_ = kFileSize > kRecordsOffset + footer_.num_records * sizeof(PoseRecord);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BinaryTrajectoryWriter::TruncateAfterRecords() {
+        file_.flush();
+        fs::resize_file(file_path_, kRecordsOffset + footer_.num_records * sizeof(PoseRecord));
+        file_.clear();
+        has_trailer_ = false;
+        is_dirty_ = true;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BinaryTrajectoryWriter::Append(const Pose &pose) {
+        SLAM_CHECK_STREAM(file_.is_open(), "The writer is closed");
+        if (has_trailer_)
+            TruncateAfterRecords();
+        const auto kRecordIdx = footer_.num_records;
+        auto record = PoseRecord::FromPose(pose);
+        file_.seekp(std::streamoff(kRecordsOffset + kRecordIdx * sizeof(PoseRecord)));
+        file_.write(reinterpret_cast<const char *>(&record), sizeof(PoseRecord));
+        if (kRecordIdx % footer_.index_stride == 0)
+            index_.push_back({record.dest_timestamp, kRecordIdx});
+        if (record.dest_timestamp < last_timestamp_)
+            footer_.flags &= ~SORTED_BY_TIMESTAMP;
+        last_timestamp_ = record.dest_timestamp;
+        footer_.num_records++;
+        is_dirty_ = true;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BinaryTrajectoryWriter::Append(const std::vector<slam::Pose> &poses) {
+        for (auto &pose: poses)
+            Append(pose);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BinaryTrajectoryWriter::Flush() {
+        if (!file_.is_open() || !is_dirty_)
+            return;
+        footer_.index_offset = kRecordsOffset + footer_.num_records * sizeof(PoseRecord);
+        footer_.num_index_entries = index_.size();
+        file_.seekp(std::streamoff(footer_.index_offset));
+        file_.write(reinterpret_cast<const char *>(index_.data()), std::streamsize(index_.size() * sizeof(IndexEntry)));
+        file_.write(reinterpret_cast<const char *>(&footer_), sizeof(Footer));
+        file_.flush();
+        if (!file_.good())
+            throw std::runtime_error("Failed to write the binary trajectory " + file_path_);
+        is_dirty_ = false;
+        has_trailer_ = true;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BinaryTrajectoryWriter::Close() {
+        if (!file_.is_open())
+            return;
+        // Discard the invalid data after the records of a recovered file, before writing its footer
+        if (has_trailer_ && is_dirty_)
+            TruncateAfterRecords();
+        Flush();
+        file_.close();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    BinaryTrajectoryWriter::~BinaryTrajectoryWriter() {
+        try {
+            Close();
+        } catch (const std::exception &e) {
+            SLAM_LOG(ERROR) << "Could not close the binary trajectory " << file_path_ << ": " << e.what() << std::endl;
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    BinaryTrajectoryReader::BinaryTrajectoryReader(const std::string &file_path) {
+        file_ = std::make_unique<MemoryMappedFile>(file_path);
+        const auto kFileSize = file_->Size();
+        SLAM_CHECK_STREAM(kFileSize >= sizeof(Header) + sizeof(Footer),
+                          "The file " << file_path << " is not a valid binary trajectory");
+        Header header;
+        std::memcpy(&header, file_->Data(), sizeof(Header));
+        CheckHeader(header, file_path);
+        std::memcpy(&footer_, file_->At(kFileSize - sizeof(Footer)), sizeof(Footer));
+        SLAM_CHECK_STREAM(IsValidFooter(footer_, kFileSize),
+                          "Invalid footer for the file " << file_path
+                                                         << ". Open it with a BinaryTrajectoryWriter to recover it");
+        // The mapping is page-aligned, and all sections are 8 bytes aligned
+        records_ = reinterpret_cast<const PoseRecord *>(file_->At(kRecordsOffset));
+        index_ = reinterpret_cast<const IndexEntry *>(file_->At(footer_.index_offset));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    const PoseRecord &BinaryTrajectoryReader::RecordAt(size_t index) const {
+        SLAM_CHECK_STREAM(index < footer_.num_records, "Index " << index << " out of bounds");
+        return records_[index];
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::optional<size_t> BinaryTrajectoryReader::LowerBoundTimestamp(double timestamp) const {
+        SLAM_CHECK_STREAM(IsSortedByTimestamp(), "The records are not sorted by timestamp");
+        if (footer_.num_records == 0)
+            return {};
+
+        // Find the block of records between two index entries containing the lower bound
+        const auto *index_end = index_ + footer_.num_index_entries;
+        auto it = std::lower_bound(index_, index_end, timestamp,
+                                   [](const IndexEntry &entry, double t) { return entry.timestamp < t; });
+        size_t begin = it == index_ ? 0 : (it - 1)->record_idx;
+        size_t end = it == index_end ? footer_.num_records : it->record_idx + 1;
+        end = std::min(end, size_t(footer_.num_records));
+
+        auto record_it = std::lower_bound(records_ + begin, records_ + end, timestamp,
+                                          [](const PoseRecord &record, double t) {
+                                              return record.dest_timestamp < t;
+                                          });
+        auto idx = size_t(record_it - records_);
+        if (idx >= footer_.num_records)
+            return {};
+        return idx;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<slam::Pose> BinaryTrajectoryReader::ReadPoses(size_t begin, size_t end) const {
+        end = std::min(end, size_t(footer_.num_records));
+        std::vector<slam::Pose> poses;
+        if (begin >= end)
+            return poses;
+        poses.reserve(end - begin);
+        for (auto idx(begin); idx < end; ++idx)
+            poses.push_back(records_[idx].ToPose());
+        return poses;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void SavePosesBinary(const std::string &file_path, const std::vector<slam::Pose> &poses) {
+        BinaryTrajectoryWriter writer(file_path, false);
+        writer.Append(poses);
+        writer.Close();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void AppendPosesBinary(const std::string &file_path, const std::vector<slam::Pose> &poses) {
+        BinaryTrajectoryWriter writer(file_path, true);
+        writer.Append(poses);
+        writer.Close();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<slam::Pose> ReadPosesBinary(const std::string &file_path) {
+        BinaryTrajectoryReader reader(file_path);
+        return reader.ReadPoses();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void ConvertTrajectoryFile(const std::string &input_file_path, const std::string &output_file_path) {
+        std::vector<slam::Pose> poses;
+        switch (FormatFromExtension(input_file_path)) {
+            case BINARY:
+                poses = ReadPosesBinary(input_file_path);
+                break;
+            case PLY:
+                poses = ReadPosesFromPLY(input_file_path);
+                break;
+            case KITTI:
+                poses = LoadPosesKITTIFormat(input_file_path);
+                break;
+        }
+
+        switch (FormatFromExtension(output_file_path)) {
+            case BINARY:
+                SavePosesBinary(output_file_path, poses);
+                break;
+            case PLY:
+                SavePosesAsPLY(output_file_path, poses);
+                break;
+            case KITTI:
+                SLAM_CHECK_STREAM(SavePosesKITTIFormat(output_file_path, poses),
+                                  "Could not write the poses to the file " << output_file_path);
+                break;
+        }
+    }
+
+} // namespace slam
@@ -45,40 +45,50 @@ namespace slam {
         return data.size() / item_info.item_size;
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void VectorBuffer::Grow(size_t num_bytes, bool geometric_growth) {
+        if (num_bytes <= data.capacity())
+            return;
+        if (pool_ && data.capacity() == 0)
+            data = pool_->Acquire(num_bytes);
+        else
+            data.reserve(geometric_growth ? std::max(num_bytes, 2 * data.capacity()) : num_bytes);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void VectorBuffer::UpdateDataPtr() {
+        // A reallocation can change the pointer to the first element
+        if (data.empty())
+            view_data_ptr = nullptr;
+        else
+            view_data_ptr = &data[0];
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
     void VectorBuffer::InsertItems(size_t num_items, const char *items_data) {
         const int item_size = item_info.item_size;
         const size_t new_items_size = num_items * item_size;
-        for (auto i(0); i < new_items_size; ++i)
-            data.push_back(items_data ? items_data[i] : char(0)); // by default initialize all bytes to zero
-
-        if (!data.empty())
-            view_data_ptr = &data[0];
+        const size_t old_size = data.size();
+        Grow(old_size + new_items_size, true);
+        if (items_data)
+            data.insert(data.end(), items_data, items_data + new_items_size);
+        else
+            data.resize(old_size + new_items_size, char(0)); // by default initialize all bytes to zero
+        UpdateDataPtr();
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
     void VectorBuffer::Resize(size_t num_items) {
         auto new_size = num_items * item_info.item_size;
-        auto old_size = data.size();
-        data.resize(new_size);
-        if (new_size > old_size)
-            std::fill(data.begin() + old_size, data.begin() + new_size, char(0));
-
-        // The resize operation can change the pointer to the first element
-        if (data.empty())
-            view_data_ptr = nullptr;
-        else
-            view_data_ptr = &data[0];
+        Grow(new_size, true);
+        data.resize(new_size, char(0));
+        UpdateDataPtr();
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
     void VectorBuffer::Reserve(size_t num_items) {
-        data.reserve(num_items + item_info.item_size);
-        // The reserve operation can change the pointer to the first element
-        if (data.empty())
-            view_data_ptr = nullptr;
-        else
-            view_data_ptr = &data[0];
+        Grow(num_items * item_info.item_size, false);
+        UpdateDataPtr();
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
@@ -86,6 +96,17 @@ namespace slam {
         Reserve(num_items + NumItems());
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t VectorBuffer::Capacity() const {
+        return data.capacity() / item_info.item_size;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void VectorBuffer::ShrinkToFit() {
+        data.shrink_to_fit();
+        UpdateDataPtr();
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
     VectorBuffer VectorBuffer::DeepCopy(const ItemBuffer &other) {
         VectorBuffer new_buffer(other.GetItemSchema().GetBuilder().Build(), other.item_info.item_size);
@@ -96,9 +117,9 @@ namespace slam {
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
-    std::unique_ptr<VectorBuffer> VectorBuffer::DeepCopyPtr(const ItemBuffer &other) {
+    std::unique_ptr<VectorBuffer> VectorBuffer::DeepCopyPtr(const ItemBuffer &other, std::shared_ptr<BufferPool> pool) {
         auto new_buffer = std::make_unique<VectorBuffer>(other.GetItemSchema().GetBuilder().Build(),
-                                                         other.item_info.item_size);
+                                                         other.item_info.item_size, std::move(pool));
         new_buffer->Resize(other.NumItems());
         std::copy(other.view_data_ptr, other.view_data_ptr + other.item_info.item_size * other.NumItems(),
                   new_buffer->data.data());
@@ -106,7 +127,10 @@ namespace slam {
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
-    VectorBuffer::~VectorBuffer() = default;
+    VectorBuffer::~VectorBuffer() {
+        if (pool_)
+            pool_->Release(std::move(data));
+    }
 
     /* -------------------------------------------------------------------------------------------------------------- */
     BufferWrapper::BufferWrapper(ItemSchema &&view, char *buffer, size_t num_items,
@@ -1,4 +1,5 @@
 #include "SlamCore/data/buffer_collection.h"
+#include "SlamCore/data/schema_converter.h"
 
 namespace slam {
 
@@ -17,7 +18,7 @@ namespace slam {
     /* -------------------------------------------------------------------------------------------------------------- */
     bool BufferCollection::HasElement(const std::string &name) const {
         return std::find_if(item_buffers.begin(),
-                            item_buffers.end(), [&name](const ItemBufferPtr &ptr) {
+                            item_buffers.end(), [&name](const SharedItemBufferPtr &ptr) {
                     return ptr && (*ptr).item_info.HasElement(name);
                 }) != item_buffers.end();
     }
@@ -31,7 +32,7 @@ namespace slam {
 
     /* -------------------------------------------------------------------------------------------------------------- */
     bool BufferCollection::IsResizable() const {
-        return std::all_of(item_buffers.begin(), item_buffers.end(), [&](const ItemBufferPtr &ptr) {
+        return std::all_of(item_buffers.begin(), item_buffers.end(), [&](const SharedItemBufferPtr &ptr) {
             return ptr->IsResizable();
         });
     }
@@ -39,6 +40,7 @@ namespace slam {
     /* -------------------------------------------------------------------------------------------------------------- */
     ItemInfo &BufferCollection::GetItemInfo(size_t item_index) {
         CHECK(item_index < item_buffers.size()) << "Invalid item index" << std::endl;
+        Detach(item_index);
         return item_buffers[item_index]->item_info;
     }
 
@@ -53,7 +55,9 @@ namespace slam {
         if (!buffer_ptr.empty()) {
             CHECK(AreSizesConsistent(buffer_ptr)) << "Sizes are consistent" << std::endl;
         }
-        item_buffers = std::move(buffer_ptr);
+        item_buffers.reserve(buffer_ptr.size());
+        for (auto &ptr: buffer_ptr)
+            item_buffers.emplace_back(std::move(ptr));
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
@@ -62,6 +66,10 @@ namespace slam {
         item_buffers[0] = std::move(buffer_ptr);
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    BufferCollection::BufferCollection(std::vector<SharedItemBufferPtr> &&buffer_ptr) :
+            item_buffers(std::move(buffer_ptr)) {}
+
 
     /* -------------------------------------------------------------------------------------------------------------- */
     bool BufferCollection::AreSizesConsistent(const std::vector<ItemBufferPtr> &buffer) {
@@ -92,31 +100,45 @@ namespace slam {
         return static_cast<int>(std::accumulate(item_buffers.begin(),
                                                 item_buffers.end(),
                                                 0,
-                                                [](int acc, const ItemBufferPtr &buffer_ptr) {
+                                                [](int acc, const SharedItemBufferPtr &buffer_ptr) {
                                                     return acc + (buffer_ptr ? 1 : 0);
                                                 }));
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
     void BufferCollection::Resize(size_t new_size) {
+        CHECK(IsResizable());
+        DetachAll();
         for (auto &buffer: item_buffers) {
-            CHECK(buffer->IsResizable());
             dynamic_cast<ResizableBuffer &>(*buffer).Resize(new_size);
         }
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
     void BufferCollection::Reserve(size_t new_size) {
+        CHECK(IsResizable());
+        DetachAll();
         for (auto &buffer: item_buffers) {
-            CHECK(buffer->IsResizable());
             dynamic_cast<ResizableBuffer &>(*buffer).Reserve(new_size);
         }
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t BufferCollection::Capacity() const {
+        CHECK(IsResizable());
+        size_t capacity = std::numeric_limits<size_t>::max();
+        for (auto &buffer: item_buffers) {
+            if (buffer)
+                capacity = std::min(capacity, dynamic_cast<const ResizableBuffer &>(*buffer).Capacity());
+        }
+        return capacity;
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
     void BufferCollection::RemoveElement(const std::string &element_name, bool remove_if_empty) {
         if (HasElement(element_name)) {
             size_t item_index = GetItemIndex(element_name);
+            Detach(item_index);
             auto &item = item_buffers[item_index];
             item->RemoveElementFromSchema(element_name);
 
@@ -148,6 +170,7 @@ namespace slam {
     /* -------------------------------------------------------------------------------------------------------------- */
     void BufferCollection::InsertItems(size_t num_items) {
         CHECK(IsResizable());
+        DetachAll();
         for (auto &buffer_ptr: item_buffers) {
             dynamic_cast<ResizableBuffer &>(*buffer_ptr).InsertItems(num_items);
         }
@@ -189,27 +212,20 @@ namespace slam {
         auto collection = EmptyCopy();
         const auto kNumSelectedPoints = indices.size();
         collection.Resize(kNumSelectedPoints);
+        for (auto old_item_idx: indices)
+            SLAM_CHECK_STREAM(old_item_idx < NumItemsPerBuffer(),
+                              "Invalid index! " << old_item_idx << " Not in the range[0, "
+                                                << NumItemsPerBuffer() << "]");
 
         int num_buffers = NumItemsInSchema();
         for (auto buffer_idx(0); buffer_idx < num_buffers; buffer_idx++) {
             auto &buffer = item_buffers[buffer_idx];
             auto &dest_buffer = collection.item_buffers[buffer_idx];
 
-            const char *old_buffer_ptr = buffer->view_data_ptr;
-            char *buffer_ptr = dest_buffer->view_data_ptr;
-            const auto kItemSize = buffer->item_info.item_size;
-            for (auto item_idx(0); item_idx < kNumSelectedPoints; ++item_idx) {
-                auto old_item_idx = indices[item_idx];
-                SLAM_CHECK_STREAM(old_item_idx < NumItemsPerBuffer(),
-                                  "Invalid index! " << old_item_idx << " Not in the range[0, "
-                                                    << kNumSelectedPoints << "]");
-
-                // Copy Item Data
-                std::copy(old_buffer_ptr + old_item_idx * kItemSize,
-                          old_buffer_ptr + (old_item_idx + 1) * kItemSize,
-                          buffer_ptr + item_idx * kItemSize);
-
-            }
+            // Copy Item Data
+            auto &schema = buffer->GetItemSchema();
+            SchemaConverter::Get(schema, schema)->ConvertSelection(buffer->view_data_ptr, indices,
+                                                                   dest_buffer->view_data_ptr);
         }
         return collection;
     }
@@ -217,7 +233,19 @@ namespace slam {
     /* -------------------------------------------------------------------------------------------------------------- */
     void BufferCollection::Append(const BufferCollection &collection) {
         SLAM_CHECK_STREAM(IsResizable(), "Cannot append points to a non-resizable point cloud");
-        SLAM_CHECK_STREAM(HasSameSchema(collection), "The Two collections do not have the same schema");
+        SLAM_CHECK_STREAM(collection.NumItemsInSchema() == NumItemsInSchema(),
+                          "The Two collections do not have the same number of items in their schema");
+        std::vector<std::shared_ptr<const SchemaConverter>> converters(NumItemsInSchema());
+        for (auto idx(0); idx < NumItemsInSchema(); ++idx) {
+            converters[idx] = SchemaConverter::Get(collection.GetItemInfo(idx).item_schema,
+                                                   GetItemInfo(idx).item_schema);
+            // Items with different names are copied as raw bytes only if they have the same memory layout
+            if (!converters[idx]->IsComplete() &&
+                (collection.GetItemInfo(idx).item_size != GetItemInfo(idx).item_size ||
+                 !HaveSameLayout(collection.GetItemInfo(idx).item_schema, GetItemInfo(idx).item_schema)))
+                throw std::runtime_error("The Two collections do not have the same schema");
+        }
+
         size_t old_size = NumItemsPerBuffer();
         size_t num_items = collection.NumItemsPerBuffer();
         Resize(old_size + num_items);
@@ -228,7 +256,10 @@ namespace slam {
 
             auto dest_ptr = (item_info.parent_buffer->view_data_ptr + item_info.item_size * old_size);
             auto src_ptr = other_item_info.parent_buffer->view_data_ptr;
-            std::copy(src_ptr, src_ptr + num_items * other_item_info.item_size, dest_ptr);
+            if (converters[idx]->IsComplete())
+                converters[idx]->Convert(src_ptr, dest_ptr, num_items);
+            else
+                std::copy(src_ptr, src_ptr + num_items * other_item_info.item_size, dest_ptr);
         }
     }
 
@@ -246,5 +277,118 @@ namespace slam {
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
+    bool BufferCollection::IsShared(size_t item_index) const {
+        CHECK(item_index < item_buffers.size()) << "Bad Index" << std::endl;
+        return item_buffers[item_index] && item_buffers[item_index].use_count() > 1;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BufferCollection::Detach(size_t item_index) {
+        if (!IsShared(item_index))
+            return;
+        // The detached buffer is allocated from the pool of the shared buffer (if any)
+        auto *vector_buffer = dynamic_cast<const VectorBuffer *>(item_buffers[item_index].get());
+        item_buffers[item_index] = VectorBuffer::DeepCopyPtr(*item_buffers[item_index],
+                                                             vector_buffer ? vector_buffer->Pool() : nullptr);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BufferCollection::DetachAll() {
+        for (auto idx(0); idx < item_buffers.size(); ++idx)
+            Detach(idx);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    BufferCollection BufferCollection::ShallowCopy() const {
+        std::vector<SharedItemBufferPtr> buffers;
+        buffers.reserve(item_buffers.size());
+        for (auto &buffer: item_buffers) {
+            if (!buffer || buffer->OwnsData())
+                buffers.push_back(buffer);
+            else
+                buffers.push_back(VectorBuffer::DeepCopyPtr(*buffer));
+        }
+        return BufferCollection(std::move(buffers));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::optional<ItemSchema> BufferCollection::ProjectSchema(const ItemSchema &schema,
+                                                              const std::vector<std::string> &element_names) {
+        ItemSchema::Builder builder(0);
+        int offset = 0;
+        for (auto &element_name: element_names) {
+            if (!schema.HasElement(element_name))
+                continue;
+            auto &element = schema.GetElementInfo(element_name);
+            builder.AddElement(element_name, offset);
+            for (auto &property: element.properties)
+                builder.AddProperty(element_name, std::string(property.property_name),
+                                    property.type, property.offset_in_elem, property.dimension);
+            offset += element.ElementSize();
+        }
+        if (offset == 0)
+            return {};
+        builder.SetItemSize(offset);
+        return builder.Build();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    BufferCollection BufferCollection::SelectElements(const std::vector<std::string> &element_names) const {
+        std::vector<SharedItemBufferPtr> buffers;
+        for (auto &buffer: item_buffers) {
+            if (!buffer)
+                continue;
+            auto &schema = buffer->GetItemSchema();
+            auto projected_schema = ProjectSchema(schema, element_names);
+            if (!projected_schema)
+                continue;
+
+            // All elements are selected: share the buffer (or copy it if it does not own its data)
+            if (projected_schema->GetElementNames().size() == schema.GetElementNames().size()) {
+                if (buffer->OwnsData())
+                    buffers.push_back(buffer);
+                else
+                    buffers.push_back(VectorBuffer::DeepCopyPtr(*buffer));
+                continue;
+            }
+
+            // Otherwise copy the selected elements in a new buffer
+            const auto kItemSize = projected_schema->GetItemSize();
+            auto converter = SchemaConverter::Get(schema, *projected_schema);
+            auto new_buffer = std::make_shared<VectorBuffer>(std::move(*projected_schema), kItemSize);
+            new_buffer->Resize(buffer->NumItems());
+            converter->Convert(buffer->view_data_ptr, new_buffer->view_data_ptr, buffer->NumItems());
+            buffers.emplace_back(std::move(new_buffer));
+        }
+        SLAM_CHECK_STREAM(!buffers.empty(), "None of the selected elements exist in the collection");
+        return BufferCollection(std::move(buffers));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    BufferCollection BufferCollection::SelectItems(const std::vector<size_t> &indices,
+                                                   const std::vector<std::string> &element_names) const {
+        for (auto old_item_idx: indices)
+            SLAM_CHECK_STREAM(old_item_idx < NumItemsPerBuffer(),
+                              "Invalid index! " << old_item_idx << " Not in the range[0, "
+                                                << NumItemsPerBuffer() << "]");
+        std::vector<SharedItemBufferPtr> buffers;
+        for (auto &buffer: item_buffers) {
+            if (!buffer)
+                continue;
+            auto &schema = buffer->GetItemSchema();
+            auto projected_schema = ProjectSchema(schema, element_names);
+            if (!projected_schema)
+                continue;
+
+            const auto kItemSize = projected_schema->GetItemSize();
+            auto converter = SchemaConverter::Get(schema, *projected_schema);
+            auto new_buffer = std::make_shared<VectorBuffer>(std::move(*projected_schema), kItemSize);
+            new_buffer->Resize(indices.size());
+            converter->ConvertSelection(buffer->view_data_ptr, indices, new_buffer->view_data_ptr);
+            buffers.emplace_back(std::move(new_buffer));
+        }
+        SLAM_CHECK_STREAM(!buffers.empty(), "None of the selected elements exist in the collection");
+        return BufferCollection(std::move(buffers));
+    }
 
-}
\ No newline at end of file
+}
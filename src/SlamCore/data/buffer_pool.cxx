@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "SlamCore/data/buffer_pool.h"
+
+namespace slam {
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<BufferPool> BufferPool::DefaultPool() {
+        static std::shared_ptr<BufferPool> pool = std::make_shared<BufferPool>();
+        return pool;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<char> BufferPool::Acquire(size_t num_bytes) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Select the smallest byte array with a sufficient capacity
+            auto best_it = buffers_.end();
+            for (auto it = buffers_.begin(); it != buffers_.end(); ++it) {
+                if (it->capacity() >= num_bytes &&
+                    (best_it == buffers_.end() || it->capacity() < best_it->capacity()))
+                    best_it = it;
+            }
+            if (best_it != buffers_.end()) {
+                std::vector<char> data = std::move(*best_it);
+                buffers_.erase(best_it);
+                pooled_bytes_ -= data.capacity();
+                num_recycled_++;
+                return data;
+            }
+        }
+        num_allocated_++;
+        std::vector<char> data;
+        data.reserve(num_bytes);
+        return data;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BufferPool::Release(std::vector<char> &&data) {
+        const auto kCapacity = data.capacity();
+        if (kCapacity == 0 || kCapacity > options_.max_total_bytes || options_.max_num_buffers == 0)
+            return;
+        data.clear();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffers_.emplace_back(std::move(data));
+        pooled_bytes_ += kCapacity;
+
+        // Drop the smallest byte arrays until the pool is within its limits
+        while (buffers_.size() > options_.max_num_buffers || pooled_bytes_ > options_.max_total_bytes) {
+            auto min_it = std::min_element(buffers_.begin(), buffers_.end(),
+                                           [](const std::vector<char> &lhs, const std::vector<char> &rhs) {
+                                               return lhs.capacity() < rhs.capacity();
+                                           });
+            pooled_bytes_ -= min_it->capacity();
+            buffers_.erase(min_it);
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void BufferPool::Clear() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffers_.clear();
+        pooled_bytes_ = 0;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t BufferPool::NumPooledBuffers() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return buffers_.size();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t BufferPool::PooledBytes() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return pooled_bytes_;
+    }
+
+} // namespace slam
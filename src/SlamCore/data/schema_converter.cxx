@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <tuple>
+
+#include "SlamCore/data/schema_converter.h"
+#include "SlamCore/concurrent/lru_cache.h"
+
+namespace slam {
+
+    namespace {
+
+        template<typename SourceT, typename DestT>
+        void StridedScalarCopy(const char *source, size_t source_stride,
+                               char *dest, size_t dest_stride, size_t num_items) {
+            if (source_stride == sizeof(SourceT) && dest_stride == sizeof(DestT)) {
+                // Contiguous columns: a simple loop which the compiler vectorizes
+                const auto *source_ptr = reinterpret_cast<const SourceT *>(source);
+                auto *dest_ptr = reinterpret_cast<DestT *>(dest);
+                for (size_t idx(0); idx < num_items; ++idx)
+                    dest_ptr[idx] = static_cast<DestT>(source_ptr[idx]);
+                return;
+            }
+            for (size_t idx(0); idx < num_items; ++idx) {
+                SourceT value;
+                std::memcpy(&value, source + idx * source_stride, sizeof(SourceT));
+                auto converted = static_cast<DestT>(value);
+                std::memcpy(dest + idx * dest_stride, &converted, sizeof(DestT));
+            }
+        }
+
+        template<typename SourceT>
+        StridedScalarCopyFunction SelectCopyFunction(PROPERTY_TYPE dest_type) {
+            switch (dest_type) {
+                case FLOAT32:
+                    return &StridedScalarCopy<SourceT, float>;
+                case FLOAT64:
+                    return &StridedScalarCopy<SourceT, double>;
+                case INT8:
+                    return &StridedScalarCopy<SourceT, std::int8_t>;
+                case UINT8:
+                    return &StridedScalarCopy<SourceT, std::uint8_t>;
+                case INT16:
+                    return &StridedScalarCopy<SourceT, std::int16_t>;
+                case UINT16:
+                    return &StridedScalarCopy<SourceT, std::uint16_t>;
+                case INT32:
+                    return &StridedScalarCopy<SourceT, std::int32_t>;
+                case UINT32:
+                    return &StridedScalarCopy<SourceT, std::uint32_t>;
+                case INT64:
+                    return &StridedScalarCopy<SourceT, std::int64_t>;
+                case UINT64:
+                    return &StridedScalarCopy<SourceT, std::uint64_t>;
+            }
+            throw std::runtime_error("The property type " + std::to_string(dest_type) + " does not exist");
+        }
+
+        // Copies `num_bytes` at the same offset of each item
+        inline void StridedMemcpy(const char *source, size_t source_stride,
+                                  char *dest, size_t dest_stride, size_t num_items, size_t num_bytes) {
+            for (size_t idx(0); idx < num_items; ++idx)
+                std::memcpy(dest + idx * dest_stride, source + idx * source_stride, num_bytes);
+        }
+
+    } // namespace
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    StridedScalarCopyFunction GetStridedScalarCopyFunction(PROPERTY_TYPE source_type, PROPERTY_TYPE dest_type) {
+        switch (source_type) {
+            case FLOAT32:
+                return SelectCopyFunction<float>(dest_type);
+            case FLOAT64:
+                return SelectCopyFunction<double>(dest_type);
+            case INT8:
+                return SelectCopyFunction<std::int8_t>(dest_type);
+            case UINT8:
+                return SelectCopyFunction<std::uint8_t>(dest_type);
+            case INT16:
+                return SelectCopyFunction<std::int16_t>(dest_type);
+            case UINT16:
+                return SelectCopyFunction<std::uint16_t>(dest_type);
+            case INT32:
+                return SelectCopyFunction<std::int32_t>(dest_type);
+            case UINT32:
+                return SelectCopyFunction<std::uint32_t>(dest_type);
+            case INT64:
+                return SelectCopyFunction<std::int64_t>(dest_type);
+            case UINT64:
+                return SelectCopyFunction<std::uint64_t>(dest_type);
+        }
+        throw std::runtime_error("The property type " + std::to_string(source_type) + " does not exist");
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::string SchemaSignature(const ItemSchema &schema) {
+        std::stringstream ss;
+        ss << schema.GetItemSize();
+        for (auto &elem_name: schema.GetElementNames()) {
+            auto &elem = schema.GetElementInfo(elem_name);
+            ss << '|' << elem_name << '@' << elem.offset_in_item;
+            for (auto &pty: elem.properties)
+                ss << ',' << pty.property_name << ':' << PropertyTypeChar(pty.type)
+                   << pty.dimension << '@' << pty.offset_in_elem;
+        }
+        return ss.str();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool HaveSameLayout(const ItemSchema &lhs, const ItemSchema &rhs) {
+        if (lhs.GetItemSize() != rhs.GetItemSize())
+            return false;
+        // The properties of each schema, as (offset in the item, type, dimension) sorted by offset
+        auto layout = [](const ItemSchema &schema) {
+            std::vector<std::tuple<int, int, int>> properties;
+            for (auto &elem_name: schema.GetElementNames()) {
+                auto &elem = schema.GetElementInfo(elem_name);
+                for (auto &pty: elem.properties)
+                    properties.emplace_back(elem.offset_in_item + pty.offset_in_elem, int(pty.type), pty.dimension);
+            }
+            std::sort(properties.begin(), properties.end());
+            return properties;
+        };
+        return layout(lhs) == layout(rhs);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    SchemaConverter::SchemaConverter(const ItemSchema &source, const ItemSchema &dest) :
+            source_item_size_(source.GetItemSize()), dest_item_size_(dest.GetItemSize()) {
+        std::vector<Operation> memcpy_ops, convert_ops;
+        for (auto &elem_name: dest.GetElementNames()) {
+            auto &dest_elem = dest.GetElementInfo(elem_name);
+            for (auto &dest_pty: dest_elem.properties) {
+                if (!source.HasProperty(elem_name, dest_pty.property_name)) {
+                    is_complete_ = false;
+                    continue;
+                }
+                auto &source_elem = source.GetElementInfo(elem_name);
+                auto &source_pty = source.GetPropertyInfo(elem_name, dest_pty.property_name);
+                if (source_pty.dimension != dest_pty.dimension) {
+                    is_complete_ = false;
+                    continue;
+                }
+
+                Operation op;
+                op.source_offset = source_elem.offset_in_item + source_pty.offset_in_elem;
+                op.dest_offset = dest_elem.offset_in_item + dest_pty.offset_in_elem;
+                op.num_bytes = dest_pty.Size();
+                op.dimension = dest_pty.dimension;
+                op.source_type = source_pty.type;
+                op.dest_type = dest_pty.type;
+                if (source_pty.type == dest_pty.type) {
+                    op.type = Operation::MEMCPY;
+                    memcpy_ops.push_back(op);
+                } else {
+                    op.type = Operation::CONVERT;
+                    op.function = GetStridedScalarCopyFunction(source_pty.type, dest_pty.type);
+                    convert_ops.push_back(op);
+                }
+            }
+        }
+
+        // Merge the byte runs which are contiguous (or overlapping) in both the source and destination
+        std::sort(memcpy_ops.begin(), memcpy_ops.end(), [](const Operation &lhs, const Operation &rhs) {
+            return lhs.dest_offset < rhs.dest_offset;
+        });
+        for (auto &op: memcpy_ops) {
+            if (!operations_.empty()) {
+                auto &last = operations_.back();
+                if (last.dest_offset - last.source_offset == op.dest_offset - op.source_offset &&
+                    op.dest_offset <= last.dest_offset + last.num_bytes) {
+                    last.num_bytes = std::max(last.num_bytes, op.dest_offset + op.num_bytes - last.dest_offset);
+                    continue;
+                }
+            }
+            operations_.push_back(op);
+        }
+
+        // Merge the conversions of consecutive scalars with the same types (e.g. x, y, z) in a single operation
+        std::sort(convert_ops.begin(), convert_ops.end(), [](const Operation &lhs, const Operation &rhs) {
+            return lhs.dest_offset < rhs.dest_offset;
+        });
+        const auto num_memcpy_ops = operations_.size();
+        for (auto &op: convert_ops) {
+            if (operations_.size() > num_memcpy_ops) {
+                auto &last = operations_.back();
+                if (last.source_type == op.source_type && last.dest_type == op.dest_type &&
+                    op.source_offset == last.source_offset + last.dimension * PropertySize(last.source_type) &&
+                    op.dest_offset == last.dest_offset + last.num_bytes) {
+                    last.dimension += op.dimension;
+                    last.num_bytes += op.num_bytes;
+                    continue;
+                }
+            }
+            operations_.push_back(op);
+        }
+
+        is_identity_ = is_complete_ && source_item_size_ == dest_item_size_ &&
+                       ((operations_.size() == 1 && operations_.front().type == Operation::MEMCPY &&
+                         operations_.front().source_offset == operations_.front().dest_offset) ||
+                        SchemaSignature(source) == SchemaSignature(dest));
+        if (is_identity_) {
+            operations_.resize(1);
+            // The whole item is copied (including the eventual padding between the elements)
+            auto &op = operations_.front();
+            op.type = Operation::MEMCPY;
+            op.source_offset = op.dest_offset = 0;
+            op.num_bytes = dest_item_size_;
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<const SchemaConverter> SchemaConverter::Get(const ItemSchema &source, const ItemSchema &dest) {
+        static slam::lru_cache<std::string, std::shared_ptr<const SchemaConverter>> converters(256);
+        auto key = SchemaSignature(source) + "->" + SchemaSignature(dest);
+        auto converter = converters.get(key);
+        if (converter)
+            return *converter;
+        auto new_converter = std::make_shared<const SchemaConverter>(source, dest);
+        converters.put(key, new_converter);
+        return new_converter;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void SchemaConverter::Convert(const char *source, char *dest, size_t num_items) const {
+        if (is_identity_) {
+            std::memcpy(dest, source, num_items * dest_item_size_);
+            return;
+        }
+        for (auto &op: operations_) {
+            const char *source_ptr = source + op.source_offset;
+            char *dest_ptr = dest + op.dest_offset;
+            if (op.type == Operation::MEMCPY) {
+                StridedMemcpy(source_ptr, source_item_size_, dest_ptr, dest_item_size_, num_items, op.num_bytes);
+                continue;
+            }
+            const int source_scalar_size = PropertySize(op.source_type);
+            const int dest_scalar_size = PropertySize(op.dest_type);
+            for (int dim(0); dim < op.dimension; ++dim)
+                op.function(source_ptr + dim * source_scalar_size, source_item_size_,
+                            dest_ptr + dim * dest_scalar_size, dest_item_size_, num_items);
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void SchemaConverter::ConvertSelection(const char *source, const std::vector<size_t> &indices, char *dest) const {
+        if (is_identity_) {
+            for (size_t idx(0); idx < indices.size(); ++idx)
+                std::memcpy(dest + idx * dest_item_size_, source + indices[idx] * source_item_size_,
+                            dest_item_size_);
+            return;
+        }
+        for (size_t idx(0); idx < indices.size(); ++idx)
+            Convert(source + indices[idx] * source_item_size_, dest + idx * dest_item_size_, 1);
+    }
+
+} // namespace slam
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstddef>
+
+#include "SlamCore/data/slab_pool.h"
+#include "SlamCore/utils.h"
+
+namespace slam {
+
+    namespace {
+        constexpr size_t kMinBlockSize = 64;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    SlabPool::SlabPool(const Options &options) : options_(options) {
+        SLAM_CHECK_STREAM(options_.slab_size >= 4 * kMinBlockSize,
+                          "The slab size " << options_.slab_size << " is too small");
+        // Size classes 2^k and 3 * 2^(k-1), up to a quarter of a slab
+        for (size_t size = kMinBlockSize; size <= options_.slab_size / 4; size *= 2) {
+            class_sizes_.push_back(size);
+            if (size + size / 2 <= options_.slab_size / 4)
+                class_sizes_.push_back(size + size / 2);
+        }
+        free_lists_.resize(class_sizes_.size(), nullptr);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    SlabPool::~SlabPool() = default;
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t SlabPool::SizeClass(size_t num_bytes) const {
+        return std::lower_bound(class_sizes_.begin(), class_sizes_.end(), num_bytes) - class_sizes_.begin();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t SlabPool::BlockSize(size_t num_bytes) const {
+        auto class_idx = SizeClass(num_bytes);
+        return class_idx < class_sizes_.size() ? class_sizes_[class_idx] : num_bytes;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void SlabPool::RecycleSlabRemainder() {
+        // Split the remainder in blocks of decreasing sizes (a tail smaller than the smallest class is lost)
+        while (slab_cursor_ && size_t(slab_end_ - slab_cursor_) >= kMinBlockSize) {
+            auto remaining = size_t(slab_end_ - slab_cursor_);
+            auto class_idx = size_t(std::upper_bound(class_sizes_.begin(), class_sizes_.end(), remaining) -
+                                    class_sizes_.begin()) - 1;
+            *reinterpret_cast<void **>(slab_cursor_) = free_lists_[class_idx];
+            free_lists_[class_idx] = slab_cursor_;
+            slab_cursor_ += class_sizes_[class_idx];
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void *SlabPool::Allocate(size_t num_bytes) {
+        stats_.num_allocations++;
+        stats_.num_blocks++;
+        stats_.requested_bytes += num_bytes;
+        const auto class_idx = SizeClass(num_bytes);
+        if (class_idx >= class_sizes_.size()) {
+            // Large blocks are not pooled
+            stats_.reserved_bytes += num_bytes;
+            stats_.allocated_bytes += num_bytes;
+            return ::operator new(num_bytes);
+        }
+
+        const size_t block_size = class_sizes_[class_idx];
+        stats_.allocated_bytes += block_size;
+        if (free_lists_[class_idx]) {
+            void *block = free_lists_[class_idx];
+            free_lists_[class_idx] = *reinterpret_cast<void **>(block);
+            stats_.num_recycled++;
+            return block;
+        }
+
+        if (!slab_cursor_ || size_t(slab_end_ - slab_cursor_) < block_size) {
+            RecycleSlabRemainder();
+            // `new char[]` returns memory aligned for any fundamental type, and the block sizes preserve it
+            slabs_.emplace_back(new char[options_.slab_size]);
+            slab_cursor_ = slabs_.back().get();
+            slab_end_ = slab_cursor_ + options_.slab_size;
+            stats_.num_slabs++;
+            stats_.reserved_bytes += options_.slab_size;
+        }
+        void *block = slab_cursor_;
+        slab_cursor_ += block_size;
+        return block;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void SlabPool::Deallocate(void *ptr, size_t num_bytes) {
+        if (!ptr)
+            return;
+        stats_.num_blocks--;
+        stats_.requested_bytes -= num_bytes;
+        const auto class_idx = SizeClass(num_bytes);
+        if (class_idx >= class_sizes_.size()) {
+            stats_.reserved_bytes -= num_bytes;
+            stats_.allocated_bytes -= num_bytes;
+            ::operator delete(ptr);
+            return;
+        }
+        stats_.allocated_bytes -= class_sizes_[class_idx];
+        *reinterpret_cast<void **>(ptr) = free_lists_[class_idx];
+        free_lists_[class_idx] = ptr;
+    }
+
+} // namespace slam
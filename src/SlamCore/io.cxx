@@ -7,6 +7,7 @@
 #include "SlamCore/io.h"
 #include "SlamCore/generic_tools.h"
 #include "SlamCore/data/buffer.h"
+#include "SlamCore/data/schema_converter.h"
 
 namespace slam {
 
@@ -573,82 +574,6 @@ namespace slam {
         }
     }
 
-#define CONVERT_SOURCE_TO_DEST(src_ptr, _src_type, dest_ptr, _dest_type) \
-    (*reinterpret_cast<_dest_type *>(dest_ptr)) = _dest_type(*reinterpret_cast<const _src_type *>(src_ptr));
-
-#define TINYPLY_TO_SLAM__CASE_SLAM(dest_slam_pty, _dest_slam_type, _src_tinyply_type) \
-    case dest_slam_pty : \
-    CONVERT_SOURCE_TO_DEST(source, _src_tinyply_type, dest, _dest_slam_type)\
-    break;
-
-#define SLAM_TO_TINYPLY__CASE_SLAM(src_slam_pty, _src_slam_type, _dest_tinyply_type) \
-    case src_slam_pty: \
-    CONVERT_SOURCE_TO_DEST(source, _src_slam_type, dest, _dest_tinyply_type)\
-    break;
-
-#define TINYPLY_TO_SLAM__CASE_TINYPLY(tinyply_type, _type) \
-    case tinyply_type: { switch(dest_type) {                  \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::FLOAT64, double, _type); \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::FLOAT32, float, _type);  \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::INT64, std::int64_t , _type);  \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::UINT64, std::uint64_t , _type);  \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::INT32, std::int32_t , _type);  \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::UINT32, std::uint32_t , _type);  \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::INT16, std::int16_t , _type); \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::UINT16, std::uint16_t , _type); \
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::INT8, std::int8_t , _type);\
-        TINYPLY_TO_SLAM__CASE_SLAM(slam::PROPERTY_TYPE::UINT8, std::uint8_t , _type);\
-    } } break;
-
-#define SLAM_TO_TINYPLY__CASE_TINYPLY(tinyply_type, _type) \
-    case tinyply_type: { switch(source_type) {                  \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::FLOAT64, double, _type); \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::FLOAT32, float, _type);  \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::INT64, std::int64_t , _type);  \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::UINT64, std::uint64_t , _type);  \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::INT32, std::int32_t , _type);  \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::UINT32, std::uint32_t , _type);  \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::INT16, std::int16_t , _type); \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::UINT16, std::uint16_t , _type); \
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::INT8, std::int8_t , _type);\
-        SLAM_TO_TINYPLY__CASE_SLAM(slam::PROPERTY_TYPE::UINT8, std::uint8_t , _type);\
-    } } break;
-
-
-    /* -------------------------------------------------------------------------------------------------------------- */
-    void TinyPLYScalarToSlamScalar(const char *source, tinyply::Type source_type,
-                                   char *dest, slam::PROPERTY_TYPE dest_type) {
-        switch (source_type) {
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::FLOAT64, double)
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::FLOAT32, float)
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::INT32, std::int32_t)
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::UINT32, std::uint32_t)
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::INT16, std::int16_t)
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::UINT16, std::uint16_t)
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::INT8, std::int8_t)
-            TINYPLY_TO_SLAM__CASE_TINYPLY (tinyply::Type::UINT8, std::uint8_t)
-            case tinyply::Type::INVALID:
-                throw std::runtime_error("Source Type is the tinyply::INVALID type, cannot copy scalar into buffer.");
-        }
-    }
-
-    /* -------------------------------------------------------------------------------------------------------------- */
-    void SlamScalarToTinyPLYScalar(const char *source, slam::PROPERTY_TYPE source_type,
-                                   char *dest, tinyply::Type dest_type) {
-        switch (dest_type) {
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::FLOAT64, double)
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::FLOAT32, float)
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::INT32, std::int32_t)
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::UINT32, std::uint32_t)
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::INT16, std::int16_t)
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::UINT16, std::uint16_t)
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::INT8, std::int8_t)
-            SLAM_TO_TINYPLY__CASE_TINYPLY (tinyply::Type::UINT8, std::uint8_t)
-            case tinyply::Type::INVALID:
-                throw std::runtime_error("Source Type is the tinyply::INVALID type, cannot copy scalar into buffer.");
-        }
-    }
-
     /* -------------------------------------------------------------------------------------------------------------- */
     namespace {
         void WriteCollectionToPLY(std::ostream &output_file,
@@ -689,13 +614,12 @@ namespace slam {
                     const auto kTinyPLYPtySize = SizeOfTinyPLYType(pty.pty_type);
                     property_data.data.resize(kNumItems * kTinyPLYPtySize);
 
+                    // Copies the column of scalars to the destination TinyPLY buffer
                     auto *buffer = item_info.parent_buffer->view_data_ptr + kElemOffset + kPropertyOffset;
-                    for (auto idx(0); idx < kNumItems; idx++) {
-                        const char *slam_pty_scalar = &buffer[idx * kItemSize];
-                        char *tinyply_pty_scalar = reinterpret_cast<char *>(&property_data.data[kTinyPLYPtySize * idx]);
-                        // Copies each scalar to the destination TinyPLY buffer
-                        SlamScalarToTinyPLYScalar(slam_pty_scalar, kSlamPtyType, tinyply_pty_scalar, kTinyplyPtyType);
-                    }
+                    auto copy_function = GetStridedScalarCopyFunction(kSlamPtyType,
+                                                                      TinyPLYToSlamPropertyType(kTinyplyPtyType));
+                    copy_function(buffer, kItemSize, reinterpret_cast<char *>(property_data.data.data()),
+                                  kTinyPLYPtySize, kNumItems);
                     element_to_properties[elem].emplace_back(std::move(property_data));
                 }
             }
@@ -790,7 +714,8 @@ namespace slam {
                                     << "An error occurred while reading the PLY file" << std::endl;
                 }
 
-                auto collection = schema.AllocateBufferCollection(num_items);
+                // Frames read consecutively have similar sizes, their memory is recycled by the default pool
+                auto collection = schema.AllocateBufferCollection(num_items, BufferPool::DefaultPool());
                 // For each property copy the content in the buffer
                 for (auto &_pty: properties_mapping) {
                     auto &pty = *_pty.property;
@@ -808,12 +733,10 @@ namespace slam {
                     // Copy / Convert the scalar values from the tinyply buffers to the slam buffers
                     std::uint8_t *tinyply_buffer = _pty.data->buffer.get();
                     char *slam_buffer = item_info.parent_buffer->view_data_ptr + kElemOffset + kPropertyOffset;
-                    for (auto idx(0); idx < num_items; ++idx) {
-                        const char *source_ptr = reinterpret_cast<const char *>(&tinyply_buffer[idx *
-                                                                                                kTinyPlyElemSize]);
-                        char *dest_ptr = &slam_buffer[idx * kItemSize];
-                        TinyPLYScalarToSlamScalar(source_ptr, pty.pty_type, dest_ptr, pty.slam_pty_type);
-                    }
+                    auto copy_function = GetStridedScalarCopyFunction(TinyPLYToSlamPropertyType(pty.pty_type),
+                                                                      pty.slam_pty_type);
+                    copy_function(reinterpret_cast<const char *>(tinyply_buffer), kTinyPlyElemSize,
+                                  slam_buffer, kItemSize, num_items);
                 }
                 return collection;
             }
@@ -1088,11 +1011,12 @@ namespace slam {
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
-    slam::BufferCollection PLYSchemaMapper::AllocateBufferCollection(size_t num_items) const {
+    slam::BufferCollection PLYSchemaMapper::AllocateBufferCollection(size_t num_items,
+                                                                     std::shared_ptr<BufferPool> pool) const {
         std::vector<ItemBufferPtr> buffers;
         for (auto &item_schema: schemas_) {
             auto ptr = std::make_unique<VectorBuffer>(slam::ItemSchema(item_schema),
-                                                      item_schema.GetItemSize());
+                                                      item_schema.GetItemSize(), pool);
             ptr->Resize(num_items);
             buffers.emplace_back(std::move(ptr));
         }
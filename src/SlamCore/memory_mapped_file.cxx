@@ -0,0 +1,55 @@
+#include "SlamCore/memory_mapped_file.h"
+
+#include <fstream>
+
+#if !defined(_WIN32)
+#define _WITH_MMAP
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#endif
+
+namespace slam {
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    MemoryMappedFile::MemoryMappedFile(const std::string &file_path) : file_path_(file_path) {
+        SLAM_CHECK_STREAM(fs::exists(file_path), "The file " << file_path << " does not exist on disk");
+#ifdef _WITH_MMAP
+        int fd = open(file_path.c_str(), O_RDONLY);
+        SLAM_CHECK_STREAM(fd >= 0, "Could not open the file " << file_path);
+        struct stat file_stat{};
+        SLAM_CHECK_STREAM(fstat(fd, &file_stat) == 0, "Could not read the size of the file " << file_path);
+        size_ = size_t(file_stat.st_size);
+        if (size_ > 0) {
+            void *ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED) {
+                data_ = static_cast<const char *>(ptr);
+                is_mapped_ = true;
+            }
+        }
+        close(fd);
+        if (is_mapped_ || size_ == 0)
+            return;
+        SLAM_LOG(WARNING) << "Failed to map the file " << file_path << " in memory, reading it instead" << std::endl;
+#endif
+        std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+        SLAM_CHECK_STREAM(file.is_open(), "Could not open the file " << file_path);
+        size_ = size_t(file.tellg());
+        buffer_.resize(size_);
+        file.seekg(0);
+        file.read(buffer_.data(), std::streamsize(size_));
+        data_ = buffer_.data();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    MemoryMappedFile::~MemoryMappedFile() {
+#ifdef _WITH_MMAP
+        if (is_mapped_ && data_)
+            munmap(const_cast<char *>(data_), size_);
+#endif
+    }
+
+} // namespace slam
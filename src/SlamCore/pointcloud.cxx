@@ -17,6 +17,11 @@ namespace slam {
         collection_.Reserve(new_size);
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t PointCloud::capacity() const {
+        return collection_.Capacity();
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
     const BufferCollection &PointCloud::GetCollection() const {
         return collection_;
@@ -221,7 +226,7 @@ namespace slam {
             for (auto item_idx(0); item_idx < collection_.NumItemsInSchema(); ++item_idx) {
                 if (timestamps)
                     break;
-                auto &item_info = collection_.GetItemInfo(item_idx);
+                auto &item_info = GetCollection().GetItemInfo(item_idx);
                 for (auto &elem_name: item_info.item_schema.GetElementNames()) {
                     if (timestamps)
                         break;
@@ -297,10 +302,71 @@ namespace slam {
         return pc;
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void PointCloud::CopyFieldsFrom(const PointCloud &cloud) {
+        auto is_defined = [this](const std::optional<Field> &field) {
+            return field && !field->IsItem() && collection_.HasElement(*field->element_name) &&
+                   (!field->IsProperty() || collection_.HasProperty(*field->element_name, *field->property_name));
+        };
+        auto copy_field = [&](const std::optional<Field> &field) -> std::optional<Field> {
+            if (!is_defined(field))
+                return {};
+            Field copy = *field;
+            copy.item_index = int(collection_.GetItemIndex(*field->element_name));
+            return copy;
+        };
+        xyz_ = *copy_field(cloud.xyz_);
+        normals = copy_field(cloud.normals);
+        intensity = copy_field(cloud.intensity);
+        timestamps = copy_field(cloud.timestamps);
+        rgb = copy_field(cloud.rgb);
+        world_point = copy_field(cloud.world_point);
+        raw_point = copy_field(cloud.raw_point);
+        registered_fields_.clear();
+        for (auto &[name, field]: cloud.registered_fields_) {
+            auto field_copy = copy_field(field);
+            if (field_copy)
+                registered_fields_.emplace(name, std::move(*field_copy));
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr PointCloud::SelectPoints(const std::vector<size_t> &indices,
+                                                 const std::vector<std::string> &element_names) const {
+        auto selected_elements = element_names;
+        selected_elements.push_back(*xyz_.element_name);
+        auto pc = std::make_shared<slam::PointCloud>(collection_.SelectItems(indices, selected_elements),
+                                                     std::string(*xyz_.element_name));
+        pc->CopyFieldsFrom(*this);
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr PointCloud::SelectElements(const std::vector<std::string> &element_names) const {
+        auto selected_elements = element_names;
+        selected_elements.push_back(*xyz_.element_name);
+        auto pc = std::make_shared<slam::PointCloud>(collection_.SelectElements(selected_elements),
+                                                     std::string(*xyz_.element_name));
+        pc->CopyFieldsFrom(*this);
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    PointCloudPtr PointCloud::ShallowCopyPtr() const {
+        auto result = std::make_shared<PointCloud>(collection_.ShallowCopy(), Field(xyz_));
+        result->registered_fields_ = registered_fields_;
+        result->timestamps = timestamps;
+        result->intensity = intensity;
+        result->rgb = rgb;
+        result->normals = normals;
+        result->world_point = world_point;
+        result->raw_point = raw_point;
+        return result;
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
     void PointCloud::AppendPointCloud(const PointCloud &cloud) {
         SLAM_CHECK_STREAM(IsResizable(), "Cannot append points to a non-resizable point cloud");
-        SLAM_CHECK_STREAM(HaveSameSchema(cloud), "The Two point clouds do not have the same schema");
         collection_.Append(cloud.collection_);
     }
 
@@ -315,9 +381,10 @@ namespace slam {
         SLAM_CHECK_STREAM(HasTimestamps(), "The Timestamps field is not defined");
         if (!HasWorldPoints())
             AddDefaultWorldPointsField();
-        auto _timestamps = TimestampsProxy<double>();
-        auto raw_points = RawPointsProxy<Eigen::Vector3d>();
         auto world_points = WorldPointsProxy<Eigen::Vector3d>();
+        const auto &self = *this;
+        const auto _timestamps = self.TimestampsProxy<double>();
+        const auto raw_points = self.RawPointsProxy<Eigen::Vector3d>();
         for (auto idx(0); idx < size(); ++idx) {
             double t = _timestamps[idx];
             Eigen::Vector3d _raw_point = raw_points[idx];
@@ -331,9 +398,10 @@ namespace slam {
         SLAM_CHECK_STREAM(HasTimestamps(), "The Timestamps field is not defined");
         if (!HasWorldPoints())
             AddDefaultWorldPointsField();
-        auto _timestamps = TimestampsProxy<double>();
-        auto raw_points = RawPointsProxy<Eigen::Vector3d>();
         auto world_points = WorldPointsProxy<Eigen::Vector3d>();
+        const auto &self = *this;
+        const auto _timestamps = self.TimestampsProxy<double>();
+        const auto raw_points = self.RawPointsProxy<Eigen::Vector3d>();
         for (auto idx(0); idx < size(); ++idx) {
             double t = _timestamps[idx];
             Eigen::Vector3d _raw_point = raw_points[idx];
@@ -346,8 +414,9 @@ namespace slam {
         SLAM_CHECK_STREAM(HasRawPoints(), "The RawPoints field is not defined");
         if (!HasWorldPoints())
             AddDefaultWorldPointsField();
-        auto raw_points = RawPointsProxy<Eigen::Vector3d>();
         auto world_points = WorldPointsProxy<Eigen::Vector3d>();
+        const auto &self = *this;
+        const auto raw_points = self.RawPointsProxy<Eigen::Vector3d>();
         for (auto idx(0); idx < size(); ++idx) {
             Eigen::Vector3d _raw_point = raw_points[idx];
             world_points[idx] = pose * _raw_point;
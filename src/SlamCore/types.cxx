@@ -12,9 +12,9 @@ namespace slam {
     /* -------------------------------------------------------------------------------------------------------------- */
     Voxel Voxel::Coordinates(const Eigen::Vector3d &point, double voxel_size) {
         Voxel voxel;
-        voxel.x = int(point.x() / voxel_size);
-        voxel.y = int(point.y() / voxel_size);
-        voxel.z = int(point.z() / voxel_size);
+        voxel.x = int(std::floor(point.x() / voxel_size));
+        voxel.y = int(std::floor(point.y() / voxel_size));
+        voxel.z = int(std::floor(point.z() / voxel_size));
 
         return voxel;
     }
@@ -2,122 +2,451 @@
 #include <pybind11/numpy.h>
 #include <pybind11/eigen.h>
 #include <pybind11/stl.h>
+#include <pybind11/functional.h>
 #include <Eigen/Dense>
-#include <types.hpp>
-#include <iostream>
 
-#include "ct_icp.hpp"
-#include "odometry.hpp"
-#include "dataset.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <SlamCore/pointcloud.h>
+
+#include "ct_icp/ct_icp.h"
+#include "ct_icp/odometry.h"
+#include "ct_icp/dataset.h"
 
 namespace py = pybind11;
 
+#define STRUCT_READWRITE(_struct, argument) .def_readwrite(#argument, & _struct :: argument )
 
-struct PyLiDARPoint {
-    double raw_point[3];
-    double pt[3];
-    double alpha_timestamp;
-    double timestamp;
-    int frame_index;
-};
+#define ADD_VALUE(_enum, _value) .value(#_value, _enum :: _value )
 
+namespace {
 
-/// A Wrapper for an array of ct_icp Points
-/// Allows access to ct_icp::Point3D from python using numpy's structured dtypes
-struct LiDARFrame {
+    /* -------------------------------------------------------------------------------------------------------------- */
+    /// A Smart Pointer wrapper which keeps the numpy array alive as long as a BufferWrapper points to its data
+    /// The GIL is acquired before releasing the python reference, as the wrapper can be destroyed from a native thread
+    struct NumpyDataPtr : slam::BufferWrapper::SmartDataPtrWrapper {
 
-    std::vector<ct_icp::Point3D> points;
+        explicit NumpyDataPtr(py::object &&_array) : array(std::move(_array)) {}
 
-    void SetFrame(const py::array_t<PyLiDARPoint> &arr) {
-        auto req = arr.request();
-        auto size = arr.size();
-        auto ptr = static_cast<ct_icp::Point3D *>(req.ptr);
+        ~NumpyDataPtr() override {
+            py::gil_scoped_acquire acquire;
+            array = py::object();
+        }
 
-        points.resize(size);
-        std::copy(ptr, ptr + size, points.begin());
+        py::object array;
     };
 
-    py::array_t<PyLiDARPoint> GetWrappingArray(py::handle handle = py::handle()) {
-        py::buffer_info buffer_info(
-                static_cast<void *>(&points[0]),
-                sizeof(PyLiDARPoint),
-                py::format_descriptor<PyLiDARPoint>::format(),
-                1,
-                {points.size()},
-                {sizeof(PyLiDARPoint)});
-
-        py::array_t<PyLiDARPoint> array(buffer_info, handle);
-        return array;
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Returns the slam::PROPERTY_TYPE of a numpy scalar dtype
+    slam::PROPERTY_TYPE PropertyTypeFromDType(const py::dtype &dtype) {
+        const auto kind = dtype.kind();
+        const auto size = dtype.itemsize();
+        if (kind == 'f') {
+            if (size == 4) return slam::FLOAT32;
+            if (size == 8) return slam::FLOAT64;
+        }
+        if (kind == 'i') {
+            if (size == 1) return slam::INT8;
+            if (size == 2) return slam::INT16;
+            if (size == 4) return slam::INT32;
+            if (size == 8) return slam::INT64;
+        }
+        if (kind == 'u') {
+            if (size == 1) return slam::UINT8;
+            if (size == 2) return slam::UINT16;
+            if (size == 4) return slam::UINT32;
+            if (size == 8) return slam::UINT64;
+        }
+        throw std::runtime_error("Unsupported numpy dtype for a point cloud field: " +
+                                 py::str(dtype).cast<std::string>());
     }
-};
 
-//! Wraps a RegistrationSummary (in order to wrap the std::vector of points with a LiDARFrame)
-struct PyRegistrationSummary : ct_icp::Odometry::RegistrationSummary {
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Wraps a numpy array into a BufferWrapper, without copying the data
+    slam::ItemBufferPtr WrapNumpyArray(const py::array &array, slam::ItemSchema &&schema) {
+        SLAM_CHECK_STREAM(array.flags() & py::array::c_style,
+                          "The numpy array must be C-contiguous to be wrapped without copy");
+        auto num_items = size_t(array.ndim() == 0 ? 0 : array.shape(0));
+        auto item_size = int(num_items == 0 ? schema.GetItemSize() : array.nbytes() / num_items);
+        SLAM_CHECK_STREAM(item_size == schema.GetItemSize(),
+                          "The stride of the numpy array does not match the item size of the schema");
+        auto handle = std::make_shared<NumpyDataPtr>(py::reinterpret_borrow<py::object>(array));
+        return std::make_unique<slam::BufferWrapper>(std::move(schema),
+                                                     static_cast<char *>(const_cast<void *>(array.data())),
+                                                     num_items, item_size, handle);
+    }
 
-    explicit PyRegistrationSummary(ct_icp::Odometry::RegistrationSummary &&summary_)
-            : ct_icp::Odometry::RegistrationSummary(std::move(summary_)) {
-        lidar_points.points = std::move(corrected_points);
+    /* -------------------------------------------------------------------------------------------------------------- */
+    /// Builds a slam::PointCloud which points to the memory of numpy arrays
+    ///
+    /// Two layouts are supported:
+    ///     - Contiguous (N, 3) or (N, 4) float32 / float64 arrays with columns [x, y, z, (timestamp)]
+    ///     - Structured arrays with the fields `x`, `y`, `z` (or a 3-dim field `xyz`) and an optional `timestamp` or `t`
+    ///
+    /// An optional (N,) array of timestamps can be passed separately, in which case it is wrapped as an additional item
+    slam::PointCloud WrapPointCloud(const py::array &points,
+                                    const std::optional<py::array> &timestamps = {}) {
+        std::vector<slam::ItemBufferPtr> buffers;
+        std::optional<slam::PointCloud::Field> timestamps_field{};
+        std::string xyz_element = "vertex";
+        const auto dtype = points.dtype();
+
+        if (dtype.kind() == 'V') {
+            // Structured array: each field becomes an element of the item schema
+            SLAM_CHECK_STREAM(points.ndim() == 1, "A structured array of points must be 1-dimensional");
+            slam::ItemSchema::Builder builder(dtype.itemsize());
+            auto fields = dtype.attr("fields").cast<py::dict>();
+            std::string timestamp_name;
+            for (auto &item: fields) {
+                auto name = item.first.cast<std::string>();
+                auto field_info = item.second.cast<py::tuple>();
+                auto field_dtype = field_info[0].cast<py::dtype>();
+                auto offset = field_info[1].cast<int>();
+                int dim = 1;
+                if (field_dtype.attr("subdtype").ptr() != Py_None) {
+                    auto subdtype = field_dtype.attr("subdtype").cast<py::tuple>();
+                    field_dtype = subdtype[0].cast<py::dtype>();
+                    for (auto &size: subdtype[1].cast<py::tuple>())
+                        dim *= size.cast<int>();
+                }
+                builder.AddElement(name, offset);
+                builder.AddProperty(name, std::string(name), PropertyTypeFromDType(field_dtype), 0, dim);
+                if (name == "timestamp" || (name == "t" && timestamp_name.empty()))
+                    timestamp_name = name;
+            }
+
+            const bool kHasXYZ = fields.contains("xyz");
+            if (!kHasXYZ) {
+                SLAM_CHECK_STREAM(fields.contains("x") && fields.contains("y") && fields.contains("z"),
+                                  "The structured array must define the fields `x`, `y`, `z` or `xyz`");
+                auto x_info = fields["x"].cast<py::tuple>();
+                auto y_info = fields["y"].cast<py::tuple>();
+                auto z_info = fields["z"].cast<py::tuple>();
+                auto scalar_dtype = x_info[0].cast<py::dtype>();
+                auto x_offset = x_info[1].cast<int>();
+                SLAM_CHECK_STREAM(y_info[1].cast<int>() == x_offset + scalar_dtype.itemsize() &&
+                                  z_info[1].cast<int>() == x_offset + 2 * scalar_dtype.itemsize(),
+                                  "The fields `x`, `y`, `z` must be contiguous in the structured array");
+                builder.AddElement("vertex", x_offset);
+                builder.AddProperty("vertex", "xyz", PropertyTypeFromDType(scalar_dtype), 0, 3);
+            }
+            buffers.push_back(WrapNumpyArray(points, builder.Build()));
+            xyz_element = kHasXYZ ? "xyz" : "vertex";
+            if (!timestamp_name.empty())
+                timestamps_field = slam::PointCloud::Field{0, timestamp_name, {}};
+        } else {
+            // Contiguous (N, 3) or (N, 4) array
+            SLAM_CHECK_STREAM(points.ndim() == 2 && (points.shape(1) == 3 || points.shape(1) == 4),
+                              "Expected an array of shape (N, 3) or (N, 4), got ndim=" << points.ndim());
+            const auto kType = PropertyTypeFromDType(dtype);
+            SLAM_CHECK_STREAM(kType == slam::FLOAT32 || kType == slam::FLOAT64,
+                              "Only float32 and float64 arrays of points are supported");
+            const auto kScalarSize = int(dtype.itemsize());
+            const auto kNumCols = int(points.shape(1));
+            slam::ItemSchema::Builder builder(kScalarSize * kNumCols);
+            builder.AddElement("vertex", 0)
+                    .AddProperty("vertex", "xyz", kType, 0, 3);
+            if (kNumCols == 4) {
+                builder.AddElement("timestamp", 3 * kScalarSize)
+                        .AddProperty("timestamp", "timestamp", kType, 0, 1);
+                timestamps_field = slam::PointCloud::Field{0, "timestamp", {}};
+            }
+            buffers.push_back(WrapNumpyArray(points, builder.Build()));
+        }
+
+        if (timestamps) {
+            SLAM_CHECK_STREAM(!timestamps_field, "The timestamps are already defined in the array of points");
+            const auto &t_array = *timestamps;
+            SLAM_CHECK_STREAM(t_array.ndim() == 1 && t_array.shape(0) == points.shape(0),
+                              "The timestamps must be an array of shape (N,)");
+            const auto kTType = PropertyTypeFromDType(t_array.dtype());
+            slam::ItemSchema::Builder t_builder(int(t_array.dtype().itemsize()));
+            t_builder.AddElement("timestamp", 0)
+                    .AddProperty("timestamp", "timestamp", kTType, 0, 1);
+            buffers.push_back(WrapNumpyArray(t_array, t_builder.Build()));
+            timestamps_field = slam::PointCloud::Field{1, "timestamp", {}};
+        }
+
+        slam::PointCloud pc(slam::BufferCollection(std::move(buffers)), std::move(xyz_element));
+        if (timestamps_field)
+            pc.SetTimestampsField(std::move(*timestamps_field));
+        return pc;
     }
 
-    LiDARFrame lidar_points;
-};
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Returns a numpy view of shape (7,) [qx, qy, qz, qw, tx, ty, tz] of a pose, owned by `base`
+    py::array PoseView(const slam::SE3 &pose, py::handle base) {
+        const double *data = pose.quat.coeffs().data();
+        CHECK(reinterpret_cast<const double *>(&pose.tr) == data + 4) << "Unexpected memory layout of slam::SE3";
+        return py::array_t<double>({7}, {sizeof(double)}, data, base);
+    }
 
-#define STRUCT_READWRITE(_struct, argument) .def_readwrite(#argument, & _struct :: argument )
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Returns a numpy view of shape (N, 3) of a Eigen::Vector3d member of the points, owned by `base`
+    py::array PointsView(const std::vector<slam::WPoint3D> &points, size_t offset, py::handle base) {
+        const char *data = points.empty() ? nullptr : reinterpret_cast<const char *>(points.data()) + offset;
+        return py::array_t<double>({points.size(), size_t(3)},
+                                   {sizeof(slam::WPoint3D), sizeof(double)},
+                                   reinterpret_cast<const double *>(data), base);
+    }
 
-#define ADD_VALUE(_enum, _value) .value(#_value, _enum :: _value )
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Returns a numpy view of shape (N,) of the timestamps of the points, owned by `base`
+    py::array TimestampsView(const std::vector<slam::WPoint3D> &points, py::handle base) {
+        const char *data = points.empty() ? nullptr :
+                           reinterpret_cast<const char *>(&points.front().raw_point.timestamp);
+        return py::array_t<double>({points.size()}, {sizeof(slam::WPoint3D)},
+                                   reinterpret_cast<const double *>(data), base);
+    }
 
-// Copies a vector to a np_array
-template<typename T, typename Scalar = T, typename Alloc_ = std::allocator<T>>
-py::array_t<Scalar> vector_to_ndarray(const std::vector<T, Alloc_> &vector) {
-
-    const auto width = static_cast<py::ssize_t >(sizeof(T) / sizeof(Scalar));
-    py::ssize_t ndim;
-    std::vector<size_t> shape, strides;
-    if (width == 1) {
-        ndim = 1;
-        shape = {vector.size()};
-        strides = {sizeof(T)};
-    } else {
-        ndim = 2;
-        shape = {vector.size(), width};
-        strides = {sizeof(Scalar) * width, sizeof(Scalar)};
+    const size_t kRawPointOffset = offsetof(slam::WPoint3D, raw_point);
+    const size_t kWorldPointOffset = offsetof(slam::WPoint3D, world_point);
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Registers a frame wrapping the numpy arrays, releasing the GIL during the registration
+    std::shared_ptr<ct_icp::Odometry::RegistrationSummary> RegisterNumpyFrame(
+            ct_icp::Odometry &odometry,
+            const py::array &points,
+            const std::optional<py::array> &timestamps,
+            std::optional<slam::frame_id_t> frame_id,
+            const std::optional<ct_icp::TrajectoryFrame> &initial_estimate,
+            bool with_corrected_points) {
+        auto pointcloud = WrapPointCloud(points, timestamps);
+        SLAM_CHECK_STREAM(pointcloud.HasTimestamps(),
+                          "The frame does not define timestamps, pass an array of shape (N, 4) or `timestamps`");
+        auto summary = std::make_shared<ct_icp::Odometry::RegistrationSummary>();
+        {
+            py::gil_scoped_release release;
+            const auto kFrameId = frame_id ? *frame_id : slam::frame_id_t(odometry.NumRegisteredFrames());
+            if (initial_estimate)
+                *summary = odometry.RegisterFrameWithEstimate(pointcloud, *initial_estimate, kFrameId);
+            else
+                *summary = odometry.RegisterFrame(pointcloud, kFrameId);
+            if (!with_corrected_points) {
+                summary->corrected_points = {};
+                summary->all_corrected_points = {};
+                summary->keypoints = {};
+            }
+        }
+        return summary;
     }
 
-    py::array_t<Scalar> result(py::buffer_info(
-    (void *) (&vector[0]), static_cast<py::ssize_t>(sizeof(Scalar)),
-            py::format_descriptor<Scalar>::format(),
-            ndim,
-            shape,
-            strides
-    ));
+    /* -------------------------------------------------------------------------------------------------------------- */
+    /// A SequenceRun runs the odometry natively over a whole sequence (a dataset sequence or a list of numpy frames)
+    ///
+    /// The run holds the GIL only to call the optional progress callback, and can be executed on a worker thread.
+    /// The numpy frames are wrapped (without copy) before the run, and are released with the SequenceRun
+    class SequenceRun {
+    public:
+        typedef std::function<void(size_t, size_t)> ProgressCallback;
+
+        SequenceRun(const ct_icp::OdometryOptions &options,
+                    std::shared_ptr<ct_icp::ADatasetSequence> sequence,
+                    std::optional<ProgressCallback> &&callback, int progress_period) :
+                options_(options), sequence_(std::move(sequence)), callback_(std::move(callback)),
+                progress_period_(std::max(progress_period, 1)) {
+            num_frames_ = sequence_->NumFrames();
+        }
+
+        SequenceRun(const ct_icp::OdometryOptions &options,
+                    std::vector<slam::PointCloudPtr> &&frames,
+                    std::optional<ProgressCallback> &&callback, int progress_period) :
+                options_(options), frames_(std::move(frames)), callback_(std::move(callback)),
+                progress_period_(std::max(progress_period, 1)) {
+            num_frames_ = frames_.size();
+        }
+
+        ~SequenceRun() {
+            Cancel();
+            if (PyGILState_Check()) {
+                // The worker thread might wait for the GIL to call the progress callback
+                py::gil_scoped_release release;
+                Join();
+            } else
+                Join();
+        }
+
+        // Runs the odometry on the sequence in the calling thread (the GIL must be released)
+        void Run() {
+            ct_icp::Odometry odometry(options_);
+            frames_poses_.reserve(num_frames_);
+            read_ms_.reserve(num_frames_);
+            registration_ms_.reserve(num_frames_);
+            success_.reserve(num_frames_);
+
+            auto now = [] { return std::chrono::steady_clock::now(); };
+            auto duration_ms = [](const auto &end, const auto &begin) {
+                return std::chrono::duration<double, std::milli>(end - begin).count();
+            };
+
+            slam::frame_id_t frame_id = 0;
+            try {
+                while (!cancelled_) {
+                    auto begin = now();
+                    slam::PointCloudPtr frame = nullptr;
+                    if (sequence_) {
+                        if (!sequence_->HasNext())
+                            break;
+                        frame = sequence_->NextFrame().pointcloud;
+                    } else {
+                        if (frame_id >= frames_.size())
+                            break;
+                        frame = frames_[frame_id];
+                    }
+                    auto end_read = now();
+                    auto summary = odometry.RegisterFrame(*frame, frame_id);
+                    auto end_registration = now();
+
+                    frames_poses_.push_back(summary.frame);
+                    read_ms_.push_back(duration_ms(end_read, begin));
+                    registration_ms_.push_back(duration_ms(end_registration, end_read));
+                    success_.push_back(summary.success);
+                    frame_id++;
+                    num_processed_ = frame_id;
+
+                    if (callback_ && (frame_id % progress_period_ == 0)) {
+                        py::gil_scoped_acquire acquire;
+                        (*callback_)(size_t(frame_id), num_frames_);
+                    }
+                }
+            } catch (std::exception &e) {
+                error_message_ = e.what();
+            }
+            is_done_ = true;
+        }
+
+        // Launches the run on a worker thread
+        void Launch() {
+            CHECK(!worker_) << "The SequenceRun was already launched" << std::endl;
+            worker_ = std::make_unique<std::thread>([this] { Run(); });
+        }
+
+        // Requests the run to stop after the frame being registered
+        void Cancel() { cancelled_ = true; }
+
+        // Waits for the end of the run (the GIL must be released)
+        void Join() {
+            if (worker_ && worker_->joinable())
+                worker_->join();
+        }
+
+        bool IsDone() const { return is_done_; }
+
+        size_t NumProcessedFrames() const { return num_processed_; }
+
+        size_t NumFrames() const { return num_frames_; }
+
+        // Returns the results of the run as a dictionary of numpy arrays (copies the results)
+        py::dict Results() const {
+            SLAM_CHECK_STREAM(is_done_, "The SequenceRun is not done, call `Wait()` before accessing the results");
+            if (!error_message_.empty())
+                throw std::runtime_error("The odometry failed with the error: " + error_message_);
+
+            const auto kNumFrames = frames_poses_.size();
+            py::array_t<double> trajectory({kNumFrames, size_t(2), size_t(7)});
+            auto trajectory_ = trajectory.mutable_unchecked<3>();
+            for (auto i(0); i < kNumFrames; ++i) {
+                const auto &frame = frames_poses_[i];
+                for (auto k(0); k < 2; ++k) {
+                    const auto &pose = k == 0 ? frame.begin_pose.pose : frame.end_pose.pose;
+                    for (auto j(0); j < 4; ++j)
+                        trajectory_(i, k, j) = pose.quat.coeffs()[j];
+                    for (auto j(0); j < 3; ++j)
+                        trajectory_(i, k, 4 + j) = pose.tr[j];
+                }
+            }
+
+            py::dict results;
+            results["trajectory"] = trajectory;
+            results["read_ms"] = py::array_t<double>(read_ms_.size(), read_ms_.data());
+            results["registration_ms"] = py::array_t<double>(registration_ms_.size(), registration_ms_.data());
+            results["success"] = py::array_t<bool>(success_.size(), reinterpret_cast<const bool *>(success_.data()));
+            return results;
+        }
+
+    private:
+        ct_icp::OdometryOptions options_;
+        std::shared_ptr<ct_icp::ADatasetSequence> sequence_ = nullptr;
+        std::vector<slam::PointCloudPtr> frames_;
+        std::optional<ProgressCallback> callback_{};
+        int progress_period_ = 1;
+        size_t num_frames_ = 0;
+
+        std::unique_ptr<std::thread> worker_ = nullptr;
+        std::atomic<bool> cancelled_ = false, is_done_ = false;
+        std::atomic<size_t> num_processed_ = 0;
+        std::string error_message_;
+
+        std::vector<ct_icp::TrajectoryFrame> frames_poses_;
+        std::vector<double> read_ms_, registration_ms_;
+        std::vector<uint8_t> success_;
+    };
 
-    return result;
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Builds a SequenceRun from a python object: either an ADatasetSequence or a list of numpy frames
+    std::shared_ptr<SequenceRun> MakeSequenceRun(const ct_icp::OdometryOptions &options,
+                                                 const py::object &frames,
+                                                 std::optional<SequenceRun::ProgressCallback> &&callback,
+                                                 int progress_period) {
+        auto options_copy = options;
+        options_copy.debug_print = false;
+        options_copy.ct_icp_options.debug_print = false;
+        if (py::isinstance<ct_icp::ADatasetSequence>(frames)) {
+            return std::make_shared<SequenceRun>(options_copy,
+                                                 frames.cast<std::shared_ptr<ct_icp::ADatasetSequence>>(),
+                                                 std::move(callback), progress_period);
+        }
+        std::vector<slam::PointCloudPtr> pointclouds;
+        for (auto &item: frames) {
+            auto pc = std::make_shared<slam::PointCloud>(WrapPointCloud(item.cast<py::array>()));
+            SLAM_CHECK_STREAM(pc->HasTimestamps(), "A frame does not define timestamps, pass arrays of shape (N, 4)");
+            pointclouds.push_back(pc);
+        }
+        return std::make_shared<SequenceRun>(options_copy, std::move(pointclouds), std::move(callback),
+                                             progress_period);
+    }
 
 }
 
 PYBIND11_MODULE(pyct_icp, m) {
-    /// LiDARFrame : A wrapper around a vector of ct_icp::Point3D
-    PYBIND11_NUMPY_DTYPE(PyLiDARPoint, raw_point, pt, alpha_timestamp, timestamp, frame_index);
 
-    py::class_<LiDARFrame, std::shared_ptr<LiDARFrame>>(m, "LiDARFrame")
+    /// TYPES
+    py::class_<slam::SE3>(m, "SE3")
             .def(py::init())
-            .def("SetFrame", &LiDARFrame::SetFrame)
-            .def("GetStructuredArrayCopy", [](LiDARFrame &self) {
-                return self.GetWrappingArray();
-            })
-            .def("GetStructuredArrayRef", [](py::object &self) {
-                auto &self_frame = py::cast<LiDARFrame &>(self);
-                return self_frame.GetWrappingArray(self);
+            .def_property("quat", [](const slam::SE3 &self) { return self.quat.coeffs(); },
+                          [](slam::SE3 &self, const Eigen::Vector4d &coeffs) {
+                              self.quat.coeffs() = coeffs;
+                              self.quat.normalize();
+                          })
+            .def_readwrite("tr", &slam::SE3::tr)
+            .def("Matrix", &slam::SE3::Matrix)
+            .def("Inverse", &slam::SE3::Inverse)
+            .def("AsArray", [](py::object self) {
+                return PoseView(self.cast<const slam::SE3 &>(), self);
             });
 
-    py::class_<ct_icp::TrajectoryFrame, std::shared_ptr<ct_icp::TrajectoryFrame>>(m, "TrajectoryFrame")
+    py::class_<slam::Pose>(m, "Pose")
             .def(py::init())
-                    STRUCT_READWRITE(ct_icp::TrajectoryFrame, begin_R)
-                    STRUCT_READWRITE(ct_icp::TrajectoryFrame, end_R)
-                    STRUCT_READWRITE(ct_icp::TrajectoryFrame, end_t)
-                    STRUCT_READWRITE(ct_icp::TrajectoryFrame, begin_t)
-            .def("MidPose", &ct_icp::TrajectoryFrame::MidPose);
-
+            .def_readwrite("pose", &slam::Pose::pose)
+            .def_readwrite("dest_timestamp", &slam::Pose::dest_timestamp)
+            .def_readwrite("dest_frame_id", &slam::Pose::dest_frame_id)
+            .def_readwrite("ref_timestamp", &slam::Pose::ref_timestamp)
+            .def_readwrite("ref_frame_id", &slam::Pose::ref_frame_id)
+            .def("Matrix", &slam::Pose::Matrix);
+
+    py::class_<ct_icp::TrajectoryFrame>(m, "TrajectoryFrame")
+            .def(py::init())
+                    STRUCT_READWRITE(ct_icp::TrajectoryFrame, begin_pose)
+                    STRUCT_READWRITE(ct_icp::TrajectoryFrame, end_pose)
+            .def("MidPose", &ct_icp::TrajectoryFrame::MidPose)
+            .def("BeginPoseArray", [](py::object self) {
+                return PoseView(self.cast<const ct_icp::TrajectoryFrame &>().begin_pose.pose, self);
+            })
+            .def("EndPoseArray", [](py::object self) {
+                return PoseView(self.cast<const ct_icp::TrajectoryFrame &>().end_pose.pose, self);
+            });
 
     /// ODOMETRY
     py::enum_<ct_icp::LEAST_SQUARES>(m, "LEAST_SQUARES")
@@ -135,7 +464,15 @@ PYBIND11_MODULE(pyct_icp, m) {
 
     py::enum_<ct_icp::ICP_DISTANCE>(m, "ICP_DISTANCE")
             ADD_VALUE(ct_icp::ICP_DISTANCE, POINT_TO_PLANE)
-            ADD_VALUE(ct_icp::ICP_DISTANCE, CT_POINT_TO_PLANE)
+            ADD_VALUE(ct_icp::ICP_DISTANCE, POINT_TO_POINT)
+            ADD_VALUE(ct_icp::ICP_DISTANCE, POINT_TO_LINE)
+            ADD_VALUE(ct_icp::ICP_DISTANCE, POINT_TO_DISTRIBUTION)
+            ADD_VALUE(ct_icp::ICP_DISTANCE, DISTRIBUTION_TO_DISTRIBUTION)
+            .export_values();
+
+    py::enum_<ct_icp::POSE_PARAMETRIZATION>(m, "POSE_PARAMETRIZATION")
+            ADD_VALUE(ct_icp::POSE_PARAMETRIZATION, SIMPLE)
+            ADD_VALUE(ct_icp::POSE_PARAMETRIZATION, CONTINUOUS_TIME)
             .export_values();
 
     py::enum_<ct_icp::MOTION_COMPENSATION>(m, "MOTION_COMPENSATION")
@@ -148,59 +485,61 @@ PYBIND11_MODULE(pyct_icp, m) {
     py::enum_<ct_icp::CT_ICP_SOLVER>(m, "CT_ICP_SOLVER")
             ADD_VALUE(ct_icp::CT_ICP_SOLVER, CERES)
             ADD_VALUE(ct_icp::CT_ICP_SOLVER, GN)
+            ADD_VALUE(ct_icp::CT_ICP_SOLVER, ROBUST)
             .export_values();
 
-    py::class_<ct_icp::SequenceInfo>(m, "SequenceInfo")
-            .def(py::init())
-                    STRUCT_READWRITE(ct_icp::SequenceInfo, sequence_size)
-                    STRUCT_READWRITE(ct_icp::SequenceInfo, sequence_name)
-                    STRUCT_READWRITE(ct_icp::SequenceInfo, sequence_id);
-
-
     py::class_<ct_icp::CTICPOptions,
             std::shared_ptr<ct_icp::CTICPOptions>>(m, "CTICPOptions")
             .def(py::init())
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, distance)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, num_iters_icp)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, parametrization)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, distance)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, solver)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, max_num_residuals)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, min_num_residuals)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, observability_selection)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, observability_information_ratio)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, observability_min_num_keypoints)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, weight_alpha)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, weight_neighborhood)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, power_planarity)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, min_number_neighbors)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, voxel_neighborhood)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, max_number_neighbors)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, max_dist_to_plane_ct_icp)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, threshold_voxel_occupancy)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, num_closest_neighbors)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, threshold_orientation_norm)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, threshold_translation_norm)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, debug_print)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, point_to_plane_with_distortion)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, distance)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, init_num_frames)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, num_closest_neighbors)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, beta_location_consistency)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, beta_constant_velocity)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, beta_small_velocity)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, beta_orientation_consistency)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, loss_function)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, ls_max_num_iters)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, ls_num_threads)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, size_voxel_map)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, bundle_residuals)
                     STRUCT_READWRITE(ct_icp::CTICPOptions, ls_sigma)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, max_num_residuals)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, min_num_residuals)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, weight_alpha)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, weight_neighborhood)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, solver)
-                    STRUCT_READWRITE(ct_icp::CTICPOptions, ls_tolerant_min_threshold);
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, ls_tolerant_min_threshold)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, max_dist_to_plane_ct_icp)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, gicp_source_radius)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, gicp_epsilon)
+                    STRUCT_READWRITE(ct_icp::CTICPOptions, debug_print);
 
     py::class_<ct_icp::OdometryOptions>(m, "OdometryOptions")
             .def(py::init())
                     STRUCT_READWRITE(ct_icp::OdometryOptions, voxel_size)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, init_num_frames)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, init_with_motion_hypotheses)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, hypotheses_sample_voxel_size)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, hypotheses_max_num_points)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, hypotheses_search_radius)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, hypotheses_max_residual)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, init_voxel_size)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, init_sample_voxel_size)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, sample_voxel_size)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, max_num_keypoints)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, max_distance)
-                    STRUCT_READWRITE(ct_icp::OdometryOptions, max_num_points_in_voxel)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, motion_compensation)
-                    STRUCT_READWRITE(ct_icp::OdometryOptions, debug_print)
-                    STRUCT_READWRITE(ct_icp::OdometryOptions, min_distance_points)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, initialization)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, debug_print)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, distance_error_threshold)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, orientation_error_threshold)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, robust_registration)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, robust_fail_early)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, robust_minimal_level)
@@ -209,52 +548,95 @@ PYBIND11_MODULE(pyct_icp, m) {
                     STRUCT_READWRITE(ct_icp::OdometryOptions, robust_threshold_relative_orientation)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, robust_threshold_ego_orientation)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, robust_num_attempts)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, robust_num_parallel_attempts)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, robust_max_voxel_neighborhood)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, always_insert)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, do_no_insert)
+                    STRUCT_READWRITE(ct_icp::OdometryOptions, localization_mode)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, log_file_destination)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, log_to_file)
                     STRUCT_READWRITE(ct_icp::OdometryOptions, ct_icp_options);
 
-
     m.def("DefaultDrivingProfile", &ct_icp::OdometryOptions::DefaultDrivingProfile);
     m.def("RobustDrivingProfile", &ct_icp::OdometryOptions::RobustDrivingProfile);
     m.def("DefaultRobustOutdoorLowInertia", &ct_icp::OdometryOptions::DefaultRobustOutdoorLowInertia);
 
     using RegSummary = ct_icp::Odometry::RegistrationSummary;
-    py::class_<PyRegistrationSummary,
-            std::shared_ptr<PyRegistrationSummary>>(m, "RegistrationSummary")
-            .def_readonly("sample_size", &PyRegistrationSummary::sample_size)
-            .def_readonly("number_of_residuals", &PyRegistrationSummary::number_of_residuals)
-            .def_readonly("distance_correction", &PyRegistrationSummary::distance_correction)
-            .def_readonly("relative_distance", &PyRegistrationSummary::relative_distance)
-            .def_readonly("number_of_attempts", &PyRegistrationSummary::relative_orientation)
-            .def_readonly("number_of_attempts", &PyRegistrationSummary::ego_orientation)
-            .def_readonly("success", &PyRegistrationSummary::success)
-            .def_readonly("frame", &PyRegistrationSummary::frame)
-            .def_readonly("error_message", &PyRegistrationSummary::error_message)
-            .def_readonly("number_of_attempts", &PyRegistrationSummary::number_of_attempts)
-            .def_readonly("points", &PyRegistrationSummary::lidar_points);
-
+    py::class_<RegSummary, std::shared_ptr<RegSummary>>(m, "RegistrationSummary")
+            .def_readonly("sample_size", &RegSummary::sample_size)
+            .def_readonly("number_of_residuals", &RegSummary::number_of_residuals)
+            .def_readonly("robust_level", &RegSummary::robust_level)
+            .def_readonly("distance_correction", &RegSummary::distance_correction)
+            .def_readonly("relative_distance", &RegSummary::relative_distance)
+            .def_readonly("relative_orientation", &RegSummary::relative_orientation)
+            .def_readonly("ego_orientation", &RegSummary::ego_orientation)
+            .def_readonly("success", &RegSummary::success)
+            .def_readonly("points_added", &RegSummary::points_added)
+            .def_readonly("number_of_attempts", &RegSummary::number_of_attempts)
+            .def_readonly("error_message", &RegSummary::error_message)
+            .def_readonly("frame", &RegSummary::frame)
+            .def_readonly("logged_values", &RegSummary::logged_values)
+            .def_property_readonly("begin_pose", [](py::object self) {
+                return PoseView(self.cast<const RegSummary &>().frame.begin_pose.pose, self);
+            })
+            .def_property_readonly("end_pose", [](py::object self) {
+                return PoseView(self.cast<const RegSummary &>().frame.end_pose.pose, self);
+            })
+            .def_property_readonly("corrected_points", [](py::object self) {
+                return PointsView(self.cast<const RegSummary &>().all_corrected_points, kWorldPointOffset, self);
+            })
+            .def_property_readonly("raw_points", [](py::object self) {
+                return PointsView(self.cast<const RegSummary &>().all_corrected_points, kRawPointOffset, self);
+            })
+            .def_property_readonly("timestamps", [](py::object self) {
+                return TimestampsView(self.cast<const RegSummary &>().all_corrected_points, self);
+            })
+            .def_property_readonly("keypoints", [](py::object self) {
+                return PointsView(self.cast<const RegSummary &>().keypoints, kWorldPointOffset, self);
+            });
 
     py::class_<ct_icp::Odometry,
             std::shared_ptr<ct_icp::Odometry>>(m, "Odometry")
             .def(py::init([](ct_icp::OdometryOptions &options) {
                 return std::make_shared<ct_icp::Odometry>(options);
             }))
-            .def("RegisterFrame", [](ct_icp::Odometry &odometry, const LiDARFrame &frame) {
-                return PyRegistrationSummary(odometry.RegisterFrame(frame.points));
-            })
+            .def("RegisterFrame", [](ct_icp::Odometry &odometry,
+                                     const py::array &points,
+                                     const std::optional<py::array> &timestamps,
+                                     std::optional<slam::frame_id_t> frame_id,
+                                     bool with_corrected_points) {
+                     return RegisterNumpyFrame(odometry, points, timestamps, frame_id, {}, with_corrected_points);
+                 }, py::arg("points"), py::arg("timestamps") = py::none(), py::arg("frame_id") = py::none(),
+                 py::arg("with_corrected_points") = false)
             .def("RegisterFrameWithEstimate", [](ct_icp::Odometry &odometry,
-                                                 const LiDARFrame &frame,
-                                                 const ct_icp::TrajectoryFrame &initial_estimate) {
-                return PyRegistrationSummary(odometry.RegisterFrameWithEstimate(frame.points,
-                                                                                initial_estimate));
-            })
-            .def("MapSize", &ct_icp::Odometry::MapSize)
+                                                 const py::array &points,
+                                                 const ct_icp::TrajectoryFrame &initial_estimate,
+                                                 const std::optional<py::array> &timestamps,
+                                                 std::optional<slam::frame_id_t> frame_id,
+                                                 bool with_corrected_points) {
+                     return RegisterNumpyFrame(odometry, points, timestamps, frame_id,
+                                               initial_estimate, with_corrected_points);
+                 }, py::arg("points"), py::arg("initial_estimate"), py::arg("timestamps") = py::none(),
+                 py::arg("frame_id") = py::none(), py::arg("with_corrected_points") = false)
+            .def("NumRegisteredFrames", &ct_icp::Odometry::NumRegisteredFrames)
+            .def("MapSize", &ct_icp::Odometry::MapSize, py::call_guard<py::gil_scoped_release>())
             .def("Trajectory", &ct_icp::Odometry::Trajectory)
-            .def("GetLocalMap", [](const ct_icp::Odometry &self) {
-                // Convert to numpy
-                return vector_to_ndarray<Eigen::Vector3d, double,
-                        Eigen::aligned_allocator<Eigen::Vector3d>>(self.GetLocalMap());
+            .def("Reset", [](ct_icp::Odometry &self) { self.Reset(); })
+            .def("GetMapPoints", [](const ct_icp::Odometry &self) {
+                slam::PointCloudPtr map_pc;
+                {
+                    py::gil_scoped_release release;
+                    map_pc = self.GetMapPointCloud();
+                }
+                auto xyz = map_pc->XYZConst<double>();
+                py::array_t<double> result({map_pc->size(), size_t(3)});
+                auto result_ = result.mutable_unchecked<2>();
+                for (auto i(0); i < map_pc->size(); ++i) {
+                    Eigen::Vector3d point = xyz[i];
+                    for (auto k(0); k < 3; ++k)
+                        result_(i, k) = point[k];
+                }
+                return result;
             });
 
 
@@ -262,11 +644,24 @@ PYBIND11_MODULE(pyct_icp, m) {
     py::enum_<ct_icp::DATASET>(m, "CT_ICP_DATASET")
             ADD_VALUE(ct_icp::DATASET, KITTI_raw)
             ADD_VALUE(ct_icp::DATASET, KITTI_CARLA)
+            ADD_VALUE(ct_icp::DATASET, KITTI)
+            ADD_VALUE(ct_icp::DATASET, KITTI_360)
             ADD_VALUE(ct_icp::DATASET, NCLT)
+            ADD_VALUE(ct_icp::DATASET, HILTI_2021)
+            ADD_VALUE(ct_icp::DATASET, HILTI_2022)
             ADD_VALUE(ct_icp::DATASET, PLY_DIRECTORY)
-            ADD_VALUE(ct_icp::DATASET, KITTI_360)
+            ADD_VALUE(ct_icp::DATASET, SYNTHETIC)
+            ADD_VALUE(ct_icp::DATASET, CUSTOM)
             .export_values();
 
+    py::class_<ct_icp::SequenceInfo>(m, "SequenceInfo")
+            .def(py::init())
+                    STRUCT_READWRITE(ct_icp::SequenceInfo, sequence_name)
+                    STRUCT_READWRITE(ct_icp::SequenceInfo, label)
+                    STRUCT_READWRITE(ct_icp::SequenceInfo, sequence_id)
+                    STRUCT_READWRITE(ct_icp::SequenceInfo, sequence_size)
+                    STRUCT_READWRITE(ct_icp::SequenceInfo, with_ground_truth);
+
     py::class_<ct_icp::DatasetOptions>(m, "DatasetOptions")
             .def(py::init())
                     STRUCT_READWRITE(ct_icp::DatasetOptions, dataset)
@@ -274,29 +669,70 @@ PYBIND11_MODULE(pyct_icp, m) {
                     STRUCT_READWRITE(ct_icp::DatasetOptions, fail_if_incomplete)
                     STRUCT_READWRITE(ct_icp::DatasetOptions, min_dist_lidar_center)
                     STRUCT_READWRITE(ct_icp::DatasetOptions, max_dist_lidar_center)
-                    STRUCT_READWRITE(ct_icp::DatasetOptions, nclt_num_aggregated_pc);
-
-    py::class_<ct_icp::DatasetSequence, std::shared_ptr<ct_icp::DatasetSequence>>(m, "DatasetSequence")
-            .def("HasNext", &ct_icp::DatasetSequence::HasNext)
-            .def("Next", [](ct_icp::DatasetSequence &iterator) {
-                LiDARFrame frame;
-                frame.points = iterator.Next();
-                return frame;
-            })
-            .def("NumFrames", &ct_icp::DatasetSequence::NumFrames)
-            .def("WithRandomAccess", &ct_icp::DatasetSequence::WithRandomAccess)
-            .def("Frame", [](ct_icp::DatasetSequence &self, int index_frame) {
-                CHECK(self.WithRandomAccess()) << "Random Access is not available for the dataset";
-                LiDARFrame frame;
-                frame.points = self.Frame(size_t(index_frame));
-                return frame;
+                    STRUCT_READWRITE(ct_icp::DatasetOptions, nclt_num_aggregated_pc)
+                    STRUCT_READWRITE(ct_icp::DatasetOptions, use_all_datasets)
+                    STRUCT_READWRITE(ct_icp::DatasetOptions, cache_directory);
+
+    py::class_<ct_icp::ADatasetSequence, std::shared_ptr<ct_icp::ADatasetSequence>>(m, "ADatasetSequence")
+            .def("HasNext", &ct_icp::ADatasetSequence::HasNext)
+            .def("NumFrames", &ct_icp::ADatasetSequence::NumFrames)
+            .def("WithRandomAccess", &ct_icp::ADatasetSequence::WithRandomAccess)
+            .def("SetInitFrame", &ct_icp::ADatasetSequence::SetInitFrame)
+            .def("SetMaxNumFrames", &ct_icp::ADatasetSequence::SetMaxNumFrames)
+            .def("HasGroundTruth", &ct_icp::ADatasetSequence::HasGroundTruth)
+            .def("GetSequenceInfo", [](const ct_icp::ADatasetSequence &self) {
+                return self.GetSequenceInfo();
             });
 
-    m.def("sequence_name", &ct_icp::sequence_name);
-    m.def("get_sequences", &ct_icp::get_sequences);
-    m.def("has_ground_truth", &ct_icp::has_ground_truth);
-    m.def("get_dataset_sequence", &ct_icp::get_dataset_sequence);
-    m.def("load_sensor_ground_truth", &ct_icp::load_sensor_ground_truth);
-    m.def("load_ground_truth", &ct_icp::load_sensor_ground_truth);
+    py::class_<ct_icp::PLYDirectory, ct_icp::ADatasetSequence,
+            std::shared_ptr<ct_icp::PLYDirectory>>(m, "PLYDirectory")
+            .def_static("PtrFromDirectoryPath", [](const std::string &dir_path) {
+                return ct_icp::PLYDirectory::PtrFromDirectoryPath(dir_path);
+            });
+
+    m.def("LoadSequences", [](const ct_icp::DatasetOptions &options) {
+        return ct_icp::Dataset::LoadDataset(options).AllSequences();
+    });
+
+    /// BATCH RUNS
+    py::class_<SequenceRun, std::shared_ptr<SequenceRun>>(m, "SequenceRun")
+            .def("Wait", [](SequenceRun &self) {
+                {
+                    py::gil_scoped_release release;
+                    self.Join();
+                }
+                return self.Results();
+            })
+            .def("Cancel", &SequenceRun::Cancel)
+            .def("IsDone", &SequenceRun::IsDone)
+            .def("NumProcessedFrames", &SequenceRun::NumProcessedFrames)
+            .def("NumFrames", &SequenceRun::NumFrames);
+
+    // Runs the odometry over a whole sequence, returns a dict with
+    // `trajectory` (N, 2, 7) [begin/end][qx, qy, qz, qw, tx, ty, tz], `read_ms` (N,), `registration_ms` (N,)
+    // And `success` (N,)
+    m.def("RunOdometry", [](const ct_icp::OdometryOptions &options,
+                            const py::object &frames,
+                            std::optional<SequenceRun::ProgressCallback> progress_callback,
+                            int progress_period) {
+              auto run = MakeSequenceRun(options, frames, std::move(progress_callback), progress_period);
+              {
+                  py::gil_scoped_release release;
+                  run->Run();
+              }
+              return run->Results();
+          }, py::arg("options"), py::arg("frames"), py::arg("progress_callback") = py::none(),
+          py::arg("progress_period") = 100);
+
+    // Launches the odometry over a whole sequence on a worker thread, returns a SequenceRun
+    m.def("RunOdometryAsync", [](const ct_icp::OdometryOptions &options,
+                                 const py::object &frames,
+                                 std::optional<SequenceRun::ProgressCallback> progress_callback,
+                                 int progress_period) {
+              auto run = MakeSequenceRun(options, frames, std::move(progress_callback), progress_period);
+              run->Launch();
+              return run;
+          }, py::arg("options"), py::arg("frames"), py::arg("progress_callback") = py::none(),
+          py::arg("progress_period") = 100);
 
-}
\ No newline at end of file
+}
@@ -38,9 +38,13 @@ namespace ct_icp {
         OPTION_CLAUSE(icp_node, icp_options, num_closest_neighbors, int);;
         OPTION_CLAUSE(icp_node, icp_options, ls_max_num_iters, int);
         OPTION_CLAUSE(icp_node, icp_options, ls_num_threads, int);
+        OPTION_CLAUSE(icp_node, icp_options, bundle_residuals, bool);
         OPTION_CLAUSE(icp_node, icp_options, ls_sigma, double);
         OPTION_CLAUSE(icp_node, icp_options, min_num_residuals, int);
         OPTION_CLAUSE(icp_node, icp_options, max_num_residuals, int);
+        OPTION_CLAUSE(icp_node, icp_options, observability_selection, bool);
+        OPTION_CLAUSE(icp_node, icp_options, observability_information_ratio, double);
+        OPTION_CLAUSE(icp_node, icp_options, observability_min_num_keypoints, int);
         OPTION_CLAUSE(icp_node, icp_options, weight_alpha, double);
         OPTION_CLAUSE(icp_node, icp_options, weight_neighborhood, double);
         OPTION_CLAUSE(icp_node, icp_options, ls_tolerant_min_threshold, double);
@@ -61,6 +65,10 @@ namespace ct_icp {
         OPTION_CLAUSE(icp_node, icp_options, outlier_distance, double);
         OPTION_CLAUSE(icp_node, icp_options, use_barycenter, bool);
 
+        // GENERALIZED-ICP PARAMS
+        OPTION_CLAUSE(icp_node, icp_options, gicp_source_radius, double);
+        OPTION_CLAUSE(icp_node, icp_options, gicp_epsilon, double);
+
         if (icp_node["distance"]) {
             auto distance = icp_node["distance"].as<std::string>();
             if (distance == "POINT_TO_PLANE")
@@ -71,6 +79,8 @@ namespace ct_icp {
                 icp_options.distance = POINT_TO_POINT;
             else if (distance == "POINT_TO_DISTRIBUTION")
                 icp_options.distance = POINT_TO_DISTRIBUTION;
+            else if (distance == "DISTRIBUTION_TO_DISTRIBUTION")
+                icp_options.distance = DISTRIBUTION_TO_DISTRIBUTION;
             else
                 throw std::runtime_error("Distance " + distance + " not recognized as a valid distance");
         }
@@ -118,6 +128,18 @@ namespace ct_icp {
                 icp_options.loss_function = TRUNCATED;
         }
 
+        if (icp_node["coarse_to_fine_levels"]) {
+            auto levels_node = icp_node["coarse_to_fine_levels"];
+            CHECK(levels_node.IsSequence()) << "The node `coarse_to_fine_levels` must be a sequence of levels";
+            for (auto level_node: levels_node) {
+                ct_icp::CTICPOptions::CoarseToFineLevel level;
+                OPTION_CLAUSE(level_node, level, num_iters, int);
+                OPTION_CLAUSE(level_node, level, keypoints_ratio, double);
+                OPTION_CLAUSE(level_node, level, search_radius, double);
+                icp_options.coarse_to_fine_levels.push_back(level);
+            }
+        }
+
         return icp_options;
     }
 
@@ -161,6 +183,10 @@ namespace ct_icp {
                 type = odometry_options.neighborhood_strategy->GetType();
             if (type == DistanceBasedStrategy::Options::Type())
                 odometry_options.neighborhood_strategy = std::make_shared<DistanceBasedStrategy::Options>();
+            else if (type == FixedRadiusStrategy::Options::Type())
+                odometry_options.neighborhood_strategy = std::make_shared<FixedRadiusStrategy::Options>();
+            else if (type == RangeImageStrategy::Options::Type())
+                odometry_options.neighborhood_strategy = std::make_shared<RangeImageStrategy::Options>();
             else if (type != DefaultNearestNeighborStrategy::Options::Type()) {
                 SLAM_LOG(WARNING) << "The neighborhood strategy type :" << type << " is not recognised" << std::endl;
             }
@@ -176,6 +202,11 @@ namespace ct_icp {
 
         // Init options
         OPTION_CLAUSE(odometry_node, odometry_options, init_num_frames, int)
+        OPTION_CLAUSE(odometry_node, odometry_options, init_with_motion_hypotheses, bool)
+        OPTION_CLAUSE(odometry_node, odometry_options, hypotheses_sample_voxel_size, double)
+        OPTION_CLAUSE(odometry_node, odometry_options, hypotheses_max_num_points, int)
+        OPTION_CLAUSE(odometry_node, odometry_options, hypotheses_search_radius, double)
+        OPTION_CLAUSE(odometry_node, odometry_options, hypotheses_max_residual, double)
         OPTION_CLAUSE(odometry_node, odometry_options, init_voxel_size, double)
         OPTION_CLAUSE(odometry_node, odometry_options, init_sample_voxel_size, double)
 
@@ -185,6 +216,7 @@ namespace ct_icp {
         OPTION_CLAUSE(odometry_node, odometry_options, debug_print, bool)
         OPTION_CLAUSE(odometry_node, odometry_options, debug_viz, bool)
         OPTION_CLAUSE(odometry_node, odometry_options, do_no_insert, bool)
+        OPTION_CLAUSE(odometry_node, odometry_options, localization_mode, bool)
         OPTION_CLAUSE(odometry_node, odometry_options, always_insert, bool)
 
         // Robust options
@@ -193,6 +225,7 @@ namespace ct_icp {
         OPTION_CLAUSE(odometry_node, odometry_options, robust_full_voxel_threshold, double);
         OPTION_CLAUSE(odometry_node, odometry_options, robust_fail_early, bool);
         OPTION_CLAUSE(odometry_node, odometry_options, robust_num_attempts, int);
+        OPTION_CLAUSE(odometry_node, odometry_options, robust_num_parallel_attempts, int);
         OPTION_CLAUSE(odometry_node, odometry_options, robust_max_voxel_neighborhood, int);
         OPTION_CLAUSE(odometry_node, odometry_options, robust_threshold_relative_orientation, double)
         OPTION_CLAUSE(odometry_node, odometry_options, robust_threshold_ego_orientation, double);
@@ -274,6 +307,7 @@ namespace ct_icp {
         OPTION_CLAUSE(dataset_node, dataset_options, nclt_num_aggregated_pc, int)
         OPTION_CLAUSE(dataset_node, dataset_options, max_dist_lidar_center, float)
         OPTION_CLAUSE(dataset_node, dataset_options, use_all_datasets, bool)
+        OPTION_CLAUSE(dataset_node, dataset_options, cache_directory, std::string)
 
         if (dataset_node["sequence_options"]) {
             std::vector<SequenceOptions> sequence_options;
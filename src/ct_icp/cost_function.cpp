@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include <ct_icp/cost_functions.h>
 
 namespace ct_icp {
@@ -13,5 +15,176 @@ namespace ct_icp {
         rho[1] = 0.0;
         rho[2] = 0.0;
     }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    PointToPlaneBundle::PointToPlaneBundle(POSE_PARAMETRIZATION parametrization,
+                                           std::unique_ptr<ceres::LossFunction> loss_function,
+                                           int num_threads) : parametrization_(parametrization),
+                                                              loss_function_(std::move(loss_function)),
+                                                              num_threads_(std::max(1, num_threads)) {
+        if (parametrization == CONTINUOUS_TIME)
+            *mutable_parameter_block_sizes() = {4, 3, 4, 3};
+        else
+            *mutable_parameter_block_sizes() = {4, 3};
+        set_num_residuals(0);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void PointToPlaneBundle::Reserve(size_t num_points) {
+        for (auto *array: {&raw_x_, &raw_y_, &raw_z_, &normal_x_, &normal_y_, &normal_z_,
+                           &offsets_, &weights_, &alphas_})
+            array->reserve(num_points);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void PointToPlaneBundle::AddResidual(const Eigen::Vector3d &reference,
+                                         const Eigen::Vector3d &raw_point,
+                                         const Eigen::Vector3d &normal,
+                                         double weight, double alpha_timestamp) {
+        raw_x_.push_back(raw_point.x());
+        raw_y_.push_back(raw_point.y());
+        raw_z_.push_back(raw_point.z());
+        normal_x_.push_back(normal.x());
+        normal_y_.push_back(normal.y());
+        normal_z_.push_back(normal.z());
+        offsets_.push_back(reference.dot(normal));
+        weights_.push_back(weight);
+        alphas_.push_back(parametrization_ == CONTINUOUS_TIME ? alpha_timestamp : 1.0);
+        set_num_residuals(int(weights_.size()));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool PointToPlaneBundle::Evaluate(double const *const *parameters, double *residuals, double **jacobians) const {
+        const bool kIsCT = parametrization_ == CONTINUOUS_TIME;
+        const double *qb = parameters[0], *tb = parameters[1];
+        const double *qe = kIsCT ? parameters[2] : parameters[0];
+        const double *te = kIsCT ? parameters[3] : parameters[1];
+        double *jac_qb = nullptr, *jac_tb = nullptr, *jac_qe = nullptr, *jac_te = nullptr;
+        if (jacobians) {
+            if (kIsCT) {
+                jac_qb = jacobians[0];
+                jac_tb = jacobians[1];
+                jac_qe = jacobians[2];
+                jac_te = jacobians[3];
+            } else {
+                jac_qe = jacobians[0];
+                jac_te = jacobians[1];
+            }
+        }
+        // Interpolate along the shortest path between the two orientations
+        const double sign = (qb[0] * qe[0] + qb[1] * qe[1] + qb[2] * qe[2] + qb[3] * qe[3]) < 0. ? -1. : 1.;
+
+        constexpr int kChunkSize = 256;
+        const int num_points = int(NumPoints());
+        const int num_chunks = (num_points + kChunkSize - 1) / kChunkSize;
+
+#pragma omp parallel for num_threads(num_threads_) schedule(static)
+        for (int chunk_idx = 0; chunk_idx < num_chunks; ++chunk_idx) {
+            const int begin = chunk_idx * kChunkSize;
+            const int end = std::min(num_points, begin + kChunkSize);
+            const int size = end - begin;
+
+            // The residuals and the jacobians w.r.t. the interpolated (normalized) quaternion and translation
+            double res[kChunkSize], scale[kChunkSize];
+            double dq[4][kChunkSize], dt[3][kChunkSize];
+
+#pragma omp simd
+            for (int j = 0; j < size; ++j) {
+                const int i = begin + j;
+                const double a = alphas_[i], b = 1.0 - a;
+                double x = b * qb[0] + a * sign * qe[0];
+                double y = b * qb[1] + a * sign * qe[1];
+                double z = b * qb[2] + a * sign * qe[2];
+                double w = b * qb[3] + a * sign * qe[3];
+                const double inv_norm = 1.0 / std::sqrt(x * x + y * y + z * z + w * w);
+                x *= inv_norm;
+                y *= inv_norm;
+                z *= inv_norm;
+                w *= inv_norm;
+
+                const double px = raw_x_[i], py = raw_y_[i], pz = raw_z_[i];
+                const double nx = normal_x_[i], ny = normal_y_[i], nz = normal_z_[i];
+                const double weight = weights_[i];
+
+                // R(q) p = p + 2 w (v x p) + 2 v x (v x p)
+                const double cx = y * pz - z * py, cy = z * px - x * pz, cz = x * py - y * px;
+                const double ccx = y * cz - z * cy, ccy = z * cx - x * cz, ccz = x * cy - y * cx;
+                const double rpx = px + 2.0 * (w * cx + ccx);
+                const double rpy = py + 2.0 * (w * cy + ccy);
+                const double rpz = pz + 2.0 * (w * cz + ccz);
+                const double tx = b * tb[0] + a * te[0];
+                const double ty = b * tb[1] + a * te[1];
+                const double tz = b * tb[2] + a * te[2];
+                res[j] = weight * (offsets_[i] - (nx * (rpx + tx) + ny * (rpy + ty) + nz * (rpz + tz)));
+
+                // d(R p)/dw = 2 (v x p), d(R p)/dv = 2 (-w [p]x + (v.p) I + v p^T - 2 p v^T)
+                const double n_dot_p = nx * px + ny * py + nz * pz;
+                const double n_dot_v = nx * x + ny * y + nz * z;
+                const double v_dot_p = x * px + y * py + z * pz;
+                const double npx = ny * pz - nz * py, npy = nz * px - nx * pz, npz = nx * py - ny * px;
+                const double gx = -2.0 * weight * (-w * npx + v_dot_p * nx + n_dot_v * px - 2.0 * n_dot_p * x);
+                const double gy = -2.0 * weight * (-w * npy + v_dot_p * ny + n_dot_v * py - 2.0 * n_dot_p * y);
+                const double gz = -2.0 * weight * (-w * npz + v_dot_p * nz + n_dot_v * pz - 2.0 * n_dot_p * z);
+                const double gw = -2.0 * weight * (nx * cx + ny * cy + nz * cz);
+
+                // Project on the tangent of the normalization of the interpolated quaternion
+                const double g_dot_q = gx * x + gy * y + gz * z + gw * w;
+                dq[0][j] = (gx - g_dot_q * x) * inv_norm;
+                dq[1][j] = (gy - g_dot_q * y) * inv_norm;
+                dq[2][j] = (gz - g_dot_q * z) * inv_norm;
+                dq[3][j] = (gw - g_dot_q * w) * inv_norm;
+                dt[0][j] = -weight * nx;
+                dt[1][j] = -weight * ny;
+                dt[2][j] = -weight * nz;
+            }
+
+            // Apply the robust loss
+            for (int j = 0; j < size; ++j) {
+                scale[j] = 1.0;
+                if (!loss_function_)
+                    continue;
+                double rho[3];
+                const double r = res[j];
+                loss_function_->Evaluate(r * r, rho);
+                const double sqrt_rho = std::sqrt(std::max(rho[0], 0.));
+                if (sqrt_rho > 1.e-12) {
+                    scale[j] = rho[1] * std::abs(r) / sqrt_rho;
+                    res[j] = r < 0. ? -sqrt_rho : sqrt_rho;
+                } else {
+                    scale[j] = std::sqrt(std::max(rho[1], 0.));
+                    res[j] = scale[j] * r;
+                }
+            }
+
+            for (int j = 0; j < size; ++j)
+                residuals[begin + j] = res[j];
+            if (!jacobians)
+                continue;
+
+#pragma omp simd
+            for (int j = 0; j < size; ++j) {
+                const int i = begin + j;
+                const double a = alphas_[i], b = 1.0 - a;
+                const double s_b = scale[j] * b, s_e = scale[j] * a;
+                if (jac_qb) {
+                    for (int c = 0; c < 4; ++c)
+                        jac_qb[4 * i + c] = s_b * dq[c][j];
+                }
+                if (jac_tb) {
+                    for (int c = 0; c < 3; ++c)
+                        jac_tb[3 * i + c] = s_b * dt[c][j];
+                }
+                if (jac_qe) {
+                    for (int c = 0; c < 4; ++c)
+                        jac_qe[4 * i + c] = sign * s_e * dq[c][j];
+                }
+                if (jac_te) {
+                    for (int c = 0; c < 3; ++c)
+                        jac_te[3 * i + c] = s_e * dt[c][j];
+                }
+            }
+        }
+        return true;
+    }
 }
 
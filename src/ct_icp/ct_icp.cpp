@@ -3,6 +3,7 @@
 #include <queue>
 #include <thread>
 #include <atomic>
+#include <array>
 
 #include <Eigen/StdVector>
 #include <ceres/ceres.h>
@@ -26,38 +27,157 @@ namespace ct_icp {
         };
     }
 
-    template<POSE_PARAMETRIZATION ParameterT, ICP_DISTANCE DistanceT>
-    struct parametrization_traits {};
+    // The functor of the residuals of a distance
+    template<ICP_DISTANCE DistanceT>
+    struct distance_traits {};
 
     template<>
-    struct parametrization_traits<SIMPLE, POINT_TO_PLANE> {
-        typedef FunctorPointToPlane cost_functor_t;
-        typedef FunctorPointToPlane::cost_function_t cost_function_t;
+    struct distance_traits<POINT_TO_PLANE> {
+        typedef FunctorPointToPlane functor_t;
     };
 
     template<>
-    struct parametrization_traits<SIMPLE, POINT_TO_POINT> {
-        typedef FunctorPointToPoint cost_functor_t;
-        typedef FunctorPointToPoint::cost_function_t cost_function_t;
+    struct distance_traits<POINT_TO_POINT> {
+        typedef FunctorPointToPoint functor_t;
     };
 
     template<>
-    struct parametrization_traits<SIMPLE, POINT_TO_LINE> {
-        typedef FunctorPointToLine cost_functor_t;
-        typedef FunctorPointToLine::cost_function_t cost_function_t;
+    struct distance_traits<POINT_TO_LINE> {
+        typedef FunctorPointToLine functor_t;
     };
 
     template<>
-    struct parametrization_traits<SIMPLE, POINT_TO_DISTRIBUTION> {
-        typedef FunctorPointToDistribution cost_functor_t;
-        typedef FunctorPointToDistribution::cost_function_t cost_function_t;
+    struct distance_traits<POINT_TO_DISTRIBUTION> {
+        typedef FunctorPointToDistribution functor_t;
     };
 
-    template<ICP_DISTANCE DistanceT>
-    struct parametrization_traits<CONTINUOUS_TIME, DistanceT> {
-        typedef typename parametrization_traits<SIMPLE, DistanceT>::cost_functor_t base_functor_t;
-        typedef CTFunctor<base_functor_t> cost_functor_t;
-        typedef typename CTFunctor<base_functor_t>::cost_function_t cost_function_t;
+    template<>
+    struct distance_traits<DISTRIBUTION_TO_DISTRIBUTION> {
+        typedef FunctorDistributionToDistribution functor_t;
+    };
+
+    // The cost functor of a geometric functor for a parametrization, and the parameter blocks of its residuals
+    template<POSE_PARAMETRIZATION ParameterT>
+    struct parametrization_traits {};
+
+    template<>
+    struct parametrization_traits<SIMPLE> {
+        template<typename FunctorT>
+        using cost_functor_t = FunctorT;
+
+        template<typename FunctorT, typename... Args>
+        static FunctorT *MakeFunctor(double alpha_timestamp, Args &&... args) {
+            return new FunctorT(std::forward<Args>(args)...);
+        }
+
+        static std::vector<double *> ParameterBlocks(double *begin_quat, double *begin_t,
+                                                     double *end_quat, double *end_t) {
+            return {end_quat, end_t};
+        }
+    };
+
+    template<>
+    struct parametrization_traits<CONTINUOUS_TIME> {
+        template<typename FunctorT>
+        using cost_functor_t = CTFunctor<FunctorT>;
+
+        template<typename FunctorT, typename... Args>
+        static CTFunctor<FunctorT> *MakeFunctor(double alpha_timestamp, Args &&... args) {
+            return new CTFunctor<FunctorT>(alpha_timestamp, std::forward<Args>(args)...);
+        }
+
+        static std::vector<double *> ParameterBlocks(double *begin_quat, double *begin_t,
+                                                     double *end_quat, double *end_t) {
+            return {begin_quat, begin_t, end_quat, end_t};
+        }
+    };
+
+    // The residual kernel of a configuration (parametrization, distance), which constructs its cost functions
+    template<POSE_PARAMETRIZATION ParameterT, ICP_DISTANCE DistanceT>
+    struct ResidualKernel {
+        typedef parametrization_traits<ParameterT> param_traits_t;
+        typedef typename distance_traits<DistanceT>::functor_t functor_t;
+        typedef typename param_traits_t::template cost_functor_t<functor_t> cost_functor_t;
+        typedef typename cost_functor_t::cost_function_t cost_function_t;
+
+        template<typename... Args>
+        static ceres::CostFunction *MakeCostFunction(double alpha_timestamp, Args &&... args) {
+            return new cost_function_t(param_traits_t::template MakeFunctor<functor_t>(
+                    alpha_timestamp, std::forward<Args>(args)...));
+        }
+
+        // Constructs a residual from the neighborhood of a keypoint
+        static ceres::CostFunction *MakeFromNeighborhood(double alpha_timestamp,
+                                                         const Eigen::Vector3d &reference,
+                                                         const Eigen::Vector3d &raw_point,
+                                                         const slam::NeighborhoodDescription<double> &neighborhood,
+                                                         double weight) {
+            return MakeCostFunction(alpha_timestamp, reference, raw_point, neighborhood, weight);
+        }
+    };
+
+    typedef ceres::CostFunction *(*neighborhood_residual_factory_t)(double, const Eigen::Vector3d &,
+                                                                      const Eigen::Vector3d &,
+                                                                      const slam::NeighborhoodDescription<double> &,
+                                                                      double);
+
+    typedef ceres::CostFunction *(*distribution_residual_factory_t)(double, const Eigen::Vector3d &,
+                                                                      const Eigen::Vector3d &,
+                                                                      const Eigen::Matrix3d &, double);
+
+    // The distances index the table of the residual factories: they must be contiguous from 0
+    constexpr size_t kNumDistances = DISTRIBUTION_TO_DISTRIBUTION + 1;
+    static_assert(POINT_TO_PLANE == 0 && POINT_TO_POINT == 1 && POINT_TO_LINE == 2 &&
+                  POINT_TO_DISTRIBUTION == 3 && DISTRIBUTION_TO_DISTRIBUTION == 4,
+                  "The residual factories are indexed by ICP_DISTANCE, update `kNumDistances` with the enum");
+
+    // The residual kernels of a parametrization (indexed by distance), selected at the start of a registration
+    struct ResidualFactories {
+        std::array<neighborhood_residual_factory_t, kNumDistances> from_neighborhood;
+        distribution_residual_factory_t from_distribution = nullptr;
+
+        // Returns the factory of the residuals of a distance (the table is built from this switch)
+        template<POSE_PARAMETRIZATION ParameterT>
+        static neighborhood_residual_factory_t NeighborhoodFactory(ICP_DISTANCE distance) {
+            switch (distance) {
+                case POINT_TO_PLANE:
+                    return &ResidualKernel<ParameterT, POINT_TO_PLANE>::MakeFromNeighborhood;
+                case POINT_TO_POINT:
+                    return &ResidualKernel<ParameterT, POINT_TO_POINT>::MakeFromNeighborhood;
+                case POINT_TO_LINE:
+                    return &ResidualKernel<ParameterT, POINT_TO_LINE>::MakeFromNeighborhood;
+                case POINT_TO_DISTRIBUTION:
+                    return &ResidualKernel<ParameterT, POINT_TO_DISTRIBUTION>::MakeFromNeighborhood;
+                case DISTRIBUTION_TO_DISTRIBUTION:
+                    return &ResidualKernel<ParameterT, DISTRIBUTION_TO_DISTRIBUTION>::MakeFromNeighborhood;
+            }
+            throw std::runtime_error("Unsupported distance");
+        }
+
+        template<POSE_PARAMETRIZATION ParameterT>
+        static ResidualFactories Make() {
+            ResidualFactories factories;
+            for (size_t idx(0); idx < kNumDistances; ++idx)
+                factories.from_neighborhood[idx] = NeighborhoodFactory<ParameterT>(ICP_DISTANCE(idx));
+            factories.from_distribution = [](double alpha_timestamp, const Eigen::Vector3d &raw_point,
+                                             const Eigen::Vector3d &mean, const Eigen::Matrix3d &information_sqrt,
+                                             double weight) {
+                return ResidualKernel<ParameterT, DISTRIBUTION_TO_DISTRIBUTION>::MakeCostFunction(
+                        alpha_timestamp, raw_point, mean, information_sqrt, weight);
+            };
+            return factories;
+        }
+
+        static ResidualFactories Select(POSE_PARAMETRIZATION parametrization) {
+            switch (parametrization) {
+                case SIMPLE:
+                    return Make<SIMPLE>();
+                case CONTINUOUS_TIME:
+                    return Make<CONTINUOUS_TIME>();
+                default:
+                    throw std::runtime_error("Unsupported parametrization");
+            }
+        }
     };
 
     /* -------------------------------------------------------------------------------------------------------------- */
@@ -67,9 +187,7 @@ namespace ct_icp {
         grid.reserve(size_t(frame.size() / 4.));
         slam::Voxel voxel;
         for (int i = 0; i < (int) frame.size(); i++) {
-            voxel.x = static_cast<short>(frame[i].RawPoint()[0] / size_voxel);
-            voxel.y = static_cast<short>(frame[i].RawPoint()[1] / size_voxel);
-            voxel.z = static_cast<short>(frame[i].RawPoint()[2] / size_voxel);
+            voxel = slam::Voxel::Coordinates(frame[i].RawPoint(), size_voxel);
             if (grid.find(voxel) == grid.end()) {
                 grid[voxel] = frame[i];
             }
@@ -143,6 +261,138 @@ namespace ct_icp {
     }
 
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Computes the regularized covariances of the keypoints from their neighbors (in the raw frame) in a radius
+    // The keypoints without enough neighbors are left without covariance
+    std::vector<std::optional<Eigen::Matrix3d>> compute_keypoints_covariances(
+            slam::ProxyView<Eigen::Vector3d> &raw_kpts, double radius, double epsilon) {
+        const auto num_points = raw_kpts.size();
+        std::vector<std::optional<Eigen::Matrix3d>> covariances(num_points);
+        if (radius <= 0.)
+            return covariances;
+
+        std::vector<Eigen::Vector3d> points(num_points);
+        tsl::robin_map<slam::Voxel, std::vector<size_t>> grid;
+        for (auto idx(0); idx < num_points; ++idx) {
+            points[idx] = raw_kpts[idx];
+            grid[slam::Voxel::Coordinates(points[idx], radius)].push_back(idx);
+        }
+
+        const double sq_radius = radius * radius;
+        const int kMinNumNeighbors = slam::Neighborhood::MinNeighborhoodSize();
+#pragma omp parallel for
+        for (int idx = 0; idx < int(num_points); ++idx) {
+            const auto &point = points[idx];
+            const auto voxel = slam::Voxel::Coordinates(point, radius);
+            Eigen::Vector3d barycenter = Eigen::Vector3d::Zero();
+            Eigen::Matrix3d second_moment = Eigen::Matrix3d::Zero();
+            int num_neighbors = 0;
+            for (int dx(-1); dx <= 1; ++dx) {
+                for (int dy(-1); dy <= 1; ++dy) {
+                    for (int dz(-1); dz <= 1; ++dz) {
+                        auto it = grid.find(slam::Voxel{voxel.x + dx, voxel.y + dy, voxel.z + dz});
+                        if (it == grid.end())
+                            continue;
+                        for (auto neighbor_idx: it->second) {
+                            const auto &neighbor = points[neighbor_idx];
+                            if ((neighbor - point).squaredNorm() > sq_radius)
+                                continue;
+                            barycenter += neighbor;
+                            second_moment += neighbor * neighbor.transpose();
+                            num_neighbors++;
+                        }
+                    }
+                }
+            }
+            if (num_neighbors < kMinNumNeighbors)
+                continue;
+            barycenter /= num_neighbors;
+            Eigen::Matrix3d covariance = second_moment / num_neighbors - barycenter * barycenter.transpose();
+            covariances[idx] = RegularizeCovariance(covariance, epsilon);
+        }
+        return covariances;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    // Returns the whitening matrix of a Generalized-ICP residual
+    // The source covariance is expressed in the world frame with the current estimate of the rotation
+    inline Eigen::Matrix3d gicp_information_sqrt(const VoxelDistribution &target,
+                                                 const std::optional<Eigen::Matrix3d> &source_covariance,
+                                                 const Eigen::Quaterniond &rotation) {
+        if (!source_covariance)
+            return target.information_sqrt;
+        Eigen::Matrix3d rot = rotation.toRotationMatrix();
+        return InformationSqrt(target.covariance + rot * (*source_covariance) * rot.transpose());
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    typedef Eigen::Matrix<double, 6, 1> Vector6d;
+    typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+    // The information is the hessian of the rows (sum of r r^T).
+    // For each eigen direction of the hessian (starting from the least observable), the keypoints contributing the most
+    // in this direction are selected until `information_ratio` of its information is preserved.
+    std::vector<char> select_observable_keypoints(const jacobian_rows_t &rows,
+                                                  double information_ratio,
+                                                  int min_num_keypoints) {
+        const int num_keypoints = int(rows.size());
+        std::vector<char> selected(num_keypoints, 0);
+        Matrix6d hessian = Matrix6d::Zero();
+        for (auto &row: rows)
+            hessian += row * row.transpose();
+        Eigen::SelfAdjointEigenSolver<Matrix6d> solver(hessian);
+        if (solver.info() != Eigen::Success) {
+            std::fill(selected.begin(), selected.end(), 1);
+            return selected;
+        }
+        const Vector6d eigenvalues = solver.eigenvalues(); // Sorted in increasing order
+        const Matrix6d eigenvectors = solver.eigenvectors();
+
+        // The contributions of each keypoint in every eigen direction
+        jacobian_rows_t contributions(num_keypoints);
+        for (auto idx(0); idx < num_keypoints; ++idx)
+            contributions[idx] = (eigenvectors.transpose() * rows[idx]).cwiseAbs2();
+
+        int num_selected = 0;
+        Vector6d selected_information = Vector6d::Zero();
+        std::vector<std::pair<double, int>> candidates;
+        candidates.reserve(num_keypoints);
+        for (int dir(0); dir < 6; ++dir) {
+            const double required_information = information_ratio * eigenvalues[dir];
+            if (selected_information[dir] >= required_information)
+                continue;
+            candidates.resize(0);
+            for (auto idx(0); idx < num_keypoints; ++idx) {
+                if (!selected[idx] && contributions[idx][dir] > 0.)
+                    candidates.emplace_back(contributions[idx][dir], idx);
+            }
+            std::sort(candidates.begin(), candidates.end(), std::greater<>());
+            for (auto &[_, idx]: candidates) {
+                if (selected_information[dir] >= required_information)
+                    break;
+                selected[idx] = 1;
+                selected_information += contributions[idx];
+                num_selected++;
+            }
+        }
+
+        // Complete the selection with the keypoints of highest leverage
+        if (num_selected < min_num_keypoints) {
+            const Vector6d inv_eigenvalues = eigenvalues.cwiseMax(std::numeric_limits<double>::epsilon()).cwiseInverse();
+            candidates.resize(0);
+            for (auto idx(0); idx < num_keypoints; ++idx) {
+                if (!selected[idx])
+                    candidates.emplace_back(contributions[idx].dot(inv_eigenvalues), idx);
+            }
+            const auto num_missing = std::min(candidates.size(), size_t(min_num_keypoints - num_selected));
+            std::partial_sort(candidates.begin(), candidates.begin() + num_missing, candidates.end(),
+                              std::greater<>());
+            for (auto i(0); i < num_missing; ++i)
+                selected[candidates[i].second] = 1;
+        }
+        return selected;
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
 
     // A Builder to abstract the different configurations of ICP optimization
@@ -161,30 +411,32 @@ namespace ct_icp {
                 corrected_raw_points_[i] = raw_points_[i].operator Eigen::Vector3d();
 
             max_num_residuals_ = options->max_num_residuals;
+            factories_ = ResidualFactories::Select(options->parametrization);
         }
 
-        bool InitProblem(int num_residuals) {
-            problem = std::make_unique<ceres::Problem>();
-            parameter_block_set_ = false;
-
-            // Select Loss function
+        // Returns a new loss function selected by the options (nullptr for the STANDARD least squares)
+        ceres::LossFunction *MakeLossFunction() const {
             switch (options_->loss_function) {
-                case LEAST_SQUARES::STANDARD:
-                    break;
                 case LEAST_SQUARES::CAUCHY:
-                    loss_function = new ceres::CauchyLoss(options_->ls_sigma);
-                    break;
+                    return new ceres::CauchyLoss(options_->ls_sigma);
                 case LEAST_SQUARES::HUBER:
-                    loss_function = new ceres::HuberLoss(options_->ls_sigma);
-                    break;
+                    return new ceres::HuberLoss(options_->ls_sigma);
                 case LEAST_SQUARES::TOLERANT:
-                    loss_function = new ceres::TolerantLoss(options_->ls_tolerant_min_threshold,
-                                                            options_->ls_sigma);
-                    break;
+                    return new ceres::TolerantLoss(options_->ls_tolerant_min_threshold,
+                                                   options_->ls_sigma);
                 case LEAST_SQUARES::TRUNCATED:
-                    loss_function = new ct_icp::TruncatedLoss(options_->ls_sigma);
-                    break;
+                    return new ct_icp::TruncatedLoss(options_->ls_sigma);
+                default:
+                    return nullptr;
             }
+        }
+
+        bool InitProblem(int num_residuals) {
+            problem = std::make_unique<ceres::Problem>();
+            parameter_block_set_ = false;
+
+            // Select Loss function
+            loss_function = MakeLossFunction();
 
             // Resize the number of residuals
             vector_cost_functors_.resize(num_residuals);
@@ -223,6 +475,11 @@ namespace ct_icp {
             end_t_ = &end_t.x();
             begin_quat_ = &begin_quat.x();
             end_quat_ = &end_quat.x();
+            parameter_blocks_ = options_->parametrization == CONTINUOUS_TIME ?
+                                parametrization_traits<CONTINUOUS_TIME>::ParameterBlocks(begin_quat_, begin_t_,
+                                                                                         end_quat_, end_t_) :
+                                parametrization_traits<SIMPLE>::ParameterBlocks(begin_quat_, begin_t_,
+                                                                                end_quat_, end_t_);
 
             switch (options_->parametrization) {
                 case CONTINUOUS_TIME:
@@ -251,122 +508,28 @@ namespace ct_icp {
 
         struct _FunctorStruct {
             ICP_DISTANCE distance = POINT_TO_PLANE;
-            POSE_PARAMETRIZATION parametrization = CONTINUOUS_TIME;
-
-            CTFunctor<FunctorPointToPlane> *ct_pt_to_plane = nullptr;
-            CTFunctor<FunctorPointToPoint> *ct_pt_to_point = nullptr;
-            CTFunctor<FunctorPointToLine> *ct_pt_to_line = nullptr;
-            CTFunctor<FunctorPointToDistribution> *ct_pt_to_distr = nullptr;
-            FunctorPointToPlane *pt_to_plane = nullptr;
-            FunctorPointToPoint *pt_to_point = nullptr;
-            FunctorPointToLine *pt_to_line = nullptr;
-            FunctorPointToDistribution *pt_to_distr = nullptr;
-            void *cost_function = nullptr;
+            ceres::CostFunction *cost_function = nullptr; //< Owned by the builder until added to the problem
             ceres::ResidualBlockId block_id = nullptr;
 
+            bool is_distribution = false; //< Whether the residual uses a distribution cached by the map
 
-            /* ------------------------------------------------------------------------------------------------------ */
-#define __CLEAR_CASE(_parametrization, _distance) \
-            case _distance: \
-                delete static_cast<parametrization_traits<_parametrization, _distance>::cost_function_t *>(cost_function); \
-                break;
+            // The point-to-plane residuals packed in a bundle are stored without cost function
+            bool is_bundled = false;
+            Eigen::Vector3d reference, raw_point, normal;
+            double weight = 1.0, alpha_timestamp = 1.0;
 
+            bool IsSet() const { return cost_function != nullptr || is_bundled; }
 
             void clear(bool deallocate_memory = true) {
-
-                if (cost_function && deallocate_memory) {
-                    switch (parametrization) {
-                        case SIMPLE:
-                            switch (distance) {
-                                __CLEAR_CASE(SIMPLE, POINT_TO_PLANE)
-                                __CLEAR_CASE(SIMPLE, POINT_TO_LINE)
-                                __CLEAR_CASE(SIMPLE, POINT_TO_POINT)
-                                __CLEAR_CASE(SIMPLE, POINT_TO_DISTRIBUTION)
-                            }
-                            break;
-                        case CONTINUOUS_TIME:
-                            switch (distance) {
-                                __CLEAR_CASE(CONTINUOUS_TIME, POINT_TO_PLANE)
-                                __CLEAR_CASE(CONTINUOUS_TIME, POINT_TO_LINE)
-                                __CLEAR_CASE(CONTINUOUS_TIME, POINT_TO_POINT)
-                                __CLEAR_CASE(CONTINUOUS_TIME, POINT_TO_DISTRIBUTION)
-                            }
-                            break;
-                    }
-                }
-
-
-                ct_pt_to_line = nullptr;
-                ct_pt_to_point = nullptr;
-                ct_pt_to_plane = nullptr;
-                ct_pt_to_distr = nullptr;
-                block_id = nullptr;
-
-                pt_to_plane = nullptr;
-                pt_to_point = nullptr;
-                pt_to_line = nullptr;
-                pt_to_distr = nullptr;
+                if (deallocate_memory)
+                    delete cost_function;
                 cost_function = nullptr;
+                block_id = nullptr;
+                is_distribution = false;
+                is_bundled = false;
             }
-
         };
 
-#define __ADD_RESIDUAL_CASE_SIMPLE(_distance) \
-        case _distance: \
-            functor.block_id = problem.AddResidualBlock(              \
-                static_cast<parametrization_traits<SIMPLE, _distance>::cost_function_t *>(functor.cost_function),  \
-                loss_function, end_quat_, end_t_);  \
-        break;
-
-#define __ADD_RESIDUAL_CASE_CT(_distance) \
-        case _distance: \
-            functor.block_id = problem.AddResidualBlock(              \
-                static_cast<parametrization_traits<CONTINUOUS_TIME, _distance>::cost_function_t *>(functor.cost_function),  \
-                loss_function, begin_quat_, begin_t_, end_quat_, end_t_);  \
-        break;
-
-        inline void AddCostFunctorToProblem(ceres::Problem &problem,
-                                            _FunctorStruct &functor,
-                                            ceres::LossFunction *loss_function) {
-            switch (functor.parametrization) {
-                case SIMPLE:
-                    switch (functor.distance) {
-                        __ADD_RESIDUAL_CASE_SIMPLE(POINT_TO_PLANE)
-                        __ADD_RESIDUAL_CASE_SIMPLE(POINT_TO_LINE)
-                        __ADD_RESIDUAL_CASE_SIMPLE(POINT_TO_POINT)
-                        __ADD_RESIDUAL_CASE_SIMPLE(POINT_TO_DISTRIBUTION)
-                    }
-                    break;
-                case CONTINUOUS_TIME:
-                    switch (functor.distance) {
-                        __ADD_RESIDUAL_CASE_CT(POINT_TO_PLANE)
-                        __ADD_RESIDUAL_CASE_CT(POINT_TO_LINE)
-                        __ADD_RESIDUAL_CASE_CT(POINT_TO_POINT)
-                        __ADD_RESIDUAL_CASE_CT(POINT_TO_DISTRIBUTION)
-                    }
-                    break;
-            }
-        }
-
-
-#define __SET_RESIDUAL_BLOCK_SIMPLE(name, _distance) \
-        case _distance: \
-        functor.name = new parametrization_traits<SIMPLE, _distance>::cost_functor_t(reference_point, raw_point, \
-                                                      neighborhood, weight); \
-        functor.cost_function = static_cast<void *>(new parametrization_traits<SIMPLE, _distance>::cost_function_t( \
-                functor.name)); \
-        break;
-
-#define __SET_RESIDUAL_BLOCK_CT(name, _distance) \
-        case _distance: \
-        functor.name = new parametrization_traits<CONTINUOUS_TIME, _distance>::cost_functor_t(alpha_timestamp, \
-                                                        reference_point, raw_point, \
-                                                        neighborhood, weight); \
-        functor.cost_function = static_cast<void *>(new parametrization_traits<CONTINUOUS_TIME, _distance>::cost_function_t( \
-                functor.name)); \
-        break;
-
-
         inline void SetResidualBlock(int residual_id,
                                      int keypoint_id,
                                      const Eigen::Vector3d &reference_point,
@@ -376,48 +539,94 @@ namespace ct_icp {
                                      std::optional<ICP_DISTANCE> distance_override = {}) {
 
             _FunctorStruct functor;
-            functor.parametrization = options_->parametrization;
             functor.distance = distance_override.has_value() ? distance_override.value() : options_->distance;
             if (alpha_timestamp < 0 || alpha_timestamp > 1)
                 throw std::runtime_error("BAD ALPHA TIMESTAMP !");
             auto &raw_point = corrected_raw_points_[keypoint_id];
-            switch (functor.parametrization) {
-                case SIMPLE: {
-                    switch (functor.distance) {
-                        __SET_RESIDUAL_BLOCK_SIMPLE(pt_to_plane, POINT_TO_PLANE)
-                        __SET_RESIDUAL_BLOCK_SIMPLE(pt_to_point, POINT_TO_POINT)
-                        __SET_RESIDUAL_BLOCK_SIMPLE(pt_to_line, POINT_TO_LINE)
-                        __SET_RESIDUAL_BLOCK_SIMPLE(pt_to_distr, POINT_TO_DISTRIBUTION)
-                    }
-                }
-                    break;
+            if (options_->bundle_residuals && functor.distance == POINT_TO_PLANE) {
+                functor.is_bundled = true;
+                functor.reference = reference_point;
+                functor.raw_point = raw_point;
+                functor.normal = neighborhood.normal;
+                functor.weight = weight;
+                functor.alpha_timestamp = alpha_timestamp;
+            } else
+                functor.cost_function = factories_.from_neighborhood[functor.distance](alpha_timestamp,
+                                                                                       reference_point, raw_point,
+                                                                                       neighborhood, weight);
+            vector_cost_functors_[residual_id] = functor;
+        }
 
-                case CONTINUOUS_TIME: {
-                    switch (functor.distance) {
-                        __SET_RESIDUAL_BLOCK_CT(ct_pt_to_plane, POINT_TO_PLANE)
-                        __SET_RESIDUAL_BLOCK_CT(ct_pt_to_point, POINT_TO_POINT)
-                        __SET_RESIDUAL_BLOCK_CT(ct_pt_to_line, POINT_TO_LINE)
-                        __SET_RESIDUAL_BLOCK_CT(ct_pt_to_distr, POINT_TO_DISTRIBUTION)
-                    }
-                }
-                    break;
-            }
+        // Sets a Generalized-ICP residual, whitened by the precomputed `information_sqrt`
+        inline void SetDistributionResidualBlock(int residual_id,
+                                                 int keypoint_id,
+                                                 const Eigen::Vector3d &mean,
+                                                 const Eigen::Matrix3d &information_sqrt,
+                                                 double weight = 1.0,
+                                                 double alpha_timestamp = -1.0) {
+            _FunctorStruct functor;
+            functor.distance = DISTRIBUTION_TO_DISTRIBUTION;
+            functor.is_distribution = true;
+            if (alpha_timestamp < 0 || alpha_timestamp > 1)
+                throw std::runtime_error("BAD ALPHA TIMESTAMP !");
+            functor.cost_function = factories_.from_distribution(alpha_timestamp, corrected_raw_points_[keypoint_id],
+                                                                 mean, information_sqrt, weight);
             vector_cost_functors_[residual_id] = functor;
         }
 
+        // Discards the residuals of the keypoints not selected (`num_residuals_per_keypoint` consecutive residuals)
+        void DiscardResidualBlocks(const std::vector<char> &selected_keypoints, int num_residuals_per_keypoint) {
+            for (auto residual_id(0); residual_id < vector_cost_functors_.size(); ++residual_id) {
+                const auto keypoint_id = residual_id / num_residuals_per_keypoint;
+                if (keypoint_id < selected_keypoints.size() && !selected_keypoints[keypoint_id])
+                    vector_cost_functors_[residual_id].clear(true);
+            }
+        }
 
         std::unique_ptr<ceres::Problem> GetProblem(int &out_number_of_residuals) {
             out_number_of_residuals = 0;
+            num_distribution_residuals_ = 0;
+
+            // The point-to-plane residuals are optionally packed in a single residual block
+            std::unique_ptr<PointToPlaneBundle> bundle = nullptr;
+            if (options_->bundle_residuals) {
+                bundle = std::make_unique<PointToPlaneBundle>(
+                        options_->parametrization,
+                        std::unique_ptr<ceres::LossFunction>(MakeLossFunction()),
+                        options_->ls_num_threads);
+                bundle->Reserve(vector_cost_functors_.size());
+            }
+
+            bool is_loss_function_used = false;
             for (auto &functor: vector_cost_functors_) {
-                if (functor.cost_function != nullptr) {
+                if (functor.IsSet()) {
                     if (max_num_residuals_ <= 0 || out_number_of_residuals < max_num_residuals_) {
-                        AddCostFunctorToProblem(*problem, functor, loss_function);
+                        if (functor.is_bundled) {
+                            bundle->AddResidual(functor.reference, functor.raw_point, functor.normal,
+                                                functor.weight, functor.alpha_timestamp);
+                        } else {
+                            functor.block_id = problem->AddResidualBlock(functor.cost_function, loss_function,
+                                                                         parameter_blocks_);
+                            is_loss_function_used = true;
+                        }
                         out_number_of_residuals++;
+                        if (functor.is_distribution)
+                            num_distribution_residuals_++;
                     } else {
                         functor.clear(true);
                     }
                 }
             }
+
+            if (bundle && bundle->NumPoints() > 0) {
+                // The loss function is applied within the bundle
+                problem->AddResidualBlock(bundle.release(), nullptr, parameter_blocks_);
+            }
+            if (!is_loss_function_used && loss_function != nullptr) {
+                // The problem only takes ownership of the loss functions of its residual blocks
+                delete loss_function;
+                loss_function = nullptr;
+            }
             std::for_each(vector_cost_functors_.begin(), vector_cost_functors_.end(),
                           [](auto &item) { item.clear(false); });
             return std::move(problem);
@@ -433,10 +642,14 @@ namespace ct_icp {
             return vector_cost_functors_;
         }
 
+        // The number of residuals of the last problem using the distributions cached by the map
+        int NumDistributionResiduals() const { return num_distribution_residuals_; }
+
     private:
         const CTICPOptions *options_;
         std::unique_ptr<ceres::Problem> problem = nullptr;
         int max_num_residuals_ = -1;
+        int num_distribution_residuals_ = 0;
 
         // Parameters block pointers
         bool parameter_block_set_ = false;
@@ -444,6 +657,10 @@ namespace ct_icp {
         double *end_quat_ = nullptr;
         double *begin_t_ = nullptr;
         double *end_t_ = nullptr;
+        std::vector<double *> parameter_blocks_;
+
+        // The residual kernels selected for the parametrization of the options
+        ResidualFactories factories_;
 
         // Pointers managed by ceres
         const slam::ProxyView<Eigen::Vector3d> &world_points_;
@@ -508,6 +725,18 @@ namespace ct_icp {
 
         int number_of_residuals;
 
+        const bool kUseDistributions = options.distance == DISTRIBUTION_TO_DISTRIBUTION;
+        std::vector<std::optional<Eigen::Matrix3d>> keypoints_covariances;
+        if (kUseDistributions)
+            keypoints_covariances = compute_keypoints_covariances(raw_kpts, options.gicp_source_radius,
+                                                                  options.gicp_epsilon);
+
+        // The keypoints are selected after the first association (only for point-to-plane residuals)
+        const bool kSelectKeypoints = options.observability_selection && options.distance == POINT_TO_PLANE;
+        jacobian_rows_t jacobian_rows(kSelectKeypoints ? num_points : 0, Vector6d::Zero());
+        std::vector<char> has_jacobian_row(jacobian_rows.size(), 0);
+        std::vector<char> selected_keypoints;
+
         ICPOptimizationBuilder builder(&options, raw_kpts, world_kpts, timestamps);
         if (options.point_to_plane_with_distortion) {
             builder.DistortFrame(begin_pose, end_pose);
@@ -547,6 +776,8 @@ namespace ct_icp {
         auto end_init = now();
         int iter(0);
         for (; iter < options.num_iters_icp; iter++) {
+            if (IsCancelled())
+                return CancelledSummary();
             auto begin_iter = now();
 
             transform_keypoints();
@@ -560,6 +791,8 @@ namespace ct_icp {
             std::atomic<size_t> num_points_ignored = 0;
 #pragma omp parallel for num_threads(num_threads)
             for (int k = 0; k < num_keypoints; ++k) {
+                if (!selected_keypoints.empty() && !selected_keypoints[k])
+                    continue;
                 Eigen::Vector3d raw_point = raw_kpts[k];
                 double timestamp = timestamps[k];
                 Eigen::Vector3d world_point = world_kpts[k];
@@ -567,6 +800,34 @@ namespace ct_icp {
                 pt.RawPoint() = raw_point;
                 pt.WorldPoint() = world_point;
                 pt.Timestamp() = timestamp;
+
+                // Generalized-ICP residuals use the distributions cached by the map (without neighborhood search)
+                // Without a cached distribution (e.g. the map does not cache them), fall back to the neighborhood search
+                VoxelDistribution distribution;
+                if (kUseDistributions && voxels_map.FindDistribution(world_point, distribution)) {
+                    // The closest distribution can be arbitrarily far: reject the outliers
+                    const double distance = (distribution.mean - world_point).norm();
+                    if (distance >= options.outlier_distance)
+                        continue;
+
+                    // Same weighting as the point-to-plane residuals (planarity and distance to the neighborhood)
+                    const auto description = slam::ComputeNeighborhoodInfo(distribution.mean, distribution.covariance,
+                                                                           slam::A2D);
+                    double weight = lambda_weight * std::pow(description.a2D, options.power_planarity) +
+                                    lambda_neighborhood * std::exp(-distance / (kMaxPointToPlane * kMinNumNeighbors));
+                    if (options.output_weights)
+                        weights[k] = weight;
+
+                    auto rotation = begin_pose.InterpolatePose(end_pose, timestamp).pose.quat;
+                    builder.SetDistributionResidualBlock(options.num_closest_neighbors * k, k,
+                                                         distribution.mean,
+                                                         gicp_information_sqrt(distribution,
+                                                                               keypoints_covariances[k],
+                                                                               rotation),
+                                                         weight, begin_pose.GetAlphaTimestamp(timestamp, end_pose));
+                    continue;
+                }
+
                 // Neighborhood search
                 const_strategy->ComputeNeighborhoodInPlace(voxels_map, pt, neighborhoods[k], &end_t);
                 auto &neighborhood = neighborhoods[k];
@@ -589,6 +850,7 @@ namespace ct_icp {
                     weights[k] = weight;
 
                 double point_to_plane_dist;
+                bool has_residual = false;
                 std::set<slam::Voxel> neighbor_voxels;
                 for (int i(0); i < options.num_closest_neighbors; ++i) {
 
@@ -599,8 +861,17 @@ namespace ct_icp {
                                              neighborhood.points[i],
                                              neighborhood.description, weight,
                                              begin_pose.GetAlphaTimestamp(timestamp, end_pose));
+                    has_residual = true;
 //                    }
                 }
+
+                // Only the keypoints with residuals contribute to the information of the selection
+                if (kSelectKeypoints && iter == 0 && has_residual) {
+                    const auto &normal = neighborhood.description.normal;
+                    jacobian_rows[k].head<3>() = weight * (world_point - end_t).cross(normal);
+                    jacobian_rows[k].tail<3>() = weight * normal;
+                    has_jacobian_row[k] = 1;
+                }
             }
             auto end_neighborhood = now();
 
@@ -608,6 +879,23 @@ namespace ct_icp {
                 std::cout << "Num points ignored=" << num_points_ignored << std::endl;
             }
 
+            if (kSelectKeypoints && iter == 0) {
+                selected_keypoints = select_observable_keypoints(jacobian_rows,
+                                                                 options.observability_information_ratio,
+                                                                 options.observability_min_num_keypoints);
+                builder.DiscardResidualBlocks(selected_keypoints, options.num_closest_neighbors);
+                // The keypoints without residual at the first iteration were not evaluated: they remain candidates
+                for (auto k(0); k < num_points; ++k) {
+                    if (!has_jacobian_row[k])
+                        selected_keypoints[k] = 1;
+                }
+                if (options.debug_print) {
+                    std::cout << "[CT_ICP] Observability-aware selection: "
+                              << std::count(selected_keypoints.begin(), selected_keypoints.end(), 1)
+                              << " / " << num_points << " keypoints selected" << std::endl;
+                }
+            }
+
             auto problem = builder.GetProblem(number_of_residuals);
 
             if (_previous_frame && options.parametrization == CONTINUOUS_TIME) {
@@ -620,6 +908,7 @@ namespace ct_icp {
                 ss_out << "[CT_ICP] number_of_residuals : " << number_of_residuals << std::endl;
                 ICPSummary summary;
                 summary.success = false;
+                summary.num_iters = iter + 1; // The failed iteration is charged
                 summary.num_residuals_used = number_of_residuals;
                 summary.error_log = ss_out.str();
                 if (options.debug_print) {
@@ -669,6 +958,7 @@ namespace ct_icp {
                 if (options.debug_print)
                     std::cout << "CT_ICP: Finished with N=" << iter << " ICP iterations" << std::endl;
 
+                iter++; // The converged iteration counts in the iterations performed
                 break;
             } else if (options.debug_print) {
                 std::cout << "[CT-ICP]: Rotation diff: " << diff_rot << "(deg)" << std::endl;
@@ -694,6 +984,7 @@ namespace ct_icp {
         icp_summary.avg_duration_neighborhood /= iter;
         icp_summary.success = true;
         icp_summary.num_residuals_used = number_of_residuals;
+        icp_summary.num_distribution_residuals = builder.NumDistributionResiduals();
         icp_summary.num_iters = iter;
 
 //        if (options.output_weights)
@@ -743,6 +1034,8 @@ namespace ct_icp {
         int num_iter_icp = options.num_iters_icp;
         int iter(0);
         for (; iter < num_iter_icp; iter++) {
+            if (IsCancelled())
+                return CancelledSummary();
             A = Eigen::MatrixXd::Zero(12, 12);
             b = Eigen::VectorXd::Zero(12);
 
@@ -867,6 +1160,7 @@ namespace ct_icp {
                     std::cout << summary.error_log;
 
                 summary.success = false;
+                summary.num_iters = iter + 1; // The failed iteration is charged
                 return summary;
             }
 
@@ -976,6 +1270,7 @@ namespace ct_icp {
 
 
             if ((x_bundle.norm() < options.threshold_orientation_norm)) {
+                iter++; // The converged iteration counts in the iterations performed
                 break;
             }
         }
@@ -990,37 +1285,65 @@ namespace ct_icp {
             std::cout << "Number iterations CT-ICP : " << options.num_iters_icp << std::endl;
         }
         summary.success = true;
+        summary.num_iters = iter;
         summary.num_residuals_used = number_keypoints_used;
 
         return summary;
     }
 
-#define SELECT_SOLVER \
-        switch (options_.solver) {                          \
-            case CERES:                                     \
-                return DoRegisterCeres(voxel_map,           \
-                        raw_points,                         \
-                        world_points,                       \
-                        timestamps,                         \
-                        trajectory_frame,                   \
-                        motion_model,                       \
-                        strategy);                          \
-            case GN:                                        \
-                return DoRegisterGaussNewton(voxel_map,     \
-                        raw_points,                         \
-                        world_points,                       \
-                        timestamps,                         \
-                        trajectory_frame,                   \
-                        motion_model, strategy);            \
-            case ROBUST:                                    \
-                return DoRegisterRobust(voxel_map,          \
-                            raw_points,                     \
-                            world_points,                   \
-                            timestamps,                     \
-                            trajectory_frame,               \
-                            motion_model, strategy);        \
-            default: throw std::runtime_error("Unsupported Solver Type" );      \
-                    }
+    /* -------------------------------------------------------------------------------------------------------------- */
+    ICPSummary CT_ICP_Registration::RegisterWithSolver(const ct_icp::ISlamMap &voxel_map,
+                                                       slam::ProxyView<Eigen::Vector3d> &raw_points,
+                                                       slam::ProxyView<Eigen::Vector3d> &world_points,
+                                                       slam::ProxyView<double> &timestamps,
+                                                       TrajectoryFrame &trajectory_frame,
+                                                       const AMotionModel *motion_model,
+                                                       ANeighborhoodStrategy *strategy) {
+        int num_coarse_iters = 0;
+        CT_ICP_Registration *registration = this;
+        CT_ICP_Registration fine_registration;
+        if (!options_.coarse_to_fine_levels.empty()) {
+            num_coarse_iters = RegisterCoarseToFine(voxel_map, raw_points, world_points, timestamps,
+                                                    trajectory_frame, motion_model);
+            if (IsCancelled())
+                return CancelledSummary();
+
+            // The coarse iterations replace fine ones (with a local copy of the options)
+            fine_registration.options_ = options_;
+            fine_registration.options_.coarse_to_fine_levels.clear();
+            fine_registration.options_.num_iters_icp = std::max(options_.num_iters_icp - num_coarse_iters, 1);
+            fine_registration.cancel_flag_ = cancel_flag_;
+            registration = &fine_registration;
+        }
+
+        ICPSummary summary;
+        switch (options_.solver) {
+            case CERES:
+                summary = registration->DoRegisterCeres(voxel_map, raw_points, world_points, timestamps,
+                                                        trajectory_frame, motion_model, strategy);
+                break;
+            case GN:
+                summary = registration->DoRegisterGaussNewton(voxel_map, raw_points, world_points, timestamps,
+                                                              trajectory_frame, motion_model, strategy);
+                break;
+            case ROBUST:
+                summary = registration->DoRegisterRobust(voxel_map, raw_points, world_points, timestamps,
+                                                         trajectory_frame, motion_model, strategy);
+                break;
+            default:
+                throw std::runtime_error("Unsupported Solver Type");
+        }
+        summary.num_coarse_iters = num_coarse_iters;
+        return summary;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    ICPSummary CT_ICP_Registration::CancelledSummary() const {
+        ICPSummary summary;
+        summary.success = false;
+        summary.error_log = "[CT_ICP] The registration was cancelled";
+        return summary;
+    }
 
     /* -------------------------------------------------------------------------------------------------------------- */
     ICPSummary CT_ICP_Registration::Register(const ct_icp::ISlamMap &voxel_map, std::vector<slam::WPoint3D> &keypoints,
@@ -1033,7 +1356,8 @@ namespace ct_icp {
         auto raw_points = buffer_collection.element_proxy<Eigen::Vector3d>("raw_point");
         auto world_points = buffer_collection.element_proxy<Eigen::Vector3d>("world_point");
         auto timestamps = buffer_collection.property_proxy<double>("properties", "t");
-        SELECT_SOLVER
+        return RegisterWithSolver(voxel_map, raw_points, world_points, timestamps, trajectory_frame,
+                                  motion_model, strategy);
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
@@ -1049,7 +1373,79 @@ namespace ct_icp {
         auto raw_points = keypoints.RawPointsProxy<Eigen::Vector3d>();
         auto world_points = keypoints.WorldPointsProxy<Eigen::Vector3d>();
         auto timestamps = keypoints.TimestampsProxy<double>();
-        SELECT_SOLVER
+        return RegisterWithSolver(voxel_map, raw_points, world_points, timestamps, trajectory_frame,
+                                  motion_model, strategy);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    int CT_ICP_Registration::RegisterCoarseToFine(const ct_icp::ISlamMap &voxel_map,
+                                                  slam::ProxyView<Eigen::Vector3d> &raw_kpts,
+                                                  slam::ProxyView<Eigen::Vector3d> &world_kpts,
+                                                  slam::ProxyView<double> &timestamps,
+                                                  TrajectoryFrame &trajectory_frame,
+                                                  const AMotionModel *motion_model) {
+        const auto num_keypoints = raw_kpts.size();
+        if (num_keypoints == 0)
+            return 0;
+
+        // Each level is registered by a nested registration, with the options of the level
+        CT_ICP_Registration level_registration;
+        level_registration.options_ = options_;
+        level_registration.options_.coarse_to_fine_levels.clear();
+        level_registration.options_.debug_print = false;
+        level_registration.cancel_flag_ = cancel_flag_;
+
+        int num_iters = 0;
+        std::vector<slam::WPoint3D> level_keypoints;
+        for (auto level_idx(0); level_idx < options_.coarse_to_fine_levels.size(); ++level_idx) {
+            if (IsCancelled())
+                break;
+            const auto &level = options_.coarse_to_fine_levels[level_idx];
+            SLAM_CHECK_STREAM(level.keypoints_ratio > 0. && level.search_radius > 0.,
+                              "Invalid coarse-to-fine level " << level_idx);
+            if (level.num_iters <= 0)
+                continue;
+
+            // Select a uniform subset of the keypoints (the keypoints are spread in the frame by the sampling)
+            const auto num_level_keypoints = std::min(num_keypoints, std::max<size_t>(
+                    1, size_t(std::ceil(double(num_keypoints) * std::min(level.keypoints_ratio, 1.)))));
+            const double stride = double(num_keypoints) / double(num_level_keypoints);
+            level_keypoints.resize(num_level_keypoints);
+            for (auto idx(0); idx < num_level_keypoints; ++idx) {
+                const auto kpt_idx = std::min(num_keypoints - 1, size_t(double(idx) * stride));
+                auto &keypoint = level_keypoints[idx];
+                keypoint.raw_point.point = raw_kpts[kpt_idx];
+                keypoint.raw_point.timestamp = timestamps[kpt_idx];
+                keypoint.world_point = world_kpts[kpt_idx];
+            }
+
+            FixedRadiusStrategy::Options strategy_options;
+            strategy_options.radius = level.search_radius;
+            strategy_options.max_num_neighbors = options_.max_number_neighbors;
+            strategy_options.min_num_neighbors = options_.min_number_neighbors;
+            FixedRadiusStrategy strategy(strategy_options);
+
+            level_registration.options_.num_iters_icp = level.num_iters;
+            level_registration.options_.min_num_residuals = std::min(options_.min_num_residuals,
+                                                                     int(num_level_keypoints));
+            auto level_frame = trajectory_frame;
+            auto summary = level_registration.Register(voxel_map, level_keypoints, level_frame,
+                                                       motion_model, &strategy);
+            // The level is charged the iterations it actually performed (the solvers stop once converged)
+            num_iters += summary.num_iters;
+            if (!summary.success) {
+                // A failure at a coarse level leaves the initial estimate untouched for the next levels
+                if (options_.debug_print)
+                    std::cout << "[CT_ICP] Coarse-to-fine level " << level_idx
+                              << " failed: " << summary.error_log << std::endl;
+                continue;
+            }
+            trajectory_frame = level_frame;
+        }
+
+        // Update the world points of all the keypoints for the finest registration
+        TransformKeyPoints(trajectory_frame, raw_kpts, world_kpts, timestamps);
+        return num_iters;
     }
 
     struct OptimizationTracker {
@@ -1211,11 +1607,20 @@ namespace ct_icp {
 
         std::vector<slam::Neighborhood> neighborhoods(kNumPoints);
         int number_of_residuals = -1;
+
+        // Volumic neighborhoods use Generalized-ICP residuals with the distributions cached by the map
+        const bool kUseDistributions = options.distance == DISTRIBUTION_TO_DISTRIBUTION;
+        std::vector<std::optional<Eigen::Matrix3d>> keypoints_covariances;
+        if (kUseDistributions)
+            keypoints_covariances = compute_keypoints_covariances(raw_kpts, options.gicp_source_radius,
+                                                                  options.gicp_epsilon);
         auto end_init = now();
         duration_init = duration_ms(end_init, begin);
 
         int iter(0);
         for (; iter < options.num_iters_icp; iter++) {
+            if (IsCancelled())
+                return CancelledSummary();
             auto begin_iter = now();
             TransformKeyPoints(frame_to_optimize, raw_kpts, world_kpts, timestamps);
             builder.InitProblem(kNumPoints);
@@ -1258,6 +1663,27 @@ namespace ct_icp {
                 double distance = std::numeric_limits<double>::max();
                 Eigen::Vector3d point = options.use_barycenter ?
                                         neighborhood.description.barycenter : neighborhood.points.front();
+                double alpha_timestamp = frame_to_optimize.begin_pose.GetAlphaTimestamp(timestamp,
+                                                                                        frame_to_optimize.end_pose);
+
+                VoxelDistribution distribution;
+                if (kUseDistributions && neighborhood.neighborhood == slam::VOLUMIC &&
+                    map.FindDistribution(world_point, distribution)) {
+                    distance = (distribution.mean - world_point).norm();
+                    output_builder.SetNeighborhoodData(k, neighborhood);
+                    output_builder.SetWeight(k, weight, distance);
+                    if (distance < options.outlier_distance) {
+                        auto rotation = frame_to_optimize.begin_pose.InterpolatePose(frame_to_optimize.end_pose,
+                                                                                     timestamp).pose.quat;
+                        builder.SetDistributionResidualBlock(k, k, distribution.mean,
+                                                             gicp_information_sqrt(distribution,
+                                                                                   keypoints_covariances[k],
+                                                                                   rotation),
+                                                             weight, alpha_timestamp);
+                    }
+                    continue;
+                }
+
                 ICP_DISTANCE _distance = POINT_TO_DISTRIBUTION;
                 switch (neighborhood.neighborhood) {
                     case slam::LINEAR:
@@ -1279,9 +1705,7 @@ namespace ct_icp {
 
                 if (distance < options.outlier_distance) {
                     builder.SetResidualBlock(k, k, point, neighborhood.description, weight,
-                                             frame_to_optimize.begin_pose.GetAlphaTimestamp(timestamp,
-                                                                                            frame_to_optimize.end_pose),
-                                             _distance);
+                                             alpha_timestamp, _distance);
                 }
             }
             auto end_neighborhood = now();
@@ -1296,6 +1720,7 @@ namespace ct_icp {
                 ss_out << "[CT_ICP] number_of_residuals : " << number_of_residuals << std::endl;
                 ICPSummary summary;
                 summary.success = false;
+                summary.num_iters = iter + 1; // The failed iteration is charged
                 summary.num_residuals_used = number_of_residuals;
                 summary.error_log = ss_out.str();
                 if (options.debug_print) {
@@ -1333,6 +1758,7 @@ namespace ct_icp {
                 if (options.debug_print)
                     std::cout << "CT_ICP: Finished with N=" << iter << " ICP iterations" << std::endl;
 
+                iter++; // The converged iteration counts in the iterations performed
                 break;
             } else if (options.debug_print) {
                 std::cout << "[CT-ICP]: Rotation diff: " << diff_rot << "(deg)" << std::endl;
@@ -1352,7 +1778,9 @@ namespace ct_icp {
         TransformKeyPoints(frame_to_optimize, raw_kpts, world_kpts, timestamps);
         ICPSummary summary;
         summary.success = true;
+        summary.num_iters = iter;
         summary.num_residuals_used = number_of_residuals;
+        summary.num_distribution_residuals = builder.NumDistributionResiduals();
 
         output_builder.AddToSummary(summary);
 
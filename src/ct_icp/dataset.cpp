@@ -2,10 +2,13 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <regex>
 
 #include <SlamCore/config_utils.h>
+#include <SlamCore/memory_mapped_file.h>
 #include <ct_icp/dataset.h>
+#include <ct_icp/dataset_cache.h>
 #include <ct_icp/io.h>
 #include <ct_icp/utils.h>
 
@@ -296,6 +299,29 @@ namespace ct_icp {
         return frame;
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<ADatasetSequence::Frame> ADatasetSequence::GetFrames(size_t begin, size_t end) const {
+        std::vector<Frame> frames;
+        frames.reserve(end > begin ? end - begin : 0);
+        for (auto index(begin); index < end; ++index)
+            frames.push_back(GetFrame(index));
+        return frames;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<ADatasetSequence::Frame> ADatasetSequence::NextFrames(size_t num_frames) {
+        if (!WithRandomAccess()) {
+            std::vector<Frame> frames;
+            while (frames.size() < num_frames && HasNext())
+                frames.push_back(NextFrame());
+            return frames;
+        }
+        const size_t begin = current_frame_id_;
+        while (current_frame_id_ - begin < num_frames && HasNext())
+            current_frame_id_++;
+        return GetFrames(begin, current_frame_id_);
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
     void ADatasetSequence::SkipFrame() {
         CHECK(HasNext()) << "Cannot skip frame. No more frames in the iterator" << std::endl;
@@ -446,7 +472,10 @@ namespace ct_icp {
 
         Frame DoNext(bool jump_frame = false) {
             auto pc_ptr = slam::PointCloud::MakeEmptyPointCloud<LidarPoint, double>({LidarPoint::DefaultSchema()},
-                                                                                    "vertex");
+                                                                                    "vertex",
+                                                                                    slam::BufferPool::DefaultPool());
+            // Consecutive frames have similar sizes: reserve the size of the previous frame
+            pc_ptr->reserve(last_frame_size_);
             pc_ptr->RegisterFieldsFromSchema();
             // Normalize timestamps
             double min_timestamp = std::numeric_limits<double>::infinity(), max_timestamp = std::numeric_limits<double>::lowest();
@@ -474,6 +503,8 @@ namespace ct_icp {
                 std::copy(next_batch.begin(), next_batch.end(), points_view.begin() + old_size);
             }
 
+            if (!jump_frame)
+                last_frame_size_ = pc_ptr->size();
             Frame frame{pc_ptr, {}, {}};
             if (ground_truth_ && frame.pointcloud->size() > 0) {
                 auto timestamps = frame.pointcloud->PropertyView<double>("properties", "timestamp");
@@ -563,6 +594,7 @@ namespace ct_icp {
         }
 
         int num_aggregated_pc_;
+        size_t last_frame_size_ = 0;
 
         std::optional<slam::LinearContinuousTrajectory> ground_truth_{};
         std::unique_ptr<std::ifstream> file = nullptr;
@@ -835,6 +867,107 @@ namespace ct_icp {
                             std::move(filenames));
     }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    KITTIBinDirectory::KITTIBinDirectory(std::string &&root_path, SequenceInfo &&seq_info,
+                                         size_t expected_size, int zero_padding, const Options &options) :
+            AFileSequence(std::move(root_path), std::move(seq_info), expected_size,
+                          [zero_padding](size_t index) { return KITTIBinFilePattern(index, zero_padding); }),
+            options_(options) {}
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    KITTIBinDirectory::KITTIBinDirectory(std::string &&root_path, SequenceInfo &&seq_info,
+                                         std::vector<std::string> &&file_names, const Options &options) :
+            AFileSequence(std::move(root_path), std::move(seq_info), file_names), options_(options) {}
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<KITTIBinDirectory> KITTIBinDirectory::PtrFromDirectoryPath(const std::string &dir_path,
+                                                                               std::optional<SequenceInfo> seq_info,
+                                                                               const Options &options) {
+        auto [path, filenames] = find_filenames(dir_path);
+        filenames.erase(std::remove_if(filenames.begin(), filenames.end(), [](const std::string &filename) {
+            return fs::path(filename).extension() != ".bin";
+        }), filenames.end());
+        return std::make_shared<KITTIBinDirectory>(std::move(path),
+                                                   seq_info ? *seq_info : SequenceInfo{"Unnamed Sequence"},
+                                                   std::move(filenames), options);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr KITTIBinDirectory::ConvertPoints(const float *data, size_t num_points,
+                                                         size_t frame_index, const Options &options) {
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(num_points);
+        pc->AddDefaultTimestampsField();
+        pc->AddDefaultIntensityField();
+        auto xyz = pc->XYZ<double>();
+        auto timestamps = pc->Timestamps<double>();
+        auto intensities = pc->Intensity<float>();
+
+        const double cos_offset = std::cos(options.vertical_angle_offset * M_PI / 180.);
+        const double sin_offset = std::sin(options.vertical_angle_offset * M_PI / 180.);
+        const double direction = options.clockwise ? -1. : 1.;
+        const double begin_timestamp = double(frame_index) * options.frame_duration;
+
+        // The points are converted by blocks: the arithmetic on the block is vectorized, then stored in the views
+        constexpr size_t kBlockSize = 256;
+        alignas(64) double x[kBlockSize], y[kBlockSize], z[kBlockSize], t[kBlockSize];
+        for (size_t block_begin(0); block_begin < num_points; block_begin += kBlockSize) {
+            const size_t block_size = std::min(kBlockSize, num_points - block_begin);
+            const float *block_data = data + 4 * block_begin;
+
+#pragma omp simd
+            for (size_t i = 0; i < block_size; ++i) {
+                const double px = block_data[4 * i], py = block_data[4 * i + 1], pz = block_data[4 * i + 2];
+
+                // The sweep starts and ends at the rear of the vehicle (azimuth of +/- pi)
+                const double azimuth = std::atan2(py, px);
+                const double alpha = 0.5 * (1. + direction * azimuth / M_PI);
+                t[i] = begin_timestamp + std::min(std::max(alpha, 0.), 1.) * options.frame_duration;
+
+                // Rotation of the point by the vertical angle offset, around the horizontal axis p x uz
+                // (closed form of the rotation of `kitti_frame_filter`)
+                const double r_xy = std::max(std::sqrt(px * px + py * py), 1.e-12);
+                const double scale_xy = -sin_offset * pz / r_xy;
+                const bool is_valid = pz > options.min_z;
+                x[i] = is_valid ? px * cos_offset + px * scale_xy : 0.;
+                y[i] = is_valid ? py * cos_offset + py * scale_xy : 0.;
+                z[i] = is_valid ? pz * cos_offset + sin_offset * r_xy : 0.;
+            }
+
+            for (size_t i = 0; i < block_size; ++i) {
+                const size_t idx = block_begin + i;
+                xyz[idx] = Eigen::Vector3d(x[i], y[i], z[i]);
+                timestamps[idx] = t[i];
+                intensities[idx] = block_data[4 * i + 3];
+            }
+        }
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    ADatasetSequence::Frame KITTIBinDirectory::ReadFrame(const std::string &filename) const {
+        const auto stem = fs::path(filename).stem().string();
+        SLAM_CHECK_STREAM(!stem.empty() && std::all_of(stem.begin(), stem.end(), ::isdigit),
+                          "The name of the velodyne file " << filename << " is not the index of its frame");
+        const size_t frame_index = std::stoul(stem);
+
+        slam::MemoryMappedFile file(filename);
+        SLAM_CHECK_STREAM(file.Size() % (4 * sizeof(float)) == 0,
+                          "The size of the velodyne file " << filename << " is not a multiple of 4 float32");
+        const size_t num_points = file.Size() / (4 * sizeof(float));
+
+        Frame new_frame;
+        new_frame.pointcloud = ConvertPoints(reinterpret_cast<const float *>(file.Data()), num_points,
+                                             frame_index, options_);
+        if (num_points > 0) {
+            auto timestamps = new_frame.pointcloud->TimestampsProxy<double>();
+            auto [min, max] = std::minmax_element(timestamps.begin(), timestamps.end());
+            new_frame.timestamp_min = *min;
+            new_frame.timestamp_max = *max;
+        }
+        return new_frame;
+    }
+
     /* -------------------------------------------------------------------------------------------------------------- */
     bool AFileSequence::HasNext() const {
         return current_frame_id_ < full_sequence_size_ &&
@@ -861,12 +994,52 @@ namespace ct_icp {
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
-    ADatasetSequence::Frame AFileSequence::GetUnfilteredFrame(size_t index) const {
+    std::string AFileSequence::FilePath(size_t index) const {
         std::string filepath;
         if (file_pattern_)
             filepath = (root_dir_path_ / (*file_pattern_)(index)).string();
         if (file_names_)
             filepath = (root_dir_path_ / file_names_->at(index)).string();
+        return filepath;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<AFileSequence::FrameCache> AFileSequence::SharedFrameCache() {
+        static std::shared_ptr<FrameCache> shared_cache = std::make_shared<FrameCache>(500);
+        return shared_cache;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<ADatasetSequence::Frame> AFileSequence::GetFrames(size_t begin, size_t end) const {
+        std::vector<Frame> frames(end > begin ? end - begin : 0);
+        std::exception_ptr exception = nullptr;
+        std::mutex mutex;
+#pragma omp parallel for num_threads(num_read_threads_) schedule(dynamic)
+        for (int idx = 0; idx < int(frames.size()); ++idx) {
+            try {
+                frames[idx] = GetFrame(begin + idx);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!exception)
+                    exception = std::current_exception();
+            }
+        }
+        if (exception)
+            std::rethrow_exception(exception);
+        return frames;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    ADatasetSequence::Frame AFileSequence::GetUnfilteredFrame(size_t index) const {
+        std::string filepath = FilePath(index);
+        if (frame_cache_) {
+            auto cached_frame = frame_cache_->get(filepath);
+            if (cached_frame) {
+                // The frame returned can be modified by the filters, so it only shares the (copy-on-write) buffers
+                cached_frame->pointcloud = cached_frame->pointcloud->ShallowCopyPtr();
+                return *cached_frame;
+            }
+        }
 
         Frame frame = ReadFrame(filepath);
         frame.file_path = filepath;
@@ -884,6 +1057,12 @@ namespace ct_icp {
             frame.begin_pose = ground_truth_->InterpolatePose(*min_max.first);
             frame.end_pose = ground_truth_->InterpolatePose(*min_max.second);
         }
+
+        if (frame_cache_) {
+            Frame cached_frame = frame;
+            cached_frame.pointcloud = frame.pointcloud->ShallowCopyPtr();
+            frame_cache_->put(filepath, cached_frame);
+        }
         return frame;
     }
 
@@ -1103,18 +1282,18 @@ namespace ct_icp {
                                                                         const fs::path &sequence_path) {
         std::shared_ptr<ADatasetSequence> dataset_sequence = nullptr;
         std::shared_ptr<NCLTIterator> nclt_ptr = nullptr;
-        std::shared_ptr<PLYDirectory> ply_directory_ptr = nullptr;
+        std::shared_ptr<AFileSequence> file_sequence_ptr = nullptr;
         std::shared_ptr<SyntheticSequence> synthetic_ptr = nullptr;
         SequenceInfo seq_info;
         std::optional<std::vector<Pose>> gt_poses{};
 
-        auto convert_plydir_to_dataset_sequence = [&] {
+        auto convert_file_sequence_to_dataset_sequence = [&] {
             gt_poses = LoadPoses(options, sequence_path, seq_info);
             if (gt_poses.has_value()) {
-                ply_directory_ptr->SetGroundTruth(std::move(*gt_poses));
+                file_sequence_ptr->SetGroundTruth(std::move(*gt_poses));
                 seq_info.with_ground_truth = true;
             }
-            dataset_sequence = std::move(ply_directory_ptr);
+            dataset_sequence = std::move(file_sequence_ptr);
         };
 
         switch (options.dataset) {
@@ -1124,37 +1303,53 @@ namespace ct_icp {
                 seq_info.sequence_id = kKITTINamesToIds.at(seq_dirname);
                 seq_info.sequence_size = KITTI_SEQUENCES_SIZE[seq_info.sequence_id];
                 seq_info.sequence_name = KITTI_SEQUENCE_NAMES[seq_info.sequence_id];
-                ply_directory_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames", SequenceInfo(seq_info),
-                                                                   seq_info.sequence_size,
-                                                                   [](size_t index) {
-                                                                       return DefaultFilePattern(index, 4);
-                                                                   });
-                ply_directory_ptr->SetFilter(kitti_frame_filter);
-                convert_plydir_to_dataset_sequence();
+                if (!fs::exists(sequence_path / "frames") && fs::exists(sequence_path / "velodyne")) {
+                    // Reads the original velodyne files (the correction of `kitti_frame_filter` is applied on read)
+                    file_sequence_ptr = std::make_shared<KITTIBinDirectory>(sequence_path / "velodyne",
+                                                                            SequenceInfo(seq_info),
+                                                                            seq_info.sequence_size, 6);
+                } else {
+                    file_sequence_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames",
+                                                                       SequenceInfo(seq_info),
+                                                                       seq_info.sequence_size,
+                                                                       [](size_t index) {
+                                                                           return DefaultFilePattern(index, 4);
+                                                                       });
+                    file_sequence_ptr->SetFilter(kitti_frame_filter);
+                }
+                convert_file_sequence_to_dataset_sequence();
                 break;
 
             case KITTI_360:
                 seq_info.sequence_id = kKITTI360NamesToIds.at(seq_dirname);
                 seq_info.sequence_size = KITTI_360_SEQUENCES_SIZE[seq_info.sequence_id];
                 seq_info.sequence_name = KITTI_360_SEQUENCE_NAMES[seq_info.sequence_id];
-                ply_directory_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames", SequenceInfo(seq_info),
-                                                                   seq_info.sequence_size,
-                                                                   [](size_t index) {
-                                                                       return DefaultFilePattern(index, 5);
-                                                                   });
-                ply_directory_ptr->SetFilter(kitti_frame_filter);
-                convert_plydir_to_dataset_sequence();
+                if (!fs::exists(sequence_path / "frames") && fs::exists(sequence_path / "velodyne_points" / "data")) {
+                    // Reads the original velodyne files (the correction of `kitti_frame_filter` is applied on read)
+                    file_sequence_ptr = std::make_shared<KITTIBinDirectory>(sequence_path / "velodyne_points" / "data",
+                                                                            SequenceInfo(seq_info),
+                                                                            seq_info.sequence_size, 10);
+                } else {
+                    file_sequence_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames",
+                                                                       SequenceInfo(seq_info),
+                                                                       seq_info.sequence_size,
+                                                                       [](size_t index) {
+                                                                           return DefaultFilePattern(index, 5);
+                                                                       });
+                    file_sequence_ptr->SetFilter(kitti_frame_filter);
+                }
+                convert_file_sequence_to_dataset_sequence();
                 break;
             case KITTI_CARLA:
                 seq_info.sequence_id = kKITTI_CARLANamesToIds.at(seq_dirname);
                 seq_info.sequence_size = 5000;
                 seq_info.sequence_name = KITTI_CARLA_SEQUENCE_NAMES[seq_info.sequence_id];
-                ply_directory_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames", SequenceInfo(seq_info),
+                file_sequence_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames", SequenceInfo(seq_info),
                                                                    seq_info.sequence_size,
                                                                    [](size_t index) {
                                                                        return DefaultFilePattern(index, 4);
                                                                    });
-                convert_plydir_to_dataset_sequence();
+                convert_file_sequence_to_dataset_sequence();
                 break;
             case NCLT:
                 CHECK(kNCLTDirNameToId.find(seq_dirname) != kNCLTDirNameToId.end());
@@ -1175,12 +1370,12 @@ namespace ct_icp {
                 seq_info.sequence_id = kHILTINamesToIds.at(seq_dirname);
                 seq_info.sequence_name = seq_dirname;
                 seq_info.sequence_size = HILTI_SEQUENCES_SIZE[seq_info.sequence_id];
-                ply_directory_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames", SequenceInfo(seq_info),
+                file_sequence_ptr = std::make_shared<PLYDirectory>(sequence_path / "frames", SequenceInfo(seq_info),
                                                                    seq_info.sequence_size,
                                                                    [](size_t index) {
                                                                        return DefaultFilePattern(index, 5);
                                                                    });
-                convert_plydir_to_dataset_sequence();
+                convert_file_sequence_to_dataset_sequence();
                 break;
             case SYNTHETIC:
                 if (fs::exists(sequence_path) && fs::is_regular_file(sequence_path)
@@ -1205,8 +1400,24 @@ namespace ct_icp {
                 break;
         }
         seq_info.label = ct_icp::DATASETEnumToString(options.dataset) + "_" + seq_info.sequence_name;
-        dataset_sequence->GetSequenceInfo() = seq_info;
         CHECK(dataset_sequence) << "Could not build the dataset for sequence " << seq_dirname << std::endl;
+
+        if (!options.cache_directory.empty()) {
+            // Replace the sequence by its cached version, keeping its filter
+            auto cache_path = dataset_cache::CacheFilePath(options.cache_directory, seq_info);
+            if (fs::exists(cache_path)) {
+                auto cached_sequence = CachedSequence::PtrFromFile(cache_path, seq_info);
+                seq_info.sequence_size = cached_sequence->GetSequenceInfo().sequence_size;
+                seq_info.with_ground_truth = cached_sequence->HasGroundTruth();
+                auto filter = dataset_sequence->GetFilter();
+                if (filter)
+                    cached_sequence->SetFilter(std::move(*filter));
+                dataset_sequence = std::move(cached_sequence);
+            } else
+                LOG(INFO) << "No dataset cache found for sequence " << seq_info.sequence_name
+                          << " (expected at " << cache_path << ")" << std::endl;
+        }
+        dataset_sequence->GetSequenceInfo() = seq_info;
         return {dataset_sequence};
     }
 
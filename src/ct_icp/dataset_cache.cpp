@@ -0,0 +1,339 @@
+#include <cmath>
+#include <cstring>
+
+#include "ct_icp/dataset_cache.h"
+
+namespace ct_icp {
+
+    namespace {
+
+        using namespace dataset_cache;
+
+        constexpr size_t kAlignment = 8;
+
+        inline size_t AlignedSize(size_t num_bytes) {
+            return ((num_bytes + kAlignment - 1) / kAlignment) * kAlignment;
+        }
+
+        // Appends `num_bytes` bytes to the chunk, padded to the alignment, and returns a pointer to the new bytes
+        inline char *GrowChunk(std::vector<char> &chunk, size_t num_bytes) {
+            const auto offset = chunk.size();
+            chunk.resize(offset + AlignedSize(num_bytes), 0);
+            return chunk.data() + offset;
+        }
+
+        template<typename IntT>
+        void QuantizeColumn(const std::vector<std::int64_t> &values, char *dest) {
+            auto *dest_ptr = reinterpret_cast<IntT *>(dest);
+            for (auto i(0); i < values.size(); ++i)
+                dest_ptr[i] = static_cast<IntT>(values[i]);
+        }
+
+        // Dequantizes a column of integers into a contiguous array of values
+        // The loop is branch free over contiguous data, so that the compiler can vectorize it
+        template<typename IntT>
+        void DequantizeColumn(const char *src, size_t num_points, double origin, double resolution, double *dest) {
+            const auto *src_ptr = reinterpret_cast<const IntT *>(src);
+            for (size_t i(0); i < num_points; ++i)
+                dest[i] = origin + resolution * static_cast<double>(src_ptr[i]);
+        }
+
+        /* ---------------------------------------------------------------------------------------------------------- */
+        bool IsValidCacheFile(const slam::MemoryMappedFile &file, Footer &footer) {
+            if (file.Size() < sizeof(Header) + sizeof(Footer))
+                return false;
+            Header header;
+            std::memcpy(&header, file.Data(), sizeof(Header));
+            if (std::memcmp(header.magic, kHeaderMagic, 8) != 0 || header.version != kVersion)
+                return false;
+            std::memcpy(&footer, file.At(file.Size() - sizeof(Footer)), sizeof(Footer));
+            if (std::memcmp(footer.magic, kFooterMagic, 8) != 0)
+                return false;
+            return footer.offsets_offset + footer.num_frames * sizeof(std::uint64_t) <= file.Size() - sizeof(Footer) &&
+                   footer.poses_offset + footer.num_poses * sizeof(slam::binary_trajectory::PoseRecord) <=
+                   file.Size() - sizeof(Footer);
+        }
+
+    } // namespace
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::string dataset_cache::CacheFilePath(const std::string &cache_dir, const SequenceInfo &seq_info) {
+        const auto &name = seq_info.label.empty() ? seq_info.sequence_name : seq_info.label;
+        return (fs::path(cache_dir) / (name + kFileExtension)).string();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    DatasetCacheWriter::DatasetCacheWriter(const std::string &file_path, const Options &options) :
+            file_path_(file_path), options_(options) {
+        SLAM_CHECK_STREAM(options.xyz_resolution > 0. && options.timestamp_resolution > 0.,
+                          "The resolutions of the dataset cache must be strictly positive");
+        file_.open(file_path, std::ios::binary | std::ios::out | std::ios::trunc);
+        SLAM_CHECK_STREAM(file_.is_open(), "Could not open the file " << file_path);
+        Header header;
+        std::memcpy(header.magic, kHeaderMagic, 8);
+        file_.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    DatasetCacheWriter::~DatasetCacheWriter() {
+        if (file_.is_open())
+            Close();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void DatasetCacheWriter::AddFrame(const slam::PointCloud &pointcloud) {
+        SLAM_CHECK_STREAM(file_.is_open(), "The file " << file_path_ << " is closed");
+        const auto num_points = pointcloud.size();
+
+        FrameHeader frame_header;
+        frame_header.num_points = num_points;
+        frame_header.xyz_resolution = options_.xyz_resolution;
+        frame_header.timestamp_resolution = options_.timestamp_resolution;
+
+        // Compute the quantized coordinates, column by column
+        std::vector<std::int64_t> columns[3];
+        {
+            std::vector<Eigen::Vector3d> points(num_points);
+            auto xyz = pointcloud.XYZConst<double>();
+            std::copy(xyz.cbegin(), xyz.cend(), points.begin());
+            Eigen::Vector3d min_xyz = Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+            Eigen::Vector3d max_xyz = Eigen::Vector3d::Constant(std::numeric_limits<double>::lowest());
+            for (auto &point: points) {
+                SLAM_CHECK_STREAM(point.allFinite(), "Cannot cache a point cloud with non finite coordinates");
+                min_xyz = min_xyz.cwiseMin(point);
+                max_xyz = max_xyz.cwiseMax(point);
+            }
+            for (int dim(0); dim < 3; ++dim) {
+                auto &column = columns[dim];
+                column.resize(num_points);
+                const double origin = num_points == 0 ? 0. :
+                                      std::round(0.5 * (min_xyz[dim] + max_xyz[dim]) / options_.xyz_resolution) *
+                                      options_.xyz_resolution;
+                std::int64_t max_abs_value = 0;
+                for (auto i(0); i < num_points; ++i) {
+                    column[i] = std::llround((points[i][dim] - origin) / options_.xyz_resolution);
+                    max_abs_value = std::max(max_abs_value, std::abs(column[i]));
+                }
+                SLAM_CHECK_STREAM(max_abs_value <= std::numeric_limits<std::int32_t>::max(),
+                                  "The extent of the point cloud is too large for the resolution "
+                                          << options_.xyz_resolution);
+                frame_header.xyz_origin[dim] = origin;
+                frame_header.xyz_width[dim] = max_abs_value <= std::numeric_limits<std::int16_t>::max() ? 2 : 4;
+            }
+        }
+
+        // Compute the timestamps deltas
+        std::vector<std::int32_t> deltas;
+        std::vector<double> raw_timestamps;
+        if (pointcloud.HasTimestamps() && num_points > 0) {
+            auto timestamps = pointcloud.TimestampsProxy<double>();
+            raw_timestamps.resize(num_points);
+            std::copy(timestamps.begin(), timestamps.end(), raw_timestamps.begin());
+            auto [min_it, max_it] = std::minmax_element(raw_timestamps.begin(), raw_timestamps.end());
+            frame_header.timestamp_min = *min_it;
+            frame_header.timestamp_max = *max_it;
+            frame_header.timestamp_origin = raw_timestamps.front();
+
+            frame_header.timestamp_encoding = DELTA_INT32;
+            deltas.resize(num_points);
+            std::int64_t previous = 0;
+            for (auto i(0); i < num_points; ++i) {
+                const double ticks = std::round((raw_timestamps[i] - frame_header.timestamp_origin) /
+                                                options_.timestamp_resolution);
+                const double delta = ticks - double(previous);
+                if (!std::isfinite(ticks) || std::abs(delta) > double(std::numeric_limits<std::int32_t>::max())) {
+                    frame_header.timestamp_encoding = RAW_FLOAT64;
+                    deltas.clear();
+                    break;
+                }
+                deltas[i] = static_cast<std::int32_t>(delta);
+                previous += deltas[i];
+            }
+        }
+
+        // Encode the chunk
+        chunk_.clear();
+        std::memcpy(GrowChunk(chunk_, sizeof(FrameHeader)), &frame_header, sizeof(FrameHeader));
+        for (int dim(0); dim < 3; ++dim) {
+            char *dest = GrowChunk(chunk_, num_points * frame_header.xyz_width[dim]);
+            if (frame_header.xyz_width[dim] == 2)
+                QuantizeColumn<std::int16_t>(columns[dim], dest);
+            else
+                QuantizeColumn<std::int32_t>(columns[dim], dest);
+        }
+        if (frame_header.timestamp_encoding == DELTA_INT32)
+            std::memcpy(GrowChunk(chunk_, num_points * sizeof(std::int32_t)), deltas.data(),
+                        num_points * sizeof(std::int32_t));
+        if (frame_header.timestamp_encoding == RAW_FLOAT64)
+            std::memcpy(GrowChunk(chunk_, num_points * sizeof(double)), raw_timestamps.data(),
+                        num_points * sizeof(double));
+
+        frame_offsets_.push_back(std::uint64_t(file_.tellp()));
+        file_.write(chunk_.data(), std::streamsize(chunk_.size()));
+        SLAM_CHECK_STREAM(file_.good(), "Failed to write a frame to the file " << file_path_);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void DatasetCacheWriter::SetGroundTruth(const std::vector<slam::Pose> &poses) {
+        ground_truth_ = poses;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void DatasetCacheWriter::Close() {
+        if (!file_.is_open())
+            return;
+        Footer footer;
+        std::memcpy(footer.magic, kFooterMagic, 8);
+        footer.num_frames = frame_offsets_.size();
+        footer.num_poses = ground_truth_.size();
+        footer.poses_offset = std::uint64_t(file_.tellp());
+        for (auto &pose: ground_truth_) {
+            auto record = slam::binary_trajectory::PoseRecord::FromPose(pose);
+            file_.write(reinterpret_cast<const char *>(&record), sizeof(record));
+        }
+        footer.offsets_offset = std::uint64_t(file_.tellp());
+        file_.write(reinterpret_cast<const char *>(frame_offsets_.data()),
+                    std::streamsize(frame_offsets_.size() * sizeof(std::uint64_t)));
+        file_.write(reinterpret_cast<const char *>(&footer), sizeof(Footer));
+        SLAM_CHECK_STREAM(file_.good(), "Failed to write the footer of the file " << file_path_);
+        file_.close();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void WriteDatasetCache(ADatasetSequence &sequence, const std::string &file_path,
+                           const DatasetCacheWriter::Options &options) {
+        DatasetCacheWriter writer(file_path, options);
+        auto filter = sequence.GetFilter();
+        sequence.ClearFilter();
+        sequence.SetInitFrame(0);
+        while (sequence.HasNext()) {
+            auto frame = sequence.NextFrame();
+            writer.AddFrame(*frame.pointcloud);
+        }
+        if (filter)
+            sequence.SetFilter(std::move(*filter));
+        auto ground_truth = sequence.GroundTruth();
+        if (ground_truth)
+            writer.SetGroundTruth(*ground_truth);
+        writer.Close();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    CachedSequence::CachedSequence(const std::string &file_path, SequenceInfo &&seq_info) :
+            ADatasetSequence(std::move(seq_info)) {
+        file_ = std::make_shared<slam::MemoryMappedFile>(file_path);
+        SLAM_CHECK_STREAM(IsValidCacheFile(*file_, footer_), "The file " << file_path
+                                                                         << " is not a valid dataset cache");
+        frame_offsets_ = reinterpret_cast<const std::uint64_t *>(file_->At(footer_.offsets_offset));
+        seq_info_.sequence_size = int(footer_.num_frames);
+
+        if (footer_.num_poses > 0) {
+            std::vector<slam::Pose> poses(footer_.num_poses);
+            const auto *records = reinterpret_cast<const slam::binary_trajectory::PoseRecord *>(
+                    file_->At(footer_.poses_offset));
+            for (auto i(0); i < poses.size(); ++i)
+                poses[i] = records[i].ToPose();
+            ground_truth_.emplace(slam::LinearContinuousTrajectory::Create(std::move(poses)));
+            seq_info_.with_ground_truth = true;
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<CachedSequence> CachedSequence::PtrFromFile(const std::string &file_path,
+                                                                std::optional<SequenceInfo> seq_info) {
+        SequenceInfo info = seq_info ? *seq_info : SequenceInfo{fs::path(file_path).stem().string()};
+        return std::make_shared<CachedSequence>(file_path, std::move(info));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool CachedSequence::HasNext() const {
+        return current_frame_id_ < footer_.num_frames &&
+               (max_num_frames_ < 0 || current_frame_id_ - init_frame_id_ < max_num_frames_);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    ADatasetSequence::Frame CachedSequence::NextUnfilteredFrame() {
+        return GetUnfilteredFrame(current_frame_id_++);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t CachedSequence::NumFrames() const {
+        auto max_possible_num_frames = std::max(static_cast<int>(footer_.num_frames) - init_frame_id_, 0);
+        return max_num_frames_ < 0 ? max_possible_num_frames : std::min(max_possible_num_frames, max_num_frames_);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    ADatasetSequence::Frame CachedSequence::GetUnfilteredFrame(size_t index) const {
+        SLAM_CHECK_STREAM(index < footer_.num_frames, "The frame index " << index << " is out of range");
+        const size_t chunk_offset = frame_offsets_[index];
+        FrameHeader frame_header;
+        std::memcpy(&frame_header, file_->At(chunk_offset), sizeof(FrameHeader));
+        const size_t num_points = frame_header.num_points;
+
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(num_points);
+
+        size_t offset = chunk_offset + AlignedSize(sizeof(FrameHeader));
+        if (num_points > 0) {
+            auto xyz = pc->ElementView<Eigen::Vector3d>("vertex");
+            double *xyz_ptr = xyz[0].data();
+            std::vector<double> values(num_points);
+            for (int dim(0); dim < 3; ++dim) {
+                const auto width = frame_header.xyz_width[dim];
+                const char *column = file_->At(offset);
+                if (width == 2)
+                    DequantizeColumn<std::int16_t>(column, num_points, frame_header.xyz_origin[dim],
+                                                   frame_header.xyz_resolution, values.data());
+                else
+                    DequantizeColumn<std::int32_t>(column, num_points, frame_header.xyz_origin[dim],
+                                                   frame_header.xyz_resolution, values.data());
+                // Scatter the column into the coordinates of the points
+                for (size_t i(0); i < num_points; ++i)
+                    xyz_ptr[3 * i + dim] = values[i];
+                offset += AlignedSize(num_points * width);
+            }
+        }
+
+        if (frame_header.timestamp_encoding != NO_TIMESTAMPS) {
+            pc->AddDefaultTimestampsField();
+            auto timestamps = pc->Timestamps<double>();
+            double *timestamps_ptr = &timestamps[0];
+            if (frame_header.timestamp_encoding == DELTA_INT32) {
+                const auto *deltas = reinterpret_cast<const std::int32_t *>(file_->At(offset));
+                std::int64_t ticks = 0;
+                for (size_t i(0); i < num_points; ++i) {
+                    ticks += deltas[i];
+                    timestamps_ptr[i] = frame_header.timestamp_origin +
+                                        frame_header.timestamp_resolution * static_cast<double>(ticks);
+                }
+            } else {
+                std::memcpy(timestamps_ptr, file_->At(offset), num_points * sizeof(double));
+            }
+        }
+
+        Frame frame;
+        frame.pointcloud = pc;
+        frame.file_path = file_->FilePath();
+        frame.timestamp_min = frame_header.timestamp_min;
+        frame.timestamp_max = frame_header.timestamp_max;
+        if (ground_truth_ && frame_header.timestamp_encoding != NO_TIMESTAMPS) {
+            frame.begin_pose = ground_truth_->InterpolatePose(frame.timestamp_min);
+            frame.end_pose = ground_truth_->InterpolatePose(frame.timestamp_max);
+        }
+        return frame;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::optional<std::vector<slam::Pose>> CachedSequence::GroundTruth() {
+        if (ground_truth_)
+            return ground_truth_->Poses();
+        return {};
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void CachedSequence::SetInitFrame(int frame_index) {
+        init_frame_id_ = frame_index;
+        current_frame_id_ = frame_index;
+    }
+
+} // namespace ct_icp
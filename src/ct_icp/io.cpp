@@ -2,6 +2,8 @@
 #include <iomanip>
 #include <iostream>
 
+#include <SlamCore/binary_trajectory.h>
+
 #include "ct_icp/io.h"
 #include "ct_icp/utils.h"
 
@@ -93,5 +95,48 @@ namespace ct_icp {
         return frames;
     }
 
+    namespace {
+        std::vector<Pose> frames_to_poses(const std::vector<TrajectoryFrame> &trajectory) {
+            std::vector<Pose> poses;
+            poses.reserve(2 * trajectory.size());
+            for (auto &frame: trajectory) {
+                poses.push_back(frame.begin_pose);
+                poses.push_back(frame.end_pose);
+            }
+            return poses;
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void SaveTrajectoryFrameBinary(const std::string &file_path, const std::vector<TrajectoryFrame> &trajectory) {
+        slam::SavePosesBinary(file_path, frames_to_poses(trajectory));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void AppendTrajectoryFrameBinary(const std::string &file_path, const std::vector<TrajectoryFrame> &trajectory) {
+        slam::AppendPosesBinary(file_path, frames_to_poses(trajectory));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<TrajectoryFrame> LoadTrajectoryBinary(const std::string &file_path) {
+        slam::BinaryTrajectoryReader reader(file_path);
+        SLAM_CHECK_STREAM(reader.NumPoses() % 2 == 0,
+                          "The file " << file_path << " does not contain pairs of begin and end poses");
+        std::vector<TrajectoryFrame> frames(reader.NumPoses() / 2);
+        for (auto i(0); i < frames.size(); ++i) {
+            frames[i].begin_pose = reader.PoseAt(2 * i);
+            frames[i].end_pose = reader.PoseAt(2 * i + 1);
+        }
+        return frames;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    TrajectoryFrame LoadTrajectoryFrameBinary(const std::string &file_path, size_t frame_index) {
+        slam::BinaryTrajectoryReader reader(file_path);
+        TrajectoryFrame frame;
+        frame.begin_pose = reader.PoseAt(2 * frame_index);
+        frame.end_pose = reader.PoseAt(2 * frame_index + 1);
+        return frame;
+    }
 
 } // namespace ct_icp
@@ -1,5 +1,12 @@
+#include <numeric>
+#include <fstream>
+#include <mutex>
+#include <cstring>
+#include <chrono>
+
 #include "ct_icp/map.h"
 #include "ct_icp/config.h"
+#include "ct_icp/cost_functions.h"
 #include <SlamCore/config_utils.h>
 
 namespace ct_icp {
@@ -61,6 +68,15 @@ namespace ct_icp {
         }
         FIND_OPTION(node, (*map_options), max_frames_to_keep, int)
         FIND_OPTION(node, (*map_options), default_radius, double)
+        FIND_OPTION(node, (*map_options), max_journal_size, int)
+        FIND_OPTION(node, (*map_options), cache_distributions, bool)
+        FIND_OPTION(node, (*map_options), distribution_epsilon, double)
+        FIND_OPTION(node, (*map_options), hierarchical_insertion, bool)
+        FIND_OPTION(node, (*map_options), compaction_time_budget_ms, double)
+        FIND_OPTION(node, (*map_options), compaction_merge_ratio, double)
+        FIND_OPTION(node, (*map_options), compaction_planarity_threshold, double)
+        FIND_OPTION(node, (*map_options), compaction_num_planar_points, int)
+        FIND_OPTION(node, (*map_options), compaction_max_unobserved_frames, int)
         return map_options;
     }
 
@@ -70,6 +86,22 @@ namespace ct_icp {
             std::string map_type = node["map_type"].as<std::string>();
             if (map_type == MultipleResolutionVoxelMap::Options::Type())
                 return multi_resolution_map_options_from_yaml(node);
+            if (map_type == FrozenVoxelMap::Options::Type()) {
+                auto map_options = std::make_shared<FrozenVoxelMap::Options>();
+                FIND_OPTION(node, (*map_options), map_path, std::string)
+                FIND_OPTION(node, (*map_options), share_instances, bool)
+                return map_options;
+            }
+            if (map_type == TiledVoxelMap::Options::Type()) {
+                auto map_options = std::make_shared<TiledVoxelMap::Options>();
+                FIND_OPTION(node, (*map_options), tiles_directory, std::string)
+                FIND_OPTION(node, (*map_options), max_tiles_in_memory, int)
+                FIND_OPTION(node, (*map_options), prefetch_horizon, double)
+                FIND_OPTION(node, (*map_options), prefetch_radius, int)
+                FIND_OPTION(node, (*map_options), pinned_radius, int)
+                FIND_OPTION(node, (*map_options), asynchronous_prefetch, bool)
+                return map_options;
+            }
             throw std::runtime_error("Not implemented error");
         } else {
             return old_map_options_from_yaml(node);
@@ -77,6 +109,1043 @@ namespace ct_icp {
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
+    MapRegion MapRegion::Box(const Eigen::Vector3d &min_corner, const Eigen::Vector3d &max_corner) {
+        MapRegion region;
+        region.box = Eigen::AlignedBox3d(min_corner, max_corner);
+        return region;
+    }
 
-} // namespace ct_icp
+    /* -------------------------------------------------------------------------------------------------------------- */
+    MapRegion MapRegion::Ball(const Eigen::Vector3d &center, double radius) {
+        MapRegion region;
+        region.center = center;
+        region.radius = radius;
+        return region;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    MapRegion MapRegion::FromFrustum(const Frustum &frustum, bool cull_normals) {
+        MapRegion region;
+        region.frustum = frustum;
+        if (cull_normals)
+            region.sensor_location = frustum.sensor_pose.tr;
+        return region;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    MapRegion MapRegion::VisibleFrom(const Eigen::Vector3d &sensor_location) {
+        MapRegion region;
+        region.sensor_location = sensor_location;
+        return region;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool MapRegion::Contains(const Eigen::Vector3d &point) const {
+        if (box && !box->contains(point))
+            return false;
+        if (center && (point - *center).squaredNorm() > radius * radius)
+            return false;
+        if (frustum) {
+            Eigen::Vector3d local = frustum->sensor_pose.quat.conjugate() * (point - frustum->sensor_pose.tr);
+            if (local.squaredNorm() > frustum->max_distance * frustum->max_distance)
+                return false;
+            if (frustum->horizontal_fov < 2 * M_PI &&
+                std::abs(std::atan2(local.y(), local.x())) > 0.5 * frustum->horizontal_fov)
+                return false;
+            if (frustum->vertical_fov < M_PI &&
+                std::abs(std::atan2(local.z(), local.head<2>().norm())) > 0.5 * frustum->vertical_fov)
+                return false;
+        }
+        return true;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool MapRegion::Intersects(const Eigen::AlignedBox3d &_box) const {
+        if (box && !box->intersects(_box))
+            return false;
+        if (center && _box.squaredExteriorDistance(*center) > radius * radius)
+            return false;
+        if (frustum && _box.squaredExteriorDistance(frustum->sensor_pose.tr) >
+                       frustum->max_distance * frustum->max_distance)
+            return false;
+        return true;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::optional<Eigen::AlignedBox3d> MapRegion::BoundingBox() const {
+        Eigen::AlignedBox3d bounding_box(Eigen::Vector3d::Constant(std::numeric_limits<double>::lowest()),
+                                         Eigen::Vector3d::Constant(std::numeric_limits<double>::max()));
+        bool is_bounded = false;
+        if (box) {
+            bounding_box = bounding_box.intersection(*box);
+            is_bounded = true;
+        }
+        if (center && radius < std::numeric_limits<double>::max()) {
+            bounding_box = bounding_box.intersection(Eigen::AlignedBox3d(*center - Eigen::Vector3d::Constant(radius),
+                                                                         *center + Eigen::Vector3d::Constant(radius)));
+            is_bounded = true;
+        }
+        if (frustum) {
+            const Eigen::Vector3d extent = Eigen::Vector3d::Constant(frustum->max_distance);
+            bounding_box = bounding_box.intersection(Eigen::AlignedBox3d(frustum->sensor_pose.tr - extent,
+                                                                         frustum->sensor_pose.tr + extent));
+            is_bounded = true;
+        }
+        if (!is_bounded)
+            return {};
+        return bounding_box;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr ISlamMap::ExtractPoints(const MapRegion &region) const {
+        auto pc = MapAsPointCloud();
+        const slam::PointCloud &const_pc = *pc;
+        auto xyz = const_pc.XYZConst<double>();
+        std::vector<size_t> indices;
+        indices.reserve(xyz.size());
+        if (pc->HasNormals()) {
+            auto normals = const_pc.NormalsProxy<Eigen::Vector3d>();
+            for (auto idx(0); idx < xyz.size(); ++idx) {
+                if (region.Contains(xyz[idx], normals[idx], true))
+                    indices.push_back(idx);
+            }
+        } else {
+            for (auto idx(0); idx < xyz.size(); ++idx) {
+                if (!region.sensor_location && region.Contains(xyz[idx]))
+                    indices.push_back(idx);
+            }
+        }
+        return pc->SelectPoints(indices);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<MapChunk> ISlamMap::ExtractChunks(const MapRegion &region, uint64_t since_version) const {
+        auto version = Version();
+        if (since_version > 0 && version <= since_version)
+            return {};
+        return {MapChunk{slam::Voxel(0, 0, 0), version, ExtractPoints(region)}};
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    Eigen::AlignedBox3d MultipleResolutionVoxelMap::ChunkBox(const slam::Voxel &chunk,
+                                                             double resolution, int chunk_size) const {
+        // The voxel k spans [k, k + 1) * resolution
+        const int k = chunk_size;
+        return {Eigen::Vector3d(chunk.x * k, chunk.y * k, chunk.z * k) * resolution,
+                Eigen::Vector3d(chunk.x * k + k, chunk.y * k + k, chunk.z * k + k) * resolution};
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<std::pair<slam::Voxel, const MultipleResolutionVoxelMap::ChunkInfo *>>
+    MultipleResolutionVoxelMap::SelectChunks(size_t map_idx, const MapRegion &region, uint64_t since_version) const {
+        SLAM_CHECK_STREAM(map_idx < voxel_maps_.size(), "Invalid map index " << map_idx);
+        const double resolution = options_.resolutions[map_idx].resolution;
+        std::vector<std::pair<slam::Voxel, const ChunkInfo *>> chunks;
+        for (auto &[coordinates, chunk]: voxel_maps_[map_idx].chunks) {
+            if (chunk.version > since_version &&
+                region.Intersects(ChunkBox(coordinates, resolution, options_.chunk_size)))
+                chunks.emplace_back(coordinates, &chunk);
+        }
+        return chunks;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<MultipleResolutionVoxelMap::MemoryStats> MultipleResolutionVoxelMap::GetMemoryStats() const {
+        std::vector<MemoryStats> stats(voxel_maps_.size());
+        for (auto map_idx(0); map_idx < voxel_maps_.size(); ++map_idx) {
+            auto &map_stats = stats[map_idx];
+            map_stats.resolution = options_.resolutions[map_idx].resolution;
+            map_stats.num_voxels = voxel_maps_[map_idx].map.size();
+            map_stats.num_points = voxel_maps_[map_idx].num_points;
+            map_stats.pool = voxel_maps_[map_idx].pool->GetStats();
+        }
+        return stats;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr MultipleResolutionVoxelMap::AllocateMapPointCloud(size_t num_points) {
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(num_points);
+        pc->AddDefaultNormalsField();
+        pc->AddDefaultTimestampsField();
+        pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr MultipleResolutionVoxelMap::GetMapPoints(size_t map_idx, const MapRegion &region) const {
+        auto chunks = SelectChunks(map_idx, region, 0);
+
+        // Count the points of each chunk in the region, to allocate the point cloud once
+        std::vector<size_t> offsets(chunks.size() + 1, 0);
+#pragma omp parallel for num_threads(options_.num_threads_export) schedule(dynamic)
+        for (int idx = 0; idx < int(chunks.size()); ++idx) {
+            size_t num_points = 0;
+            ForEachPointInRegion(map_idx, *chunks[idx].second, region, [&num_points](const PointType &) {
+                num_points++;
+            });
+            offsets[idx + 1] = num_points;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        auto pc = AllocateMapPointCloud(offsets.back());
+        auto xyz = pc->XYZ<double>();
+        auto normals = pc->NormalsProxy<Eigen::Vector3d>();
+        auto timestamps = pc->TimestampsProxy<double>();
+#pragma omp parallel for num_threads(options_.num_threads_export) schedule(dynamic)
+        for (int idx = 0; idx < int(chunks.size()); ++idx) {
+            size_t point_idx = offsets[idx];
+            ForEachPointInRegion(map_idx, *chunks[idx].second, region, [&](const PointType &point) {
+                xyz[point_idx] = point.xyz;
+                normals[point_idx] = point.normal;
+                timestamps[point_idx] = point.timestamp;
+                point_idx++;
+            });
+        }
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<MapChunk> MultipleResolutionVoxelMap::GetMapChunks(size_t map_idx, const MapRegion &region,
+                                                                   uint64_t since_version) const {
+        auto chunks = SelectChunks(map_idx, region, since_version);
+        std::vector<MapChunk> map_chunks(chunks.size());
+#pragma omp parallel for num_threads(options_.num_threads_export) schedule(dynamic)
+        for (int idx = 0; idx < int(chunks.size()); ++idx) {
+            auto &[coordinates, chunk] = chunks[idx];
+            size_t num_points = 0;
+            ForEachPointInRegion(map_idx, *chunk, region, [&num_points](const PointType &) { num_points++; });
+
+            auto pc = AllocateMapPointCloud(num_points);
+            auto xyz = pc->XYZ<double>();
+            auto normals = pc->NormalsProxy<Eigen::Vector3d>();
+            auto timestamps = pc->TimestampsProxy<double>();
+            size_t point_idx = 0;
+            ForEachPointInRegion(map_idx, *chunk, region, [&](const PointType &point) {
+                xyz[point_idx] = point.xyz;
+                normals[point_idx] = point.normal;
+                timestamps[point_idx] = point.timestamp;
+                point_idx++;
+            });
+            map_chunks[idx] = MapChunk{coordinates, chunk->version, pc};
+        }
+        return map_chunks;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    MapChangeSet MultipleResolutionVoxelMap::GetChangesSince(uint64_t since_version, size_t map_idx) const {
+        SLAM_CHECK_STREAM(map_idx < voxel_maps_.size(), "Invalid map index " << map_idx);
+        auto &map = voxel_maps_[map_idx];
+        MapChangeSet change_set;
+        change_set.since_version = since_version;
+        change_set.version = version_;
+        change_set.is_complete = options_.max_journal_size > 0 && since_version >= map.journal_min_version;
+
+        auto begin = std::upper_bound(map.journal.begin(), map.journal.end(), since_version,
+                                      [](uint64_t version, const MapPointChange &change) {
+                                          return version < change.version;
+                                      });
+        change_set.changes.assign(begin, map.journal.end());
+        return change_set;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void MultipleResolutionVoxelMap::UpdateDistribution(VoxelBlock &block) const {
+        if (!block.distribution)
+            block.distribution = std::make_unique<VoxelDistribution>();
+        auto &distribution = *block.distribution;
+        distribution.mean = block.description.barycenter;
+        distribution.covariance = RegularizeCovariance(block.description.covariance,
+                                                       options_.distribution_epsilon,
+                                                       &distribution.information_sqrt);
+        distribution.num_points = int(block.num_aggregated > 0 ? block.num_aggregated : block.points.size());
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void MultipleResolutionVoxelMap::CheckOptions(const Options &options) {
+        SLAM_CHECK_STREAM(!options.resolutions.empty(), "The map does not define any resolution");
+        if (options.hierarchical_insertion) {
+            // The coarse voxels must nest the finest voxels, for all the points of a fine voxel to aggregate in the
+            // same coarse voxel (otherwise the moments of a coarse voxel can be split from its representative points)
+            const double finest_resolution = options.resolutions[0].resolution;
+            SLAM_CHECK_STREAM(finest_resolution > 0., "Invalid resolution " << finest_resolution);
+            for (auto idx(1); idx < options.resolutions.size(); ++idx) {
+                const double ratio = options.resolutions[idx].resolution / finest_resolution;
+                SLAM_CHECK_STREAM(options.resolutions[idx - 1].resolution < options.resolutions[idx].resolution,
+                                  "The hierarchical insertion requires increasing resolutions");
+                SLAM_CHECK_STREAM(std::abs(ratio - std::round(ratio)) < 1.e-6 * ratio,
+                                  "The hierarchical insertion requires resolutions multiple of the finest one, got "
+                                          << options.resolutions[idx].resolution << " for " << finest_resolution);
+            }
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void MultipleResolutionVoxelMap::OrientNormals(VoxelBlock &block) {
+        for (auto &point: block.points) {
+            point.normal = block.description.normal;
+            point.is_normal_computed = true;
+            if (frame_id_to_frame.find(point.frame_id) != frame_id_to_frame.end()) {
+                // Orient the normal using the pose of the source frame
+                auto &src_frame = frame_id_to_frame[point.frame_id];
+                auto &begin = src_frame.poses.Poses().front();
+                if ((point.xyz - begin.TrRef()).dot(point.normal) > 0.) {
+                    point.normal = -point.normal;
+                }
+                point.is_normal_oriented = true;
+            } else
+                point.is_normal_oriented = false;
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t MultipleResolutionVoxelMap::CompactVoxel(size_t map_idx, const slam::Voxel &voxel, VoxelBlock &block) {
+        auto &points = block.points;
+        std::vector<char> removed(points.size(), 0);
+
+        // Merge the near-duplicate points (the oldest point is kept, the points of other frames count as observations)
+        const double merge_distance = options_.compaction_merge_ratio *
+                                      options_.resolutions[map_idx].min_distance_between_points;
+        for (auto i(0); i < points.size(); ++i) {
+            if (removed[i])
+                continue;
+            for (auto j(i + 1); j < points.size(); ++j) {
+                if (!removed[j] && (points[i].xyz - points[j].xyz).squaredNorm() < merge_distance * merge_distance) {
+                    points[i].num_observations += points[j].num_observations +
+                                                  (points[j].frame_id != points[i].frame_id ? 1 : 0);
+                    removed[j] = 1;
+                }
+            }
+        }
+
+        // Drop the points never observed again (e.g. the points of dynamic objects)
+        const size_t max_unobserved_frames = options_.compaction_max_unobserved_frames;
+        if (max_unobserved_frames > 0) {
+            for (auto i(0); i < points.size(); ++i) {
+                if (points[i].num_observations == 0 && points[i].frame_id < frame_id_count_ &&
+                    frame_id_count_ - points[i].frame_id > max_unobserved_frames)
+                    removed[i] = 1;
+            }
+        }
+
+        // Downsample the planar voxels to representative points spread by farthest point sampling
+        const size_t num_kept = std::count(removed.begin(), removed.end(), 0);
+        const size_t num_representatives = std::max(options_.compaction_num_planar_points, 1);
+        if (block.is_valid && block.description.planarity > options_.compaction_planarity_threshold &&
+            num_kept > num_representatives) {
+            if (block.num_aggregated == 0) {
+                // The description of the voxel is now maintained from the moments of all its points (but the points
+                // merged or dropped above)
+                for (auto i(0); i < points.size(); ++i) {
+                    if (!removed[i])
+                        AccumulateMoments(block, points[i].xyz);
+                }
+            }
+            std::vector<double> sq_distances(points.size(), std::numeric_limits<double>::max());
+            std::vector<char> selected(points.size(), 0);
+            auto next = std::distance(removed.begin(), std::find(removed.begin(), removed.end(), 0));
+            for (auto k(0); k < num_representatives; ++k) {
+                selected[next] = 1;
+                double max_sq_distance = -1.;
+                for (auto i(0); i < points.size(); ++i) {
+                    if (removed[i] || selected[i])
+                        continue;
+                    sq_distances[i] = std::min(sq_distances[i], (points[i].xyz - points[next].xyz).squaredNorm());
+                    if (sq_distances[i] > max_sq_distance) {
+                        max_sq_distance = sq_distances[i];
+                        next = i;
+                    }
+                }
+            }
+            for (auto i(0); i < points.size(); ++i)
+                removed[i] = removed[i] || !selected[i];
+        }
+
+        const size_t num_removed = std::count(removed.begin(), removed.end(), 1);
+        if (num_removed == 0)
+            return 0;
+        MarkChunkModified(map_idx, voxel);
+        size_t num_points = 0;
+        for (auto i(0); i < points.size(); ++i) {
+            if (removed[i])
+                RecordChange(map_idx, points[i], false);
+            else
+                points[num_points++] = points[i];
+        }
+        points.resize(num_points);
+        if (points.capacity() > 2 * points.size())
+            points.shrink_to_fit(); // The larger block returns to the pool of the voxel map
+        voxel_maps_[map_idx].num_points -= num_removed;
+        return num_removed;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t MultipleResolutionVoxelMap::Compact(double time_budget_ms) {
+        const auto start = std::chrono::steady_clock::now();
+        auto elapsed_ms = [&start] {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+        // The voxels are queued at their creation, so that a call only pays for the voxels it visits
+        size_t num_removed = 0;
+        size_t num_to_visit = compaction_queue_.size();
+        while (num_to_visit > 0 && elapsed_ms() < time_budget_ms) {
+            num_to_visit--;
+            auto entry = compaction_queue_.front();
+            compaction_queue_.pop_front();
+            auto &map = voxel_maps_[entry.map_idx].map;
+            auto it = map.find(entry.voxel);
+            if (it == map.end() || it->second.compaction_id != entry.compaction_id)
+                continue; // The voxel was removed (and possibly recreated with a new entry) since it was queued
+            num_removed += CompactVoxel(entry.map_idx, entry.voxel, it.value());
+            if (IsEmpty(it.value()))
+                RemoveVoxel(entry.map_idx, entry.voxel);
+            else
+                compaction_queue_.push_back(entry);
+        }
+        return num_removed;
+    }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void MultipleResolutionVoxelMap::PurgeCompactionQueue() {
+        // Each voxel of the map has exactly one entry in the queue, the others are the entries of removed voxels
+        size_t num_voxels = 0;
+        for (auto &voxel_map: voxel_maps_)
+            num_voxels += voxel_map.map.size();
+        if (compaction_queue_.size() <= 2 * num_voxels)
+            return;
+        auto is_removed = [this](const CompactionEntry &entry) {
+            auto &map = voxel_maps_[entry.map_idx].map;
+            auto it = map.find(entry.voxel);
+            return it == map.end() || it->second.compaction_id != entry.compaction_id;
+        };
+        compaction_queue_.erase(std::remove_if(compaction_queue_.begin(), compaction_queue_.end(), is_removed),
+                                compaction_queue_.end());
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool MultipleResolutionVoxelMap::FindDistribution(const Eigen::Vector3d &query,
+                                                      VoxelDistribution &distribution) const {
+        if (!options_.cache_distributions)
+            return false;
+        auto params = SearchParamsFromRadiusSearch(options_.default_radius);
+        const auto &map = voxel_maps_[params.map_id].map;
+        slam::Voxel voxel = slam::Voxel::Coordinates(query, params.voxel_resolution);
+
+        // Select the closest mean among the distributions of the voxel of the query and its direct neighbors
+        const VoxelBlock *closest = nullptr;
+        double min_sq_distance = std::numeric_limits<double>::max();
+        for (int dx(-1); dx <= 1; ++dx) {
+            for (int dy(-1); dy <= 1; ++dy) {
+                for (int dz(-1); dz <= 1; ++dz) {
+                    auto it = map.find(slam::Voxel{voxel.x + dx, voxel.y + dy, voxel.z + dz});
+                    if (it == map.end() || !it->second.distribution)
+                        continue;
+                    double sq_distance = (it->second.distribution->mean - query).squaredNorm();
+                    if (sq_distance < min_sq_distance) {
+                        min_sq_distance = sq_distance;
+                        closest = &it->second;
+                    }
+                }
+            }
+        }
+        if (closest == nullptr)
+            return false;
+        distribution = *closest->distribution;
+        return true;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    namespace {
+        const char kFrozenMapMagic[8] = {'C', 'T', 'I', 'C', 'P', 'M', 'A', 'P'};
+
+        // The frozen maps loaded in the process, indexed by file path
+        std::mutex frozen_maps_mutex;
+        std::map<std::string, std::weak_ptr<FrozenVoxelMap>> frozen_maps;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<ISlamMap> FrozenVoxelMap::Options::MakeMapFromOptions() const {
+        SLAM_CHECK_STREAM(!map_path.empty(), "The path to the map of a FrozenVoxelMap is not defined");
+        return FrozenVoxelMap::Load(map_path, share_instances);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<FrozenVoxelMap> FrozenVoxelMap::Load(const std::string &file_path, bool share_instance) {
+        if (!share_instance)
+            return std::make_shared<FrozenVoxelMap>(file_path);
+
+        std::lock_guard<std::mutex> lock(frozen_maps_mutex);
+        auto &instance = frozen_maps[file_path];
+        auto map = instance.lock();
+        if (!map) {
+            map = std::make_shared<FrozenVoxelMap>(file_path);
+            instance = map;
+        }
+        return map;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void FrozenVoxelMap::Write(const slam::PointCloud &pointcloud, const std::string &file_path, double voxel_size) {
+        SLAM_CHECK_STREAM(voxel_size > 0., "Invalid voxel size " << voxel_size);
+        auto xyz = pointcloud.XYZConst<double>();
+
+        // Sort the points by voxel, to store the points of a voxel contiguously
+        std::vector<std::pair<slam::Voxel, size_t>> voxel_points(xyz.size());
+        for (auto idx(0); idx < xyz.size(); ++idx)
+            voxel_points[idx] = {slam::Voxel::Coordinates(xyz[idx], voxel_size), idx};
+        std::sort(voxel_points.begin(), voxel_points.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.first < rhs.first;
+        });
+
+        FileHeader header;
+        std::memcpy(header.magic, kFrozenMapMagic, sizeof(kFrozenMapMagic));
+        header.voxel_size = voxel_size;
+        header.num_points = voxel_points.size();
+        std::vector<double> points(3 * voxel_points.size());
+        std::vector<VoxelEntry> entries;
+        for (auto idx(0); idx < voxel_points.size(); ++idx) {
+            const auto &voxel = voxel_points[idx].first;
+            if (entries.empty() || slam::Voxel(entries.back().x, entries.back().y, entries.back().z) != voxel) {
+                VoxelEntry entry;
+                entry.x = voxel.x;
+                entry.y = voxel.y;
+                entry.z = voxel.z;
+                entry.first_point = idx;
+                entries.push_back(entry);
+            }
+            entries.back().num_points++;
+            Eigen::Vector3d point = xyz[voxel_points[idx].second];
+            std::copy(point.data(), point.data() + 3, points.data() + 3 * idx);
+        }
+        header.num_voxels = entries.size();
+
+        // Open-addressing hash table with linear probing, with a load factor of at most 0.5
+        header.table_capacity = 16;
+        while (header.table_capacity < 2 * entries.size())
+            header.table_capacity *= 2;
+        std::vector<VoxelEntry> table(header.table_capacity);
+        const uint64_t mask = header.table_capacity - 1;
+        for (auto &entry: entries) {
+            auto slot = HashVoxel(entry.x, entry.y, entry.z) & mask;
+            while (table[slot].num_points > 0)
+                slot = (slot + 1) & mask;
+            table[slot] = entry;
+        }
+
+        std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+        SLAM_CHECK_STREAM(file.is_open(), "Could not open the file " << file_path);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+        file.write(reinterpret_cast<const char *>(table.data()), sizeof(VoxelEntry) * table.size());
+        file.write(reinterpret_cast<const char *>(points.data()), sizeof(double) * points.size());
+        SLAM_CHECK_STREAM(file.good(), "Could not write the map in the file " << file_path);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    FrozenVoxelMap::FrozenVoxelMap(const std::string &file_path) {
+        file_ = std::make_shared<slam::MemoryMappedFile>(file_path);
+        SLAM_CHECK_STREAM(file_->Size() >= sizeof(FileHeader) &&
+                          std::memcmp(file_->Data(), kFrozenMapMagic, sizeof(kFrozenMapMagic)) == 0,
+                          "The file " << file_path << " is not a map written by FrozenVoxelMap::Write");
+        header_ = reinterpret_cast<const FileHeader *>(file_->Data());
+        SLAM_CHECK_STREAM(header_->format_version == 2,
+                          "Unsupported version " << header_->format_version << " of the map " << file_path);
+        const size_t table_offset = sizeof(FileHeader);
+        const size_t points_offset = table_offset + sizeof(VoxelEntry) * header_->table_capacity;
+        SLAM_CHECK_STREAM(file_->Size() == points_offset + 3 * sizeof(double) * header_->num_points,
+                          "The map " << file_path << " is truncated");
+        table_ = reinterpret_cast<const VoxelEntry *>(file_->At(table_offset));
+        points_ = reinterpret_cast<const double *>(file_->At(points_offset));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    const FrozenVoxelMap::VoxelEntry *FrozenVoxelMap::FindVoxel(int32_t x, int32_t y, int32_t z) const {
+        const uint64_t mask = header_->table_capacity - 1;
+        auto slot = HashVoxel(x, y, z) & mask;
+        while (table_[slot].num_points > 0) {
+            const auto &entry = table_[slot];
+            if (entry.x == x && entry.y == y && entry.z == z)
+                return &entry;
+            slot = (slot + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void FrozenVoxelMap::ClearMap() {
+        throw std::runtime_error("A FrozenVoxelMap is read-only");
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void FrozenVoxelMap::InsertPointCloud(const slam::PointCloud &pointcloud,
+                                          const std::vector<slam::Pose> &frame_poses,
+                                          std::vector<size_t> &out_indices) {
+        throw std::runtime_error("A FrozenVoxelMap is read-only");
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void FrozenVoxelMap::RemoveElementsFarFromLocation(const Eigen::Vector3d &location, double distance) {
+        throw std::runtime_error("A FrozenVoxelMap is read-only");
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr FrozenVoxelMap::MapAsPointCloud() const {
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(NumPoints());
+        auto xyz = pc->XYZ<double>();
+        for (auto idx(0); idx < NumPoints(); ++idx)
+            xyz[idx] = Point(idx);
+        pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr FrozenVoxelMap::ExtractPoints(const MapRegion &region) const {
+        std::vector<uint64_t> indices;
+        auto select_points = [&](const VoxelEntry &entry) {
+            const Eigen::Vector3d voxel_min = Eigen::Vector3d(entry.x, entry.y, entry.z) * VoxelSize();
+            if (!region.Intersects(Eigen::AlignedBox3d(voxel_min, voxel_min + Eigen::Vector3d::Constant(VoxelSize()))))
+                return;
+            for (auto idx = entry.first_point; idx < entry.first_point + entry.num_points; ++idx) {
+                if (region.Contains(Point(idx)))
+                    indices.push_back(idx);
+            }
+        };
+
+        // Without normals, no point is visible from the sensor location (as for the default implementation)
+        auto bounding_box = region.BoundingBox();
+        if (region.sensor_location || (bounding_box && bounding_box->isEmpty())) {
+            // The region does not contain any point
+        } else if (bounding_box && ((bounding_box->sizes() / VoxelSize()).array() + 2.).prod() <
+                                   double(header_->table_capacity)) {
+            // Look up the voxels of the bounding box in the hash table
+            const auto min_voxel = slam::Voxel::Coordinates(bounding_box->min(), VoxelSize());
+            const auto max_voxel = slam::Voxel::Coordinates(bounding_box->max(), VoxelSize());
+            for (int kx = min_voxel.x; kx <= max_voxel.x; ++kx) {
+                for (int ky = min_voxel.y; ky <= max_voxel.y; ++ky) {
+                    for (int kz = min_voxel.z; kz <= max_voxel.z; ++kz) {
+                        const auto *entry = FindVoxel(kx, ky, kz);
+                        if (entry)
+                            select_points(*entry);
+                    }
+                }
+            }
+        } else {
+            // Scan the slots of the hash table (cheaper than the voxels of a large bounding box)
+            for (auto slot(0); slot < header_->table_capacity; ++slot) {
+                if (table_[slot].num_points > 0)
+                    select_points(table_[slot]);
+            }
+        }
+
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(indices.size());
+        auto xyz = pc->XYZ<double>();
+        for (auto i(0); i < indices.size(); ++i)
+            xyz[i] = Point(indices[i]);
+        pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void FrozenVoxelMap::RadiusSearchInPlace(const Eigen::Vector3d &query, slam::Neighborhood &neighborhood,
+                                             double radius, int max_num_neighbors, bool nearest_neighbors,
+                                             Eigen::Vector3d *sensor_location) const {
+        const double voxel_size = VoxelSize();
+        const int nb_voxels_visited = int(std::ceil(radius / voxel_size));
+        const double sq_radius = radius * radius;
+        slam::Voxel voxel = slam::Voxel::Coordinates(query, voxel_size);
+
+        // Max-heap of the closest neighbors found
+        std::vector<std::pair<double, uint64_t>> heap;
+        if (max_num_neighbors > 0)
+            heap.reserve(max_num_neighbors);
+        for (int kx = voxel.x - nb_voxels_visited; kx <= voxel.x + nb_voxels_visited; ++kx) {
+            for (int ky = voxel.y - nb_voxels_visited; ky <= voxel.y + nb_voxels_visited; ++ky) {
+                for (int kz = voxel.z - nb_voxels_visited; kz <= voxel.z + nb_voxels_visited; ++kz) {
+                    const auto *entry = FindVoxel(kx, ky, kz);
+                    if (!entry)
+                        continue;
+                    for (auto idx = entry->first_point; idx < entry->first_point + entry->num_points; ++idx) {
+                        double sq_distance = (Point(idx) - query).squaredNorm();
+                        if (sq_distance > sq_radius)
+                            continue;
+                        if (max_num_neighbors > 0 && heap.size() == max_num_neighbors) {
+                            if (sq_distance >= heap.front().first)
+                                continue;
+                            std::pop_heap(heap.begin(), heap.end());
+                            heap.back() = {sq_distance, idx};
+                        } else
+                            heap.emplace_back(sq_distance, idx);
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                }
+            }
+        }
+
+        // The neighbors are sorted by decreasing distance (as for the MultipleResolutionVoxelMap)
+        std::sort_heap(heap.begin(), heap.end());
+        neighborhood.points.resize(heap.size());
+        for (auto i(0); i < heap.size(); ++i)
+            neighborhood.points[i] = Point(heap[heap.size() - 1 - i].second);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<slam::Neighborhood> FrozenVoxelMap::ComputeNeighborhoods(const std::vector<Eigen::Vector3d> &queries,
+                                                                         const std::vector<double> radiuses,
+                                                                         int max_num_neighbors,
+                                                                         bool nearest_neighbors,
+                                                                         Eigen::Vector3d *sensor_location) const {
+        SLAM_CHECK_STREAM(radiuses.size() == queries.size(),
+                          "Invalid Parameters, size of queries and radiuses do not match");
+        std::vector<slam::Neighborhood> neighborhoods(queries.size());
+        for (size_t i = 0; i < queries.size(); ++i)
+            RadiusSearchInPlace(queries[i], neighborhoods[i], radiuses[i], max_num_neighbors,
+                                nearest_neighbors, sensor_location);
+        return neighborhoods;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    namespace {
+        const char kTilesIndexMagic[8] = {'C', 'T', 'I', 'C', 'P', 'T', 'I', 'L'};
+        const char *kTilesIndexFilename = "tiles.index";
+
+        // The header of the index of the tiles, followed by a `TileEntry` for each tile
+        struct TilesIndexHeader {
+            char magic[8];
+            uint32_t format_version = 1;
+            uint32_t num_tiles = 0;
+            double tile_size = 1.;
+            double voxel_size = 1.;
+        };
+
+        struct TileEntry {
+            int32_t x = 0, y = 0;
+            uint64_t num_points = 0;
+        };
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::string TiledVoxelMap::TilePath(const std::string &tiles_directory, const slam::Voxel &tile) {
+        return (fs::path(tiles_directory) /
+                ("tile_" + std::to_string(tile.x) + "_" + std::to_string(tile.y) + ".bin")).string();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::Write(const slam::PointCloud &pointcloud, const std::string &tiles_directory,
+                              double tile_size, double voxel_size) {
+        SLAM_CHECK_STREAM(tile_size > 0. && voxel_size > 0., "Invalid tile size " << tile_size
+                                                                                  << " or voxel size " << voxel_size);
+        fs::create_directories(tiles_directory);
+
+        // Partition the points by tile
+        std::map<slam::Voxel, std::vector<size_t>> tile_indices;
+        auto xyz = pointcloud.XYZConst<double>();
+        for (auto idx(0); idx < xyz.size(); ++idx) {
+            tile_indices[TileCoordinates(xyz[idx], tile_size)].push_back(idx);
+        }
+
+        TilesIndexHeader header;
+        std::memcpy(header.magic, kTilesIndexMagic, sizeof(kTilesIndexMagic));
+        header.num_tiles = tile_indices.size();
+        header.tile_size = tile_size;
+        header.voxel_size = voxel_size;
+        std::vector<TileEntry> entries;
+        entries.reserve(tile_indices.size());
+        for (auto &[tile, indices]: tile_indices) {
+            FrozenVoxelMap::Write(*pointcloud.SelectPoints(indices), TilePath(tiles_directory, tile), voxel_size);
+            entries.push_back(TileEntry{tile.x, tile.y, indices.size()});
+        }
+
+        // The index is written last, so that an interrupted write does not leave a valid directory of tiles
+        const auto index_path = (fs::path(tiles_directory) / kTilesIndexFilename).string();
+        std::ofstream file(index_path, std::ios::binary | std::ios::trunc);
+        SLAM_CHECK_STREAM(file.is_open(), "Could not open the file " << index_path);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(TilesIndexHeader));
+        file.write(reinterpret_cast<const char *>(entries.data()), sizeof(TileEntry) * entries.size());
+        SLAM_CHECK_STREAM(file.good(), "Could not write the index of the tiles " << index_path);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    TiledVoxelMap::TiledVoxelMap(const Options &options) : options_(options), cache_(options.max_tiles_in_memory) {
+        const auto index_path = (fs::path(options.tiles_directory) / kTilesIndexFilename).string();
+        std::ifstream file(index_path, std::ios::binary);
+        SLAM_CHECK_STREAM(file.is_open(), "Could not open the index of the tiles " << index_path);
+        TilesIndexHeader header;
+        file.read(reinterpret_cast<char *>(&header), sizeof(TilesIndexHeader));
+        SLAM_CHECK_STREAM(file.good() && std::memcmp(header.magic, kTilesIndexMagic, sizeof(kTilesIndexMagic)) == 0,
+                          "The file " << index_path << " is not an index written by TiledVoxelMap::Write");
+        SLAM_CHECK_STREAM(header.format_version == 1,
+                          "Unsupported version " << header.format_version << " of the tiles " << index_path);
+        tile_size_ = header.tile_size;
+        voxel_size_ = header.voxel_size;
+        std::vector<TileEntry> entries(header.num_tiles);
+        file.read(reinterpret_cast<char *>(entries.data()), sizeof(TileEntry) * entries.size());
+        SLAM_CHECK_STREAM(file.good(), "The index of the tiles " << index_path << " is truncated");
+        for (auto &entry: entries) {
+            tiles_[slam::Voxel(entry.x, entry.y, 0)] = entry.num_points;
+            num_points_ += entry.num_points;
+        }
+
+        if (options_.asynchronous_prefetch)
+            prefetch_thread_ = std::thread(&TiledVoxelMap::PrefetchLoop, this);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    TiledVoxelMap::~TiledVoxelMap() {
+        stop_prefetch_ = true;
+        prefetch_queue_.notify_event();
+        if (prefetch_thread_.joinable())
+            prefetch_thread_.join();
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<FrozenVoxelMap> TiledVoxelMap::GetTile(const slam::Voxel &tile) const {
+        if (tiles_.find(tile) == tiles_.end())
+            return nullptr;
+        auto cached = cache_.get(tile);
+        if (cached)
+            return *cached;
+
+        // The tile might have been loaded by another thread while waiting for the lock
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        cached = cache_.get(tile);
+        if (cached)
+            return *cached;
+        auto map = std::make_shared<FrozenVoxelMap>(TilePath(options_.tiles_directory, tile));
+        cache_.put(tile, map);
+        return map;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::shared_ptr<FrozenVoxelMap> TiledVoxelMap::GetTile(const TilesSnapshot *pinned_tiles,
+                                                           const slam::Voxel &tile) const {
+        if (pinned_tiles) {
+            auto it = pinned_tiles->find(tile);
+            if (it != pinned_tiles->end())
+                return it->second;
+        }
+        return GetTile(tile);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::PinTiles(const Eigen::Vector3d &location) {
+        const auto center = TileCoordinates(location);
+        const int radius = options_.pinned_radius;
+        auto pinned_tiles = std::make_shared<TilesSnapshot>();
+        for (int x = center.x - radius; x <= center.x + radius; ++x) {
+            for (int y = center.y - radius; y <= center.y + radius; ++y) {
+                auto tile = GetTile(slam::Voxel(x, y, 0));
+                if (tile)
+                    (*pinned_tiles)[slam::Voxel(x, y, 0)] = std::move(tile);
+            }
+        }
+        std::atomic_store(&pinned_tiles_, std::shared_ptr<const TilesSnapshot>(std::move(pinned_tiles)));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t TiledVoxelMap::NumPinnedTiles() const {
+        auto pinned_tiles = std::atomic_load(&pinned_tiles_);
+        return pinned_tiles ? pinned_tiles->size() : 0;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::PrefetchLoop() {
+        while (!stop_prefetch_) {
+            auto tile = prefetch_queue_.blocking_pop_with([this] { return bool(stop_prefetch_); }, 100);
+            if (tile && !stop_prefetch_ && !cache_.contains(*tile))
+                GetTile(*tile);
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::Prefetch(const Eigen::Vector3d &location) {
+        const auto center = TileCoordinates(location);
+        const int radius = options_.prefetch_radius;
+        for (int x = center.x - radius; x <= center.x + radius; ++x) {
+            for (int y = center.y - radius; y <= center.y + radius; ++y) {
+                slam::Voxel tile(x, y, 0);
+                if (tiles_.find(tile) == tiles_.end() || cache_.contains(tile))
+                    continue;
+                if (options_.asynchronous_prefetch)
+                    prefetch_queue_.push(tile);
+                else
+                    GetTile(tile);
+            }
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::UpdateTrajectory(const std::vector<slam::Pose> &poses) {
+        if (poses.empty())
+            return;
+        const auto &last_pose = poses.back();
+        const Eigen::Vector3d location = last_pose.pose.tr;
+        // The next frame is registered around the last pose: its queries read the pinned tiles
+        PinTiles(location);
+        Prefetch(location);
+
+        const auto &first_pose = poses.front();
+        const double dt = last_pose.dest_timestamp - first_pose.dest_timestamp;
+        if (poses.size() < 2 || dt <= 0. || options_.prefetch_horizon <= 0.)
+            return;
+
+        // Prefetch the tiles along the extrapolated motion, sampled at half the size of a tile
+        const Eigen::Vector3d velocity = (location - first_pose.pose.tr) / dt;
+        const double distance = velocity.norm() * options_.prefetch_horizon;
+        const int num_samples = int(std::ceil(2. * distance / tile_size_));
+        for (int i(1); i <= num_samples; ++i)
+            Prefetch(location + velocity * (options_.prefetch_horizon * i / num_samples));
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::ClearMap() {
+        throw std::runtime_error("A TiledVoxelMap is read-only");
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::InsertPointCloud(const slam::PointCloud &pointcloud,
+                                         const std::vector<slam::Pose> &frame_poses,
+                                         std::vector<size_t> &out_indices) {
+        throw std::runtime_error("A TiledVoxelMap is read-only");
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::RemoveElementsFarFromLocation(const Eigen::Vector3d &location, double distance) {
+        const auto center = TileCoordinates(location);
+        const int max_tile_distance = int(std::ceil(distance / tile_size_));
+        for (auto &[tile, num_points]: tiles_) {
+            if (std::max(std::abs(tile.x - center.x), std::abs(tile.y - center.y)) > max_tile_distance)
+                cache_.erase(tile);
+        }
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr TiledVoxelMap::MapAsPointCloud() const {
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(num_points_);
+        auto xyz = pc->XYZ<double>();
+        size_t point_idx = 0;
+        for (auto &[tile, num_points]: tiles_) {
+            // The tiles are not cached, to avoid evicting the tiles of the current location
+            FrozenVoxelMap tile_map(TilePath(options_.tiles_directory, tile));
+            auto tile_pc = tile_map.MapAsPointCloud();
+            const auto &const_tile_pc = *tile_pc;
+            auto tile_xyz = const_tile_pc.XYZConst<double>();
+            for (auto idx(0); idx < tile_xyz.size(); ++idx)
+                xyz[point_idx++] = Eigen::Vector3d(tile_xyz[idx]);
+        }
+        pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    slam::PointCloudPtr TiledVoxelMap::ExtractPoints(const MapRegion &region) const {
+        if (!region.BoundingBox())
+            return ISlamMap::ExtractPoints(region);
+
+        // The index of the tiles is in memory: only the tiles intersecting the region are loaded
+        const auto pinned_tiles = std::atomic_load(&pinned_tiles_);
+        std::vector<slam::PointCloudPtr> tile_points;
+        size_t num_points = 0;
+        for (auto &[tile_coordinates, _]: tiles_) {
+            // The tiles span the whole vertical axis
+            const Eigen::AlignedBox3d tile_box(
+                    Eigen::Vector3d(tile_coordinates.x * tile_size_, tile_coordinates.y * tile_size_,
+                                    std::numeric_limits<double>::lowest()),
+                    Eigen::Vector3d((tile_coordinates.x + 1) * tile_size_, (tile_coordinates.y + 1) * tile_size_,
+                                    std::numeric_limits<double>::max()));
+            if (!region.Intersects(tile_box))
+                continue;
+            auto tile = GetTile(pinned_tiles.get(), tile_coordinates);
+            if (!tile)
+                continue;
+            tile_points.push_back(tile->ExtractPoints(region));
+            num_points += tile_points.back()->size();
+        }
+
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(num_points);
+        auto xyz = pc->XYZ<double>();
+        size_t point_idx = 0;
+        for (auto &tile_pc: tile_points) {
+            const auto &const_tile_pc = *tile_pc;
+            auto tile_xyz = const_tile_pc.XYZConst<double>();
+            for (auto idx(0); idx < tile_xyz.size(); ++idx)
+                xyz[point_idx++] = Eigen::Vector3d(tile_xyz[idx]);
+        }
+        pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+        return pc;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::RadiusSearchInPlace(const Eigen::Vector3d &query, slam::Neighborhood &neighborhood,
+                                            double radius, int max_num_neighbors, bool nearest_neighbors,
+                                            Eigen::Vector3d *sensor_location) const {
+        const auto pinned_tiles = std::atomic_load(&pinned_tiles_);
+        RadiusSearchInTiles(pinned_tiles.get(), query, neighborhood, radius, max_num_neighbors,
+                            nearest_neighbors, sensor_location);
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void TiledVoxelMap::RadiusSearchInTiles(const TilesSnapshot *pinned_tiles,
+                                            const Eigen::Vector3d &query, slam::Neighborhood &neighborhood,
+                                            double radius, int max_num_neighbors, bool nearest_neighbors,
+                                            Eigen::Vector3d *sensor_location) const {
+        const auto min_tile = TileCoordinates(query - Eigen::Vector3d::Constant(radius));
+        const auto max_tile = TileCoordinates(query + Eigen::Vector3d::Constant(radius));
+        if (min_tile == max_tile) {
+            auto tile = GetTile(pinned_tiles, min_tile);
+            neighborhood.points.resize(0);
+            if (tile)
+                tile->RadiusSearchInPlace(query, neighborhood, radius, max_num_neighbors,
+                                          nearest_neighbors, sensor_location);
+            return;
+        }
+
+        // Merge the neighbors of the tiles overlapping the ball of the query
+        std::vector<std::pair<double, Eigen::Vector3d>> neighbors;
+        slam::Neighborhood tile_neighborhood;
+        for (int x = min_tile.x; x <= max_tile.x; ++x) {
+            for (int y = min_tile.y; y <= max_tile.y; ++y) {
+                auto tile = GetTile(pinned_tiles, slam::Voxel(x, y, 0));
+                if (!tile)
+                    continue;
+                tile->RadiusSearchInPlace(query, tile_neighborhood, radius, max_num_neighbors,
+                                          nearest_neighbors, sensor_location);
+                for (auto &point: tile_neighborhood.points)
+                    neighbors.emplace_back((point - query).squaredNorm(), point);
+            }
+        }
+        auto by_distance = [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; };
+        if (max_num_neighbors > 0 && neighbors.size() > max_num_neighbors) {
+            std::nth_element(neighbors.begin(), neighbors.begin() + max_num_neighbors, neighbors.end(), by_distance);
+            neighbors.resize(max_num_neighbors);
+        }
+
+        // The neighbors are sorted by decreasing distance (as for the MultipleResolutionVoxelMap)
+        std::sort(neighbors.begin(), neighbors.end(), by_distance);
+        neighborhood.points.resize(neighbors.size());
+        for (auto i(0); i < neighbors.size(); ++i)
+            neighborhood.points[i] = neighbors[neighbors.size() - 1 - i].second;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<slam::Neighborhood> TiledVoxelMap::ComputeNeighborhoods(const std::vector<Eigen::Vector3d> &queries,
+                                                                        const std::vector<double> radiuses,
+                                                                        int max_num_neighbors,
+                                                                        bool nearest_neighbors,
+                                                                        Eigen::Vector3d *sensor_location) const {
+        SLAM_CHECK_STREAM(radiuses.size() == queries.size(),
+                          "Invalid Parameters, size of queries and radiuses do not match");
+        // The snapshot of the pinned tiles is read once for all the queries
+        const auto pinned_tiles = std::atomic_load(&pinned_tiles_);
+        std::vector<slam::Neighborhood> neighborhoods(queries.size());
+        for (size_t i = 0; i < queries.size(); ++i)
+            RadiusSearchInTiles(pinned_tiles.get(), queries[i], neighborhoods[i], radiuses[i], max_num_neighbors,
+                                nearest_neighbors, sensor_location);
+        return neighborhoods;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+
+} // namespace ct_icp
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "ct_icp/neighborhood_strategy.h"
 
 namespace ct_icp {
@@ -5,4 +7,147 @@ namespace ct_icp {
     /* -------------------------------------------------------------------------------------------------------------- */
     INeighborStrategyOptions::~INeighborStrategyOptions() = default;
 
-} // namespace ct_icp
\ No newline at end of file
+    /* -------------------------------------------------------------------------------------------------------------- */
+    RangeImageStrategy::RangeImageStrategy(const Options &options_) : options(options_) {
+        SLAM_CHECK_STREAM(options.num_azimuth_bins > 0 && options.num_elevation_bins > 0,
+                          "Invalid size of the range image");
+        SLAM_CHECK_STREAM(options.min_elevation < options.max_elevation, "Invalid elevations of the range image");
+        SLAM_CHECK_STREAM((2 * options.window_half_width + 1) * (2 * options.window_half_height + 1) >=
+                          options.min_num_neighbors,
+                          "The search window cannot hold the minimum number of neighbors: every query would "
+                          "fall back to a radius search");
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool RangeImageStrategy::Project(const Eigen::Vector3d &sensor_point, int &row, int &col) const {
+        const double range = sensor_point.norm();
+        if (range <= 0.)
+            return false;
+        const double elevation = std::asin(sensor_point.z() / range) * 180. / M_PI;
+        const double elevation_ratio = (elevation - options.min_elevation) /
+                                       (options.max_elevation - options.min_elevation);
+        if (elevation_ratio < 0. || elevation_ratio >= 1.)
+            return false;
+        const double azimuth_ratio = (std::atan2(sensor_point.y(), sensor_point.x()) + M_PI) / (2. * M_PI);
+        row = int(elevation_ratio * options.num_elevation_bins);
+        col = int(azimuth_ratio * options.num_azimuth_bins) % options.num_azimuth_bins;
+        return true;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    void RangeImageStrategy::UpdateMapView(const ISlamMap &map, const slam::SE3 &sensor_pose) {
+        // Synchronize the points of the map
+        std::vector<slam::PointCloudPtr> pointclouds;
+        const auto version = map.Version();
+        if (version > 0) {
+            if (&map != cached_map_ || version < cached_version_) {
+                cached_chunks_.clear();
+                cached_version_ = 0;
+            }
+            // The chunks are cached entirely, as the chunks unchanged can enter the view with the motion
+            for (auto &chunk: map.ExtractChunks(MapRegion(), cached_version_)) {
+                if (!chunk.points || chunk.points->size() == 0) {
+                    cached_chunks_.erase(chunk.coordinates);
+                    continue;
+                }
+                auto &cached_chunk = cached_chunks_[chunk.coordinates];
+                cached_chunk.points = chunk.points;
+                cached_chunk.box.setEmpty();
+                const slam::PointCloud &const_pc = *chunk.points;
+                auto xyz = const_pc.XYZConst<double>();
+                for (auto idx(0); idx < xyz.size(); ++idx)
+                    cached_chunk.box.extend(Eigen::Vector3d(xyz[idx]));
+            }
+            cached_map_ = &map;
+            cached_version_ = version;
+            for (auto &[_, cached_chunk]: cached_chunks_) {
+                if (cached_chunk.box.exteriorDistance(sensor_pose.tr) <= options.max_range)
+                    pointclouds.push_back(cached_chunk.points);
+            }
+        } else {
+            cached_chunks_.clear();
+            cached_map_ = nullptr;
+            pointclouds.push_back(map.ExtractPoints(MapRegion::Ball(sensor_pose.tr, options.max_range)));
+        }
+
+        // Render the range image from the predicted pose, keeping the closest point of each pixel
+        const size_t num_pixels = size_t(options.num_azimuth_bins) * options.num_elevation_bins;
+        pixel_points_.resize(num_pixels);
+        pixel_ranges_.assign(num_pixels, std::numeric_limits<float>::infinity());
+        const slam::SE3 world_to_sensor = sensor_pose.Inverse();
+        const double sq_max_range = options.max_range * options.max_range;
+        int row, col;
+        for (auto &pc: pointclouds) {
+            if (!pc || pc->size() == 0)
+                continue;
+            const slam::PointCloud &const_pc = *pc;
+            auto xyz = const_pc.XYZConst<double>();
+            for (auto idx(0); idx < xyz.size(); ++idx) {
+                Eigen::Vector3d world_point = xyz[idx];
+                Eigen::Vector3d sensor_point = world_to_sensor * world_point;
+                const double sq_range = sensor_point.squaredNorm();
+                if (sq_range > sq_max_range || !Project(sensor_point, row, col))
+                    continue;
+                const auto pixel = size_t(row) * options.num_azimuth_bins + col;
+                const auto range = float(std::sqrt(sq_range));
+                if (range < pixel_ranges_[pixel]) {
+                    pixel_ranges_[pixel] = range;
+                    pixel_points_[pixel] = world_point;
+                }
+            }
+        }
+        sensor_pose_ = sensor_pose;
+        has_view_ = true;
+        num_fallbacks_ = 0;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    bool RangeImageStrategy::ComputeNeighborhoodInPlace(const ISlamMap &map,
+                                                        const slam::WPoint3D &query,
+                                                        slam::Neighborhood &neighborhood,
+                                                        Eigen::Vector3d *sensor_location) const {
+        neighborhood.points.resize(0);
+        int row, col;
+        if (has_view_ && Project(sensor_pose_.Inverse() * query.world_point, row, col)) {
+            // Select the closest points of the window around the projection of the query
+            const double sq_max_distance = options.max_distance * options.max_distance;
+            std::vector<std::pair<double, int>> candidates;
+            candidates.reserve((2 * options.window_half_width + 1) * (2 * options.window_half_height + 1));
+            for (int r = std::max(row - options.window_half_height, 0);
+                 r <= std::min(row + options.window_half_height, options.num_elevation_bins - 1); ++r) {
+                for (int dc = -options.window_half_width; dc <= options.window_half_width; ++dc) {
+                    // The azimuth wraps around the image
+                    const int c = (col + dc + options.num_azimuth_bins) % options.num_azimuth_bins;
+                    const auto pixel = r * options.num_azimuth_bins + c;
+                    if (std::isinf(pixel_ranges_[pixel]))
+                        continue;
+                    const double sq_distance = (pixel_points_[pixel] - query.world_point).squaredNorm();
+                    if (sq_distance <= sq_max_distance)
+                        candidates.emplace_back(sq_distance, pixel);
+                }
+            }
+            if (candidates.size() >= options.min_num_neighbors) {
+                const auto num_neighbors = std::min(candidates.size(), size_t(options.max_num_neighbors));
+                std::partial_sort(candidates.begin(), candidates.begin() + num_neighbors, candidates.end());
+                // The neighbors are ordered from the farthest to the closest, as for the radius searches of the maps
+                neighborhood.points.reserve(num_neighbors);
+                for (auto i(num_neighbors); i > 0; --i)
+                    neighborhood.points.push_back(pixel_points_[candidates[i - 1].second]);
+                return true;
+            }
+        }
+
+        // Fall back to a radius search in the map
+        num_fallbacks_++;
+        map.RadiusSearchInPlace(query.world_point, neighborhood, options.fallback_radius,
+                                options.max_num_neighbors, true, sensor_location);
+        return neighborhood.points.size() >= options.min_num_neighbors;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    size_t RangeImageStrategy::NumFilledPixels() const {
+        return std::count_if(pixel_ranges_.begin(), pixel_ranges_.end(),
+                             [](float range) { return !std::isinf(range); });
+    }
+
+} // namespace ct_icp
@@ -1,7 +1,10 @@
 #include <omp.h>
 #include <chrono>
+#include <numeric>
+#include <thread>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include "ct_icp/odometry.h"
 #include "ct_icp/utils.h"
@@ -21,6 +24,20 @@ namespace ct_icp {
             std::chrono::duration<double, std::milli> elapsed = (tp_end - tp_begin);
             return elapsed.count();
         };
+
+        // Makes the map of the odometry, which caches the distributions of the voxels when the registration uses them
+        // (`options` must hold the registration options actually used, see the constructor of the Odometry)
+        std::shared_ptr<ISlamMap> MakeOdometryMap(const OdometryOptions &options) {
+            auto *voxel_map_options = dynamic_cast<const MultipleResolutionVoxelMap::Options *>(
+                    options.map_options.get());
+            if (voxel_map_options && !voxel_map_options->cache_distributions &&
+                options.ct_icp_options.distance == DISTRIBUTION_TO_DISTRIBUTION) {
+                auto map_options = *voxel_map_options;
+                map_options.cache_distributions = true;
+                return map_options.MakeMapFromOptions();
+            }
+            return options.map_options->MakeMapFromOptions();
+        }
     }
 
     using namespace slam;
@@ -281,52 +298,128 @@ namespace ct_icp {
         }
 
         // TODO: Initialize the motion with the motion model
+        trajectory_.emplace_back(InitialMotionEstimate(frame_info, options_.initialization));
+    }
 
+    /* -------------------------------------------------------------------------------------------------------------- */
+    TrajectoryFrame Odometry::InitialMotionEstimate(FrameInfo frame_info, INITIALIZATION initialization) const {
         const auto kFrameIndex = frame_info.registered_fid;
         // Initial Trajectory Estimate
-        trajectory_.emplace_back(TrajectoryFrame());
-        trajectory_[kFrameIndex].begin_pose = Pose(SE3(), frame_info.begin_timestamp, frame_info.frame_id);
-        trajectory_[kFrameIndex].end_pose = Pose(SE3(), frame_info.end_timestamp, frame_info.frame_id);
+        TrajectoryFrame new_frame;
+        new_frame.begin_pose = Pose(SE3(), frame_info.begin_timestamp, frame_info.frame_id);
+        new_frame.end_pose = Pose(SE3(), frame_info.end_timestamp, frame_info.frame_id);
 
         if (kFrameIndex <= 1) {
             // Initialize first pose at Identity
 
         } else if (kFrameIndex == 2) {
-            if (options_.initialization == INIT_CONSTANT_VELOCITY) {
+            if (initialization == INIT_CONSTANT_VELOCITY) {
                 // Different regimen for the second frame due to the bootstrapped elasticity
-                trajectory_[kFrameIndex].begin_pose.pose = trajectory_[kFrameIndex - 1].end_pose.pose;
-                trajectory_[kFrameIndex].end_pose.pose = trajectory_[kFrameIndex - 1].end_pose.pose *
-                                                         trajectory_[kFrameIndex - 2].end_pose.pose.Inverse() *
-                                                         trajectory_[kFrameIndex - 1].end_pose.pose;
+                new_frame.begin_pose.pose = trajectory_[kFrameIndex - 1].end_pose.pose;
+                new_frame.end_pose.pose = trajectory_[kFrameIndex - 1].end_pose.pose *
+                                          trajectory_[kFrameIndex - 2].end_pose.pose.Inverse() *
+                                          trajectory_[kFrameIndex - 1].end_pose.pose;
             } else {
                 // Important ! Start with a rigid frame and let the ICP distort it !
                 // It would make more sense to start
-                trajectory_[kFrameIndex].begin_pose.pose = trajectory_[kFrameIndex - 1].begin_pose.pose;
-                trajectory_[kFrameIndex].end_pose.pose = trajectory_[kFrameIndex].begin_pose.pose;
+                new_frame.begin_pose.pose = trajectory_[kFrameIndex - 1].begin_pose.pose;
+                new_frame.end_pose.pose = new_frame.begin_pose.pose;
             }
         } else {
             const auto &frame_m_1 = trajectory_[kFrameIndex - 1];
             const auto &frame_m_2 = trajectory_[kFrameIndex - 2];
 
-            if (options_.initialization == INIT_CONSTANT_VELOCITY) {
+            if (initialization == INIT_CONSTANT_VELOCITY) {
                 if (options_.motion_compensation == CONTINUOUS) {
                     // When continuous: use the previous begin_pose as reference
                     auto next_begin = frame_m_1.begin_pose.pose *
                                       frame_m_2.begin_pose.pose.Inverse() *
                                       frame_m_1.begin_pose.pose;
-                    trajectory_[kFrameIndex].begin_pose.pose = next_begin;
+                    new_frame.begin_pose.pose = next_begin;
                 } else {
                     // When not continuous: set the new begin and previous end pose to be consistent
-                    trajectory_[kFrameIndex].begin_pose.pose = frame_m_1.end_pose.pose;
+                    new_frame.begin_pose.pose = frame_m_1.end_pose.pose;
                 }
-                trajectory_[kFrameIndex].end_pose.pose = trajectory_[kFrameIndex - 1].end_pose.pose *
-                                                         trajectory_[kFrameIndex - 2].end_pose.pose.Inverse() *
-                                                         trajectory_[kFrameIndex - 1].end_pose.pose;
+                new_frame.end_pose.pose = trajectory_[kFrameIndex - 1].end_pose.pose *
+                                          trajectory_[kFrameIndex - 2].end_pose.pose.Inverse() *
+                                          trajectory_[kFrameIndex - 1].end_pose.pose;
             } else {
-                trajectory_[kFrameIndex].begin_pose.pose = frame_m_1.end_pose.pose;
-                trajectory_[kFrameIndex].end_pose.pose = frame_m_1.end_pose.pose;
+                new_frame.begin_pose.pose = frame_m_1.end_pose.pose;
+                new_frame.end_pose.pose = frame_m_1.end_pose.pose;
+            }
+        }
+        return new_frame;
+    }
+
+    /* -------------------------------------------------------------------------------------------------------------- */
+    int Odometry::SelectMotionHypothesis(const slam::PointCloud &const_frame, FrameInfo frame_info,
+                                         AMotionModel *motion_model) {
+        const auto kIndexFrame = frame_info.registered_fid;
+        std::vector<TrajectoryFrame> hypotheses{
+                trajectory_[kIndexFrame], // The current initialization (or the estimate of the caller)
+                InitialMotionEstimate(frame_info, INIT_CONSTANT_VELOCITY),
+                InitialMotionEstimate(frame_info, INIT_NONE)
+        };
+        if (motion_model) {
+            // The prediction of the motion model of the caller (e.g. integrated from an IMU)
+            auto prediction = motion_model->NextFrame();
+            auto hypothesis = trajectory_[kIndexFrame];
+            hypothesis.begin_pose.pose = prediction.begin_pose.pose;
+            hypothesis.end_pose.pose = prediction.end_pose.pose;
+            hypotheses.push_back(hypothesis);
+        }
+
+        // Sub-sample the frame
+        const auto view_timestamps = const_frame.TimestampsProxy<double>();
+        const auto view_xyz = const_frame.XYZConst<double>();
+        std::vector<slam::WPoint3D> points(const_frame.size());
+        for (auto i(0); i < points.size(); ++i) {
+            points[i].raw_point.point = view_xyz[i];
+            points[i].raw_point.timestamp = view_timestamps[i];
+        }
+        sub_sample_frame(points, options_.hypotheses_sample_voxel_size);
+        if (options_.hypotheses_max_num_points > 0 && points.size() > options_.hypotheses_max_num_points) {
+            std::shuffle(points.begin(), points.end(), g_);
+            points.resize(options_.hypotheses_max_num_points);
+        }
+        if (points.empty())
+            return 0;
+
+        // Score all hypotheses in parallel with the truncated point-to-plane residuals of the sub-sampled points
+        const double kMaxSquaredResidual = options_.hypotheses_max_residual * options_.hypotheses_max_residual;
+        const int kNumPoints = int(points.size());
+        std::vector<double> squared_residuals(hypotheses.size() * kNumPoints);
+#pragma omp parallel for num_threads(options_.ct_icp_options.ls_num_threads)
+        for (int idx = 0; idx < int(squared_residuals.size()); ++idx) {
+            const auto &hypothesis = hypotheses[idx / kNumPoints];
+            const auto &point = points[idx % kNumPoints];
+            Eigen::Vector3d world_point = hypothesis.begin_pose.ContinuousTransform(point.raw_point.point,
+                                                                                   hypothesis.end_pose,
+                                                                                   point.raw_point.timestamp);
+            auto neighborhood = map_->RadiusSearch(world_point, options_.hypotheses_search_radius,
+                                                   options_.ct_icp_options.max_number_neighbors, true);
+            double squared_residual = kMaxSquaredResidual;
+            if (neighborhood.points.size() >= std::max(options_.ct_icp_options.min_number_neighbors, 3)) {
+                neighborhood.ComputeNeighborhood(slam::NORMAL);
+                double residual = (world_point - neighborhood.description.barycenter).dot(
+                        neighborhood.description.normal);
+                squared_residual = std::min(residual * residual, kMaxSquaredResidual);
             }
+            squared_residuals[idx] = squared_residual;
         }
+
+        int best_idx = 0;
+        double best_score = std::numeric_limits<double>::max();
+        for (int hidx(0); hidx < hypotheses.size(); ++hidx) {
+            double score = std::accumulate(squared_residuals.begin() + hidx * kNumPoints,
+                                           squared_residuals.begin() + (hidx + 1) * kNumPoints, 0.);
+            if (score < best_score) {
+                best_score = score;
+                best_idx = hidx;
+            }
+        }
+        trajectory_[kIndexFrame] = hypotheses[best_idx];
+        return best_idx;
     }
 
     /* -------------------------------------------------------------------------------------------------------------- */
@@ -394,6 +487,10 @@ namespace ct_icp {
         const double kSizeVoxelMap = options_.size_voxel_map;
         const auto kIndexFrame = frame_info.registered_fid;
 
+        // Score several initial motions, and keep the best one as the initial estimate
+        int selected_hypothesis = -1;
+        if (options_.init_with_motion_hypotheses && kIndexFrame > 1)
+            selected_hypothesis = SelectMotionHypothesis(const_frame, frame_info, motion_model);
 
         auto frame = InitializeFrame(const_frame, frame_info);
 
@@ -405,17 +502,26 @@ namespace ct_icp {
         RegistrationSummary summary;
         summary.frame = initial_estimate;
         summary.initial_frame = initial_estimate;
+        if (selected_hypothesis >= 0)
+            summary.logged_values["odometry_motion_hypothesis"] = selected_hypothesis;
         auto &current_frame = summary.frame;
 
         auto end_initialization = now();
-        if (kIndexFrame > 0) {
+        // In localization mode, the first frame is also registered against the prebuilt map
+        if (kIndexFrame > 0 || options_.localization_mode) {
             auto motion_model_ptr = motion_model;
-            if (!motion_model && options_.with_default_motion_model) {
+            if (!motion_model && options_.with_default_motion_model && kIndexFrame > 0) {
                 default_motion_model.GetOptions() = options_.default_motion_model;
                 default_motion_model.UpdateState(trajectory_[kIndexFrame - 1], kIndexFrame - 1);
                 motion_model_ptr = &default_motion_model;
             }
 
+            // Prepare the neighborhood strategy from the initial estimate of the frame (e.g. projective strategies)
+            // Once per frame, as the registration attempts share the strategy (and can run concurrently)
+            if (neighborhood_strategy_)
+                neighborhood_strategy_->UpdateMapView(*map_, current_frame.begin_pose.InterpolatePoseAlpha(
+                        current_frame.end_pose, 0.5).pose);
+
             if (options_.robust_registration) {
                 RobustRegistration(frame, frame_info, summary, motion_model_ptr);
             } else {
@@ -428,8 +534,9 @@ namespace ct_icp {
                 summary.logged_values["odometry_try_register"] = duration_ms(end_ct_icp, start_ct_icp);
 
 
-                summary.relative_orientation = slam::AngularDistance(trajectory_[kIndexFrame - 1].end_pose.pose,
-                                                                     trajectory_[kIndexFrame].end_pose.pose);
+                if (kIndexFrame > 0)
+                    summary.relative_orientation = slam::AngularDistance(trajectory_[kIndexFrame - 1].end_pose.pose,
+                                                                         trajectory_[kIndexFrame].end_pose.pose);
                 summary.ego_orientation = summary.frame.EgoAngularDistance();
                 summary.relative_distance = (summary.frame.EndTr() - summary.frame.BeginTr()).norm();
                 if (!AssessRegistration(frame, summary, log_out_)) {
@@ -526,28 +633,17 @@ namespace ct_icp {
                                CTICPOptions &options,
                                RegistrationSummary &registration_summary,
                                double sample_voxel_size,
-                               AMotionModel *motion_model) {
+                               AMotionModel *motion_model,
+                               RegistrationContext *context) {
         const auto kIndexFrame = frame_info.registered_fid;
+        const bool kWithCallbacks = !context || context->with_callbacks;
         const bool kIsAtStartup = kIndexFrame < options_.init_num_frames;
 
         auto start = now();
         // Use new sub_sample frame as keypoints
-        std::vector<slam::WPoint3D> keypoints;
-
-        if (options_.sampling == sampling::GRID) {
-            grid_sampling(frame, keypoints, sample_voxel_size);
-        } else if (options_.sampling == sampling::ADAPTIVE) {
-            auto [begin, end] = slam::make_transform_collection(frame, slam::RawPointConversion());
-            auto indices = ct_icp::AdaptiveSamplePointsInGrid(begin, end, options_.adaptive_options);
-            keypoints.reserve(indices.size());
-            for (auto idx: indices)
-                keypoints.push_back(frame[idx]);
-        } else {
-            keypoints = frame;
-        }
-
+        std::vector<slam::WPoint3D> keypoints = SampleKeypoints(frame, sample_voxel_size);
         if (!kIsAtStartup && options_.max_num_keypoints > 0 && keypoints.size() > options_.max_num_keypoints) {
-            std::shuffle(keypoints.begin(), keypoints.end(), g_);
+            std::shuffle(keypoints.begin(), keypoints.end(), context ? context->rng : g_);
             keypoints.resize(options_.max_num_keypoints);
         }
 
@@ -565,13 +661,18 @@ namespace ct_icp {
             }
 
             // Iterate over the callbacks with the keypoints
-            IterateOverCallbacks(OdometryCallback::BEFORE_ITERATION,
-                                 frame, &keypoints);
+            if (kWithCallbacks)
+                IterateOverCallbacks(OdometryCallback::BEFORE_ITERATION,
+                                     frame, &keypoints);
+            else if (context)
+                context->initial_keypoints = keypoints;
 
             //CT ICP
             ICPSummary icp_summary;
             CT_ICP_Registration registration;
             registration.Options() = options;
+            if (context)
+                registration.SetCancellationFlag(context->cancel_flag);
             registration_summary.icp_summary = registration.Register(*map_,
                                                                      keypoints,
                                                                      registration_summary.frame,
@@ -597,7 +698,8 @@ namespace ct_icp {
             registration_summary.keypoints = keypoints;
         }
 
-        IterateOverCallbacks(OdometryCallback::ITERATION_COMPLETED, frame, &keypoints, nullptr);
+        if (kWithCallbacks)
+            IterateOverCallbacks(OdometryCallback::ITERATION_COMPLETED, frame, &keypoints, nullptr);
     }
 
 /* -------------------------------------------------------------------------------------------------------------- */
@@ -695,9 +797,11 @@ namespace ct_icp {
 
 /* -------------------------------------------------------------------------------------------------------------- */
     Odometry::Odometry(
-            const OdometryOptions &options) : insertion_tracker_(options_) {
-        SLAM_CHECK_STREAM(options.map_options, "The Options has not specified a Map Options");
-        map_ = options.map_options->MakeMapFromOptions();
+            const OdometryOptions &options) : Odometry(options, nullptr) {}
+
+/* -------------------------------------------------------------------------------------------------------------- */
+    Odometry::Odometry(const OdometryOptions &options,
+                       std::shared_ptr<ct_icp::ISlamMap> map) : insertion_tracker_(options_) {
         options_ = options;
         neighborhood_strategy_ = options_.neighborhood_strategy->MakeStrategyFromOptions();
         // Update the motion compensation
@@ -706,22 +810,32 @@ namespace ct_icp {
             case MOTION_COMPENSATION::CONSTANT_VELOCITY:
                 // ElasticICP does not compensate the motion
                 options_.ct_icp_options.point_to_plane_with_distortion = false;
-                options_.ct_icp_options.distance = POINT_TO_PLANE;
                 options_.ct_icp_options.parametrization = SIMPLE;
                 break;
             case MOTION_COMPENSATION::ITERATIVE:
                 // ElasticICP compensates the motion at each ICP iteration
                 options_.ct_icp_options.point_to_plane_with_distortion = true;
-                options_.ct_icp_options.distance = POINT_TO_PLANE;
                 options_.ct_icp_options.parametrization = SIMPLE;
                 break;
             case MOTION_COMPENSATION::CONTINUOUS:
                 // ElasticICP compensates continuously the motion
                 options_.ct_icp_options.point_to_plane_with_distortion = true;
                 options_.ct_icp_options.parametrization = CONTINUOUS_TIME;
-                options_.ct_icp_options.distance = POINT_TO_PLANE;
                 break;
         }
+        // The residuals are point-to-plane, unless Generalized-ICP is selected (with the distributions of the map)
+        if (options_.ct_icp_options.distance != DISTRIBUTION_TO_DISTRIBUTION)
+            options_.ct_icp_options.distance = POINT_TO_PLANE;
+        SLAM_CHECK_STREAM(options_.ct_icp_options.distance != DISTRIBUTION_TO_DISTRIBUTION ||
+                          options_.ct_icp_options.solver != GN,
+                          "The DISTRIBUTION_TO_DISTRIBUTION distance requires the CERES or ROBUST solver");
+
+        if (map)
+            map_ = std::move(map);
+        else {
+            SLAM_CHECK_STREAM(options_.map_options, "The Options has not specified a Map Options");
+            map_ = MakeOdometryMap(options_);
+        }
         next_robust_level_ = options.robust_minimal_level;
 
         if (options_.log_to_file) {
@@ -776,81 +890,226 @@ namespace ct_icp {
     }
 
 
+/* -------------------------------------------------------------------------------------------------------------- */
+    std::vector<slam::WPoint3D> Odometry::SampleKeypoints(const std::vector<slam::WPoint3D> &frame,
+                                                          double sample_voxel_size) const {
+        std::vector<slam::WPoint3D> keypoints;
+        if (options_.sampling == sampling::GRID) {
+            grid_sampling(frame, keypoints, sample_voxel_size);
+        } else if (options_.sampling == sampling::ADAPTIVE) {
+            auto [begin, end] = slam::make_transform_collection(frame, slam::RawPointConversion());
+            auto indices = ct_icp::AdaptiveSamplePointsInGrid(begin, end, options_.adaptive_options);
+            keypoints.reserve(indices.size());
+            for (auto idx: indices)
+                keypoints.push_back(frame[idx]);
+        } else {
+            keypoints = frame;
+        }
+        return keypoints;
+    }
+
+/* -------------------------------------------------------------------------------------------------------------- */
+    void Odometry::AdvanceKeypointsSelection(const std::vector<slam::WPoint3D> &frame, Odometry::FrameInfo frame_info,
+                                             double sample_voxel_size, std::mt19937_64 &rng) const {
+        const bool kIsAtStartup = frame_info.registered_fid < options_.init_num_frames;
+        if (kIsAtStartup || options_.max_num_keypoints <= 0)
+            return;
+        // The keypoints are sampled from the raw points, which the attempts do not modify
+        const auto kNumKeypoints = SampleKeypoints(frame, sample_voxel_size).size();
+        if (kNumKeypoints > options_.max_num_keypoints) {
+            // The draws of the shuffle only depend on the number of elements
+            std::vector<size_t> indices(kNumKeypoints);
+            std::shuffle(indices.begin(), indices.end(), rng);
+        }
+    }
+
 /* -------------------------------------------------------------------------------------------------------------- */
     void Odometry::RobustRegistration(std::vector<slam::WPoint3D> &frame, Odometry::FrameInfo frame_info,
                                       Odometry::RegistrationSummary &registration_summary,
                                       AMotionModel *motion_model) {
+        if (options_.robust_num_parallel_attempts > 1) {
+            SpeculativeRobustRegistration(frame, frame_info, registration_summary, motion_model);
+            return;
+        }
 
         RobustRegistrationAttempt attempt(frame_info.registered_fid,
                                           options_,
                                           registration_summary.frame);
         attempt.summary = registration_summary;
-        attempt.summary.number_of_attempts = 0;
 
-        bool good_enough_registration = false;
+        int num_attempts = 0;
+        bool is_final_attempt = false;
         if (next_robust_level_ > 0)
             attempt.SetRobustLevel(next_robust_level_);
 
         do {
-            auto start_ct_icp = std::chrono::steady_clock::now();
             TryRegister(frame, frame_info, attempt.registration_options,
                         attempt.summary, attempt.sample_voxel_size, motion_model);
-
-            auto end_ct_icp = std::chrono::steady_clock::now();
-            std::chrono::duration<double> elapsed_icp = (end_ct_icp - start_ct_icp);
-            // Compute Modification of trajectory
-            if (attempt.index_frame > 0) {
-                auto kIndexFrame = attempt.index_frame;
-                attempt.summary.distance_correction = (attempt.CurrentFrame().BeginTr() -
-                                                       trajectory_[kIndexFrame - 1].EndTr()).norm();
-
-                auto norm = ((trajectory_[kIndexFrame - 1].EndQuat().normalized().toRotationMatrix() *
-                              attempt.CurrentFrame().EndQuat().normalized().toRotationMatrix().transpose()).trace() -
-                             1.) /
-                            2.;
-                if (std::abs(norm) > 1. + 1.e-8) {
-                    std::cout << "Not a rotation matrix " << norm << std::endl;
-                }
-
-                attempt.summary.relative_orientation = slam::AngularDistance(trajectory_[kIndexFrame - 1].end_pose.pose,
-                                                                             attempt.CurrentFrame().end_pose.pose);
-                attempt.summary.ego_orientation = attempt.summary.frame.EgoAngularDistance();
+            bool good_enough_registration = AssessAttempt(frame, attempt,
+                                                          options_.debug_print ? log_out_ : nullptr);
+            num_attempts++;
+            is_final_attempt = IsFinalRobustAttempt(good_enough_registration, num_attempts);
+
+            if (!is_final_attempt) {
+                auto &previous_frame = attempt.previous_frame;
+                double trans_distance = previous_frame.TranslationDistance(attempt.summary.frame);
+                double rot_distance = previous_frame.RotationDistance(attempt.summary.frame);
+
+                ODOMETRY_LOG_IF_AVAILABLE << "Registration Attempt n°"
+                                          << num_attempts
+                                          << " for frame n°" << attempt.index_frame
+                                          << " failed with message: "
+                                          << attempt.summary.error_message << std::endl;
+                ODOMETRY_LOG_IF_AVAILABLE << "Distance to previous trans : " << trans_distance <<
+                                          " rot distance " << rot_distance << std::endl;
+                attempt.IncreaseRobustnessLevel();
             }
+        } while (!is_final_attempt);
 
-            attempt.summary.relative_distance = (attempt.CurrentFrame().EndTr() -
-                                                 attempt.CurrentFrame().BeginTr()).norm();
+        SelectRobustAttempt(attempt, num_attempts, registration_summary);
+    }
 
-            good_enough_registration = AssessRegistration(frame, attempt.summary,
-                                                          options_.debug_print ? log_out_ : nullptr);
-            attempt.summary.number_of_attempts++;
-
-            if (!good_enough_registration) {
-                if (attempt.summary.number_of_attempts < options_.robust_num_attempts) {
-                    auto &previous_frame = attempt.previous_frame;
-                    double trans_distance = previous_frame.TranslationDistance(attempt.summary.frame);
-                    double rot_distance = previous_frame.RotationDistance(attempt.summary.frame);
-
-                    ODOMETRY_LOG_IF_AVAILABLE << "Registration Attempt n°"
-                                              << attempt.summary.number_of_attempts
-                                              << " for frame n°" << attempt.index_frame
-                                              << " failed with message: "
-                                              << attempt.summary.error_message << std::endl;
-                    ODOMETRY_LOG_IF_AVAILABLE << "Distance to previous trans : " << trans_distance <<
-                                              " rot distance " << rot_distance << std::endl;
-                    attempt.IncreaseRobustnessLevel();
-                } else {
-                    good_enough_registration = true;
-                }
-            }
-        } while (!good_enough_registration);
+/* -------------------------------------------------------------------------------------------------------------- */
+    bool Odometry::IsFinalRobustAttempt(bool is_good_enough, int num_attempts) const {
+        return is_good_enough || num_attempts >= options_.robust_num_attempts;
+    }
 
+/* -------------------------------------------------------------------------------------------------------------- */
+    void Odometry::SelectRobustAttempt(const RobustRegistrationAttempt &attempt, int num_attempts,
+                                       Odometry::RegistrationSummary &registration_summary) {
+        // When all the attempts failed the assessment, the last (and most robust) attempt is accepted,
+        // And keeps the success of its ICP
         registration_summary = attempt.summary;
+        registration_summary.number_of_attempts = num_attempts;
         if (registration_summary.number_of_attempts > options_.robust_num_attempts)
             robust_num_consecutive_failures_++;
         else
             robust_num_consecutive_failures_ = 0;
     }
 
+/* -------------------------------------------------------------------------------------------------------------- */
+    bool Odometry::AssessAttempt(const std::vector<slam::WPoint3D> &frame, RobustRegistrationAttempt &attempt,
+                                 std::ostream *log_stream) const {
+        // Compute Modification of trajectory
+        if (attempt.index_frame > 0) {
+            auto kIndexFrame = attempt.index_frame;
+            attempt.summary.distance_correction = (attempt.CurrentFrame().BeginTr() -
+                                                   trajectory_[kIndexFrame - 1].EndTr()).norm();
+
+            auto norm = ((trajectory_[kIndexFrame - 1].EndQuat().normalized().toRotationMatrix() *
+                          attempt.CurrentFrame().EndQuat().normalized().toRotationMatrix().transpose()).trace() -
+                         1.) /
+                        2.;
+            if (std::abs(norm) > 1. + 1.e-8) {
+                std::cout << "Not a rotation matrix " << norm << std::endl;
+            }
+
+            attempt.summary.relative_orientation = slam::AngularDistance(trajectory_[kIndexFrame - 1].end_pose.pose,
+                                                                         attempt.CurrentFrame().end_pose.pose);
+            attempt.summary.ego_orientation = attempt.summary.frame.EgoAngularDistance();
+        }
+
+        attempt.summary.relative_distance = (attempt.CurrentFrame().EndTr() -
+                                             attempt.CurrentFrame().BeginTr()).norm();
+
+        return AssessRegistration(frame, attempt.summary, log_stream);
+    }
+
+/* -------------------------------------------------------------------------------------------------------------- */
+    void Odometry::SpeculativeRobustRegistration(std::vector<slam::WPoint3D> &frame, Odometry::FrameInfo frame_info,
+                                                 Odometry::RegistrationSummary &registration_summary,
+                                                 AMotionModel *motion_model) {
+        const int kNumAttempts = std::max(options_.robust_num_attempts, 1);
+        const int kFirstLevel = std::max(next_robust_level_, 0);
+
+        int num_attempts = 0, selected_idx = -1;
+        std::vector<std::unique_ptr<RobustRegistrationAttempt>> attempts;
+        std::vector<std::vector<slam::WPoint3D>> frames;
+        std::vector<RegistrationContext> contexts;
+        while (selected_idx < 0) {
+            // Launch the next batch of robustness levels, each on its own registration context
+            const int kBatchSize = std::min(options_.robust_num_parallel_attempts, kNumAttempts - num_attempts);
+            // The attempts of a batch share the threads of the least-square solver
+            const int kNumThreadsPerAttempt = std::max(options_.ct_icp_options.ls_num_threads / kBatchSize, 1);
+            attempts.clear();
+            frames.assign(kBatchSize, frame);
+            contexts = std::vector<RegistrationContext>(kBatchSize);
+            std::unique_ptr<std::atomic<bool>[]> cancel_flags(new std::atomic<bool>[kBatchSize]);
+            std::vector<char> is_good_enough(kBatchSize, 0);
+            std::vector<std::exception_ptr> exceptions(kBatchSize);
+            std::vector<std::stringstream> assessment_logs(kBatchSize);
+            std::mt19937_64 rng = g_;
+            for (int k(0); k < kBatchSize; ++k) {
+                attempts.push_back(std::make_unique<RobustRegistrationAttempt>(frame_info.registered_fid,
+                                                                               options_,
+                                                                               registration_summary.frame));
+                attempts[k]->summary = registration_summary;
+                attempts[k]->SetRobustLevel(kFirstLevel + num_attempts + k);
+                attempts[k]->registration_options.ls_num_threads = kNumThreadsPerAttempt;
+                cancel_flags[k] = false;
+                // Each attempt samples from the state of the generator left by the previous serial attempts
+                contexts[k].rng = rng;
+                AdvanceKeypointsSelection(frame, frame_info, attempts[k]->sample_voxel_size, rng);
+                contexts[k].cancel_flag = &cancel_flags[k];
+                contexts[k].with_callbacks = false;
+            }
+
+            std::vector<std::thread> threads;
+            for (int k(0); k < kBatchSize; ++k) {
+                threads.emplace_back([&, k] {
+                    try {
+                        auto &attempt = *attempts[k];
+                        TryRegister(frames[k], frame_info, attempt.registration_options,
+                                    attempt.summary, attempt.sample_voxel_size, motion_model, &contexts[k]);
+                        if (cancel_flags[k] ||
+                            !AssessAttempt(frames[k], attempt, options_.debug_print ? &assessment_logs[k] : nullptr))
+                            return;
+                        is_good_enough[k] = 1;
+                        // The lowest level passing the assessment is selected: cancel the higher levels
+                        for (int j(k + 1); j < kBatchSize; ++j)
+                            cancel_flags[j] = true;
+                    } catch (...) {
+                        exceptions[k] = std::current_exception();
+                    }
+                });
+            }
+            for (auto &thread: threads)
+                thread.join();
+            for (auto &exception: exceptions) {
+                if (exception)
+                    std::rethrow_exception(exception);
+            }
+
+            // The attempts are decided in the order of their levels, as for the serial robust registration
+            for (int k(0); k < kBatchSize; ++k) {
+                ODOMETRY_LOG_IF_AVAILABLE << assessment_logs[k].str();
+                if (IsFinalRobustAttempt(is_good_enough[k], num_attempts + k + 1)) {
+                    selected_idx = k;
+                    break;
+                }
+                ODOMETRY_LOG_IF_AVAILABLE << "Registration Attempt n°" << num_attempts + k + 1
+                                          << " for frame n°" << attempts[k]->index_frame
+                                          << " failed with message: "
+                                          << attempts[k]->summary.error_message << std::endl;
+            }
+            num_attempts += selected_idx < 0 ? kBatchSize : selected_idx + 1;
+            // The next batch continues from the random state of the last attempt
+            g_ = rng;
+        }
+
+        // The callbacks are only called for the selected attempt (replayed after the attempts completed)
+        IterateOverCallbacks(OdometryCallback::BEFORE_ITERATION, frame, &contexts[selected_idx].initial_keypoints);
+
+        frame = std::move(frames[selected_idx]);
+        g_ = contexts[selected_idx].rng;
+        SelectRobustAttempt(*attempts[selected_idx], num_attempts, registration_summary);
+
+        // As in `TryRegister`, only a successful registration completes the iteration
+        if (registration_summary.success)
+            IterateOverCallbacks(OdometryCallback::ITERATION_COMPLETED, frame, &registration_summary.keypoints,
+                                 nullptr);
+    }
+
 /* -------------------------------------------------------------------------------------------------------------- */
     void Odometry::UpdateMap(Odometry::RegistrationSummary &summary, int registered_fid) {
         const double kMinDistancePoints = options_.min_distance_points;
@@ -933,6 +1192,14 @@ namespace ct_icp {
             }
         }
 
+        if (options_.localization_mode) {
+            // The prebuilt map is frozen (and possibly shared with other odometry instances)
+            // It is only notified of the motion (e.g. to prefetch the tiles of a TiledVoxelMap)
+            summary.points_added = false;
+            map_->UpdateTrajectory(std::vector<slam::Pose>{summary.frame.begin_pose, summary.frame.end_pose});
+            return;
+        }
+
         auto kIndexFrame = summary.frame.begin_pose.dest_frame_id;
         // Remove voxels too far from actual position of the vehicule
         const double kMaxDistance = options_.max_distance;
@@ -942,11 +1209,22 @@ namespace ct_icp {
 
             // TODO: Add the points from the original point cloud
             //Update Voxel Map+
-            auto pc_to_add = slam::PointCloud::WrapConstVector(summary.corrected_points,
-                                                               slam::WPoint3D::DefaultSchema(), "world_point");
+            // The map keeps the inserted frames: only the world points and timestamps are projected in an owned
+            // point cloud, whose buffers are shared by the map (wrapping the WPoint3D would copy the whole layout)
+            const auto &corrected_points = summary.corrected_points;
+            auto pc_to_add = slam::PointCloud::DefaultXYZPtr<double>();
+            pc_to_add->resize(corrected_points.size());
+            pc_to_add->AddDefaultTimestampsField();
+            pc_to_add->SetWorldPointsField(slam::PointCloud::Field{pc_to_add->GetXYZField()});
+            auto xyz = pc_to_add->XYZ<double>();
+            auto timestamps = pc_to_add->TimestampsProxy<double>();
+            for (auto idx(0); idx < corrected_points.size(); ++idx) {
+                xyz[idx] = corrected_points[idx].world_point;
+                timestamps[idx] = corrected_points[idx].Timestamp();
+            }
 
             std::vector<size_t> indices;
-            map_->InsertPointCloud(pc_to_add, {summary.frame.begin_pose, summary.frame.end_pose}, indices);
+            map_->InsertPointCloud(*pc_to_add, {summary.frame.begin_pose, summary.frame.end_pose}, indices);
             insertion_tracker_.InsertFrame(registered_fid);
         } else
             insertion_tracker_.SkipFrame();
@@ -955,7 +1233,8 @@ namespace ct_icp {
 /* -------------------------------------------------------------------------------------------------------------- */
     void Odometry::Reset() {
         trajectory_.clear();
-        map_->ClearMap();
+        if (!options_.localization_mode)
+            map_->ClearMap();
         neighborhood_strategy_ = options_.neighborhood_strategy->MakeStrategyFromOptions();
         registered_frames_ = 0;
         robust_num_consecutive_failures_ = 0;
@@ -969,8 +1248,11 @@ namespace ct_icp {
     void Odometry::Reset(const OdometryOptions &options) {
         Reset();
         options_ = options;
-        SLAM_CHECK_STREAM(options.map_options != nullptr, "The map options is not defined !");
-        map_ = options_.map_options->MakeMapFromOptions();
+        if (!options_.localization_mode) {
+            // In localization mode, the frozen map is kept
+            SLAM_CHECK_STREAM(options.map_options != nullptr, "The map options is not defined !");
+            map_ = MakeOdometryMap(options_);
+        }
         neighborhood_strategy_ = options_.neighborhood_strategy->MakeStrategyFromOptions();
     }
 
@@ -322,8 +322,16 @@ int main(int argc, char **argv) {
                                << seq_option.sequence_name << " / Number of Frames: " << seq_option.max_num_frames;
 
                 const auto kNumFrames = std::min(sequence_data->NumFrames(), size_t(seq_option.max_num_frames));
-                while (sequence_data->HasNext()) {
-                    auto next_frame = sequence_data->NextFrame();
+                // Frames are read by batches (concurrently for sequences of files)
+                const size_t kReadBatchSize = 16;
+                std::vector<ct_icp::ADatasetSequence::Frame> frames_batch;
+                size_t batch_idx(0);
+                while (batch_idx < frames_batch.size() || sequence_data->HasNext()) {
+                    if (batch_idx >= frames_batch.size()) {
+                        frames_batch = sequence_data->NextFrames(kReadBatchSize);
+                        batch_idx = 0;
+                    }
+                    auto next_frame = std::move(frames_batch[batch_idx++]);
 
                     {
                         auto begin = std::chrono::system_clock::now();
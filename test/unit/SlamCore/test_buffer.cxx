@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <SlamCore/data/buffer_collection.h>
+#include <SlamCore/data/slab_pool.h>
 #include "SlamCore/types.h"
 
 struct CustomItem {
@@ -172,4 +173,73 @@ TEST(ArrayBuffer, WPoint3D) {
         ASSERT_EQ((points[i].RawPoint() - buffer.At<slam::WPoint3D>(i).RawPoint()).norm(), 0.);
     }
 
-}
\ No newline at end of file
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+// Test the capacity management of the VectorBuffer, and the recycling of its memory by a pool
+TEST(VectorBuffer, CapacityAndPool) {
+    slam::VectorBuffer buffer(slam::WPoint3D::DefaultSchema(), sizeof(slam::WPoint3D));
+    buffer.Reserve(1000);
+    ASSERT_GE(buffer.Capacity(), 1000);
+    ASSERT_EQ(buffer.NumItems(), 0);
+    buffer.Resize(1);
+    auto *data_ptr = buffer.view_data_ptr;
+    for (auto i(1); i < 1000; ++i)
+        buffer.Resize(i + 1);
+    ASSERT_EQ(buffer.view_data_ptr, data_ptr);
+
+    auto pool = std::make_shared<slam::BufferPool>();
+    char *recycled_ptr = nullptr;
+    {
+        slam::VectorBuffer pooled_buffer(slam::WPoint3D::DefaultSchema(), sizeof(slam::WPoint3D), pool);
+        pooled_buffer.Resize(500);
+        recycled_ptr = pooled_buffer.view_data_ptr;
+    }
+    ASSERT_EQ(pool->NumPooledBuffers(), 1);
+    ASSERT_EQ(pool->NumAllocated(), 1);
+    {
+        // A buffer of a similar size reuses the memory released
+        slam::VectorBuffer pooled_buffer(slam::WPoint3D::DefaultSchema(), sizeof(slam::WPoint3D), pool);
+        pooled_buffer.Resize(400);
+        ASSERT_EQ(pooled_buffer.view_data_ptr, recycled_ptr);
+        ASSERT_EQ(pool->NumRecycled(), 1);
+        ASSERT_EQ(pool->NumPooledBuffers(), 0);
+    }
+    ASSERT_EQ(pool->NumPooledBuffers(), 1);
+}
+
+TEST(SlabPool, RecycleBlocks) {
+    slam::SlabPool::Options options;
+    options.slab_size = 4096;
+    slam::SlabPool pool(options);
+    ASSERT_EQ(pool.BlockSize(1), 64);
+    ASSERT_EQ(pool.BlockSize(65), 96);
+    ASSERT_EQ(pool.BlockSize(100), 128);
+    ASSERT_EQ(pool.BlockSize(2000), 2000); // Larger than a quarter of a slab
+
+    // Small blocks are carved from the same slab
+    std::vector<void *> blocks;
+    for (auto i(0); i < 10; ++i)
+        blocks.push_back(pool.Allocate(80));
+    ASSERT_EQ(pool.GetStats().num_slabs, 1);
+    ASSERT_EQ(pool.GetStats().allocated_bytes, 10 * 96);
+    ASSERT_EQ(pool.GetStats().requested_bytes, 10 * 80);
+
+    // A released block is recycled by the next allocation of its size class
+    pool.Deallocate(blocks[3], 80);
+    ASSERT_EQ(pool.Allocate(90), blocks[3]);
+    ASSERT_EQ(pool.GetStats().num_recycled, 1);
+
+    {
+        // The vectors allocated from the pool return their memory to the pool
+        std::vector<double, slam::SlabAllocator<double>> values{slam::SlabAllocator<double>(&pool)};
+        for (auto i(0); i < 100; ++i)
+            values.push_back(double(i));
+        ASSERT_EQ(values[99], 99.);
+        ASSERT_EQ(pool.GetStats().num_blocks, 11);
+    }
+    ASSERT_EQ(pool.GetStats().num_blocks, 10);
+    ASSERT_EQ(pool.GetStats().requested_bytes, 9 * 80 + 90);
+    ASSERT_GT(pool.GetStats().Fragmentation(), 0.);
+    ASSERT_LT(pool.GetStats().Fragmentation(), 1.);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <SlamCore/data/buffer_collection.h>
+#include <SlamCore/data/schema_converter.h>
 
 
 TEST(BufferCollection, collection_buffer_constructor) {
@@ -152,4 +153,108 @@ TEST(BufferCollection, resizable_buffers) {
         return acc + mat.norm();
     });
     ASSERT_GE(result, 0.);
-}
\ No newline at end of file
+}
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(BufferCollection, SchemaConverter) {
+    struct FloatPoint {
+        float x, y, z;
+        double timestamp;
+    };
+    auto float_schema = slam::ItemSchema::Builder(sizeof(FloatPoint))
+            .AddElement("vertex", offsetof(FloatPoint, x))
+            .AddScalarProperty<float>("vertex", "x", 0)
+            .AddScalarProperty<float>("vertex", "y", sizeof(float))
+            .AddScalarProperty<float>("vertex", "z", 2 * sizeof(float))
+            .AddElement("timestamp", offsetof(FloatPoint, timestamp))
+            .AddScalarProperty<double>("timestamp", "t", 0)
+            .Build();
+    auto double_schema = slam::ItemSchema::Builder(4 * sizeof(double))
+            .AddElement("timestamp", 0)
+            .AddScalarProperty<double>("timestamp", "t", 0)
+            .AddElement("vertex", sizeof(double))
+            .AddScalarProperty<double>("vertex", "x", 0)
+            .AddScalarProperty<double>("vertex", "y", sizeof(double))
+            .AddScalarProperty<double>("vertex", "z", 2 * sizeof(double))
+            .Build();
+
+    // Identical schemas are copied with a single memcpy
+    auto identity = slam::SchemaConverter::Get(float_schema, float_schema);
+    ASSERT_TRUE(identity->IsIdentity());
+    ASSERT_EQ(identity->Operations().size(), 1);
+    ASSERT_EQ(slam::SchemaConverter::Get(float_schema, float_schema), identity);
+
+    auto converter = slam::SchemaConverter::Get(float_schema, double_schema);
+    ASSERT_TRUE(converter->IsComplete());
+    ASSERT_FALSE(converter->IsIdentity());
+    // One memcpy for the timestamps, and one conversion of 3 scalars for XYZ
+    ASSERT_EQ(converter->Operations().size(), 2);
+
+    const size_t n = 10;
+    auto float_buffer = std::make_unique<slam::VectorBuffer>(std::move(float_schema), sizeof(FloatPoint));
+    float_buffer->Resize(n);
+    auto *points = reinterpret_cast<FloatPoint *>(float_buffer->view_data_ptr);
+    for (auto i(0); i < n; ++i)
+        points[i] = {float(i), float(2 * i), float(3 * i), 0.1 * i};
+    slam::BufferCollection float_collection(std::move(float_buffer));
+
+    slam::BufferCollection double_collection(std::make_unique<slam::VectorBuffer>(
+            std::move(double_schema), 4 * sizeof(double)));
+    double_collection.Append(float_collection);
+    double_collection.Append(float_collection.SelectItems({9, 0}));
+    ASSERT_EQ(double_collection.NumItemsPerBuffer(), n + 2);
+
+    auto *values = reinterpret_cast<const double *>(double_collection.GetItemInfo(0).parent_buffer->view_data_ptr);
+    for (auto i(0); i < n + 2; ++i) {
+        auto idx = i < n ? i : (i == n ? 9 : 0);
+        ASSERT_EQ(values[4 * i], 0.1 * idx);
+        ASSERT_EQ(values[4 * i + 1], double(idx));
+        ASSERT_EQ(values[4 * i + 2], double(2 * idx));
+        ASSERT_EQ(values[4 * i + 3], double(3 * idx));
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(BufferCollection, AppendMismatchedSchema) {
+    auto MakeCollection = [](const std::string &element, std::array<std::string, 3> names, bool is_float) {
+        auto builder = slam::ItemSchema::Builder(3 * sizeof(float)).AddElement(element, 0);
+        for (auto idx(0); idx < 3; ++idx) {
+            if (is_float)
+                builder.AddScalarProperty<float>(std::string(element), std::string(names[idx]), idx * sizeof(float));
+            else
+                builder.AddScalarProperty<int>(std::string(element), std::string(names[idx]), idx * sizeof(int));
+        }
+        auto buffer = std::make_unique<slam::VectorBuffer>(builder.Build(), 3 * sizeof(float));
+        buffer->Resize(4);
+        return slam::BufferCollection(std::move(buffer));
+    };
+    auto xyz = MakeCollection("vertex", {"x", "y", "z"}, true);
+
+    // Schemas of the same item size, but with different properties, are not copied as raw bytes
+    ASSERT_THROW(xyz.Append(MakeCollection("vertex", {"a", "b", "c"}, false)), std::runtime_error);
+    ASSERT_THROW(xyz.Append(MakeCollection("rgb", {"r", "g", "b"}, false)), std::runtime_error);
+    ASSERT_EQ(xyz.NumItemsPerBuffer(), 4);
+
+    // Schemas with the same layout are copied as raw bytes, whatever their names
+    xyz.Append(MakeCollection("normal", {"nx", "ny", "nz"}, true));
+    ASSERT_EQ(xyz.NumItemsPerBuffer(), 8);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(BufferCollection, DetachKeepsPool) {
+    auto pool = std::make_shared<slam::BufferPool>();
+    auto buffer = std::make_unique<slam::VectorBuffer>(
+            slam::BuilderFromSingleElementData<Eigen::Vector3d>("xyz", {{"x", "y", "z"}}).Build(),
+            sizeof(Eigen::Vector3d), pool);
+    buffer->Resize(100);
+    slam::BufferCollection collection(std::move(buffer));
+    auto copy = collection.ShallowCopy();
+    ASSERT_TRUE(copy.IsShared(0));
+
+    // The first write detaches the buffer, allocated from the pool of the shared buffer
+    copy.element<Eigen::Vector3d>("xyz")[0] = Eigen::Vector3d::Ones();
+    ASSERT_FALSE(copy.IsShared(0));
+    auto *detached = dynamic_cast<slam::VectorBuffer *>(copy.GetItemInfo(0).parent_buffer);
+    ASSERT_NE(detached, nullptr);
+    ASSERT_EQ(detached->Pool(), pool);
+    ASSERT_EQ(pool->NumAllocated(), 2);
+}
@@ -4,6 +4,7 @@
 #include "SlamCore/types.h"
 #include "SlamCore/generic_tools.h"
 #include "SlamCore/io.h"
+#include "SlamCore/binary_trajectory.h"
 #include "SlamCore/pointcloud.h"
 
 /* ------------------------------------------------------------------------------------------------------------------ */
@@ -89,4 +90,154 @@ TEST(io, Read_Write_Poses_As_PLY) {
         ASSERT_EQ(pose.ref_frame_id, copy.ref_frame_id);
         ASSERT_LE((pose.pose.Matrix() - copy.pose.Matrix()).cwiseAbs().maxCoeff(), 1.e-10);
     }
-}
\ No newline at end of file
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+// Write / Append / Read poses in a binary trajectory file
+TEST(io, Read_Write_Append_Binary_Trajectory) {
+    const size_t kNumPoses = 1000;
+    std::vector<slam::Pose> poses(kNumPoses);
+    for (auto i(0); i < kNumPoses; ++i) {
+        auto &pose = poses[i];
+        pose.pose.quat = Eigen::Quaterniond::UnitRandom();
+        pose.pose.tr = Eigen::Vector3d::Random();
+        pose.dest_frame_id = static_cast<slam::frame_id_t >(i);
+        pose.dest_timestamp = 0.1 * i;
+        pose.ref_frame_id = static_cast<slam::frame_id_t >(rand());
+        pose.ref_timestamp = (double) rand() / RAND_MAX;
+    }
+
+    auto file_path = (fs::temp_directory_path() / "test_binary_trajectory.bin").string();
+    std::vector<slam::Pose> first_half(poses.begin(), poses.begin() + kNumPoses / 2);
+    std::vector<slam::Pose> second_half(poses.begin() + kNumPoses / 2, poses.end());
+    slam::SavePosesBinary(file_path, first_half);
+    slam::AppendPosesBinary(file_path, second_half);
+
+    auto copy_poses = slam::ReadPosesBinary(file_path);
+    ASSERT_EQ(copy_poses.size(), kNumPoses);
+    for (auto i(0); i < kNumPoses; ++i) {
+        auto &pose = poses[i];
+        auto &copy = copy_poses[i];
+        ASSERT_EQ(pose.dest_timestamp, copy.dest_timestamp);
+        ASSERT_EQ(pose.dest_frame_id, copy.dest_frame_id);
+        ASSERT_EQ(pose.ref_timestamp, copy.ref_timestamp);
+        ASSERT_EQ(pose.ref_frame_id, copy.ref_frame_id);
+        ASSERT_EQ(pose.pose.quat.coeffs(), copy.pose.quat.coeffs());
+        ASSERT_EQ(pose.pose.tr, copy.pose.tr);
+    }
+
+    // Random access by index and timestamp
+    slam::BinaryTrajectoryReader reader(file_path);
+    ASSERT_TRUE(reader.IsSortedByTimestamp());
+    ASSERT_EQ(reader.PoseAt(742).dest_frame_id, 742);
+    for (auto i(0); i < kNumPoses; ++i) {
+        auto idx = reader.LowerBoundTimestamp(0.1 * i - 0.05);
+        ASSERT_TRUE(idx.has_value());
+        ASSERT_EQ(*idx, i);
+    }
+    ASSERT_FALSE(reader.LowerBoundTimestamp(0.1 * kNumPoses).has_value());
+    fs::remove(file_path);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+// Recover a binary trajectory without footer, and convert it to the other formats
+TEST(io, Recover_Convert_Binary_Trajectory) {
+    const size_t kNumPoses = 500;
+    std::vector<slam::Pose> poses(kNumPoses);
+    for (auto i(0); i < kNumPoses; ++i) {
+        auto &pose = poses[i];
+        pose.pose.quat = Eigen::Quaterniond::UnitRandom();
+        pose.pose.tr = Eigen::Vector3d::Random();
+        pose.dest_frame_id = static_cast<slam::frame_id_t >(i);
+        pose.dest_timestamp = 0.1 * i;
+    }
+    auto file_path = (fs::temp_directory_path() / "test_recover_trajectory.bin").string();
+    {
+        slam::BinaryTrajectoryWriter writer(file_path, false, 16);
+        writer.Append(poses);
+    }
+
+    // Without its footer, the index left after the records must not be read as records
+    const auto kFileSize = fs::file_size(file_path);
+    fs::resize_file(file_path, kFileSize - sizeof(slam::binary_trajectory::Footer));
+    {
+        slam::BinaryTrajectoryWriter writer(file_path, true, 16);
+        ASSERT_EQ(writer.NumRecords(), kNumPoses);
+        writer.Append(poses.back());
+    }
+    ASSERT_EQ(fs::file_size(file_path), kFileSize + sizeof(slam::binary_trajectory::PoseRecord));
+    slam::BinaryTrajectoryReader reader(file_path);
+    ASSERT_EQ(reader.NumPoses(), kNumPoses + 1);
+    ASSERT_EQ(reader.PoseAt(kNumPoses).dest_frame_id, kNumPoses - 1);
+
+    // The conversions with the PLY format are lossless
+    auto ply_path = (fs::temp_directory_path() / "test_recover_trajectory.ply").string();
+    auto copy_path = (fs::temp_directory_path() / "test_recover_trajectory_copy.bin").string();
+    slam::ConvertTrajectoryFile(file_path, ply_path);
+    slam::ConvertTrajectoryFile(ply_path, copy_path);
+    auto copy_poses = slam::ReadPosesBinary(copy_path);
+    ASSERT_EQ(copy_poses.size(), kNumPoses + 1);
+    for (auto i(0); i < kNumPoses; ++i) {
+        ASSERT_EQ(poses[i].dest_timestamp, copy_poses[i].dest_timestamp);
+        ASSERT_EQ(poses[i].dest_frame_id, copy_poses[i].dest_frame_id);
+        ASSERT_EQ(poses[i].pose.quat.coeffs(), copy_poses[i].pose.quat.coeffs());
+        ASSERT_EQ(poses[i].pose.tr, copy_poses[i].pose.tr);
+    }
+    fs::remove(file_path);
+    fs::remove(ply_path);
+    fs::remove(copy_path);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+// Convert a trajectory between the binary, PLY and KITTI formats and back
+TEST(io, Convert_Trajectory_File) {
+    const size_t kNumPoses = 200;
+    std::vector<slam::Pose> poses(kNumPoses);
+    for (auto i(0); i < kNumPoses; ++i) {
+        auto &pose = poses[i];
+        pose.pose.quat = Eigen::Quaterniond::UnitRandom();
+        pose.pose.tr = Eigen::Vector3d::Random();
+        // The frame ids and timestamps regenerated when reading the KITTI format
+        pose.dest_frame_id = static_cast<slam::frame_id_t >(i);
+        pose.dest_timestamp = static_cast<double>(i) * 0.1;
+        pose.ref_frame_id = static_cast<slam::frame_id_t >(rand());
+        pose.ref_timestamp = (double) rand() / RAND_MAX;
+    }
+    auto file_path = (fs::temp_directory_path() / "test_convert_trajectory.bin").string();
+    auto ply_path = (fs::temp_directory_path() / "test_convert_trajectory.ply").string();
+    auto kitti_path = (fs::temp_directory_path() / "test_convert_trajectory.txt").string();
+    auto copy_path = (fs::temp_directory_path() / "test_convert_trajectory_copy.bin").string();
+    slam::SavePosesBinary(file_path, poses);
+
+    // Binary -> PLY -> Binary is lossless
+    slam::ConvertTrajectoryFile(file_path, ply_path);
+    slam::ConvertTrajectoryFile(ply_path, copy_path);
+    auto copy_poses = slam::ReadPosesBinary(copy_path);
+    ASSERT_EQ(copy_poses.size(), kNumPoses);
+    for (auto i(0); i < kNumPoses; ++i) {
+        auto &pose = poses[i];
+        auto &copy = copy_poses[i];
+        ASSERT_EQ(pose.dest_timestamp, copy.dest_timestamp);
+        ASSERT_EQ(pose.dest_frame_id, copy.dest_frame_id);
+        ASSERT_EQ(pose.ref_timestamp, copy.ref_timestamp);
+        ASSERT_EQ(pose.ref_frame_id, copy.ref_frame_id);
+        ASSERT_EQ(pose.pose.quat.coeffs(), copy.pose.quat.coeffs());
+        ASSERT_EQ(pose.pose.tr, copy.pose.tr);
+    }
+
+    // Binary -> KITTI -> Binary keeps the pose matrices
+    slam::ConvertTrajectoryFile(file_path, kitti_path);
+    slam::ConvertTrajectoryFile(kitti_path, copy_path);
+    copy_poses = slam::ReadPosesBinary(copy_path);
+    ASSERT_EQ(copy_poses.size(), kNumPoses);
+    for (auto i(0); i < kNumPoses; ++i) {
+        ASSERT_EQ(poses[i].dest_timestamp, copy_poses[i].dest_timestamp);
+        ASSERT_EQ(poses[i].dest_frame_id, copy_poses[i].dest_frame_id);
+        ASSERT_LE((poses[i].Matrix() - copy_poses[i].Matrix()).norm(), 1.e-9);
+    }
+
+    fs::remove(file_path);
+    fs::remove(ply_path);
+    fs::remove(kitti_path);
+    fs::remove(copy_path);
+}
@@ -0,0 +1,50 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <SlamCore/concurrent/lru_cache.h>
+
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(lru_cache, eviction) {
+    slam::lru_cache<int, std::string> cache(2);
+    cache.put(0, "zero");
+    cache.put(1, "one");
+    ASSERT_EQ(cache.size(), 2);
+
+    // Access 0 so that 1 is the least recently used
+    ASSERT_EQ(*cache.get(0), "zero");
+    cache.put(2, "two");
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_TRUE(cache.contains(0));
+    ASSERT_FALSE(cache.contains(1));
+    ASSERT_TRUE(cache.contains(2));
+    ASSERT_FALSE(cache.get(1).has_value());
+    ASSERT_EQ(cache.num_hits(), 1);
+    ASSERT_EQ(cache.num_misses(), 1);
+
+    cache.set_max_capacity(1);
+    ASSERT_EQ(cache.size(), 1);
+    ASSERT_TRUE(cache.contains(2));
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(lru_cache, thread_safe) {
+    slam::lru_cache<int, int> cache(50);
+    std::vector<std::thread> threads;
+    for (int thread_id(0); thread_id < 4; ++thread_id) {
+        threads.emplace_back([&cache, thread_id] {
+            for (int i(0); i < 1000; ++i) {
+                int key = (i * 7 + thread_id) % 100;
+                auto value = cache.get(key);
+                if (value)
+                    ASSERT_EQ(*value, key * 2);
+                else
+                    cache.put(key, key * 2);
+            }
+        });
+    }
+    for (auto &thread: threads)
+        thread.join();
+    ASSERT_LE(cache.size(), 50);
+}
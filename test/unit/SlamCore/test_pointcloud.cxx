@@ -253,6 +253,77 @@ TEST(PointCloud, Append) {
     }
 }
 
+/* ------------------------------------------------------------------------------------------------------------------ */
+// Test the copy-on-write semantic of shallow copies, and the projections on a subset of elements
+TEST(PointCloud, ShallowCopy) {
+    auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+    pc->resize(50);
+    pc->AddDefaultTimestampsField();
+    pc->AddDefaultIntensityField();
+    {
+        auto xyz = pc->XYZ<double>();
+        auto timestamps = pc->Timestamps<double>();
+        for (auto idx(0); idx < pc->size(); idx++) {
+            xyz[idx] = Eigen::Vector3d::Constant(idx);
+            timestamps[idx] = 0.1 * idx;
+        }
+    }
+
+    auto copy = pc->ShallowCopyPtr();
+    ASSERT_TRUE(copy->GetCollection().IsShared(0));
+    ASSERT_EQ(copy->GetCollection().GetItemInfo(0).parent_buffer, pc->GetCollection().GetItemInfo(0).parent_buffer);
+
+    // Const accesses do not copy the buffers
+    const auto &const_copy = *copy;
+    Eigen::Vector3d point = const_copy.XYZConst<double>()[10];
+    ASSERT_EQ(point.x(), 10.);
+    ASSERT_TRUE(copy->GetCollection().IsShared(0));
+
+    // The first write detaches the buffer
+    copy->XYZ<double>()[10] = Eigen::Vector3d::Zero();
+    ASSERT_FALSE(copy->GetCollection().IsShared(0));
+    ASSERT_FALSE(pc->GetCollection().IsShared(0));
+    point = pc->XYZConst<double>()[10];
+    ASSERT_EQ(point.x(), 10.);
+    ASSERT_TRUE(copy->GetCollection().IsShared(1));
+
+    // Projection on the timestamps (the intensity is dropped)
+    auto projected = pc->SelectElements({"timestamps"});
+    ASSERT_EQ(projected->size(), pc->size());
+    ASSERT_TRUE(projected->HasTimestamps());
+    ASSERT_FALSE(projected->HasIntensity());
+    ASSERT_FALSE(projected->GetCollection().HasElement("intensity"));
+
+    std::vector<size_t> indices = {3, 7, 42};
+    auto selected = pc->SelectPoints(indices, {"timestamps"});
+    ASSERT_EQ(selected->size(), indices.size());
+    ASSERT_FALSE(selected->GetCollection().HasElement("intensity"));
+    const auto &const_selected = *selected;
+    auto timestamps = const_selected.Timestamps<double>();
+    auto xyz = const_selected.XYZConst<double>();
+    for (auto idx(0); idx < indices.size(); ++idx) {
+        ASSERT_EQ(timestamps[idx], 0.1 * indices[idx]);
+        Eigen::Vector3d _point = xyz[idx];
+        ASSERT_EQ(_point.x(), double(indices[idx]));
+    }
+
+    // The shallow copies of a point cloud wrapping a vector do not share the vector (it can be freed)
+    auto vector_points = std::make_unique<std::vector<slam::WPoint3D>>(10);
+    for (auto idx(0); idx < vector_points->size(); ++idx)
+        (*vector_points)[idx].world_point = Eigen::Vector3d::Constant(idx);
+    auto wrapped = slam::PointCloud::WrapConstVector(*vector_points, slam::WPoint3D::DefaultSchema(),
+                                                     "world_point");
+    auto wrapped_copy = wrapped.ShallowCopyPtr();
+    ASSERT_FALSE(wrapped_copy->GetCollection().IsShared(0));
+    vector_points.reset();
+    const auto &const_wrapped_copy = *wrapped_copy;
+    auto wrapped_xyz = const_wrapped_copy.XYZConst<double>();
+    for (auto idx(0); idx < wrapped_copy->size(); ++idx) {
+        Eigen::Vector3d _point = wrapped_xyz[idx];
+        ASSERT_EQ(_point.x(), double(idx));
+    }
+}
+
 /* ------------------------------------------------------------------------------------------------------------------ */
 // Test Adding defaults fields to the point cloud
 TEST(PointCloud, DefaultFields) {
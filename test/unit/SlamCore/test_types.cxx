@@ -2,8 +2,41 @@
 #include <Eigen/Dense>
 #include <SlamCore/types.h>
 #include <ceres/ceres.h>
+#include <SlamCore/timer.h>
+#include <tsl/robin_map.h>
 #include "test_utils.h"
 
+#include <iostream>
+#include <set>
+
+namespace {
+
+    // The previous voxel hash `x * P1 + y * P2 + z * P3`, replaced by the mixed key hash
+    struct PreviousVoxelHash {
+        size_t operator()(const slam::Voxel &voxel) const {
+            return size_t(voxel.x) * 73856093 + size_t(voxel.y) * 19349669 + size_t(voxel.z) * 83492791;
+        }
+    };
+
+    // A dense block of voxels, a ground plane, and a block of voxels sampled with a stride of 16
+    std::vector<std::vector<slam::Voxel>> VoxelPatterns() {
+        std::vector<std::vector<slam::Voxel>> patterns(3);
+        for (int x(-32); x < 32; ++x) {
+            for (int y(-32); y < 32; ++y) {
+                for (int z(-8); z < 8; ++z) {
+                    patterns[0].emplace_back(x, y, z);
+                    patterns[2].emplace_back(16 * x, 16 * y, 16 * z);
+                }
+            }
+        }
+        for (int x(0); x < 256; ++x)
+            for (int y(0); y < 256; ++y)
+                patterns[1].emplace_back(x, y, 0);
+        return patterns;
+    }
+
+}
+
 TEST(test_types_h, pose) {
 
     auto random = slam::SE3::Random();
@@ -84,4 +117,94 @@ TEST(SE3, Isometry) {
     Eigen::Vector3d b = new_pose * point;
     auto invalid_index = slam::kInvalidIndex;
     ASSERT_TRUE(test::is_equal(a, b, 1.e-10));
-}
\ No newline at end of file
+}
+
+TEST(Voxel, CoordinatesAndKeys) {
+    // Voxels are the cells [k, k+1) * voxel_size, including around the origin
+    ASSERT_EQ(slam::Voxel::Coordinates(Eigen::Vector3d(0.25, -0.25, -1.), 0.5), slam::Voxel(0, -1, -2));
+    ASSERT_EQ(slam::Voxel::Coordinates(Eigen::Vector3d(-0.75, 0.75, 1.e-6), 0.5), slam::Voxel(-2, 1, 0));
+
+    std::vector<slam::Voxel> voxels = {
+            {0, 0, 0}, {-1, -1, -1}, {1, -2, 3},
+            {slam::Voxel::kMinCoordinate, slam::Voxel::kMaxCoordinate, 0},
+            {slam::Voxel::kMaxCoordinate, slam::Voxel::kMinCoordinate, -123456},
+            {40000, -40000, 70000} // Out of the range of a `short`
+    };
+    std::set<uint64_t> keys;
+    for (auto &voxel: voxels) {
+        auto key = voxel.Key();
+        ASSERT_EQ(key >> (3 * slam::Voxel::kNumBitsPerAxis), 0);
+        ASSERT_EQ(slam::Voxel::FromKey(key), voxel);
+        keys.insert(key);
+    }
+    ASSERT_EQ(keys.size(), voxels.size());
+}
+
+TEST(Voxel, HashProbeLengths) {
+    // Inserts voxels in an open-addressing table with linear probing at a load factor of 0.5, and compares the
+    // mean probe length of the mixed key hash with the previous `x * P1 + y * P2 + z * P3` hash
+    auto mean_probe_length = [](auto hash, const std::vector<slam::Voxel> &voxels) {
+        const size_t capacity = 1 << 17, mask = capacity - 1;
+        std::vector<char> occupied(capacity, 0);
+        size_t num_probes = 0;
+        for (auto &voxel: voxels) {
+            auto slot = hash(voxel) & mask;
+            num_probes++;
+            while (occupied[slot]) {
+                slot = (slot + 1) & mask;
+                num_probes++;
+            }
+            occupied[slot] = 1;
+        }
+        return double(num_probes) / double(voxels.size());
+    };
+    auto mixed_hash = [](const slam::Voxel &voxel) { return std::hash<slam::Voxel>()(voxel); };
+    auto previous_hash = PreviousVoxelHash();
+
+    auto patterns = VoxelPatterns();
+    double max_mixed = 0., max_previous = 0.;
+    for (auto &voxels: patterns) {
+        const double mixed = mean_probe_length(mixed_hash, voxels);
+        const double previous = mean_probe_length(previous_hash, voxels);
+        // For a uniform hash, the mean probe length at a load factor of 0.5 is 1.5
+        ASSERT_LT(mixed, 1.6);
+        max_mixed = std::max(max_mixed, mixed);
+        max_previous = std::max(max_previous, previous);
+    }
+    ASSERT_LT(max_mixed, max_previous);
+}
+
+TEST(Voxel, HashInsertAndLookupTimings) {
+    // Times the insertion and the lookup of the voxels of each pattern in a `tsl::robin_map` (the hash map of the
+    // voxel maps) with the mixed key hash and with the previous hash.
+    // The timings are only reported: they depend on the machine, so the test only checks the lookups
+    auto time_map = [](auto hash, const std::vector<slam::Voxel> &voxels,
+                       slam::Timer &timer, const std::string &name) {
+        tsl::robin_map<slam::Voxel, size_t, decltype(hash)> map(0, hash);
+        {
+            slam::Timer::Ticker ticker(timer, name + " insert");
+            for (size_t idx(0); idx < voxels.size(); ++idx)
+                map.insert({voxels[idx], idx});
+        }
+        size_t num_found = 0;
+        {
+            slam::Timer::Ticker ticker(timer, name + " lookup");
+            for (int repeat(0); repeat < 4; ++repeat)
+                for (auto &voxel: voxels)
+                    num_found += map.count(voxel);
+        }
+        return num_found;
+    };
+
+    auto patterns = VoxelPatterns();
+    const std::vector<std::string> pattern_names = {"dense block", "ground plane", "strided block"};
+    slam::Timer timer;
+    for (size_t idx(0); idx < patterns.size(); ++idx) {
+        auto &voxels = patterns[idx];
+        ASSERT_EQ(time_map(std::hash<slam::Voxel>(), voxels, timer, pattern_names[idx] + " mixed"),
+                  4 * voxels.size());
+        ASSERT_EQ(time_map(PreviousVoxelHash(), voxels, timer, pattern_names[idx] + " previous"),
+                  4 * voxels.size());
+    }
+    timer.WriteMessage(std::cout, slam::Timer::MILLISECONDS);
+}
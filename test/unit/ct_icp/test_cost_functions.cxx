@@ -103,3 +103,84 @@ TEST(CostFunctions, CT_POINT_TO_PLANE) {
                   &residual);
     ASSERT_GE(std::abs(residual), 1.e-3);
 }
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+// Test the bundled point-to-plane residuals (residuals and analytic jacobians)
+TEST(CostFunctions, PointToPlaneBundle) {
+    const int kNumPoints = 600;
+    auto pose_a = slam::SE3::Random();
+    auto pose_b = pose_a * slam::SE3(Eigen::Quaterniond(Eigen::AngleAxisd(0.02, Eigen::Vector3d::UnitZ())),
+                                     Eigen::Vector3d(0.3, 0.1, 0.));
+
+    for (auto loss_sigma: {-1., 0.5}) {
+        std::unique_ptr<ceres::LossFunction> loss = nullptr;
+        if (loss_sigma > 0.)
+            loss = std::make_unique<ct_icp::TruncatedLoss>(loss_sigma);
+        ct_icp::PointToPlaneBundle bundle(ct_icp::CONTINUOUS_TIME, std::move(loss), 2);
+        std::vector<double> weights(kNumPoints);
+        std::vector<ct_icp::CTFunctor<ct_icp::FunctorPointToPlane>> functors;
+        for (int i(0); i < kNumPoints; ++i) {
+            slam::NeighborhoodDescription<double> description;
+            description.normal = Eigen::Vector3d::Random().normalized();
+            Eigen::Vector3d reference = Eigen::Vector3d::Random() * 10.;
+            Eigen::Vector3d raw_point = Eigen::Vector3d::Random() * 10.;
+            double alpha = double(i) / kNumPoints, weight = 0.5 + 0.5 * std::abs(std::sin(i));
+            bundle.AddResidual(reference, raw_point, description.normal, weight, alpha);
+            functors.emplace_back(alpha, reference, raw_point, description, weight);
+        }
+        ASSERT_EQ(bundle.num_residuals(), kNumPoints);
+
+        std::vector<double> params{pose_a.quat.x(), pose_a.quat.y(), pose_a.quat.z(), pose_a.quat.w(),
+                                   pose_a.tr.x(), pose_a.tr.y(), pose_a.tr.z(),
+                                   pose_b.quat.x(), pose_b.quat.y(), pose_b.quat.z(), pose_b.quat.w(),
+                                   pose_b.tr.x(), pose_b.tr.y(), pose_b.tr.z()};
+        const int offsets[4] = {0, 4, 7, 11}, sizes[4] = {4, 3, 4, 3};
+        auto evaluate = [&](std::vector<double> &x, std::vector<double> &residuals,
+                            std::vector<std::vector<double>> *jacobians) {
+            const double *parameters[4] = {&x[0], &x[4], &x[7], &x[11]};
+            residuals.resize(kNumPoints);
+            double *jacobians_ptr[4] = {nullptr, nullptr, nullptr, nullptr};
+            if (jacobians) {
+                jacobians->resize(4);
+                for (int b(0); b < 4; ++b) {
+                    (*jacobians)[b].resize(kNumPoints * sizes[b]);
+                    jacobians_ptr[b] = (*jacobians)[b].data();
+                }
+            }
+            return bundle.Evaluate(parameters, residuals.data(), jacobians ? jacobians_ptr : nullptr);
+        };
+
+        std::vector<double> residuals;
+        std::vector<std::vector<double>> jacobians;
+        ASSERT_TRUE(evaluate(params, residuals, &jacobians));
+
+        // Without loss, the residuals match the slerp interpolation of the CT functor
+        if (loss_sigma < 0.) {
+            for (int i(0); i < kNumPoints; ++i) {
+                double residual;
+                functors[i](&params[0], &params[4], &params[7], &params[11], &residual);
+                ASSERT_NEAR(residual, residuals[i], 1.e-6);
+            }
+        }
+
+        // The analytic jacobians match the finite differences
+        const double kEps = 1.e-6;
+        for (int b(0); b < 4; ++b) {
+            for (int c(0); c < sizes[b]; ++c) {
+                auto x_plus = params, x_minus = params;
+                x_plus[offsets[b] + c] += kEps;
+                x_minus[offsets[b] + c] -= kEps;
+                std::vector<double> r_plus, r_minus;
+                evaluate(x_plus, r_plus, nullptr);
+                evaluate(x_minus, r_minus, nullptr);
+                for (int i(0); i < kNumPoints; ++i) {
+                    // Skip the residuals at the threshold of the truncated loss
+                    if (loss_sigma > 0. && std::abs(std::abs(residuals[i]) - loss_sigma) < 1.e-3)
+                        continue;
+                    double numerical = (r_plus[i] - r_minus[i]) / (2. * kEps);
+                    ASSERT_NEAR(numerical, jacobians[b][i * sizes[b] + c], 1.e-5);
+                }
+            }
+        }
+    }
+}
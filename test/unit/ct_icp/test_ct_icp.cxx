@@ -6,7 +6,243 @@
 #include <ct_icp/odometry.h>
 #include <SlamCore/experimental/iterator/transform_iterator.h>
 
+namespace {
 
+    const double kBoxSize = 10.;
+
+    // Returns a random point on one of the six planes of a box of half-size `kBoxSize`
+    Eigen::Vector3d RandomPointInBox() {
+        Eigen::Vector3d point = Eigen::Vector3d::Random() * kBoxSize;
+        const int face = std::rand() % 6;
+        point[face / 2] = face % 2 == 0 ? -kBoxSize : kBoxSize;
+        return point;
+    }
+
+    // Returns a map of the planes of the box
+    std::unique_ptr<ct_icp::MultipleResolutionVoxelMap> BoxMap(int num_points = 60000) {
+        auto map = std::make_unique<ct_icp::MultipleResolutionVoxelMap>(
+                ct_icp::MultipleResolutionVoxelMap::Options{});
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(num_points);
+        auto xyz = pc->XYZ<double>();
+        for (auto idx(0); idx < num_points; ++idx)
+            xyz[idx] = RandomPointInBox();
+        pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+        std::vector<size_t> indices;
+        map->InsertPointCloud(*pc, {slam::Pose()}, indices);
+        return map;
+    }
+
+    // Returns a frame moving in the box (timestamps in [0, 1])
+    ct_icp::TrajectoryFrame GroundTruthFrame(bool is_rigid) {
+        ct_icp::TrajectoryFrame frame;
+        frame.begin_pose.dest_timestamp = 0.;
+        frame.end_pose.dest_timestamp = 1.;
+        frame.begin_pose.pose.tr = Eigen::Vector3d(0.5, -0.3, 0.1);
+        frame.end_pose.pose.quat = Eigen::Quaterniond(Eigen::AngleAxisd(0.05, Eigen::Vector3d::UnitZ()));
+        frame.end_pose.pose.tr = Eigen::Vector3d(0.9, -0.1, 0.1);
+        if (is_rigid)
+            frame.begin_pose.pose = frame.end_pose.pose;
+        return frame;
+    }
+
+    // Returns the keypoints of the box acquired during the frame
+    std::vector<slam::WPoint3D> BoxKeypoints(const ct_icp::TrajectoryFrame &frame, int num_keypoints = 2000) {
+        std::vector<slam::WPoint3D> keypoints(num_keypoints);
+        for (auto idx(0); idx < num_keypoints; ++idx) {
+            auto &keypoint = keypoints[idx];
+            keypoint.raw_point.timestamp = double(idx) / (num_keypoints - 1);
+            keypoint.world_point = RandomPointInBox();
+            keypoint.raw_point.point = frame.begin_pose.InterpolatePose(
+                    frame.end_pose, keypoint.raw_point.timestamp).Inverse() * keypoint.world_point;
+        }
+        return keypoints;
+    }
+
+    // Returns the initial estimate of the registration, perturbing the ground truth frame
+    ct_icp::TrajectoryFrame PerturbedFrame(const ct_icp::TrajectoryFrame &frame) {
+        slam::SE3 perturbation(Eigen::Quaterniond(Eigen::AngleAxisd(0.02, Eigen::Vector3d::UnitZ())),
+                               Eigen::Vector3d(0.15, -0.1, 0.05));
+        auto initial_frame = frame;
+        initial_frame.begin_pose.pose = perturbation * frame.begin_pose.pose;
+        initial_frame.end_pose.pose = perturbation * frame.end_pose.pose;
+        return initial_frame;
+    }
+
+    ct_icp::CTICPOptions CeresOptions(ct_icp::POSE_PARAMETRIZATION parametrization) {
+        ct_icp::CTICPOptions options;
+        options.solver = ct_icp::CERES;
+        options.parametrization = parametrization;
+        options.num_iters_icp = 20;
+        options.ls_max_num_iters = 5;
+        options.ls_num_threads = 4;
+        options.debug_print = false;
+        // The SIMPLE parametrization only estimates the end pose of a rigid frame
+        options.point_to_plane_with_distortion = parametrization == ct_icp::CONTINUOUS_TIME;
+        return options;
+    }
+
+    // The variants of the CERES residuals tested (each distance, and the bundled point-to-plane residuals)
+    const std::vector<std::pair<ct_icp::ICP_DISTANCE, bool>> kCeresResiduals = {
+            {ct_icp::POINT_TO_PLANE,        false},
+            {ct_icp::POINT_TO_PLANE,        true},
+            {ct_icp::POINT_TO_DISTRIBUTION, false}
+    };
+
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
 TEST(CT_ICP, GN) {
 
-}
\ No newline at end of file
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(CT_ICP, CeresSimple) {
+    std::srand(42);
+    auto map = BoxMap();
+    const auto ground_truth = GroundTruthFrame(true);
+    for (auto &[distance, bundle_residuals]: kCeresResiduals) {
+        auto keypoints = BoxKeypoints(ground_truth);
+        auto frame = PerturbedFrame(ground_truth);
+
+        ct_icp::CT_ICP_Registration registration;
+        registration.Options() = CeresOptions(ct_icp::SIMPLE);
+        registration.Options().distance = distance;
+        registration.Options().bundle_residuals = bundle_residuals;
+        auto summary = registration.Register(*map, keypoints, frame);
+
+        ASSERT_TRUE(summary.success) << "Distance " << distance << ": " << summary.error_log;
+        ASSERT_LT((frame.EndTr() - ground_truth.EndTr()).norm(), 0.02) << "Distance " << distance;
+        ASSERT_LT(frame.end_pose.AngularDistance(ground_truth.end_pose), 0.2) << "Distance " << distance;
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(CT_ICP, CeresContinuousTime) {
+    std::srand(42);
+    auto map = BoxMap();
+    const auto ground_truth = GroundTruthFrame(false);
+    for (auto &[distance, bundle_residuals]: kCeresResiduals) {
+        auto keypoints = BoxKeypoints(ground_truth);
+        auto frame = PerturbedFrame(ground_truth);
+
+        ct_icp::CT_ICP_Registration registration;
+        registration.Options() = CeresOptions(ct_icp::CONTINUOUS_TIME);
+        registration.Options().distance = distance;
+        registration.Options().bundle_residuals = bundle_residuals;
+        auto summary = registration.Register(*map, keypoints, frame);
+
+        ASSERT_TRUE(summary.success) << "Distance " << distance << ": " << summary.error_log;
+        ASSERT_LT((frame.BeginTr() - ground_truth.BeginTr()).norm(), 0.02) << "Distance " << distance;
+        ASSERT_LT((frame.EndTr() - ground_truth.EndTr()).norm(), 0.02) << "Distance " << distance;
+        ASSERT_LT(frame.end_pose.AngularDistance(ground_truth.end_pose), 0.2) << "Distance " << distance;
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(CT_ICP, CoarseToFineLevelFailure) {
+    std::srand(42);
+    auto map = BoxMap();
+    const auto ground_truth = GroundTruthFrame(false);
+    const auto keypoints = BoxKeypoints(ground_truth);
+    auto options = CeresOptions(ct_icp::CONTINUOUS_TIME);
+    options.ls_num_threads = 1;
+    options.num_iters_icp = 6;
+
+    // The level registers too few keypoints to succeed: it fails at its first iteration
+    auto level_keypoints = keypoints;
+    auto level_frame = PerturbedFrame(ground_truth);
+    ct_icp::CT_ICP_Registration level_registration;
+    level_registration.Options() = options;
+    level_registration.Options().coarse_to_fine_levels = {{3, 0.005, 1.5}};
+    auto level_summary = level_registration.Register(*map, level_keypoints, level_frame);
+
+    // The failed level leaves the initial estimate untouched, and is only charged its failed iteration
+    auto fine_keypoints = keypoints;
+    auto fine_frame = PerturbedFrame(ground_truth);
+    ct_icp::CT_ICP_Registration fine_registration;
+    fine_registration.Options() = options;
+    fine_registration.Options().num_iters_icp = options.num_iters_icp - 1;
+    auto fine_summary = fine_registration.Register(*map, fine_keypoints, fine_frame);
+
+    ASSERT_TRUE(level_summary.success);
+    ASSERT_EQ(level_summary.num_coarse_iters, 1);
+    ASSERT_EQ(level_summary.num_iters, fine_summary.num_iters);
+    ASSERT_LT((level_frame.BeginTr() - fine_frame.BeginTr()).norm(), 1.e-9);
+    ASSERT_LT((level_frame.EndTr() - fine_frame.EndTr()).norm(), 1.e-9);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(CT_ICP, CoarseToFineIterationsBudget) {
+    std::srand(42);
+    auto map = BoxMap();
+    const auto ground_truth = GroundTruthFrame(false);
+    auto keypoints = BoxKeypoints(ground_truth);
+    auto frame = PerturbedFrame(ground_truth);
+
+    ct_icp::CT_ICP_Registration registration;
+    registration.Options() = CeresOptions(ct_icp::CONTINUOUS_TIME);
+    auto &options = registration.Options();
+    options.num_iters_icp = 6;
+    options.coarse_to_fine_levels = {{4, 0.25, 1.5},
+                                     {4, 0.5,  1.0}};
+    auto summary = registration.Register(*map, keypoints, frame);
+
+    // The levels stop at their own budget (or once converged), and the fine iterations use the remaining budget
+    ASSERT_TRUE(summary.success) << summary.error_log;
+    ASSERT_GE(summary.num_coarse_iters, 2);
+    ASSERT_LE(summary.num_coarse_iters, 8);
+    ASSERT_GE(summary.num_iters, 1);
+    ASSERT_LE(summary.num_iters, std::max(options.num_iters_icp - summary.num_coarse_iters, 1));
+    ASSERT_LT((frame.EndTr() - ground_truth.EndTr()).norm(), 0.02);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(CT_ICP, SelectObservableKeypoints) {
+    std::srand(42);
+    // A corridor along the x axis (two walls and a floor), which only constrains the translation along x
+    // With the few keypoints of a wall at its end
+    ct_icp::jacobian_rows_t rows;
+    auto add_row = [&rows](const Eigen::Vector3d &point, const Eigen::Vector3d &normal) {
+        Eigen::Matrix<double, 6, 1> row;
+        row.head<3>() = point.cross(normal);
+        row.tail<3>() = normal;
+        rows.push_back(row);
+    };
+    for (auto idx(0); idx < 1500; ++idx) {
+        Eigen::Vector3d point = Eigen::Vector3d::Random().cwiseProduct(Eigen::Vector3d(20., 2., 1.5));
+        point.z() += 1.5;
+        if (idx % 3 == 0)
+            add_row(Eigen::Vector3d(point.x(), 2., point.z()), Eigen::Vector3d::UnitY());
+        else if (idx % 3 == 1)
+            add_row(Eigen::Vector3d(point.x(), -2., point.z()), -Eigen::Vector3d::UnitY());
+        else
+            add_row(Eigen::Vector3d(point.x(), point.y(), 0.), Eigen::Vector3d::UnitZ());
+    }
+    const int kNumCorridorKeypoints = int(rows.size()), kNumEndKeypoints = 10;
+    for (auto idx(0); idx < kNumEndKeypoints; ++idx) {
+        Eigen::Vector3d point = Eigen::Vector3d::Random().cwiseProduct(Eigen::Vector3d(0., 2., 1.5));
+        add_row(Eigen::Vector3d(20., point.y(), point.z() + 1.5), -Eigen::Vector3d::UnitX());
+    }
+
+    const double kInformationRatio = 0.5;
+    auto selected = ct_icp::select_observable_keypoints(rows, kInformationRatio, 0);
+    ASSERT_EQ(selected.size(), rows.size());
+    const auto num_selected = std::count(selected.begin(), selected.end(), 1);
+    ASSERT_GT(num_selected, 0);
+    ASSERT_LT(num_selected, rows.size());
+
+    // Only the keypoints at the end of the corridor constrain the translation along x:
+    // The selection keeps enough of them to preserve the required information in this direction
+    double information_x = 0., selected_information_x = 0.;
+    int num_end_selected = 0;
+    for (auto idx(kNumCorridorKeypoints); idx < rows.size(); ++idx) {
+        information_x += rows[idx][3] * rows[idx][3];
+        if (selected[idx]) {
+            selected_information_x += rows[idx][3] * rows[idx][3];
+            num_end_selected++;
+        }
+    }
+    ASSERT_GE(selected_information_x, kInformationRatio * information_x);
+    ASSERT_GE(num_end_selected, int(std::ceil(kInformationRatio * kNumEndKeypoints)));
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <ct_icp/dataset.h>
+#include <ct_icp/dataset_cache.h>
 #include <thread>
+#include <fstream>
 #include <SlamCore/io.h>
 #include <SlamCore/eval.h>
 
@@ -8,3 +10,167 @@
 //TEST(NCLT_poses, read_nclt_poses) {
 //    ASSERT_TRUE(true);
 //}
+
+
+TEST(DatasetCache, WriteRead) {
+    const auto file_path = (fs::temp_directory_path() / "test_dataset_cache.ctcache").string();
+    const int num_frames = 5;
+    const size_t num_points = 1000;
+    ct_icp::DatasetCacheWriter::Options options;
+
+    std::vector<slam::PointCloudPtr> frames;
+    std::vector<slam::Pose> poses;
+    {
+        ct_icp::DatasetCacheWriter writer(file_path, options);
+        for (int frame_idx(0); frame_idx < num_frames; ++frame_idx) {
+            auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+            pc->resize(num_points);
+            pc->AddDefaultTimestampsField();
+            auto xyz = pc->XYZ<double>();
+            auto timestamps = pc->TimestampsProxy<double>();
+            for (auto i(0); i < num_points; ++i) {
+                // Large coordinates on the x axis to force a column of int32
+                xyz[i] = Eigen::Vector3d::Random().cwiseProduct(Eigen::Vector3d(80., 20., 3.));
+                timestamps[i] = frame_idx + double(i) / num_points;
+            }
+            writer.AddFrame(*pc);
+            frames.push_back(pc);
+
+            slam::Pose pose;
+            pose.dest_timestamp = frame_idx;
+            pose.dest_frame_id = frame_idx;
+            pose.pose.tr = Eigen::Vector3d::Random();
+            poses.push_back(pose);
+        }
+        writer.SetGroundTruth(poses);
+    }
+
+    auto sequence = ct_icp::CachedSequence::PtrFromFile(file_path);
+    ASSERT_EQ(sequence->NumFrames(), num_frames);
+    ASSERT_TRUE(sequence->HasGroundTruth());
+    ASSERT_EQ(sequence->GroundTruth()->size(), num_frames);
+
+    // Read the frames in a random order
+    for (int frame_idx: {3, 0, 4, 1, 2}) {
+        auto frame = sequence->GetFrame(frame_idx);
+        auto &pc = *frame.pointcloud;
+        auto &ref_pc = *frames[frame_idx];
+        ASSERT_EQ(pc.size(), num_points);
+        ASSERT_TRUE(pc.HasTimestamps());
+        ASSERT_TRUE(frame.HasGroundTruth());
+        auto xyz = pc.XYZ<double>();
+        auto ref_xyz = ref_pc.XYZ<double>();
+        auto timestamps = pc.TimestampsProxy<double>();
+        auto ref_timestamps = ref_pc.TimestampsProxy<double>();
+        for (auto i(0); i < num_points; ++i) {
+            Eigen::Vector3d point = xyz[i];
+            Eigen::Vector3d ref_point = ref_xyz[i];
+            ASSERT_LE((point - ref_point).cwiseAbs().maxCoeff(), 0.5 * options.xyz_resolution + 1.e-9);
+            ASSERT_LE(std::abs(double(timestamps[i]) - double(ref_timestamps[i])),
+                      0.5 * options.timestamp_resolution + 1.e-9);
+        }
+        ASSERT_EQ(frame.timestamp_min, frame_idx);
+    }
+    fs::remove(file_path);
+}
+
+
+TEST(PLYDirectory, GetFrames) {
+    const auto dir_path = (fs::temp_directory_path() / "test_ply_directory").string();
+    if (fs::exists(dir_path))
+        fs::remove_all(dir_path);
+    fs::create_directories(dir_path);
+
+    const int num_frames = 8;
+    for (int frame_idx(0); frame_idx < num_frames; ++frame_idx) {
+        std::vector<slam::WPoint3D> points(100);
+        for (auto i(0); i < points.size(); ++i) {
+            points[i].raw_point.point = Eigen::Vector3d::Random();
+            points[i].raw_point.timestamp = frame_idx + double(i) / points.size();
+            points[i].world_point = points[i].raw_point.point;
+            points[i].index_frame = frame_idx;
+        }
+        slam::WritePLY(dir_path + "/" + ct_icp::DefaultFilePattern(frame_idx), points);
+    }
+
+    auto sequence = ct_icp::PLYDirectory::PtrFromDirectoryPath(dir_path);
+    ASSERT_EQ(sequence->NumFrames(), num_frames);
+    sequence->SetNumReadThreads(4);
+    auto cache = std::make_shared<ct_icp::AFileSequence::FrameCache>(num_frames);
+    sequence->SetFrameCache(cache);
+
+    // The frames must be returned in order
+    auto frames = sequence->GetFrames(0, num_frames);
+    ASSERT_EQ(frames.size(), num_frames);
+    for (int frame_idx(0); frame_idx < num_frames; ++frame_idx)
+        ASSERT_EQ(int(frames[frame_idx].timestamp_min), frame_idx);
+    ASSERT_EQ(cache->size(), num_frames);
+
+    // Second read from the cache
+    auto batch = sequence->NextFrames(3);
+    ASSERT_EQ(batch.size(), 3);
+    ASSERT_EQ(cache->num_hits(), 3);
+    ASSERT_EQ(batch[2].pointcloud->size(), 100);
+    ASSERT_EQ(int(batch[2].timestamp_min), 2);
+    ASSERT_TRUE(sequence->HasNext());
+    ASSERT_EQ(sequence->NextFrames(num_frames).size(), num_frames - 3);
+    ASSERT_FALSE(sequence->HasNext());
+    fs::remove_all(dir_path);
+}
+
+
+TEST(KITTIBinDirectory, ReadFrames) {
+    const auto dir_path = (fs::temp_directory_path() / "test_kitti_bin_directory").string();
+    if (fs::exists(dir_path))
+        fs::remove_all(dir_path);
+    fs::create_directories(dir_path);
+
+    const int num_frames = 3;
+    const size_t num_points = 1000;
+    std::vector<std::vector<float>> frames_data(num_frames);
+    for (int frame_idx(0); frame_idx < num_frames; ++frame_idx) {
+        auto &data = frames_data[frame_idx];
+        data.resize(4 * num_points);
+        for (auto i(0); i < num_points; ++i) {
+            Eigen::Vector3f point = Eigen::Vector3f::Random().cwiseProduct(Eigen::Vector3f(50.f, 50.f, 4.f));
+            data[4 * i] = point.x();
+            data[4 * i + 1] = point.y();
+            data[4 * i + 2] = point.z();
+            data[4 * i + 3] = float(i) / num_points;
+        }
+        std::ofstream file(dir_path + "/" + ct_icp::KITTIBinFilePattern(frame_idx), std::ios::binary);
+        file.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(float));
+    }
+
+    auto sequence = ct_icp::KITTIBinDirectory::PtrFromDirectoryPath(dir_path);
+    ASSERT_EQ(sequence->NumFrames(), num_frames);
+    ASSERT_TRUE(sequence->WithRandomAccess());
+
+    const double kOffset = 0.205 * M_PI / 180.0;
+    for (int frame_idx: {2, 0, 1}) {
+        auto frame = sequence->GetFrame(frame_idx);
+        const auto &pc = *frame.pointcloud;
+        ASSERT_EQ(pc.size(), num_points);
+        ASSERT_TRUE(pc.HasTimestamps());
+        ASSERT_TRUE(pc.HasIntensity());
+        ASSERT_GE(frame.timestamp_min, frame_idx * 0.1);
+        ASSERT_LE(frame.timestamp_max, (frame_idx + 1) * 0.1);
+
+        auto xyz = pc.XYZConst<double>();
+        auto timestamps = pc.TimestampsProxy<double>();
+        const auto &data = frames_data[frame_idx];
+        for (auto i(0); i < num_points; ++i) {
+            Eigen::Vector3d raw_point(data[4 * i], data[4 * i + 1], data[4 * i + 2]);
+
+            // The correction of the vertical angle of the KITTI preprocessing
+            Eigen::Vector3d axis = raw_point.cross(Eigen::Vector3d::UnitZ()).normalized();
+            Eigen::Vector3d expected = Eigen::AngleAxisd(kOffset, axis) * raw_point;
+            ASSERT_LE((Eigen::Vector3d(xyz[i]) - expected).norm(), 1.e-9);
+
+            // The sweep is clockwise, starting from the rear of the vehicle
+            double alpha = 0.5 * (1. - std::atan2(raw_point.y(), raw_point.x()) / M_PI);
+            ASSERT_NEAR(double(timestamps[i]), (frame_idx + alpha) * 0.1, 1.e-9);
+        }
+    }
+    fs::remove_all(dir_path);
+}
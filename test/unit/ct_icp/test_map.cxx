@@ -0,0 +1,717 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include <ct_icp/map.h>
+#include <ct_icp/neighborhood_strategy.h>
+
+namespace {
+
+    // Returns a point cloud of random points in [-scale, scale]^3
+    slam::PointCloudPtr RandomPointCloud(size_t num_points, double scale) {
+        auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+        pc->resize(num_points);
+        auto xyz = pc->XYZ<double>();
+        for (auto idx(0); idx < num_points; ++idx)
+            xyz[idx] = Eigen::Vector3d::Random() * scale;
+        pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+        return pc;
+    }
+
+    // Returns a point cloud of random points of the plane z = 0.5, in [-5, 5]^2
+    slam::PointCloudPtr RandomPlane(size_t num_points) {
+        auto pc = RandomPointCloud(num_points, 5.);
+        auto xyz = pc->XYZ<double>();
+        for (auto idx(0); idx < num_points; ++idx) {
+            Eigen::Vector3d point = xyz[idx];
+            xyz[idx] = Eigen::Vector3d(point.x(), point.y(), 0.5);
+        }
+        return pc;
+    }
+
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, ExtractPointsAndChunks) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{0.5, 0.05, 20}};
+    options.chunk_size = 4;
+    ct_icp::MultipleResolutionVoxelMap map(options);
+
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*RandomPointCloud(5000, 10.), {slam::Pose()}, indices);
+    ASSERT_GT(map.Version(), 0);
+
+    auto all_points = map.MapAsPointCloud();
+    ASSERT_EQ(all_points->size(), map.NumPoints());
+
+    // Box and ball extraction
+    auto box_points = map.ExtractPoints(ct_icp::MapRegion::Box(Eigen::Vector3d::Constant(-2.),
+                                                               Eigen::Vector3d::Constant(3.)));
+    auto ball_points = map.ExtractPoints(ct_icp::MapRegion::Ball(Eigen::Vector3d::Zero(), 4.));
+    size_t num_in_box = 0, num_in_ball = 0;
+    {
+        const auto &const_all = *all_points;
+        auto xyz = const_all.XYZConst<double>();
+        for (auto idx(0); idx < xyz.size(); ++idx) {
+            Eigen::Vector3d point = xyz[idx];
+            if ((point.array() >= -2.).all() && (point.array() <= 3.).all())
+                num_in_box++;
+            if (point.norm() <= 4.)
+                num_in_ball++;
+        }
+    }
+    ASSERT_EQ(box_points->size(), num_in_box);
+    ASSERT_EQ(ball_points->size(), num_in_ball);
+
+    // The chunks partition the map
+    auto chunks = map.ExtractChunks(ct_icp::MapRegion());
+    size_t num_points_in_chunks = 0;
+    for (auto &chunk: chunks)
+        num_points_in_chunks += chunk.points->size();
+    ASSERT_EQ(num_points_in_chunks, map.NumPoints());
+
+    // Only the chunks modified after a version are extracted
+    auto version = map.Version();
+    ASSERT_TRUE(map.ExtractChunks(ct_icp::MapRegion(), version).empty());
+    auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+    pc->resize(1);
+    pc->XYZ<double>()[0] = Eigen::Vector3d(100., 100., 100.);
+    pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    auto delta = map.ExtractChunks(ct_icp::MapRegion(), version);
+    ASSERT_EQ(delta.size(), 1);
+    ASSERT_EQ(delta.front().points->size(), 1);
+
+    // Removed voxels are signaled by emptied chunks
+    version = map.Version();
+    map.RemoveElementsFarFromLocation(Eigen::Vector3d::Zero(), 50.);
+    delta = map.ExtractChunks(ct_icp::MapRegion(), version);
+    ASSERT_EQ(delta.size(), 1);
+    ASSERT_EQ(delta.front().points->size(), 0);
+
+    // Removing part of the voxels of the chunks keeps them a partition of the map
+    map.RemoveElementsFarFromLocation(Eigen::Vector3d::Zero(), 5.);
+    ASSERT_GT(map.NumPoints(), 0);
+    num_points_in_chunks = 0;
+    for (auto &chunk: map.ExtractChunks(ct_icp::MapRegion()))
+        num_points_in_chunks += chunk.points->size();
+    ASSERT_EQ(num_points_in_chunks, map.NumPoints());
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, ChangeJournal) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{0.5, 0.05, 20}, {1.0, 0.1, 20}};
+    options.max_journal_size = 10000;
+    ct_icp::MultipleResolutionVoxelMap map(options);
+
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*RandomPointCloud(1000, 10.), {slam::Pose()}, indices);
+    auto changes = map.GetChangesSince(0);
+    ASSERT_TRUE(changes.is_complete);
+    ASSERT_EQ(changes.version, map.Version());
+    ASSERT_EQ(changes.changes.size(), map.NumPoints());
+    ASSERT_EQ(map.GetChangesSince(0, 1).changes.size(), map.GetMapPoints(1)->size());
+
+    // Only the removals are reported after the last version
+    auto version = map.Version();
+    auto num_points = map.NumPoints();
+    map.RemoveElementsFarFromLocation(Eigen::Vector3d::Zero(), 5.);
+    changes = map.GetChangesSince(version);
+    ASSERT_TRUE(changes.is_complete);
+    ASSERT_EQ(changes.changes.size(), num_points - map.NumPoints());
+    for (auto &change: changes.changes) {
+        ASSERT_FALSE(change.is_insertion);
+        ASSERT_GT(change.version, version);
+    }
+
+    // The journal is compacted beyond its maximum size
+    for (int i(0); i < 20; ++i)
+        map.InsertPointCloud(*RandomPointCloud(1000, 100.), {slam::Pose()}, indices);
+    ASSERT_FALSE(map.GetChangesSince(version).is_complete);
+    ASSERT_LE(map.GetChangesSince(0).changes.size(), options.max_journal_size);
+
+    // The journal is reset with the map
+    version = map.Version();
+    map.ClearMap();
+    ASSERT_FALSE(map.GetChangesSince(version).is_complete);
+    ASSERT_TRUE(map.GetChangesSince(map.Version()).is_complete);
+
+    // The journal is disabled by default
+    ct_icp::MultipleResolutionVoxelMap default_map;
+    default_map.InsertPointCloud(*RandomPointCloud(1000, 10.), {slam::Pose()}, indices);
+    ASSERT_FALSE(default_map.GetChangesSince(0).is_complete);
+    ASSERT_TRUE(default_map.GetChangesSince(0).changes.empty());
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, CachedDistributions) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{1.0, 0.05, 50}};
+    options.default_radius = 1.0;
+    ct_icp::MultipleResolutionVoxelMap uncached_map(options);
+    options.cache_distributions = true;
+    ct_icp::MultipleResolutionVoxelMap map(options);
+
+    // Points sampled on the plane z = 0.5
+    auto pc = RandomPlane(2000);
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    uncached_map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+
+    // The distributions are only cached on demand
+    ct_icp::VoxelDistribution distribution;
+    ASSERT_FALSE(uncached_map.FindDistribution(Eigen::Vector3d(1.2, -0.7, 0.6), distribution));
+    ASSERT_TRUE(map.FindDistribution(Eigen::Vector3d(1.2, -0.7, 0.6), distribution));
+    ASSERT_NEAR(distribution.mean.z(), 0.5, 1.e-6);
+    ASSERT_GE(distribution.num_points, 5);
+
+    // The whitened residuals are distances along the normal, and are scaled down in the plane
+    ASSERT_NEAR((distribution.information_sqrt * Eigen::Vector3d::UnitZ()).norm(), 1., 1.e-3);
+    ASSERT_LT((distribution.information_sqrt * Eigen::Vector3d::UnitX()).norm(), 0.1);
+    Eigen::Matrix3d information = distribution.information_sqrt.transpose() * distribution.information_sqrt;
+    ASSERT_LT((information * distribution.covariance - Eigen::Matrix3d::Identity()).norm(), 1.e-6);
+
+    ASSERT_FALSE(map.FindDistribution(Eigen::Vector3d(50., 50., 50.), distribution));
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, HierarchicalInsertion) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{0.2, 0.03, 50}, {1.0, 0.05, 50}};
+    options.default_radius = 1.0;
+    options.cache_distributions = true;
+    ct_icp::MultipleResolutionVoxelMap map(options);
+    options.hierarchical_insertion = true;
+    ct_icp::MultipleResolutionVoxelMap hierarchical_map(options);
+
+    // Points sampled on the plane z = 0.5
+    auto pc = RandomPlane(20000);
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    hierarchical_map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+
+    // The finest resolution is identical, the coarse voxels only keep one representative point per fine voxel
+    auto stats = map.GetMemoryStats();
+    auto hierarchical_stats = hierarchical_map.GetMemoryStats();
+    ASSERT_EQ(hierarchical_stats[0].num_points, stats[0].num_points);
+    ASSERT_EQ(hierarchical_stats[1].num_voxels, stats[1].num_voxels);
+    ASSERT_LE(hierarchical_stats[1].num_points, stats[0].num_voxels);
+    ASSERT_LT(hierarchical_stats[1].pool.requested_bytes, stats[1].pool.requested_bytes);
+
+    // The distributions of the coarse voxels aggregate all the points of their fine voxels
+    ct_icp::VoxelDistribution distribution;
+    ASSERT_TRUE(hierarchical_map.FindDistribution(Eigen::Vector3d(1.2, -0.7, 0.6), distribution));
+    ASSERT_NEAR(distribution.mean.z(), 0.5, 1.e-6);
+    ASSERT_GT(distribution.num_points, options.resolutions[1].max_num_points);
+    ASSERT_NEAR((distribution.information_sqrt * Eigen::Vector3d::UnitZ()).norm(), 1., 1.e-3);
+
+    auto neighborhood = hierarchical_map.RadiusSearch(Eigen::Vector3d(1.2, -0.7, 0.6), 1.0, 20, true, nullptr);
+    ASSERT_EQ(neighborhood.points.size(), 20);
+
+    // The coarse voxels keep their aggregated points when the compaction drops all their representative points
+    options.compaction_planarity_threshold = 2.;
+    options.compaction_max_unobserved_frames = 1;
+    ct_icp::MultipleResolutionVoxelMap compacted_map(options);
+    compacted_map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    auto far_pc = RandomPointCloud(100, 1.);
+    auto far_xyz = far_pc->XYZ<double>();
+    for (auto idx(0); idx < far_xyz.size(); ++idx) {
+        Eigen::Vector3d point = far_xyz[idx];
+        far_xyz[idx] = Eigen::Vector3d(point.x() + 100., point.y(), point.z());
+    }
+    for (auto frame(0); frame < 2; ++frame)
+        compacted_map.InsertPointCloud(*far_pc, {slam::Pose()}, indices);
+    const auto num_coarse_voxels = compacted_map.GetMemoryStats()[1].num_voxels;
+    compacted_map.Compact(1.e4);
+    ASSERT_EQ(compacted_map.GetMemoryStats()[1].num_voxels, num_coarse_voxels);
+    ASSERT_TRUE(compacted_map.FindDistribution(Eigen::Vector3d(1.2, -0.7, 0.6), distribution));
+    ASSERT_NEAR(distribution.mean.z(), 0.5, 1.e-6);
+
+    // The coarse voxels must nest the finest voxels
+    options.resolutions = {{0.2, 0.03, 50}, {0.5, 0.05, 50}};
+    ASSERT_DEATH(ct_icp::MultipleResolutionVoxelMap{options}, "multiple of the finest");
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, MemoryStats) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{0.2, 0.03, 50}, {1.0, 0.1, 40}};
+    ct_icp::MultipleResolutionVoxelMap map(options);
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*RandomPointCloud(20000, 10.), {slam::Pose()}, indices);
+
+    auto stats = map.GetMemoryStats();
+    ASSERT_EQ(stats.size(), 2);
+    for (auto &map_stats: stats) {
+        ASSERT_EQ(map_stats.pool.num_blocks, map_stats.num_voxels);
+        ASSERT_GT(map_stats.BytesPerPoint(), 0.);
+        ASSERT_LT(map_stats.Fragmentation(), 1.);
+    }
+    ASSERT_EQ(stats[0].num_points, map.NumPoints());
+    // The voxels at 0.2m hold a few points: their capacity is not reserved for the maximum number of points
+    // (reserving 50 points per voxel would cost thousands of bytes per point, a point takes 80 bytes)
+    ASSERT_LT(stats[0].BytesPerPoint(), 160.);
+    ASSERT_LT(stats[0].Fragmentation(), 0.5);
+
+    // The memory of the removed voxels is recycled by the next insertions
+    map.RemoveElementsFarFromLocation(Eigen::Vector3d::Zero(), 5.);
+    auto reserved_bytes = map.GetMemoryStats()[0].pool.reserved_bytes;
+    ASSERT_LT(map.GetMemoryStats()[0].pool.num_blocks, stats[0].pool.num_blocks);
+    auto pc = RandomPointCloud(2000, 10.);
+    auto xyz = pc->XYZ<double>();
+    for (auto idx(0); idx < xyz.size(); ++idx) {
+        Eigen::Vector3d point = xyz[idx];
+        xyz[idx] = Eigen::Vector3d(point.x(), point.y(), point.z() + 30.);
+    }
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    auto new_stats = map.GetMemoryStats()[0].pool;
+    ASSERT_GT(new_stats.num_recycled, stats[0].pool.num_recycled);
+    ASSERT_EQ(new_stats.reserved_bytes, reserved_bytes);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, Compaction) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{1.0, 0.05, 50}};
+    options.default_radius = 1.0;
+    options.compaction_num_planar_points = 5;
+    options.cache_distributions = true;
+    options.max_journal_size = 10000;
+    ct_icp::MultipleResolutionVoxelMap map(options);
+
+    // The planar voxels are downsampled, and keep the distribution of all their points
+    auto pc = RandomPlane(4000);
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    const auto num_points = map.NumPoints();
+    auto version = map.Version();
+
+    auto num_removed = map.Compact(1.e4);
+    ASSERT_GT(num_removed, 0);
+    ASSERT_EQ(map.NumPoints(), num_points - num_removed);
+    ASSERT_LT(map.NumPoints(), num_points / 3);
+    ASSERT_EQ(map.Compact(1.e4), 0);
+    auto change_set = map.GetChangesSince(version);
+    ASSERT_EQ(change_set.changes.size(), num_removed);
+    for (auto &change: change_set.changes)
+        ASSERT_FALSE(change.is_insertion);
+
+    ct_icp::VoxelDistribution distribution;
+    ASSERT_TRUE(map.FindDistribution(Eigen::Vector3d(1.2, -0.7, 0.6), distribution));
+    ASSERT_NEAR(distribution.mean.z(), 0.5, 1.e-6);
+    ASSERT_GT(distribution.num_points, 5);
+
+    // The downsampled voxels do not refill: the next frames only update their moments
+    const auto num_compacted_points = map.NumPoints();
+    const auto num_aggregated_points = distribution.num_points;
+    version = map.Version();
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    ASSERT_EQ(map.NumPoints(), num_compacted_points);
+    ASSERT_TRUE(map.GetChangesSince(version).changes.empty());
+    ASSERT_TRUE(map.FindDistribution(Eigen::Vector3d(1.2, -0.7, 0.6), distribution));
+    ASSERT_GT(distribution.num_points, num_aggregated_points);
+    ASSERT_NEAR(distribution.mean.z(), 0.5, 1.e-6);
+    ASSERT_EQ(map.Compact(1.e4), 0);
+
+    // The points never observed again are dropped
+    options.compaction_planarity_threshold = 2.;
+    options.compaction_merge_ratio = 0.;
+    options.compaction_max_unobserved_frames = 2;
+    ct_icp::MultipleResolutionVoxelMap dynamic_map(options);
+    auto static_pc = RandomPointCloud(1000, 5.);
+    auto dynamic_pc = RandomPointCloud(1000, 5.);
+    auto dynamic_xyz = dynamic_pc->XYZ<double>();
+    for (auto idx(0); idx < dynamic_xyz.size(); ++idx) {
+        Eigen::Vector3d point = dynamic_xyz[idx];
+        dynamic_xyz[idx] = Eigen::Vector3d(point.x() + 50., point.y(), point.z());
+    }
+    dynamic_map.InsertPointCloud(*static_pc, {slam::Pose()}, indices);
+    const auto num_static_points = dynamic_map.NumPoints();
+    dynamic_map.InsertPointCloud(*dynamic_pc, {slam::Pose()}, indices);
+    for (auto frame(0); frame < 3; ++frame)
+        dynamic_map.InsertPointCloud(*static_pc, {slam::Pose()}, indices);
+    dynamic_map.Compact(1.e4);
+    ASSERT_EQ(dynamic_map.NumPoints(), num_static_points);
+    ASSERT_TRUE(dynamic_map.RadiusSearch(Eigen::Vector3d(50., 0., 0.), 1.0, 100, true, nullptr).points.empty());
+
+    // The moments of a downsampled voxel ignore the points merged by the compaction
+    options.resolutions = {{1.0, 0.05, 400}};
+    options.compaction_planarity_threshold = 0.5;
+    options.compaction_merge_ratio = 1.5;
+    options.compaction_max_unobserved_frames = 0;
+    ct_icp::MultipleResolutionVoxelMap grid_map(options);
+    auto grid_pc = slam::PointCloud::DefaultXYZPtr<double>();
+    grid_pc->resize(16 * 16);
+    auto grid_xyz = grid_pc->XYZ<double>();
+    for (auto idx(0); idx < grid_xyz.size(); ++idx)
+        grid_xyz[idx] = Eigen::Vector3d(0.01 + 0.06 * (idx % 16), 0.01 + 0.06 * (idx / 16), 0.5);
+    grid_pc->SetWorldPointsField(slam::PointCloud::Field{grid_pc->GetXYZField()});
+    grid_map.InsertPointCloud(*grid_pc, {slam::Pose()}, indices);
+    ASSERT_EQ(grid_map.NumPoints(), grid_pc->size());
+    ASSERT_GT(grid_map.Compact(1.e4), 0);
+    auto next_pc = slam::PointCloud::DefaultXYZPtr<double>();
+    next_pc->resize(1);
+    next_pc->XYZ<double>()[0] = Eigen::Vector3d(0.97, 0.97, 0.5);
+    next_pc->SetWorldPointsField(slam::PointCloud::Field{next_pc->GetXYZField()});
+    grid_map.InsertPointCloud(*next_pc, {slam::Pose()}, indices);
+    ASSERT_TRUE(grid_map.FindDistribution(Eigen::Vector3d(0.5, 0.5, 0.5), distribution));
+    ASSERT_LT(distribution.num_points, grid_pc->size());
+    ASSERT_GT(distribution.num_points, options.compaction_num_planar_points);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, InsertWrappedVector) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{1.0, 0.05, 20}};
+    ct_icp::MultipleResolutionVoxelMap map(options);
+
+    // The map keeps a copy of the frames wrapping vectors (as the registered points of the odometry)
+    auto points = std::make_unique<std::vector<slam::WPoint3D>>(500);
+    for (auto &point: *points) {
+        point.world_point = Eigen::Vector3d::Random() * 5.;
+        point.raw_point.point = point.world_point;
+    }
+    const auto kPointsCopy = *points;
+    auto pc = slam::PointCloud::WrapConstVector(*points, slam::WPoint3D::DefaultSchema(), "world_point");
+    std::vector<size_t> indices;
+    map.InsertPointCloud(pc, {slam::Pose()}, indices);
+    const auto kNumPoints = map.NumPoints();
+
+    std::fill(points->begin(), points->end(), slam::WPoint3D());
+    points.reset();
+    ASSERT_EQ(map.NumPoints(), kNumPoints);
+    ASSERT_EQ(map.MapAsPointCloud()->size(), kNumPoints);
+    auto neighborhood = map.RadiusSearch(kPointsCopy.front().world_point, 0.01, 5, true, nullptr);
+    ASSERT_EQ(neighborhood.points.size(), 1);
+    auto frame = map.GetFramePointCloud(0);
+    ASSERT_NE(frame, nullptr);
+    ASSERT_EQ(frame->size(), kPointsCopy.size());
+    const auto &const_frame = *frame;
+    auto frame_xyz = const_frame.XYZConst<double>();
+    for (auto idx(0); idx < kPointsCopy.size(); ++idx) {
+        Eigen::Vector3d xyz = frame_xyz[idx];
+        ASSERT_EQ(xyz, kPointsCopy[idx].world_point);
+    }
+
+    // The map remains valid for the next insertions
+    auto next_points = kPointsCopy;
+    for (auto &point: next_points)
+        point.world_point += Eigen::Vector3d::Constant(0.5);
+    auto next_pc = slam::PointCloud::WrapConstVector(next_points, slam::WPoint3D::DefaultSchema(), "world_point");
+    map.InsertPointCloud(next_pc, {slam::Pose()}, indices);
+    ASSERT_GT(map.NumPoints(), kNumPoints);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, InsertOwnedPointCloud) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{1.0, 0.05, 20}};
+    ct_icp::MultipleResolutionVoxelMap map(options);
+
+    // The frames inserted as owned point clouds (as by the odometry) share their buffers with the map
+    auto pc = RandomPointCloud(500, 5.);
+    pc->AddDefaultTimestampsField();
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+    auto frame = map.GetFramePointCloud(0);
+    ASSERT_NE(frame, nullptr);
+    for (auto item_idx(0); item_idx < frame->GetCollection().NumItemsInSchema(); ++item_idx)
+        ASSERT_TRUE(frame->GetCollection().IsShared(item_idx));
+
+    // The frame kept by the map outlives the inserted point cloud
+    const slam::PointCloud &const_pc = *pc;
+    const Eigen::Vector3d kFirstPoint = const_pc.XYZConst<double>()[0];
+    pc.reset();
+    const auto &const_frame = *frame;
+    ASSERT_EQ(Eigen::Vector3d(const_frame.XYZConst<double>()[0]), kFirstPoint);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(MultipleResolutionVoxelMap, CompactionQueueWithoutCompaction) {
+    ct_icp::MultipleResolutionVoxelMap::Options options;
+    options.resolutions = {{0.5, 0.05, 20}, {1.0, 0.1, 20}};
+    ASSERT_EQ(options.compaction_time_budget_ms, 0.);
+    ct_icp::MultipleResolutionVoxelMap map(options);
+
+    // The entries of the voxels removed far from the vehicle do not accumulate in the queue of the compaction
+    std::vector<size_t> indices;
+    auto pc = RandomPointCloud(2000, 5.);
+    auto xyz = pc->XYZ<double>();
+    for (auto frame(0); frame < 20; ++frame) {
+        for (auto idx(0); idx < xyz.size(); ++idx) {
+            Eigen::Vector3d point = xyz[idx];
+            xyz[idx] = Eigen::Vector3d(point.x() + 20., point.y(), point.z());
+        }
+        map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+        map.RemoveElementsFarFromLocation(Eigen::Vector3d(20. * (frame + 1), 0., 0.), 10.);
+
+        size_t num_voxels = 0;
+        for (auto &stats: map.GetMemoryStats())
+            num_voxels += stats.num_voxels;
+        ASSERT_GE(map.CompactionQueueSize(), num_voxels);
+        ASSERT_LE(map.CompactionQueueSize(), 2 * num_voxels);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(FrozenVoxelMap, WriteLoadAndSearch) {
+    auto pc = RandomPointCloud(5000, 10.);
+    const auto file_path = (fs::temp_directory_path() / "test_frozen_voxel_map.bin").string();
+    ct_icp::FrozenVoxelMap::Write(*pc, file_path, 1.0);
+
+    // The maps loaded from the same file are shared
+    auto map = ct_icp::FrozenVoxelMap::Load(file_path);
+    ASSERT_EQ(map.get(), ct_icp::FrozenVoxelMap::Load(file_path).get());
+    ASSERT_NE(map.get(), ct_icp::FrozenVoxelMap::Load(file_path, false).get());
+    ASSERT_EQ(map->NumPoints(), pc->size());
+    ASSERT_EQ(map->MapAsPointCloud()->size(), pc->size());
+
+    // The radius search finds the same neighbors as a brute force search
+    const auto &const_pc = *pc;
+    auto xyz = const_pc.XYZConst<double>();
+    for (int i(0); i < 10; ++i) {
+        Eigen::Vector3d query = Eigen::Vector3d::Random() * 10.;
+        const double radius = 1.5;
+        std::vector<double> distances;
+        for (auto idx(0); idx < xyz.size(); ++idx) {
+            double distance = (Eigen::Vector3d(xyz[idx]) - query).norm();
+            if (distance <= radius)
+                distances.push_back(distance);
+        }
+        std::sort(distances.begin(), distances.end());
+        ASSERT_EQ(map->RadiusSearch(query, radius).points.size(), distances.size());
+
+        auto neighborhood = map->RadiusSearch(query, radius, 5);
+        ASSERT_EQ(neighborhood.points.size(), std::min(size_t(5), distances.size()));
+        if (!neighborhood.points.empty())
+            ASSERT_NEAR((neighborhood.points.back() - query).norm(), distances.front(), 1.e-9);
+
+        // The frozen map does not filter the neighbors by their normals
+        Eigen::Vector3d sensor_location = query + Eigen::Vector3d::UnitZ();
+        auto unfiltered = map->RadiusSearch(query, radius, 5, false, &sensor_location);
+        ASSERT_EQ(unfiltered.points.size(), neighborhood.points.size());
+        for (auto k(0); k < unfiltered.points.size(); ++k)
+            ASSERT_EQ(unfiltered.points[k], neighborhood.points[k]);
+    }
+
+    // The extraction of a region finds the same points as a brute force search (small and large regions)
+    for (auto &region: {ct_icp::MapRegion::Ball(Eigen::Vector3d(2., -1., 0.5), 3.),
+                        ct_icp::MapRegion::Box(Eigen::Vector3d::Constant(-100.), Eigen::Vector3d(0., 100., 100.))}) {
+        size_t num_in_region = 0;
+        for (auto idx(0); idx < xyz.size(); ++idx) {
+            if (region.Contains(Eigen::Vector3d(xyz[idx])))
+                num_in_region++;
+        }
+        ASSERT_EQ(map->ExtractPoints(region)->size(), num_in_region);
+    }
+    ASSERT_EQ(map->ExtractPoints(ct_icp::MapRegion())->size(), pc->size());
+
+    // The map is read-only
+    std::vector<size_t> indices;
+    ASSERT_THROW(map->InsertPointCloud(*pc, {slam::Pose()}, indices), std::runtime_error);
+    ASSERT_THROW(map->RemoveElementsFarFromLocation(Eigen::Vector3d::Zero(), 1.), std::runtime_error);
+    fs::remove(file_path);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(TiledVoxelMap, PagingAndBorderQueries) {
+    auto pc = RandomPointCloud(5000, 10.);
+    const auto tiles_directory = (fs::temp_directory_path() / "test_tiled_voxel_map").string();
+    ct_icp::TiledVoxelMap::Write(*pc, tiles_directory, 4.0, 1.0);
+
+    ct_icp::TiledVoxelMap::Options options;
+    options.tiles_directory = tiles_directory;
+    options.max_tiles_in_memory = 4;
+    options.asynchronous_prefetch = false;
+    options.prefetch_radius = 0;
+    options.pinned_radius = 0;
+    ct_icp::TiledVoxelMap map(options);
+    ASSERT_EQ(map.NumPoints(), pc->size());
+    ASSERT_EQ(map.NumTiles(), 36);
+    ASSERT_EQ(map.MapAsPointCloud()->size(), pc->size());
+    ASSERT_EQ(map.NumTilesInMemory(), 0);
+
+    // The extraction of a region only loads the tiles intersecting the region
+    const auto &const_pc = *pc;
+    auto xyz = const_pc.XYZConst<double>();
+    auto region = ct_icp::MapRegion::Ball(Eigen::Vector3d(-9., -9., 0.), 0.9);
+    size_t num_in_region = 0;
+    for (auto idx(0); idx < xyz.size(); ++idx) {
+        if (region.Contains(Eigen::Vector3d(xyz[idx])))
+            num_in_region++;
+    }
+    ASSERT_EQ(map.ExtractPoints(region)->size(), num_in_region);
+    ASSERT_EQ(map.NumTilesInMemory(), 1);
+    ASSERT_TRUE(map.IsTileInMemory(map.TileCoordinates(Eigen::Vector3d(-9., -9., 0.))));
+
+    // The queries at the borders of the tiles merge the neighbors of the tiles
+    for (auto &query: {Eigen::Vector3d(0.1, -0.1, 0.), Eigen::Vector3d(4.05, 3.9, 1.), Eigen::Vector3d(-7., 2., 3.)}) {
+        const double radius = 1.5;
+        std::vector<double> distances;
+        for (auto idx(0); idx < xyz.size(); ++idx) {
+            double distance = (Eigen::Vector3d(xyz[idx]) - query).norm();
+            if (distance <= radius)
+                distances.push_back(distance);
+        }
+        std::sort(distances.begin(), distances.end());
+        ASSERT_EQ(map.RadiusSearch(query, radius).points.size(), distances.size());
+
+        auto neighborhood = map.RadiusSearch(query, radius, 5);
+        ASSERT_EQ(neighborhood.points.size(), std::min(size_t(5), distances.size()));
+        if (!neighborhood.points.empty())
+            ASSERT_NEAR((neighborhood.points.back() - query).norm(), distances.front(), 1.e-9);
+    }
+    ASSERT_LE(map.NumTilesInMemory(), options.max_tiles_in_memory);
+
+    // The tiles ahead of the vehicle are prefetched
+    slam::Pose begin_pose, end_pose;
+    begin_pose.dest_timestamp = 0.;
+    end_pose.dest_timestamp = 1.;
+    begin_pose.pose.tr = Eigen::Vector3d(-9., -9., 0.);
+    end_pose.pose.tr = Eigen::Vector3d(-7., -9., 0.);
+    map.UpdateTrajectory({begin_pose, end_pose});
+    ASSERT_TRUE(map.IsTileInMemory(map.TileCoordinates(Eigen::Vector3d(-7., -9., 0.))));
+    ASSERT_TRUE(map.IsTileInMemory(map.TileCoordinates(Eigen::Vector3d(-1., -9., 0.))));
+    ASSERT_EQ(map.NumPinnedTiles(), 1);
+
+    // The tiles far from the vehicle are evicted
+    map.RemoveElementsFarFromLocation(Eigen::Vector3d(9., -9., 0.), 1.);
+    ASSERT_FALSE(map.IsTileInMemory(map.TileCoordinates(Eigen::Vector3d(-1., -9., 0.))));
+    ASSERT_FALSE(map.IsTileInMemory(map.TileCoordinates(Eigen::Vector3d(-7., -9., 0.))));
+
+    // The queries in the pinned tile read the snapshot, without reloading the evicted tile in the cache
+    const Eigen::Vector3d pinned_query(-6., -10., 0.);
+    size_t num_neighbors = 0;
+    for (auto idx(0); idx < xyz.size(); ++idx) {
+        if ((Eigen::Vector3d(xyz[idx]) - pinned_query).norm() <= 0.5)
+            num_neighbors++;
+    }
+    ASSERT_EQ(map.RadiusSearch(pinned_query, 0.5).points.size(), num_neighbors);
+    ASSERT_FALSE(map.IsTileInMemory(map.TileCoordinates(pinned_query)));
+    fs::remove_all(tiles_directory);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(RangeImageStrategy, ProjectiveNeighborhoods) {
+    ct_icp::MultipleResolutionVoxelMap::Options map_options;
+    map_options.resolutions = {{0.5, 0.01, 200}};
+    ct_icp::MultipleResolutionVoxelMap map(map_options);
+
+    // A cylindrical wall around the sensor
+    auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+    pc->resize(720 * 40);
+    auto xyz = pc->XYZ<double>();
+    for (auto i(0); i < 720; ++i) {
+        const double azimuth = i * M_PI / 360.;
+        for (auto j(0); j < 40; ++j)
+            xyz[i * 40 + j] = Eigen::Vector3d(10. * std::cos(azimuth), 10. * std::sin(azimuth), -2. + j * 0.1);
+    }
+    pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+
+    ct_icp::RangeImageStrategy::Options options;
+    options.num_azimuth_bins = 360;
+    options.num_elevation_bins = 32;
+    ct_icp::RangeImageStrategy strategy(options);
+    strategy.UpdateMapView(map, slam::SE3());
+    ASSERT_GT(strategy.NumFilledPixels(), 0);
+
+    // The neighbors are selected in the window around the projection (wrapping around the azimuth)
+    slam::Neighborhood neighborhood;
+    for (auto &point: {Eigen::Vector3d(10., 0., 0.05), Eigen::Vector3d(-10., 0.01, 0.5)}) {
+        slam::WPoint3D query;
+        query.world_point = point;
+        ASSERT_TRUE(strategy.ComputeNeighborhoodInPlace(map, query, neighborhood, nullptr));
+        ASSERT_GE(neighborhood.points.size(), options.min_num_neighbors);
+        ASSERT_LE(neighborhood.points.size(), options.max_num_neighbors);
+        for (auto &neighbor: neighborhood.points)
+            ASSERT_LE((neighbor - point).norm(), options.max_distance);
+        // The neighbors are ordered as the radius searches of the map (from the farthest to the closest)
+        for (auto idx(1); idx < neighborhood.points.size(); ++idx)
+            ASSERT_GE((neighborhood.points[idx - 1] - point).norm(), (neighborhood.points[idx] - point).norm());
+    }
+    ASSERT_EQ(strategy.NumFallbacks(), 0);
+
+    // The queries out of the image, or far from the points of their window fall back to a radius search
+    for (auto &point: {Eigen::Vector3d(0., 0., 5.), Eigen::Vector3d(20., 0., 0.)}) {
+        slam::WPoint3D query;
+        query.world_point = point;
+        ASSERT_FALSE(strategy.ComputeNeighborhoodInPlace(map, query, neighborhood, nullptr));
+    }
+    ASSERT_EQ(strategy.NumFallbacks(), 2);
+
+    // Only the modified chunks are extracted at the next update, and the new points occlude the wall
+    auto patch = slam::PointCloud::DefaultXYZPtr<double>();
+    patch->resize(400);
+    auto patch_xyz = patch->XYZ<double>();
+    for (auto idx(0); idx < patch_xyz.size(); ++idx)
+        patch_xyz[idx] = Eigen::Vector3d(-5., -1. + (idx % 20) * 0.1, -1. + (idx / 20) * 0.1);
+    patch->SetWorldPointsField(slam::PointCloud::Field{patch->GetXYZField()});
+    map.InsertPointCloud(*patch, {slam::Pose()}, indices);
+    slam::SE3 pose;
+    pose.tr = Eigen::Vector3d(1., 0., 0.);
+    strategy.UpdateMapView(map, pose);
+    ASSERT_EQ(strategy.NumFallbacks(), 0);
+
+    slam::WPoint3D query;
+    query.world_point = Eigen::Vector3d(-5.05, 0., 0.);
+    ASSERT_TRUE(strategy.ComputeNeighborhoodInPlace(map, query, neighborhood, nullptr));
+    for (auto &neighbor: neighborhood.points)
+        ASSERT_NEAR(neighbor.x(), -5., 1.e-9);
+    query.world_point = Eigen::Vector3d(10., 0., 0.05);
+    ASSERT_TRUE(strategy.ComputeNeighborhoodInPlace(map, query, neighborhood, nullptr));
+    ASSERT_EQ(strategy.NumFallbacks(), 0);
+
+    // The chunks out of range are culled
+    pose.tr = Eigen::Vector3d(500., 0., 0.);
+    strategy.UpdateMapView(map, pose);
+    ASSERT_EQ(strategy.NumFilledPixels(), 0);
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(RangeImageStrategy, DenseScanWithDefaultOptions) {
+    ct_icp::RangeImageStrategy::Options options;
+    ct_icp::MultipleResolutionVoxelMap::Options map_options;
+    map_options.resolutions = {{0.5, 0.01, 200}};
+    ct_icp::MultipleResolutionVoxelMap map(map_options);
+
+    // A dense scan of a cylindrical wall, with one point at the center of each pixel of the range image
+    const double kRadius = 10.;
+    const double kElevationBin = (options.max_elevation - options.min_elevation) / options.num_elevation_bins;
+    auto pc = slam::PointCloud::DefaultXYZPtr<double>();
+    pc->resize(options.num_azimuth_bins * options.num_elevation_bins);
+    auto xyz = pc->XYZ<double>();
+    for (auto i(0); i < options.num_azimuth_bins; ++i) {
+        const double azimuth = -M_PI + (i + 0.5) * 2. * M_PI / options.num_azimuth_bins;
+        for (auto j(0); j < options.num_elevation_bins; ++j) {
+            const double elevation = (options.min_elevation + (j + 0.5) * kElevationBin) * M_PI / 180.;
+            xyz[i * options.num_elevation_bins + j] = Eigen::Vector3d(kRadius * std::cos(azimuth),
+                                                                      kRadius * std::sin(azimuth),
+                                                                      kRadius * std::tan(elevation));
+        }
+    }
+    pc->SetWorldPointsField(slam::PointCloud::Field{pc->GetXYZField()});
+    std::vector<size_t> indices;
+    map.InsertPointCloud(*pc, {slam::Pose()}, indices);
+
+    ct_icp::RangeImageStrategy strategy(options);
+    strategy.UpdateMapView(map, slam::SE3());
+    ASSERT_EQ(strategy.NumFilledPixels(), pc->size());
+
+    // The neighbors of the points of the scan are all selected in the range image (without fallback)
+    slam::Neighborhood neighborhood;
+    for (auto idx(0); idx < pc->size(); idx += 97) {
+        slam::WPoint3D query;
+        query.world_point = xyz[idx];
+        ASSERT_TRUE(strategy.ComputeNeighborhoodInPlace(map, query, neighborhood, nullptr));
+        ASSERT_EQ(neighborhood.points.size(), options.max_num_neighbors);
+    }
+    ASSERT_EQ(strategy.NumFallbacks(), 0);
+
+    // A window smaller than the minimum number of neighbors is rejected
+    options.window_half_width = 1;
+    options.window_half_height = 1;
+    options.min_num_neighbors = 10;
+    ASSERT_DEATH(ct_icp::RangeImageStrategy{options}, "minimum number of neighbors");
+}
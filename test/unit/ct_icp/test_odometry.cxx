@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include <ct_icp/odometry.h>
+
+namespace {
+
+    const double kBoxSize = 15.;
+
+    // Returns the pose of a sensor at a location (at `timestamp`)
+    slam::Pose SensorPose(const Eigen::Vector3d &location, double timestamp) {
+        slam::SE3 pose;
+        pose.tr = location;
+        return slam::Pose(pose, timestamp);
+    }
+
+    // Generates the frame `frame_id` (timestamps in [frame_id, frame_id + 1]) in a box made of six planes,
+    // Acquired by a sensor at the pose `sensor_pose(timestamp)`
+    template<typename SensorPoseT>
+    std::vector<slam::WPoint3D> GenerateFrame(slam::frame_id_t frame_id, SensorPoseT &&sensor_pose,
+                                              int num_points_per_plane = 1000) {
+        std::vector<slam::WPoint3D> frame;
+        frame.reserve(6 * num_points_per_plane);
+        slam::WPoint3D point;
+        for (int i(0); i < num_points_per_plane; ++i) {
+            double timestamp = frame_id + double(i) / (num_points_per_plane - 1);
+            slam::Pose sensor_to_world = sensor_pose(timestamp);
+            for (int axis(0); axis < 3; ++axis) {
+                for (double sign: {-1., 1.}) {
+                    point.world_point = Eigen::Vector3d::Random() * kBoxSize;
+                    point.world_point[axis] = sign * kBoxSize;
+                    point.raw_point.point = sensor_to_world.Inverse() * point.world_point;
+                    point.raw_point.timestamp = timestamp;
+                    point.index_frame = frame_id;
+                    frame.push_back(point);
+                }
+            }
+        }
+        return frame;
+    }
+
+    // Generates a frame acquired by a sensor moving at constant velocity `speed` along the x axis
+    std::vector<slam::WPoint3D> GenerateFrame(slam::frame_id_t frame_id, double speed) {
+        return GenerateFrame(frame_id, [speed](double timestamp) {
+            return SensorPose(Eigen::Vector3d(speed * timestamp, 0., 0.), timestamp);
+        });
+    }
+
+    // Generates a frame acquired instantly by a sensor at `location` (without distortion)
+    std::vector<slam::WPoint3D> GenerateRigidFrame(slam::frame_id_t frame_id, const Eigen::Vector3d &location,
+                                                   int num_points_per_plane = 1000) {
+        return GenerateFrame(frame_id, [&location](double timestamp) { return SensorPose(location, timestamp); },
+                             num_points_per_plane);
+    }
+
+    // Registers the frames with a robust odometry, running `num_parallel_attempts` attempts concurrently
+    std::vector<ct_icp::Odometry::RegistrationSummary> RunRobustOdometry(
+            ct_icp::OdometryOptions options, int num_parallel_attempts,
+            const std::vector<std::vector<slam::WPoint3D>> &frames) {
+        options.robust_num_parallel_attempts = num_parallel_attempts;
+        ct_icp::Odometry odometry(options);
+        std::vector<ct_icp::Odometry::RegistrationSummary> summaries;
+        for (auto &frame: frames)
+            summaries.push_back(odometry.RegisterFrame(frame));
+        return summaries;
+    }
+
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(Odometry, SerialAndSpeculativeRobustRegistration) {
+    std::vector<std::vector<slam::WPoint3D>> frames;
+    for (int fid(0); fid < 6; ++fid)
+        frames.push_back(GenerateFrame(fid, 0.2));
+
+    ct_icp::OdometryOptions options;
+    options.debug_print = false;
+    options.ct_icp_options.debug_print = false;
+    options.ct_icp_options.solver = ct_icp::CERES;
+    // A single thread per attempt makes the registrations deterministic
+    options.ct_icp_options.ls_num_threads = 1;
+    options.init_num_frames = 1;
+    options.robust_registration = true;
+    options.robust_num_attempts = 3;
+
+    // The random selection of the keypoints draws the same samples in both modes
+    for (int max_num_keypoints: {-1, 300}) {
+        options.max_num_keypoints = max_num_keypoints;
+        // The second configuration fails the assessment of every attempt: the last attempt is accepted in both modes
+        for (double distance_error_threshold: {5., -1.}) {
+            options.distance_error_threshold = distance_error_threshold;
+            auto serial = RunRobustOdometry(options, 1, frames);
+            auto speculative = RunRobustOdometry(options, 3, frames);
+
+            ASSERT_EQ(serial.size(), speculative.size());
+            for (auto idx(1); idx < serial.size(); ++idx) {
+                EXPECT_EQ(serial[idx].success, speculative[idx].success);
+                EXPECT_EQ(serial[idx].number_of_attempts, speculative[idx].number_of_attempts);
+                EXPECT_EQ(serial[idx].sample_size, speculative[idx].sample_size);
+                if (distance_error_threshold < 0.)
+                    EXPECT_EQ(speculative[idx].number_of_attempts, options.robust_num_attempts);
+                if (max_num_keypoints > 0)
+                    EXPECT_LE(speculative[idx].sample_size, max_num_keypoints);
+                EXPECT_LT((serial[idx].frame.BeginTr() - speculative[idx].frame.BeginTr()).norm(), 1.e-6);
+                EXPECT_LT((serial[idx].frame.EndTr() - speculative[idx].frame.EndTr()).norm(), 1.e-6);
+                EXPECT_LT(serial[idx].frame.end_pose.AngularDistance(speculative[idx].frame.end_pose), 1.e-6);
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(Odometry, MotionHypotheses) {
+    ct_icp::OdometryOptions options;
+    options.debug_print = false;
+    options.ct_icp_options.debug_print = false;
+    options.initialization = ct_icp::INIT_CONSTANT_VELOCITY;
+    options.init_with_motion_hypotheses = true;
+    // The hypotheses: 0 the initialization (constant velocity), 1 the constant velocity, 2 the zero motion
+    const double kSpeed = 0.3;
+
+    // The sensor moves at constant velocity: the zero-motion hypothesis is rejected
+    {
+        ct_icp::Odometry odometry(options);
+        ct_icp::Odometry::RegistrationSummary summary;
+        for (int fid(0); fid < 6; ++fid) {
+            summary = odometry.RegisterFrame(GenerateRigidFrame(fid, Eigen::Vector3d(kSpeed * fid, 0., 0.)));
+            ASSERT_TRUE(summary.success);
+        }
+        ASSERT_EQ(summary.logged_values.count("odometry_motion_hypothesis"), 1);
+        ASSERT_NE(summary.logged_values["odometry_motion_hypothesis"], 2.);
+        ASSERT_LT((summary.initial_frame.EndTr() - Eigen::Vector3d(5 * kSpeed, 0., 0.)).norm(), 0.05);
+    }
+
+    // The sensor stops: the zero-motion hypothesis is selected over the constant velocity
+    {
+        ct_icp::Odometry odometry(options);
+        ct_icp::Odometry::RegistrationSummary summary;
+        for (int fid(0); fid < 5; ++fid) {
+            summary = odometry.RegisterFrame(
+                    GenerateRigidFrame(fid, Eigen::Vector3d(kSpeed * std::min(fid, 3), 0., 0.)));
+            ASSERT_TRUE(summary.success);
+        }
+        ASSERT_EQ(summary.logged_values["odometry_motion_hypothesis"], 2.);
+        ASSERT_LT((summary.initial_frame.EndTr() - Eigen::Vector3d(3 * kSpeed, 0., 0.)).norm(), 0.05);
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------------------------ */
+TEST(Odometry, GeneralizedICP) {
+    ct_icp::OdometryOptions options;
+    options.debug_print = false;
+    options.ct_icp_options.debug_print = false;
+    options.ct_icp_options.solver = ct_icp::CERES;
+    auto map_options = std::make_shared<ct_icp::MultipleResolutionVoxelMap::Options>();
+    map_options->resolutions = {{1.0, 0.05, 50}};
+    map_options->default_radius = 1.0;
+    options.map_options = map_options;
+    const double kSpeed = 0.1;
+
+    // The Generalized-ICP residuals use the distributions cached by the map, the other distances do not
+    for (auto distance: {ct_icp::POINT_TO_PLANE, ct_icp::DISTRIBUTION_TO_DISTRIBUTION}) {
+        options.ct_icp_options.distance = distance;
+        ct_icp::Odometry odometry(options);
+        ct_icp::Odometry::RegistrationSummary summary;
+        for (int fid(0); fid < 5; ++fid) {
+            summary = odometry.RegisterFrame(GenerateRigidFrame(fid, Eigen::Vector3d(kSpeed * fid, 0., 0.), 4000));
+            ASSERT_TRUE(summary.success);
+        }
+        ASSERT_LT((summary.frame.EndTr() - Eigen::Vector3d(4 * kSpeed, 0., 0.)).norm(), 0.05);
+        if (distance == ct_icp::DISTRIBUTION_TO_DISTRIBUTION)
+            ASSERT_GT(summary.icp_summary.num_distribution_residuals, 0);
+        else
+            ASSERT_EQ(summary.icp_summary.num_distribution_residuals, 0);
+    }
+}
@@ -15,45 +15,79 @@ class TestBinding(unittest.TestCase):
     def test_installation(self):
         self.assertEqual(True, _with_pct)  # add assertion here
 
-    def test_frame(self):
+    def test_register_frame(self):
         self.test_installation()
 
-        frame = pct.LiDARFrame()
+        options = pct.OdometryOptions()
+        options.motion_compensation = pct.NONE
+        options.debug_print = False
+        odometry = pct.Odometry(options)
+
+        n = 1000
+        points = np.random.randn(n, 4)
+        points[:, :3] *= 10.0
+        points[:, 3] = np.linspace(0.0, 1.0, n)
+
+        summary = odometry.RegisterFrame(points, with_corrected_points=True)
+        self.assertEqual(odometry.NumRegisteredFrames(), 1)
+
+        begin_pose = summary.begin_pose
+        self.assertEqual(begin_pose.shape, (7,))
 
-        n = 100
-        np_array = np.random.randn(n, 3)
-        np_raw_points = np.random.randn(n, 3)
-        timestamps = np.random.rand(n)
-        alpha_timestamps = np.random.rand(n)
-        index_frames = np.random.randint(0, 10, n)
+        corrected = summary.corrected_points
+        self.assertEqual(corrected.shape, (n, 3))
+        self.assertEqual(summary.timestamps.shape, (n,))
 
-        struct_array = np.rec.fromarrays([np_raw_points, np_array, timestamps, alpha_timestamps, index_frames],
-                                         dtype=[
-                                             ("raw_point", 'f8', 3),
-                                             ("pt", 'f8', 3),
-                                             ("alpha_timestamp", 'f8', 1),
-                                             ("timestamp", 'f8', 1),
-                                             ("index_frame", 'i4', 1)])
+        # The views share the memory of the summary
+        corrected[0, 0] = 42.0
+        self.assertEqual(summary.corrected_points[0, 0], 42.0)
 
-        frame.SetFrame(struct_array)
-        array = frame.GetStructuredArrayRef()
+    def test_register_structured_frame(self):
+        self.test_installation()
 
-        diff2 = np.abs(array["pt"] - np_array).max()
-        diff0 = np.abs(array["raw_point"] - np_raw_points).max()
-        self.assertEqual(diff2, 0.0)
-        self.assertEqual(diff0, 0.0)
+        options = pct.OdometryOptions()
+        options.debug_print = False
+        odometry = pct.Odometry(options)
 
-        array[:10]["pt"] = 0.0
+        n = 1000
+        frame = np.zeros(n, dtype=[("x", 'f4'), ("y", 'f4'), ("z", 'f4'), ("intensity", 'f4'), ("timestamp", 'f8')])
+        frame["x"] = np.random.randn(n) * 10.0
+        frame["y"] = np.random.randn(n) * 10.0
+        frame["z"] = np.random.randn(n)
+        frame["timestamp"] = np.linspace(0.0, 1.0, n)
 
-        array_bis = frame.GetStructuredArrayRef()
+        summary = odometry.RegisterFrame(frame)
+        self.assertEqual(summary.corrected_points.shape, (0, 3))
 
-        xs = array["pt"]
-        xs_bis = array_bis["pt"]
-        diff = np.abs(xs - xs_bis).max()
-        self.assertEqual(diff, 0.0)
+        # Separate timestamps array
+        xyz = np.ascontiguousarray(np.random.randn(n, 3))
+        summary = odometry.RegisterFrame(xyz, timestamps=np.linspace(1.0, 2.0, n))
+        self.assertEqual(odometry.NumRegisteredFrames(), 2)
 
-        # Check that GetWrappingArray returns a reference
-        # And SetFrame makes a copy
+    def test_run_odometry(self):
+        self.test_installation()
+
+        options = pct.OdometryOptions()
+        n = 1000
+        frames = []
+        for i in range(5):
+            frame = np.random.randn(n, 4)
+            frame[:, :3] *= 10.0
+            frame[:, 3] = np.linspace(i, i + 1, n)
+            frames.append(frame)
+
+        progress = []
+        results = pct.RunOdometry(options, frames,
+                                  progress_callback=lambda idx, total: progress.append(idx),
+                                  progress_period=1)
+        self.assertEqual(results["trajectory"].shape, (5, 2, 7))
+        self.assertEqual(results["registration_ms"].shape, (5,))
+        self.assertEqual(progress, [1, 2, 3, 4, 5])
+
+        run = pct.RunOdometryAsync(options, frames)
+        results = run.Wait()
+        self.assertTrue(run.IsDone())
+        self.assertEqual(results["trajectory"].shape, (5, 2, 7))
 
     def test_odometry(self):
         self.test_installation()